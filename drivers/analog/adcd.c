@@ -35,6 +35,7 @@
 
 #include "analog/adc.h"
 #include "analog/adcd.h"
+#include "barriers.h"
 #include "dma/dma.h"
 #include "irq/irq.h"
 #include "mm/cache.h"
@@ -75,13 +76,74 @@ static void _adcd_transfer_buffer_dma(struct _adcd_desc* desc)
 	dma_start_transfer(desc->xfer.dma.channel);
 }
 
+static uint8_t _adcd_stream_period_flags(struct _adcd_stream* stream, uint32_t index)
+{
+	uint8_t flags = 0;
+
+	if (index == (stream->periods / 2u) - 1)
+		flags |= ADCD_PERIOD_HALF;
+	if (index == stream->periods - 1u)
+		flags |= ADCD_PERIOD_FULL;
+
+	return flags;
+}
+
+static int _adcd_stream_dma_callback(void *arg, void* arg2)
+{
+	struct _adcd_desc* desc = (struct _adcd_desc*)arg;
+	struct _adcd_stream* stream = desc->xfer.stream;
+	struct _adcd_period period;
+	uint32_t sequence, offset, count;
+	uint32_t index;
+
+	if (!stream)
+		return 0;
+
+	/* Count the periods from the DMA address rather than the interrupts:
+	 * when servicing is late, one interrupt stands for several periods.
+	 * The end of the last period is the start of the first one. */
+	sequence = stream->sequence;
+	offset = (dma_get_dest_addr(desc->xfer.dma.channel) - (uint32_t)stream->buffer)
+		/ sizeof(uint16_t) % (stream->periods * stream->period_len);
+	count = (offset / stream->period_len + stream->periods - sequence % stream->periods)
+		% stream->periods;
+
+	while (count--) {
+		index = sequence % stream->periods;
+		period.data = stream->buffer + index * stream->period_len;
+		period.len = stream->period_len;
+		period.sequence = sequence;
+		period.flags = _adcd_stream_period_flags(stream, index);
+
+		/* For read, invalidate region */
+		cache_invalidate_region((void*)period.data, period.len * sizeof(uint16_t));
+
+		dmb();
+		stream->sequence = ++sequence;
+
+		callback_call(&stream->callback, &period);
+	}
+
+	return 0;
+}
+
+/* Next enabled channel after 'channel' in scan order */
+static uint8_t _adcd_next_channel(uint32_t mask, uint8_t channel)
+{
+	uint32_t higher = mask & ~((2u << channel) - 1);
+
+	if (!higher)
+		higher = mask;
+	return 31 - CLZ(higher & -higher);
+}
+
 /**
  * \brief Interrupt handler for the ADC.
  */
 static void _adcd_handler(uint32_t source, void* user_arg)
 {
 	struct _adcd_desc* desc = (struct _adcd_desc*)user_arg;
-	uint16_t* data = (uint16_t*)desc->xfer.buf->data;
+	uint16_t* data;
 	uint32_t mask = 1u << (31 - CLZ(desc->cfg.channel_mask));
 	uint32_t status;
 	int index = 0;
@@ -90,6 +152,15 @@ static void _adcd_handler(uint32_t source, void* user_arg)
 	/* Get Interrupt Status (ISR) */
 	status = adc_get_status();
 
+	if (desc->xfer.stream) {
+		/* Conversions were overwritten before the DMA read them */
+		if (status & ADC_ISR_GOVRE)
+			desc->xfer.stream->adc_overruns++;
+		return;
+	}
+
+	data = (uint16_t*)desc->xfer.buf->data;
+
 	if (status & mask) {
 		/* Read results */
 		for (i = 0; i < adc_get_num_channels(); i++) {
@@ -306,3 +377,156 @@ void adcd_wait_transfer(struct _adcd_desc* desc)
 			dma_poll();
 	}
 }
+
+uint32_t adcd_stream_start(struct _adcd_desc* desc, struct _adcd_stream* stream)
+{
+	struct _dma_transfer_cfg cfg[ADCD_STREAM_MAX_PERIODS];
+	struct _callback _cb;
+	uint32_t period_size = stream->period_len * sizeof(uint16_t);
+	uint8_t i;
+
+	if (stream->periods < 2 || stream->periods > ADCD_STREAM_MAX_PERIODS)
+		return ADCD_ERROR_TRANSFER;
+	if (stream->period_len == 0 || stream->period_len > DMA_MAX_BT_SIZE)
+		return ADCD_ERROR_TRANSFER;
+	/* Periods are invalidated one by one while the DMA writes the next */
+	if (!IS_CACHE_ALIGNED(stream->buffer) || !IS_CACHE_ALIGNED(period_size))
+		return ADCD_ERROR_TRANSFER;
+
+	if (!mutex_try_lock(&desc->mutex))
+		return ADCD_ERROR_LOCK;
+
+	stream->sequence = 0;
+	stream->released = 0;
+	stream->overruns = 0;
+	stream->adc_overruns = 0;
+	stream->lost = 0;
+	stream->next_channel = -1;
+	memset(stream->channel_seq, 0, sizeof(stream->channel_seq));
+
+	desc->xfer.stream = stream;
+	adcd_configure(desc);
+
+	/* Drop stale lines before the DMA starts filling the ring */
+	cache_invalidate_region(stream->buffer, period_size * stream->periods);
+
+	for (i = 0; i < stream->periods; i++) {
+		cfg[i].saddr = (void*)&ADC->ADC_LCDR;
+		cfg[i].daddr = stream->buffer + i * stream->period_len;
+		cfg[i].len = stream->period_len;
+	}
+	desc->xfer.dma.cfg_dma.loop = true;
+	if (dma_configure_transfer(desc->xfer.dma.channel, &desc->xfer.dma.cfg_dma,
+				   cfg, stream->periods) < 0) {
+		desc->xfer.stream = NULL;
+		mutex_unlock(&desc->mutex);
+		return ADCD_ERROR_TRANSFER;
+	}
+	callback_set(&_cb, _adcd_stream_dma_callback, desc);
+	dma_set_callback(desc->xfer.dma.channel, &_cb);
+
+	/* Count conversions lost by the ADC itself */
+	adc_disable_it(0xffffffffu);
+	adc_get_status();
+	adc_enable_it(ADC_IER_GOVRE);
+	irq_enable(ID_ADC);
+
+	dma_start_transfer(desc->xfer.dma.channel);
+
+	return ADCD_SUCCESS;
+}
+
+void adcd_stream_stop(struct _adcd_desc* desc)
+{
+	if (!desc->xfer.stream)
+		return;
+
+	adc_set_trigger_mode(ADC_TRGR_TRGMOD_NO_TRIGGER);
+	irq_disable(ID_ADC);
+	adc_disable_it(0xffffffffu);
+
+	dma_stop_transfer(desc->xfer.dma.channel);
+	dma_reset_channel(desc->xfer.dma.channel);
+
+	desc->xfer.stream = NULL;
+	mutex_unlock(&desc->mutex);
+}
+
+bool adcd_stream_peek(struct _adcd_stream* stream, struct _adcd_period* period)
+{
+	uint32_t sequence = stream->sequence;
+	uint32_t index;
+
+	if (sequence - stream->released >= stream->periods) {
+		/* The DMA went over the oldest periods, skip them */
+		stream->overruns += sequence - stream->released - (stream->periods - 1);
+		stream->released = sequence - (stream->periods - 1);
+	}
+	if (sequence == stream->released)
+		return false;
+
+	/* Read the period only after its sequence number */
+	dmb();
+
+	index = stream->released % stream->periods;
+	period->data = stream->buffer + index * stream->period_len;
+	period->len = stream->period_len;
+	period->sequence = stream->released;
+	period->flags = _adcd_stream_period_flags(stream, index);
+
+	return true;
+}
+
+void adcd_stream_release(struct _adcd_stream* stream)
+{
+	if (stream->sequence == stream->released)
+		return;
+
+	/* The DMA reached the period while it was held */
+	if (stream->sequence - stream->released >= stream->periods)
+		stream->overruns++;
+
+	/* Finish reading the period before handing it back */
+	dmb();
+	stream->released++;
+}
+
+uint32_t adcd_stream_decode(struct _adcd_desc* desc, struct _adcd_stream* stream,
+			    const struct _adcd_period* period,
+			    struct _adcd_sample* samples)
+{
+	uint32_t mask = desc->cfg.channel_mask;
+	uint32_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < period->len; i++) {
+		uint16_t raw = period->data[i];
+		uint8_t channel = (raw & ADC_LCDR_CHNB_Msk) >> ADC_LCDR_CHNB_Pos;
+
+		if (channel >= ADCD_MAX_CHANNELS || !(mask & (1u << channel))) {
+			/* Not a channel of the scan, cannot be numbered */
+			stream->lost++;
+			continue;
+		}
+
+		/* Channels are converted in increasing order: account for the
+		 * skipped ones so that their numbering shows the gap */
+		if (stream->next_channel >= 0) {
+			uint8_t expected = stream->next_channel;
+			while (expected != channel) {
+				stream->channel_seq[expected]++;
+				stream->lost++;
+				expected = _adcd_next_channel(mask, expected);
+			}
+		}
+
+		samples[count].channel = channel;
+		samples[count].value = (raw & ADC_LCDR_LDATA_Msk) >> ADC_LCDR_LDATA_Pos;
+		samples[count].sequence = stream->channel_seq[channel]++;
+		count++;
+
+		stream->next_channel = _adcd_next_channel(mask, channel);
+	}
+
+	return count;
+}
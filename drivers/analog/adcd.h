@@ -52,6 +52,13 @@
 
 #define ADCD_MAX_CHANNELS    (12)
 
+/** Maximum number of periods in a stream ring */
+#define ADCD_STREAM_MAX_PERIODS (16)
+
+/** Period flags, as reported to the stream callback */
+#define ADCD_PERIOD_HALF     (1u << 0) /*< last period of the first ring half */
+#define ADCD_PERIOD_FULL     (1u << 1) /*< last period of the ring */
+
 /** ADC trigger modes */
 enum _trg_mode
 {
@@ -87,6 +94,40 @@ struct _adcd_cfg {
 	uint32_t channel_mask;
 };
 
+/* completed stream period, passed as arg2 of the stream callback */
+struct _adcd_period {
+	const uint16_t* data;       /*< tagged samples, ADC_LCDR format */
+	uint32_t len;               /*< number of samples */
+	uint32_t sequence;          /*< period sequence number */
+	uint8_t flags;              /*< ADCD_PERIOD_xxx */
+};
+
+/* decoded stream sample */
+struct _adcd_sample {
+	uint8_t channel;            /*< channel number from the tag */
+	uint16_t value;             /*< converted data */
+	uint32_t sequence;          /*< per-channel sample sequence number */
+};
+
+/* structure to define a continuous ADC stream */
+struct _adcd_stream {
+	/* ring of 'periods' x 'period_len' samples, each period must be
+	 * cache-line aligned in size and the buffer cache-line aligned */
+	uint16_t* buffer;
+	uint32_t period_len;
+	uint8_t periods;            /*< 2 to ADCD_STREAM_MAX_PERIODS */
+	struct _callback callback;  /*< called from IRQ for each period */
+
+	/* following fields are used internally */
+	volatile uint32_t sequence; /*< completed periods, written by IRQ */
+	uint32_t released;          /*< released periods, written by consumer */
+	uint32_t overruns;          /*< periods overwritten before release */
+	volatile uint32_t adc_overruns; /*< conversions lost by the ADC (GOVRE) */
+	uint32_t lost;              /*< tag discontinuities found by decoding */
+	int8_t next_channel;        /*< expected channel of the next sample */
+	uint32_t channel_seq[ADCD_MAX_CHANNELS];
+};
+
 /* structure to define ADC state */
 struct _adcd_desc {
 	struct _adcd_cfg cfg;
@@ -103,6 +144,8 @@ struct _adcd_desc {
 			struct _dma_channel *channel;
 			struct _dma_cfg cfg_dma;
 		} dma;
+
+		struct _adcd_stream *stream; /*< active stream or NULL */
 	} xfer;
 };
 
@@ -118,4 +161,36 @@ extern bool adcd_is_busy(struct _adcd_desc* desc);
 
 extern void adcd_wait_transfer(struct _adcd_desc* desc);
 
+/**
+ * \brief Start continuous sampling into a ring of periods.
+ * The DMA loops over the ring without gaps. Each completed period is
+ * reported to the stream callback and must be released by the consumer
+ * with adcd_stream_release() before the DMA comes back to it, otherwise
+ * it is counted as an overrun and dropped. Completed periods are counted
+ * from the DMA address, a late interrupt reports all of them.
+ * The driver stays locked until adcd_stream_stop() is called.
+ */
+extern uint32_t adcd_stream_start(struct _adcd_desc* desc, struct _adcd_stream* stream);
+
+extern void adcd_stream_stop(struct _adcd_desc* desc);
+
+/**
+ * \brief Get the oldest completed period not yet released.
+ * \return false if no period is available
+ */
+extern bool adcd_stream_peek(struct _adcd_stream* stream, struct _adcd_period* period);
+
+extern void adcd_stream_release(struct _adcd_stream* stream);
+
+/**
+ * \brief Decode tagged samples of a period and number them per channel.
+ * Samples not following the scan order of the enabled channels mean
+ * conversions were lost; they are counted in stream->lost and the
+ * numbering resynchronizes on the received tag.
+ * \return number of decoded samples
+ */
+extern uint32_t adcd_stream_decode(struct _adcd_desc* desc, struct _adcd_stream* stream,
+				   const struct _adcd_period* period,
+				   struct _adcd_sample* samples);
+
 #endif /* ADCD_H_ */
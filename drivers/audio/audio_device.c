@@ -36,10 +36,13 @@
 #include <string.h>
 
 #include "audio_device.h"
+#include "barriers.h"
 #include "callback.h"
 #include "chip.h"
 #include "dma/dma.h"
+#include "errno.h"
 #include "mm/cache.h"
+#include "mutex.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -134,6 +137,141 @@ static void _configure_pdmic(struct _audio_desc *desc)
 }
 #endif
 
+/**
+ * Get the DMA resources used by a ring on the audio device.
+ */
+static int _audio_ring_get_dma(struct _audio_desc *desc, mutex_t **mutex,
+			       struct _dma_channel **channel,
+			       struct _dma_cfg **cfg_dma, void **fifo,
+			       uint8_t *width)
+{
+	switch (desc->type) {
+#if defined(CONFIG_HAVE_CLASSD)
+	case AUDIO_DEVICE_CLASSD:
+		{
+			struct _classd_desc *classd = &desc->device.classd.desc;
+
+			if (desc->direction != AUDIO_DEVICE_PLAY ||
+			    classd->transfer_mode != CLASSD_MODE_DMA)
+				return -ENOTSUP;
+			*mutex = &classd->tx.mutex;
+			*channel = classd->tx.dma.channel;
+			*cfg_dma = &classd->tx.dma.cfg_dma;
+			*fifo = (void*)&classd->addr->CLASSD_THR;
+			if (classd->left_enable && classd->right_enable)
+				*width = DMA_DATA_WIDTH_WORD;
+			else
+				*width = DMA_DATA_WIDTH_HALF_WORD;
+		}
+		return 0;
+#endif
+#if defined(CONFIG_HAVE_SSC)
+	case AUDIO_DEVICE_SSC:
+		{
+			struct _ssc_desc *ssc = &desc->device.ssc.desc;
+
+			if (ssc->slot_length == 8)
+				*width = DMA_DATA_WIDTH_BYTE;
+			else if (ssc->slot_length == 16)
+				*width = DMA_DATA_WIDTH_HALF_WORD;
+			else if (ssc->slot_length == 32)
+				*width = DMA_DATA_WIDTH_WORD;
+			else
+				return -ENOTSUP;
+			if (desc->direction == AUDIO_DEVICE_PLAY) {
+				*mutex = &ssc->tx.mutex;
+				*channel = ssc->tx.dma.channel;
+				*cfg_dma = &ssc->tx.dma.cfg_dma;
+				*fifo = (void*)&ssc->addr->SSC_THR;
+			} else {
+				*mutex = &ssc->rx.mutex;
+				*channel = ssc->rx.dma.channel;
+				*cfg_dma = &ssc->rx.dma.cfg_dma;
+				*fifo = (void*)&ssc->addr->SSC_RHR;
+			}
+		}
+		return 0;
+#endif
+#if defined(CONFIG_HAVE_PDMIC)
+	case AUDIO_DEVICE_PDMIC:
+		{
+			struct _pdmic_desc *pdmic = &desc->device.pdmic.desc;
+
+			if (desc->direction != AUDIO_DEVICE_RECORD ||
+			    pdmic->transfer_mode != PDMIC_MODE_DMA)
+				return -ENOTSUP;
+			*mutex = &pdmic->rx.mutex;
+			*channel = pdmic->rx.dma.channel;
+			*cfg_dma = &pdmic->rx.dma.cfg_dma;
+			*fifo = (void*)&pdmic->addr->PDMIC_CDR;
+			if (pdmic->dsp_size == PDMIC_CONVERTED_DATA_SIZE_32)
+				*width = DMA_DATA_WIDTH_WORD;
+			else
+				*width = DMA_DATA_WIDTH_HALF_WORD;
+		}
+		return 0;
+#endif
+	default:
+		return -ENOTSUP;
+	}
+}
+
+/* Offset in the ring of the address the DMA is working on, memory side */
+static uint32_t _audio_ring_get_offset(struct _audio_ring *ring)
+{
+	uint32_t addr;
+
+	if (ring->desc->direction == AUDIO_DEVICE_PLAY)
+		addr = dma_get_src_addr(ring->channel);
+	else
+		addr = dma_get_dest_addr(ring->channel);
+
+	/* The end of the last period is the start of the first one */
+	return (addr - (uint32_t)ring->buffer) % (ring->periods * ring->period_size);
+}
+
+static int _audio_ring_dma_callback(void *arg, void *arg2)
+{
+	struct _audio_ring *ring = (struct _audio_ring*)arg;
+	bool play = ring->desc->direction == AUDIO_DEVICE_PLAY;
+	struct _audio_period period;
+	uint32_t sequence = ring->sequence;
+	uint32_t current, count;
+
+	/* Count the periods from the DMA address rather than the interrupts:
+	 * when servicing is late, one interrupt stands for several periods.
+	 * An interrupt for a period already accounted for finds no work. */
+	current = _audio_ring_get_offset(ring) / ring->period_size;
+	count = (current + ring->periods - sequence % ring->periods) % ring->periods;
+
+	while (count--) {
+		period.data = ring->buffer + (sequence % ring->periods) * ring->period_size;
+		period.size = ring->period_size;
+		period.sequence = sequence;
+
+		if (play) {
+			/* The period was played, leave silence behind so that
+			 * an underrun does not replay stale samples */
+			memset(period.data, ring->silence, period.size);
+			cache_clean_region(period.data, period.size);
+		} else {
+			/* For read, invalidate region */
+			cache_invalidate_region(period.data, period.size);
+		}
+
+		dmb();
+		ring->sequence = ++sequence;
+
+		/* The period the DMA started next was not committed in time */
+		if (play && (int32_t)(ring->app - sequence) <= 0)
+			ring->underruns++;
+
+		callback_call(&ring->callback, &period);
+	}
+
+	return 0;
+}
+
 /**
  * Configure audio play/record
  */
@@ -495,3 +633,186 @@ void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust)
 #endif
 #endif
 }
+
+int audio_ring_start(struct _audio_desc *desc, struct _audio_ring *ring)
+{
+	struct _dma_transfer_cfg cfg[AUDIO_RING_MAX_PERIODS];
+	struct _callback _cb;
+	struct _dma_cfg *cfg_dma;
+	mutex_t *mutex;
+	void *fifo;
+	uint8_t width;
+	uint32_t len;
+	uint8_t i;
+	int err;
+
+	if (ring->periods < 2 || ring->periods > AUDIO_RING_MAX_PERIODS)
+		return -EINVAL;
+	if (ring->prefilled > ring->periods)
+		return -EINVAL;
+	/* Periods are flushed one by one while the DMA works on the others */
+	if (!IS_CACHE_ALIGNED(ring->buffer) || !IS_CACHE_ALIGNED(ring->period_size))
+		return -EINVAL;
+
+	err = _audio_ring_get_dma(desc, &mutex, &ring->channel, &cfg_dma, &fifo, &width);
+	if (err < 0)
+		return err;
+	len = ring->period_size >> width;
+	if (len == 0 || len > DMA_MAX_BT_SIZE || (len << width) != ring->period_size)
+		return -EINVAL;
+
+	if (!mutex_try_lock(mutex))
+		return -EBUSY;
+
+	ring->desc = desc;
+	ring->width_shift = width;
+	ring->sequence = 0;
+	ring->underruns = 0;
+	ring->overruns = 0;
+	ring->position = 0;
+
+	if (desc->direction == AUDIO_DEVICE_PLAY) {
+		/* Start with silence in the periods not filled yet */
+		ring->app = ring->prefilled;
+		memset(ring->buffer + ring->prefilled * ring->period_size, ring->silence,
+		       (ring->periods - ring->prefilled) * ring->period_size);
+		cache_clean_region(ring->buffer, ring->periods * ring->period_size);
+	} else {
+		/* Drop stale lines before the DMA starts filling the ring */
+		ring->app = 0;
+		cache_invalidate_region(ring->buffer, ring->periods * ring->period_size);
+	}
+
+	for (i = 0; i < ring->periods; i++) {
+		if (desc->direction == AUDIO_DEVICE_PLAY) {
+			cfg[i].saddr = ring->buffer + i * ring->period_size;
+			cfg[i].daddr = fifo;
+		} else {
+			cfg[i].saddr = fifo;
+			cfg[i].daddr = ring->buffer + i * ring->period_size;
+		}
+		cfg[i].len = len;
+	}
+	cfg_dma->data_width = width;
+	cfg_dma->loop = true;
+	if (dma_configure_transfer(ring->channel, cfg_dma, cfg, ring->periods) < 0) {
+		cfg_dma->loop = false;
+		ring->desc = NULL;
+		mutex_unlock(mutex);
+		return -EIO;
+	}
+	callback_set(&_cb, _audio_ring_dma_callback, ring);
+	dma_set_callback(ring->channel, &_cb);
+	dma_start_transfer(ring->channel);
+
+	return 0;
+}
+
+void audio_ring_stop(struct _audio_ring *ring)
+{
+	struct _dma_channel *channel;
+	struct _dma_cfg *cfg_dma;
+	mutex_t *mutex;
+	void *fifo;
+	uint8_t width;
+
+	if (!ring->desc)
+		return;
+	if (_audio_ring_get_dma(ring->desc, &mutex, &channel, &cfg_dma, &fifo, &width) < 0)
+		return;
+
+	dma_stop_transfer(channel);
+	dma_reset_channel(channel);
+
+	/* Give the device back to single transfers */
+	cfg_dma->loop = false;
+	ring->desc = NULL;
+	mutex_unlock(mutex);
+}
+
+bool audio_ring_peek(struct _audio_ring *ring, struct _audio_period *period)
+{
+	uint32_t sequence = ring->sequence;
+	uint32_t index;
+
+	if (!ring->desc)
+		return false;
+
+	if (ring->desc->direction == AUDIO_DEVICE_PLAY) {
+		/* The DMA already went over this period, write the next one */
+		if ((int32_t)(ring->app - sequence) <= 0)
+			ring->app = sequence + 1;
+		/* The ring is full until the DMA completes a period */
+		if (ring->app - sequence >= ring->periods)
+			return false;
+	} else {
+		if (sequence - ring->app >= ring->periods) {
+			/* The DMA went over the oldest periods, skip them */
+			ring->overruns += sequence - ring->app - (ring->periods - 1);
+			ring->app = sequence - (ring->periods - 1);
+		}
+		if (sequence == ring->app)
+			return false;
+	}
+
+	/* Access the period only after its sequence number */
+	dmb();
+
+	index = ring->app % ring->periods;
+	period->data = ring->buffer + index * ring->period_size;
+	period->size = ring->period_size;
+	period->sequence = ring->app;
+
+	return true;
+}
+
+void audio_ring_release(struct _audio_ring *ring)
+{
+	uint32_t sequence = ring->sequence;
+
+	if (!ring->desc)
+		return;
+
+	if (ring->desc->direction == AUDIO_DEVICE_PLAY) {
+		if (ring->app - sequence >= ring->periods)
+			return;
+		cache_clean_region(ring->buffer + (ring->app % ring->periods) * ring->period_size,
+				   ring->period_size);
+	} else {
+		if (sequence == ring->app)
+			return;
+		/* The DMA reached the period while it was held */
+		if (sequence - ring->app >= ring->periods)
+			ring->overruns++;
+	}
+
+	/* Finish accessing the period before handing it over */
+	dmb();
+	ring->app++;
+}
+
+uint64_t audio_ring_get_position(struct _audio_ring *ring)
+{
+	uint32_t sequence, offset, ahead;
+	uint64_t position;
+
+	if (!ring->desc)
+		return ring->position;
+
+	/* Sample the DMA address against a stable sequence number */
+	do {
+		sequence = ring->sequence;
+		offset = _audio_ring_get_offset(ring);
+	} while (sequence != ring->sequence);
+
+	/* Periods completed but not yet serviced by the interrupt */
+	ahead = (offset / ring->period_size + ring->periods - sequence % ring->periods) % ring->periods;
+	position = (uint64_t)(sequence + ahead) * ring->period_size + offset % ring->period_size;
+
+	/* Never go backwards, e.g. on a stale address register read */
+	if (position < ring->position)
+		position = ring->position;
+	ring->position = position;
+
+	return position;
+}
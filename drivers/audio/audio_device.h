@@ -56,6 +56,9 @@
 
 #define AUDIO_PLAY_MAX_VOLUME    (100)
 
+/** Maximum number of periods in an audio ring */
+#define AUDIO_RING_MAX_PERIODS   (16)
+
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -145,6 +148,37 @@ struct _audio_desc {
 	uint16_t bits_per_sample;
 };
 
+/* ring period, passed as arg2 of the ring callback or returned by peek */
+struct _audio_period {
+	uint8_t* data;              /*< period samples */
+	uint32_t size;              /*< period size in bytes */
+	uint32_t sequence;          /*< period sequence number */
+};
+
+/* structure to define a continuous audio stream */
+struct _audio_ring {
+	/* ring of 'periods' x 'period_size' bytes, the buffer and the period
+	 * size must be cache-line aligned */
+	uint8_t* buffer;
+	uint32_t period_size;       /*< in bytes */
+	uint8_t periods;            /*< 2 to AUDIO_RING_MAX_PERIODS */
+	uint8_t prefilled;          /*< play: periods filled before start */
+	uint8_t silence;            /*< play: byte value of silent samples,
+				     *  0x80 for 8-bit unsigned data */
+	struct _callback callback;  /*< called from IRQ for each period */
+
+	/* following fields are used internally */
+	struct _audio_desc* desc;
+	struct _dma_channel* channel;
+	uint8_t width_shift;        /*< log2 of the DMA data width in bytes */
+	volatile uint32_t sequence; /*< completed periods, written by IRQ */
+	uint32_t app;               /*< committed (play) or released (record)
+				     *  periods, written by the application */
+	volatile uint32_t underruns; /*< play: periods played without data */
+	uint32_t overruns;          /*< record: periods overwritten before release */
+	uint64_t position;          /*< last position returned */
+};
+
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -204,4 +238,49 @@ extern bool audio_transfer_is_done(struct _audio_desc *desc);
  */
 extern void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust);
 
+/**
+ * \brief Start a continuous transfer over a ring of periods.
+ * The DMA loops over the ring without gaps until audio_ring_stop().
+ * For playback the application fills periods ahead of the DMA with
+ * audio_ring_peek()/audio_ring_release(); a period reached by the DMA
+ * before it was released is played as silence and counted in
+ * ring->underruns. For record each completed period is reported to the
+ * ring callback and must be released before the DMA comes back to it,
+ * otherwise it is counted in ring->overruns and dropped.
+ * The ring callback gets every completed period: for playback the
+ * period just played, now silence, for record the period just filled.
+ * Completed periods are counted from the DMA address, a late interrupt
+ * reports all the periods completed since the previous one.
+ * \param desc     Audio descriptor, configured and enabled
+ * \param ring     Ring description
+ * \return 0 on success, -EINVAL, -ENOTSUP or -EBUSY otherwise
+ */
+extern int audio_ring_start(struct _audio_desc *desc, struct _audio_ring *ring);
+
+/**
+ * \brief Stop a ring transfer and release the audio device
+ * \param ring     Ring started with audio_ring_start()
+ */
+extern void audio_ring_stop(struct _audio_ring *ring);
+
+/**
+ * \brief Get the next period to process.
+ * For playback, the oldest free period to fill; for record, the oldest
+ * completed period not yet released.
+ * \return false if no period is available or the ring is stopped
+ */
+extern bool audio_ring_peek(struct _audio_ring *ring, struct _audio_period *period);
+
+/**
+ * \brief Hand the period returned by audio_ring_peek() back to the DMA,
+ * does nothing once the ring is stopped
+ */
+extern void audio_ring_release(struct _audio_ring *ring);
+
+/**
+ * \brief Get the number of bytes transferred by the DMA since start,
+ * including the progress inside the current period.
+ */
+extern uint64_t audio_ring_get_position(struct _audio_ring *ring);
+
 #endif /* AUDIO_DEVICE_API_H */
@@ -43,8 +43,10 @@
 #include "can/mcand.h"
 #include "errno.h"
 #include "irq/irq.h"
+#include "intmath.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
+#include "ring.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -154,6 +156,8 @@ static struct _cand_ram_item mcan_ram_item[MSG_RAM_ITEM_CNT];
 
 static struct _mcan_desc mcan_desc[CAN_IFACE_COUNT];
 
+static struct _mcand_tx_frame *mcan_tx_slot[CAN_IFACE_COUNT][RAM_TX_BUF_CNT];
+
 /*----------------------------------------------------------------------------
  *        Local Functions
  *----------------------------------------------------------------------------*/
@@ -300,6 +304,7 @@ static int mcan_initialize(struct _mcan_desc* desc, const struct mcan_config *cf
 	 * Disable all interrupts */
 	mcan_disable_it(mcan, MCAN_INT_ALL);
 	mcan->MCAN_TXBTIE = 0x00000000;
+	mcan->MCAN_TXBCIE = 0x00000000;
 	/* All interrupts directed to Line 0 */
 	mcan_line0_it(mcan, MCAN_INT_ALL);
 	/* Disable both interrupt LINE 0 & LINE 1 */
@@ -353,6 +358,10 @@ static int mcan_initialize(struct _mcan_desc* desc, const struct mcan_config *cf
 	if (!mcan_set_tx_element_size(mcan, cfg->buf_size_tx))
 		return -EINVAL;
 
+	/* Timestamp counter incremented every CAN bit time, used to stamp
+	 * frames received in streaming mode */
+	mcan->MCAN_TSCC = MCAN_TSCC_TSS_TCP_INC | MCAN_TSCC_TCP(0);
+
 	mcan->MCAN_NDAT1 = 0xFFFFFFFF;   /* clear new (rx) data flags */
 	mcan->MCAN_NDAT2 = 0xFFFFFFFF;   /* clear new (rx) data flags */
 
@@ -463,6 +472,9 @@ static void _mcand_tx_buffer_handler(struct _mcan_desc *desc)
 
 	status = mcan->MCAN_TXBTO;
 	for (buf_idx = 0; buf_idx < buf_count; buf_idx ++) {
+		/* buffers owned by the TX scheduler */
+		if (desc->tx_slot[buf_idx])
+			continue;
 		if (status & (1 << buf_idx) & mcan->MCAN_TXBTIE) {
 			mcan->MCAN_TXBTIE &= ~(1 << buf_idx);
 			ram_item = &desc->ram_item[ram_idx + buf_idx];
@@ -646,30 +658,142 @@ static void _mcand_rx_buffer_handler(struct _mcan_desc *desc)
 	}
 }
 
+static struct _mcand_rx_stream* _mcand_rx_stream_lookup(struct _mcan_desc *desc,
+		const uint32_t *rx_buf)
+{
+	enum _mcan_ram filter;
+	uint8_t filter_idx;
+
+	if (rx_buf[1] & MCAN_RAM_R1_ANMF)
+		return NULL;
+
+	filter = (rx_buf[0] & MCAN_RAM_R0_XTD) ?
+		MCAN_RAM_EXT_FILTER : MCAN_RAM_STD_FILTER;
+	filter_idx = (rx_buf[1] & MCAN_RAM_R1_FIDX_Msk) >> MCAN_RAM_R1_FIDX_Pos;
+	if (filter_idx >= desc->set.cfg.item_count[filter])
+		return NULL;
+
+	return desc->ram_item[desc->set.cfg.ram_index[filter] + filter_idx].stream;
+}
+
+static void _mcand_rx_stream_push(struct _mcan_desc *desc,
+		struct _mcand_rx_stream *stream, const uint32_t *rx_buf,
+		uint32_t ram_size)
+{
+	struct _mcand_frame *frame;
+	uint32_t len;
+
+	if (RING_SPACE(stream->head, stream->tail, stream->size) == 0) {
+		stream->overflows++;
+		return;
+	}
+
+	frame = &stream->frames[stream->head];
+	frame->flags = 0;
+	if (rx_buf[0] & MCAN_RAM_R0_XTD) {
+		frame->id = (rx_buf[0] & MCAN_RAM_R0_XTDID_Msk) >> MCAN_RAM_R0_XTDID_Pos;
+		frame->flags |= MCAND_FRAME_EXTENDED;
+	} else {
+		frame->id = (rx_buf[0] & MCAN_RAM_R0_STDID_Msk) >> MCAN_RAM_R0_STDID_Pos;
+	}
+	if (rx_buf[0] & MCAN_RAM_R0_ESI)
+		frame->flags |= MCAND_FRAME_ESI;
+	if (rx_buf[1] & MCAN_RAM_R1_FDF)
+		frame->flags |= MCAND_FRAME_FD;
+	if (rx_buf[1] & MCAN_RAM_R1_BRS)
+		frame->flags |= MCAND_FRAME_BRS;
+	frame->timestamp = (rx_buf[1] & MCAN_RAM_R1_RXTS_Msk) >> MCAN_RAM_R1_RXTS_Pos;
+
+	len = get_data_length((enum mcan_dlc)
+			((rx_buf[1] & MCAN_RAM_R1_DLC_Msk) >> MCAN_RAM_R1_DLC_Pos));
+	if (len > ram_size)
+		len = ram_size;
+	frame->len = len;
+	memcpy(frame->data, &rx_buf[2], len);
+
+	/* make the frame visible before publishing the new head */
+	dmb();
+	RING_INC(stream->head, stream->size);
+	stream->received++;
+
+	if (!stream->pending) {
+		stream->pending = true;
+		stream->next_pending = desc->rx_pending;
+		desc->rx_pending = stream;
+	}
+}
+
+static void _mcand_rx_stream_notify(struct _mcan_desc *desc)
+{
+	struct _mcand_rx_stream *stream;
+
+	while (desc->rx_pending) {
+		stream = desc->rx_pending;
+		desc->rx_pending = stream->next_pending;
+		stream->pending = false;
+		callback_call(&stream->cb, stream);
+	}
+}
+
 static void _mcand_rx_fifo_handler(struct _mcan_desc *desc, enum _mcan_ram fifo)
 {
 	uint32_t cnt;
 	uint32_t get;
 	uint32_t total;
+	uint32_t ram_size;
+	uint32_t *fifo_ram;
+	uint32_t *rx_buf;
+	struct _mcand_rx_stream *stream;
+	bool ack = false;
 	Mcan *mcan = desc->addr;
 
 	if (fifo == MCAN_RAM_RX_FIFO0) {
 		cnt = (mcan->MCAN_RXF0S & MCAN_RXF0S_F0FL_Msk) >> MCAN_RXF0S_F0FL_Pos;
 		get = (mcan->MCAN_RXF0S & MCAN_RXF0S_F0GI_Msk) >> MCAN_RXF0S_F0GI_Pos;
+		ram_size = desc->set.cfg.buf_size_rx_fifo0;
+		fifo_ram = desc->set.ram_fifo_rx0;
 	} else if (fifo == MCAN_RAM_RX_FIFO1) {
 		cnt = (mcan->MCAN_RXF1S & MCAN_RXF1S_F1FL_Msk) >> MCAN_RXF1S_F1FL_Pos;
 		get = (mcan->MCAN_RXF1S & MCAN_RXF1S_F1GI_Msk) >> MCAN_RXF1S_F1GI_Pos;
-	}
+		ram_size = desc->set.cfg.buf_size_rx_fifo1;
+		fifo_ram = desc->set.ram_fifo_rx1;
+	} else
+		return;
 	total = desc->set.cfg.item_count[fifo];
 
 	while (cnt--) {
-		_mcand_rx_proc(desc, fifo, get);
+		rx_buf = fifo_ram + get * (MCAN_RAM_BUF_HDR_SIZE + ram_size / sizeof(uint32_t));
+		stream = _mcand_rx_stream_lookup(desc, rx_buf);
+		if (stream) {
+			_mcand_rx_stream_push(desc, stream, rx_buf, ram_size);
+			ack = true;
+		} else if (desc->ram_item[desc->set.cfg.ram_index[fifo] + get].buf) {
+			/* one-shot reception, acknowledged by _mcand_rx_proc */
+			_mcand_rx_proc(desc, fifo, get);
+			ack = false;
+		} else {
+			/* no receiver (e.g. stream stopped meanwhile): drop */
+			ack = true;
+		}
+		if (cnt == 0 && ack) {
+			/* acknowledging the last element frees all the elements
+			 * read during this batch */
+			if (fifo == MCAN_RAM_RX_FIFO0)
+				mcan_rx_fifo0_ack(mcan, get);
+			else
+				mcan_rx_fifo1_ack(mcan, get);
+		}
 		get ++;
 		if (get >= total)
 			get = 0;
 	}
+
+	_mcand_rx_stream_notify(desc);
 }
 
+/* forward declaration */
+static void _mcand_tx_sched_handler(struct _mcan_desc *desc);
+
 /**
  * Interrupt handler for MCAN Driver.
  */
@@ -722,6 +846,7 @@ static void _mcan_handler(uint32_t source, void* user_arg)
 	}
 	if (status & MCAN_IR_RF0L) {
 		mcan_clear_status(mcan, MCAN_IR_RF0L);
+		desc->rx_fifo_lost[0]++;
 		trace_warning("Receive FIFO 0 Message Lost\n\r");
 	}
 	if (status & MCAN_IR_RF1F) {
@@ -734,6 +859,7 @@ static void _mcan_handler(uint32_t source, void* user_arg)
 	}
 	if (status & MCAN_IR_RF1L) {
 		mcan_clear_status(mcan, MCAN_IR_RF1L);
+		desc->rx_fifo_lost[1]++;
 		trace_warning("Receive FIFO 1 Message Lost\n\r");
 	}
 	if (status & MCAN_IR_HPM) {
@@ -741,15 +867,13 @@ static void _mcan_handler(uint32_t source, void* user_arg)
 		trace_warning("High priority message received\n\r");
 	}
 
-	if (status & MCAN_IR_TC) {
-		mcan_clear_status(mcan, MCAN_IR_TC);
-		_mcand_tx_buffer_handler(desc);
+	if (status & (MCAN_IR_TC | MCAN_IR_TCF)) {
+		mcan_clear_status(mcan, status & (MCAN_IR_TC | MCAN_IR_TCF));
+		_mcand_tx_sched_handler(desc);
 	}
 
-	if (status & MCAN_IR_TCF) {
-		mcan_clear_status(mcan, MCAN_IR_TCF);
-		trace_info("Transmission Cancellation Finished\n\r");
-	}
+	if (status & MCAN_IR_TC)
+		_mcand_tx_buffer_handler(desc);
 	if (status & MCAN_IR_TFE) {
 		mcan_clear_status(mcan, MCAN_IR_TFE);
 		_mcand_tx_fifo_handler(desc);
@@ -960,7 +1084,7 @@ static uint8_t* mcan_prepare_tx_buffer(struct _mcan_desc *desc, uint8_t buf_idx,
 	*tx_buf++ = val;
 	/* enable transmit from buffer to set TC interrupt bit in IR,
 	 * but interrupt will not happen unless TC interrupt is enabled */
-	mcan->MCAN_TXBTIE = (1 << buf_idx);
+	mcan->MCAN_TXBTIE |= (1 << buf_idx);
 	return (uint8_t *)tx_buf;   /* now it points to the data field */
 }
 
@@ -995,11 +1119,187 @@ static void mcan_enqueue_outgoing_msg(struct _mcan_desc *desc,
 	/* enable transmit from buffer to set TC interrupt bit in IR,
 	 * but interrupt will not happen unless TC interrupt is enabled
 	 */
-	mcan->MCAN_TXBTIE = (1 << putIdx);
+	mcan->MCAN_TXBTIE |= (1 << putIdx);
 	/* request to send */
 	mcan->MCAN_TXBAR = (1 << putIdx);
 }
 
+/**
+ * \brief Arbitration priority key of a frame, lower is higher priority.
+ * The 11 most significant bits of an extended identifier are arbitrated
+ * first, and a standard frame wins over an extended frame with the same
+ * base identifier.
+ */
+static uint32_t _mcand_tx_key(const struct _mcand_tx_frame *frame)
+{
+	if (frame->flags & MCAND_FRAME_EXTENDED)
+		return ((frame->id >> 18) << 19) | (1u << 18) | (frame->id & 0x3ffff);
+	return frame->id << 19;
+}
+
+/* Mask both MCAN interrupt lines, return which ones were enabled.
+ * Inside the MCAN handler the lines still read as enabled (the AIC keeps
+ * the source enabled while it is in service), so they are masked and
+ * re-enabled as usual. What the saved state protects are callers running
+ * with a line masked on purpose, e.g. an application holding the MCAN
+ * interrupts off: the unlock must not enable it behind their back. */
+static uint8_t _mcand_tx_sched_lock(struct _mcan_desc *desc)
+{
+	uint8_t enabled = 0;
+	uint8_t line;
+
+	for (line = 0; line < 2; line++) {
+		uint32_t id = get_mcan_id_from_addr(desc->addr, line);
+		if (irq_is_enabled(id)) {
+			enabled |= 1u << line;
+			irq_disable(id);
+		}
+	}
+	return enabled;
+}
+
+/* Re-enable only the interrupt lines _mcand_tx_sched_lock() masked */
+static void _mcand_tx_sched_unlock(struct _mcan_desc *desc, uint8_t enabled)
+{
+	uint8_t line;
+
+	for (line = 0; line < 2; line++)
+		if (enabled & (1u << line))
+			irq_enable(get_mcan_id_from_addr(desc->addr, line));
+}
+
+static void _mcand_tx_sched_insert(struct _mcan_desc *desc,
+		struct _mcand_tx_frame *frame)
+{
+	struct _mcand_tx_frame **p = &desc->tx_queue;
+	uint32_t key = _mcand_tx_key(frame);
+
+	/* keep FIFO order between frames of same priority */
+	while (*p && _mcand_tx_key(*p) <= key)
+		p = &(*p)->next;
+	frame->next = *p;
+	*p = frame;
+	frame->status = MCAND_TX_QUEUED;
+}
+
+static bool _mcand_tx_sched_unlink(struct _mcan_desc *desc,
+		struct _mcand_tx_frame *frame)
+{
+	struct _mcand_tx_frame **p = &desc->tx_queue;
+
+	while (*p && *p != frame)
+		p = &(*p)->next;
+	if (!*p)
+		return false;
+	*p = frame->next;
+	frame->next = NULL;
+	return true;
+}
+
+static void _mcand_tx_sched_cancel_slot(struct _mcan_desc *desc, uint8_t slot)
+{
+	desc->tx_cancel |= (1u << slot);
+	desc->addr->MCAN_TXBCR = (1u << slot);
+}
+
+/**
+ * \brief Fill free dedicated Tx Buffers with the highest priority frames,
+ * and request cancellation of buffered frames that have lower priority than
+ * queued ones.  Called with MCAN interrupts disabled.
+ */
+static void _mcand_tx_sched_run(struct _mcan_desc *desc)
+{
+	Mcan *mcan = desc->addr;
+	struct _mcand_tx_frame *frame;
+	uint32_t buf_count = desc->set.cfg.item_count[MCAN_RAM_TX_BUFFER];
+	uint32_t worst_key, key;
+	int worst;
+	uint8_t i, buf_idx;
+
+	while (desc->tx_queue) {
+		if (mcand_get_ram(desc, MCAN_RAM_TX_BUFFER, &buf_idx) < 0)
+			break;
+		frame = desc->tx_queue;
+		desc->tx_queue = frame->next;
+		frame->next = NULL;
+		frame->status = MCAND_TX_PENDING;
+		desc->tx_slot[buf_idx] = frame;
+
+		mcan->MCAN_TXBCIE |= (1u << buf_idx);
+		mcan_enqueue_outgoing_msg(desc, buf_idx,
+			(frame->flags & MCAND_FRAME_EXTENDED) ?
+				MCAN_RAM_T0_XTD | frame->id : frame->id,
+			frame->len, frame->data);
+	}
+
+	/* All buffers busy: preempt buffered frames of lower priority, so
+	 * that the controller arbitrates between the best pending frames */
+	for (frame = desc->tx_queue; frame; frame = frame->next) {
+		key = _mcand_tx_key(frame);
+		worst = -1;
+		worst_key = 0;
+		for (i = 0; i < buf_count; i++) {
+			if (!desc->tx_slot[i] || (desc->tx_cancel & (1u << i)))
+				continue;
+			if (worst < 0 || _mcand_tx_key(desc->tx_slot[i]) > worst_key) {
+				worst = i;
+				worst_key = _mcand_tx_key(desc->tx_slot[i]);
+			}
+		}
+		if (worst < 0 || key >= worst_key)
+			break;
+		_mcand_tx_sched_cancel_slot(desc, worst);
+	}
+
+	if (desc->tx_queue || desc->tx_cancel)
+		mcan_enable_it(mcan, MCAN_IE_TCE | MCAN_IE_TCFE);
+	else if (mcan->MCAN_TXBCIE)
+		mcan_enable_it(mcan, MCAN_IE_TCE);
+}
+
+/**
+ * \brief Handle transmitted and cancelled frames of the TX scheduler, then
+ * refill the Tx Buffers.  Called from the interrupt handler.
+ */
+static void _mcand_tx_sched_handler(struct _mcan_desc *desc)
+{
+	Mcan *mcan = desc->addr;
+	struct _mcand_tx_frame *frame;
+	uint32_t buf_count = desc->set.cfg.item_count[MCAN_RAM_TX_BUFFER];
+	uint32_t done = mcan->MCAN_TXBTO;
+	uint32_t cancelled = mcan->MCAN_TXBCF;
+	uint32_t pending = mcan->MCAN_TXBRP;
+	uint32_t mask;
+	uint8_t i;
+
+	for (i = 0; i < buf_count; i++) {
+		frame = desc->tx_slot[i];
+		mask = 1u << i;
+		if (!frame || (pending & mask) || !((done | cancelled) & mask))
+			continue;
+
+		desc->tx_slot[i] = NULL;
+		desc->tx_cancel &= ~mask;
+		mcan->MCAN_TXBTIE &= ~mask;
+		mcan->MCAN_TXBCIE &= ~mask;
+		mcand_release_ram(desc, MCAN_RAM_TX_BUFFER, i);
+
+		if (done & mask) {
+			/* transmitted, possibly despite a cancellation request */
+			frame->status = MCAND_TX_DONE;
+			callback_call(&frame->cb, frame);
+		} else if (frame->drop) {
+			frame->status = MCAND_TX_CANCELLED;
+			callback_call(&frame->cb, frame);
+		} else {
+			/* preempted by a higher priority frame */
+			_mcand_tx_sched_insert(desc, frame);
+		}
+	}
+
+	_mcand_tx_sched_run(desc);
+}
+
 static int mcand_tx(struct _mcan_desc *desc, struct _buffer *buf,
 			struct _callback* cb)
 {
@@ -1214,6 +1514,11 @@ int mcand_configure(struct _mcan_desc* desc)
 	assert(index <= ARRAY_SIZE(mcan_ram_item));
 	desc->ram_item = mcan_ram_item;
 
+	desc->tx_slot = mcan_tx_slot[mcan_get_index(mcan)];
+	memset(desc->tx_slot, 0, sizeof(mcan_tx_slot[0]));
+	desc->tx_queue = NULL;
+	desc->tx_cancel = 0;
+
 	err = mcan_initialize(desc, &mcan_cfg);
 	if (err < 0) {
 		trace_error("Configure message RAM failed!");
@@ -1247,3 +1552,194 @@ int mcand_transfer(struct _mcan_desc *desc, struct _buffer *buf,
 		return mcand_rx(desc, buf, cb);
 	return -EINVAL;
 }
+
+int mcand_rx_stream_start(struct _mcan_desc* desc,
+		struct _mcand_rx_stream* stream, uint32_t id, uint32_t mask,
+		uint32_t attr)
+{
+	struct mcan_set *set = &desc->set;
+	enum _mcan_ram fifo;
+	uint32_t *filter;
+	uint32_t it;
+	uint8_t filt_idx;
+	int status;
+
+	if (!stream->frames || stream->size < 2)
+		return -EINVAL;
+
+	if (CAND_BUF_ATTR_USING_FIFO1 == (attr & CAND_BUF_ATTR_USING_FIFO1)) {
+		fifo = MCAN_RAM_RX_FIFO1;
+		it = MCAN_IE_RF1NE | MCAN_IE_RF1LE;
+	} else {
+		fifo = MCAN_RAM_RX_FIFO0;
+		it = MCAN_IE_RF0NE | MCAN_IE_RF0LE;
+	}
+	if (set->cfg.item_count[fifo] == 0)
+		return -ENOSYS;
+
+	stream->filter = (attr & CAND_BUF_ATTR_EXTENDED) ?
+		MCAN_RAM_EXT_FILTER : MCAN_RAM_STD_FILTER;
+	status = mcand_get_ram(desc, stream->filter, &filt_idx);
+	if (status < 0)
+		return status;
+	stream->filter_idx = filt_idx;
+
+	RING_CLEAR(stream->head, stream->tail);
+	stream->received = 0;
+	stream->overflows = 0;
+	stream->pending = false;
+	stream->next_pending = NULL;
+	desc->ram_item[set->cfg.ram_index[stream->filter] + filt_idx].stream = stream;
+
+	if (stream->filter == MCAN_RAM_EXT_FILTER) {
+		assert(id <= 0x1fffffff);
+		filter = set->ram_filt_ext + filt_idx * MCAN_RAM_FILT_EXT_SIZE;
+		filter[1] = MCAN_RAM_F1_EFT_CLASSIC | MCAN_RAM_F1_EFID2(mask);
+		dsb();
+		filter[0] = ((fifo == MCAN_RAM_RX_FIFO1) ?
+				MCAN_RAM_F0_EFEC_FIFO1 : MCAN_RAM_F0_EFEC_FIFO0)
+			| MCAN_RAM_F0_EFID1(id);
+	} else {
+		assert(id <= 0x7ff);
+		filter = set->ram_filt_std + filt_idx * MCAN_RAM_FILT_STD_SIZE;
+		*filter = MCAN_RAM_S0_SFT_CLASSIC
+			| ((fifo == MCAN_RAM_RX_FIFO1) ?
+				MCAN_RAM_S0_SFEC_FIFO1 : MCAN_RAM_S0_SFEC_FIFO0)
+			| MCAN_RAM_S0_SFID1(id)
+			| MCAN_RAM_S0_SFID2(mask);
+	}
+	dsb();
+
+	mcan_enable_it(desc->addr, it);
+	return 0;
+}
+
+void mcand_rx_stream_stop(struct _mcan_desc* desc,
+		struct _mcand_rx_stream* stream)
+{
+	struct _cand_ram_item *ram_item;
+
+	ram_item = &desc->ram_item[desc->set.cfg.ram_index[stream->filter]
+		+ stream->filter_idx];
+	if (ram_item->stream != stream)
+		return;
+
+	/* disable the filter first, frames already in the Rx FIFO are then
+	 * handled as unmatched */
+	mcand_release_ram(desc, stream->filter, stream->filter_idx);
+	dsb();
+	ram_item->stream = NULL;
+}
+
+uint32_t mcand_rx_stream_count(const struct _mcand_rx_stream* stream)
+{
+	return RING_CNT(stream->head, stream->tail, stream->size);
+}
+
+const struct _mcand_frame* mcand_rx_stream_peek(
+		const struct _mcand_rx_stream* stream)
+{
+	if (RING_EMPTY(stream->head, stream->tail))
+		return NULL;
+	return &stream->frames[stream->tail];
+}
+
+void mcand_rx_stream_release(struct _mcand_rx_stream* stream, uint32_t count)
+{
+	uint16_t tail = stream->tail;
+
+	if (count > mcand_rx_stream_count(stream))
+		count = mcand_rx_stream_count(stream);
+
+	/* finish reading the frames before handing them back */
+	dmb();
+	stream->tail = fixed_mod(tail + count, stream->size);
+}
+
+int mcand_tx_sched_queue(struct _mcan_desc* desc,
+		struct _mcand_tx_frame* frame, bool replace)
+{
+	struct _mcand_tx_frame *old, *replaced = NULL;
+	uint32_t buf_count = desc->set.cfg.item_count[MCAN_RAM_TX_BUFFER];
+	uint8_t i, irqs;
+
+	if (frame->len > desc->set.cfg.buf_size_tx)
+		return -EINVAL;
+	if (frame->status == MCAND_TX_QUEUED || frame->status == MCAND_TX_PENDING)
+		return -EBUSY;
+
+	frame->drop = false;
+	frame->next = NULL;
+
+	irqs = _mcand_tx_sched_lock(desc);
+
+	if (replace) {
+		/* supersede a queued frame with the same identifier */
+		for (old = desc->tx_queue; old; old = old->next) {
+			if (old->id == frame->id &&
+			    (old->flags & MCAND_FRAME_EXTENDED) == (frame->flags & MCAND_FRAME_EXTENDED))
+				break;
+		}
+		if (old) {
+			_mcand_tx_sched_unlink(desc, old);
+			old->status = MCAND_TX_CANCELLED;
+			replaced = old;
+		}
+
+		/* or a buffered one, not yet transmitted */
+		for (i = 0; i < buf_count; i++) {
+			old = desc->tx_slot[i];
+			if (old && !old->drop && old->id == frame->id &&
+			    (old->flags & MCAND_FRAME_EXTENDED) == (frame->flags & MCAND_FRAME_EXTENDED)) {
+				old->drop = true;
+				if (!(desc->tx_cancel & (1u << i)))
+					_mcand_tx_sched_cancel_slot(desc, i);
+			}
+		}
+	}
+
+	_mcand_tx_sched_insert(desc, frame);
+	_mcand_tx_sched_run(desc);
+
+	_mcand_tx_sched_unlock(desc, irqs);
+
+	if (replaced)
+		callback_call(&replaced->cb, replaced);
+
+	return 0;
+}
+
+int mcand_tx_sched_cancel(struct _mcan_desc* desc,
+		struct _mcand_tx_frame* frame)
+{
+	uint32_t buf_count = desc->set.cfg.item_count[MCAN_RAM_TX_BUFFER];
+	int status = -EINVAL;
+	uint8_t i, irqs;
+
+	irqs = _mcand_tx_sched_lock(desc);
+
+	if (frame->status == MCAND_TX_QUEUED) {
+		if (_mcand_tx_sched_unlink(desc, frame)) {
+			frame->status = MCAND_TX_CANCELLED;
+			status = 0;
+		}
+	} else if (frame->status == MCAND_TX_PENDING) {
+		for (i = 0; i < buf_count; i++) {
+			if (desc->tx_slot[i] == frame) {
+				frame->drop = true;
+				if (!(desc->tx_cancel & (1u << i)))
+					_mcand_tx_sched_cancel_slot(desc, i);
+				mcan_enable_it(desc->addr, MCAN_IE_TCE | MCAN_IE_TCFE);
+				status = -EBUSY;
+				break;
+			}
+		}
+	}
+
+	_mcand_tx_sched_unlock(desc, irqs);
+
+	if (status == 0)
+		callback_call(&frame->cb, frame);
+
+	return status;
+}
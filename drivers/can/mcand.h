@@ -45,10 +45,13 @@
  *        Types
  *----------------------------------------------------------------------------*/
 
+struct _mcand_rx_stream;
+
 struct _cand_ram_item {
 	struct _buffer *buf;
 	struct _callback cb;
 	uint8_t state;
+	struct _mcand_rx_stream *stream; /* filter items only: streaming receiver */
 };
 
 enum _mcan_ram {
@@ -98,6 +101,65 @@ struct mcan_set
 	uint32_t *ram_array_tx;
 };
 
+/* Flags of a frame received in streaming mode */
+#define MCAND_FRAME_EXTENDED   0x01   /* 29-bit identifier */
+#define MCAND_FRAME_FD         0x02   /* CAN FD format */
+#define MCAND_FRAME_BRS        0x04   /* sent with bit rate switching */
+#define MCAND_FRAME_ESI        0x08   /* transmitter is error passive */
+
+/* Frame received in streaming mode */
+struct _mcand_frame {
+	uint32_t id;          /* 11-bit or 29-bit identifier */
+	uint16_t timestamp;   /* MCAN timestamp counter value at start of frame */
+	uint8_t len;          /* length of data, in bytes */
+	uint8_t flags;        /* MCAND_FRAME_xxx */
+	uint8_t data[64];
+};
+
+/* Streaming receiver: frames matching one filter are drained from the Rx
+ * FIFO in batches by the MCAN interrupt handler into a ring of frames.
+ * The ring has a single producer (the interrupt handler) and a single
+ * consumer (the application) and needs no locking. */
+struct _mcand_rx_stream {
+	struct _mcand_frame *frames;  /* ring storage, allocated by the application */
+	uint16_t size;                /* number of frames in the ring */
+	struct _callback cb;          /* called once per batch, arg is the stream */
+
+	/* following fields are used internally */
+	volatile uint16_t head;       /* written by the interrupt handler */
+	volatile uint16_t tail;       /* written by the application */
+	uint32_t received;            /* frames stored into the ring */
+	uint32_t overflows;           /* frames dropped because the ring was full */
+	enum _mcan_ram filter;        /* MCAN_RAM_STD_FILTER or MCAN_RAM_EXT_FILTER */
+	uint8_t filter_idx;
+	bool pending;                 /* notification pending for this batch */
+	struct _mcand_rx_stream *next_pending;
+};
+
+/* State of a frame handled by the TX scheduler */
+enum _mcand_tx_status {
+	MCAND_TX_IDLE = 0,
+	MCAND_TX_QUEUED,      /* waiting in the software priority queue */
+	MCAND_TX_PENDING,     /* in a dedicated Tx Buffer, transmission requested */
+	MCAND_TX_DONE,        /* transmitted */
+	MCAND_TX_CANCELLED,   /* cancelled or replaced before transmission */
+};
+
+/* Frame to transmit through the TX scheduler */
+struct _mcand_tx_frame {
+	uint32_t id;          /* 11-bit or 29-bit identifier */
+	uint8_t len;          /* length of data, in bytes */
+	uint8_t flags;        /* MCAND_FRAME_EXTENDED */
+	uint8_t data[64];
+	struct _callback cb;  /* called when the frame leaves the scheduler
+	                       * (DONE or CANCELLED), arg is the frame */
+
+	/* following fields are used internally */
+	volatile uint8_t status;  /* enum _mcand_tx_status */
+	bool drop;                /* cancel requested by the application */
+	struct _mcand_tx_frame *next;
+};
+
 struct _mcan_desc {
 	Mcan* addr;            /**< Pointer to HW register base */
 	uint32_t freq;         /**< Current working baudrate */
@@ -110,6 +172,13 @@ struct _mcan_desc {
 
 	struct _cand_ram_item * ram_item;
 	struct mcan_set set;
+
+	struct _mcand_rx_stream *rx_pending; /* streams to notify after a batch */
+	uint32_t rx_fifo_lost[2];            /* frames lost by Rx FIFO 0/1 */
+
+	struct _mcand_tx_frame *tx_queue;    /* pending frames, by priority */
+	struct _mcand_tx_frame **tx_slot;    /* frame in each dedicated Tx Buffer */
+	uint32_t tx_cancel;                  /* Tx Buffers being cancelled */
 };
 
 /*----------------------------------------------------------------------------
@@ -127,5 +196,77 @@ extern int mcand_configure(struct _mcan_desc* desc);
  */
 extern int mcand_transfer(struct _mcan_desc* desc, struct _buffer *buf,
 			  struct _callback* cb);
+
+/**
+ * Start receiving, in streaming mode, all frames whose identifier matches
+ * id under mask.  Matching frames are stored in Rx FIFO 0 (or Rx FIFO 1 if
+ * CAND_BUF_ATTR_USING_FIFO1 is set in attr), then moved by batches into the
+ * stream ring.  The stream callback is called once per batch.
+ * A Rx FIFO used in streaming mode should not be used by mcand_transfer().
+ * \param desc    Pointer to CAN Driver descriptor instance.
+ * \param stream  Pointer to stream, with frames, size and cb initialized.
+ * \param id      Identifier to match.
+ * \param mask    Identifier bits to compare (classic filter).
+ * \param attr    CAND_BUF_ATTR_EXTENDED and/or CAND_BUF_ATTR_USING_FIFO1.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int mcand_rx_stream_start(struct _mcan_desc* desc,
+		struct _mcand_rx_stream* stream, uint32_t id, uint32_t mask,
+		uint32_t attr);
+
+/**
+ * Stop a streaming receiver and release its filter.
+ * Frames still in the ring remain available.
+ * \param desc    Pointer to CAN Driver descriptor instance.
+ * \param stream  Pointer to a started stream.
+ */
+extern void mcand_rx_stream_stop(struct _mcan_desc* desc,
+		struct _mcand_rx_stream* stream);
+
+/**
+ * Queue a frame in the TX scheduler.
+ * Pending frames are kept sorted by CAN arbitration priority, and the
+ * dedicated Tx Buffers always hold the highest priority ones: when all
+ * buffers are busy, a lower priority frame is cancelled from its buffer
+ * and put back in the queue to make room.
+ * \param desc     Pointer to CAN Driver descriptor instance.
+ * \param frame    Frame to send; must stay valid until its callback.
+ * \param replace  If true, a not yet transmitted frame with the same
+ *                 identifier is cancelled and replaced by this one.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int mcand_tx_sched_queue(struct _mcan_desc* desc,
+		struct _mcand_tx_frame* frame, bool replace);
+
+/**
+ * Cancel a frame queued in the TX scheduler.
+ * If the frame is already in a Tx Buffer, cancellation is requested and
+ * completes asynchronously (the frame may still be transmitted).  The frame
+ * callback is called in all cases.
+ * \param desc   Pointer to CAN Driver descriptor instance.
+ * \param frame  Frame previously given to mcand_tx_sched_queue().
+ * \return 0 if cancelled, -EBUSY if cancellation is in progress, -EINVAL if
+ * the frame is not in the scheduler.
+ */
+extern int mcand_tx_sched_cancel(struct _mcan_desc* desc,
+		struct _mcand_tx_frame* frame);
+
+/**
+ * Get the number of frames available in a stream ring.
+ */
+extern uint32_t mcand_rx_stream_count(const struct _mcand_rx_stream* stream);
+
+/**
+ * Get the oldest frame of a stream ring, without copying or removing it.
+ * \return Pointer to the frame, or NULL if the ring is empty.
+ */
+extern const struct _mcand_frame* mcand_rx_stream_peek(
+		const struct _mcand_rx_stream* stream);
+
+/**
+ * Remove the count oldest frames from a stream ring.
+ */
+extern void mcand_rx_stream_release(struct _mcand_rx_stream* stream,
+		uint32_t count);
 /**@}*/
 #endif /* #ifndef _MCAN_H_ */
@@ -40,7 +40,9 @@
 #include "chip.h"
 #include "compiler.h"
 #include "display/lcdc.h"
+#include "intmath.h"
 #include "gpio/pio.h"
+#include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
 
@@ -55,6 +57,12 @@
  *        Local types
  *----------------------------------------------------------------------------*/
 
+/** Number of layer IDs, including LCDC_CONTROLLER */
+#define LCDC_LAYER_COUNT 5
+
+/** No buffer index */
+#define SWAP_NONE 0xFF
+
 /** Hardware info about the layers */
 struct _layer_info {
 	struct _layer_data* data;
@@ -70,6 +78,7 @@ struct _layer_info {
 	volatile uint32_t  *reg_color;      /**< regs: RGB Default, RGB Key, RGB Mask */
 	volatile uint32_t  *reg_scale;      /**< regs: scale */
 	volatile uint32_t  *reg_clut;       /**< regs: CLUT */
+	uint32_t            irq_mask;       /**< layer bit in LCDC_LCDIER */
 };
 
 /** DMA descriptor for LCDC */
@@ -79,6 +88,25 @@ struct _lcdc_dma_desc {
 	uint32_t next;
 };
 
+/** Swap chain buffer states */
+enum _swap_state {
+	SWAP_FREE = 0,     /**< can be acquired */
+	SWAP_ACQUIRED,     /**< owned by the application */
+	SWAP_QUEUED,       /**< presented, waiting for next frame start */
+	SWAP_FRONT,        /**< being displayed */
+};
+
+/** Swap chain of a layer */
+struct _swap_chain {
+	void                 *buffers[LCDC_SWAP_CHAIN_MAX];
+	volatile uint8_t      state[LCDC_SWAP_CHAIN_MAX];
+	uint8_t               count;     /**< 0 when no swap chain */
+	volatile uint8_t      front;     /**< index of displayed buffer */
+	volatile uint8_t      queued;    /**< index of presented buffer */
+	lcdc_swap_callback_t  callback;
+	void                 *arg;
+};
+
 /** Variable layer data */
 struct _layer_data {
 	struct _lcdc_dma_desc *dma_desc;
@@ -126,6 +154,16 @@ static struct _lcdc_dma_desc heo_dma_v_desc; /**< DMA desc. for HEO V Layer */
 
 static struct _layer_data lcdc_heo;          /**< HEO Layer */
 
+/** DMA descriptors of the swap chains, one per buffer */
+CACHE_ALIGNED_DDR
+static struct _lcdc_dma_desc swap_dma_desc[LCDC_LAYER_COUNT][LCDC_SWAP_CHAIN_MAX];
+
+/** Swap chains, indexed by layer ID */
+static struct _swap_chain swap_chains[LCDC_LAYER_COUNT];
+
+/** Set once the LCDC interrupt handler is installed */
+static bool lcdc_irq_installed;
+
 /*----------------------------------------------------------------------------
  *        Local constants
  *----------------------------------------------------------------------------*/
@@ -147,7 +185,8 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_cfg = &LCDC->LCDC_BASECFG0,
 		.reg_stride = &LCDC->LCDC_BASECFG2,
 		.reg_color = &LCDC->LCDC_BASECFG3,
-		.reg_clut = &LCDC->LCDC_BASECLUT[0]
+		.reg_clut = &LCDC->LCDC_BASECLUT[0],
+		.irq_mask = LCDC_LCDIER_BASEIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR1
 	/* 2: LCDC_OVR1 */
@@ -162,6 +201,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR1CFG4,
 		.reg_color = &LCDC->LCDC_OVR1CFG6,
 		.reg_clut = &LCDC->LCDC_OVR1CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR1IE,
 	},
 #else
 	/* 2: N/A */
@@ -184,6 +224,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_color = &LCDC->LCDC_HEOCFG9,
 		.reg_scale = &LCDC->LCDC_HEOCFG13,
 		.reg_clut = &LCDC->LCDC_HEOCLUT[0],
+		.irq_mask = LCDC_LCDIER_HEOIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR2
 	/* 4: LCDC_OVR2 */
@@ -198,6 +239,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR2CFG4,
 		.reg_color = &LCDC->LCDC_OVR2CFG6,
 		.reg_clut = &LCDC->LCDC_OVR2CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR2IE,
 	},
 #else
 	/* 4: N/A */
@@ -317,9 +359,10 @@ static void _clear_dma_desc(struct _lcdc_dma_desc *desc,
 }
 
 /**
- * Compute scaling factors
+ * Compute scaling factors from window size (CFG3) and memory size (CFG4)
+ * register values
  */
-static void _compute_scaling_factors(const struct _layer_info *layer,
+static void _compute_scaling_factors(uint32_t size, uint32_t mem_size,
 		uint16_t* xfactor, uint16_t* yfactor)
 {
 	uint16_t xmemsize, ymemsize;
@@ -328,10 +371,10 @@ static void _compute_scaling_factors(const struct _layer_info *layer,
 	uint16_t xfactor_1st, yfactor_1st;
 #endif
 
-	xmemsize = (layer->reg_win[2] & LCDC_HEOCFG4_XMEMSIZE_Msk) >> LCDC_HEOCFG4_XMEMSIZE_Pos;
-	ymemsize = (layer->reg_win[2] & LCDC_HEOCFG4_YMEMSIZE_Msk) >> LCDC_HEOCFG4_YMEMSIZE_Pos;
-	xsize = (layer->reg_win[1] & LCDC_HEOCFG3_XSIZE_Msk) >> LCDC_HEOCFG3_XSIZE_Pos;
-	ysize = (layer->reg_win[1] & LCDC_HEOCFG3_YSIZE_Msk) >> LCDC_HEOCFG3_YSIZE_Pos;
+	xmemsize = (mem_size & LCDC_HEOCFG4_XMEMSIZE_Msk) >> LCDC_HEOCFG4_XMEMSIZE_Pos;
+	ymemsize = (mem_size & LCDC_HEOCFG4_YMEMSIZE_Msk) >> LCDC_HEOCFG4_YMEMSIZE_Pos;
+	xsize = (size & LCDC_HEOCFG3_XSIZE_Msk) >> LCDC_HEOCFG3_XSIZE_Pos;
+	ysize = (size & LCDC_HEOCFG3_YSIZE_Msk) >> LCDC_HEOCFG3_YSIZE_Pos;
 
 #ifdef LCDC_HEOCFG41_XPHIDEF
 	/* we assume that XPHIDEF & YPHIDEF are 0 */
@@ -408,6 +451,105 @@ static void _build_color_lut1(volatile uint32_t *clut)
 	clut[1] = 0xFFFFFF;
 }
 
+/**
+ * Check whether two rectangles overlap or share an edge.
+ */
+static bool _rect_touch(const struct _lcdc_rect *a, const struct _lcdc_rect *b)
+{
+	return a->x <= b->x + b->w && b->x <= a->x + a->w &&
+	       a->y <= b->y + b->h && b->y <= a->y + a->h;
+}
+
+/**
+ * Grow rectangle a to the bounding box of a and b.
+ */
+static void _rect_union(struct _lcdc_rect *a, const struct _lcdc_rect *b)
+{
+	uint32_t x2 = max_u32(a->x + a->w, b->x + b->w);
+	uint32_t y2 = max_u32(a->y + a->h, b->y + b->h);
+
+	a->x = min_u32(a->x, b->x);
+	a->y = min_u32(a->y, b->y);
+	a->w = x2 - a->x;
+	a->h = y2 - a->y;
+}
+
+/**
+ * Area added to rectangle a when merging rectangle b into it.
+ */
+static uint32_t _rect_union_cost(const struct _lcdc_rect *a,
+		const struct _lcdc_rect *b)
+{
+	struct _lcdc_rect u = *a;
+
+	_rect_union(&u, b);
+	return u.w * u.h - a->w * a->h;
+}
+
+/**
+ * Merge the damaged region at index i with every other region it touches.
+ */
+static void _merge_canvas_damage(uint8_t i)
+{
+	struct _lcdc_rect *damage = lcdc_canvas.damage;
+	uint8_t j = 0;
+
+	while (j < lcdc_canvas.damage_count) {
+		if (j != i && _rect_touch(&damage[i], &damage[j])) {
+			_rect_union(&damage[i], &damage[j]);
+			/* Remove entry j, the last one takes its place */
+			lcdc_canvas.damage_count--;
+			damage[j] = damage[lcdc_canvas.damage_count];
+			if (i == lcdc_canvas.damage_count)
+				i = j;
+			/* Merged region may now touch earlier entries */
+			j = 0;
+		} else {
+			j++;
+		}
+	}
+}
+
+/**
+ * LCDC interrupt handler: complete the buffer flips of the swap chains.
+ */
+static void _lcdc_handler(uint32_t source, void *arg)
+{
+	uint8_t layer_id;
+
+	for (layer_id = 0; layer_id < LCDC_LAYER_COUNT; layer_id++) {
+		const struct _layer_info *layer = &lcdc_layers[layer_id];
+		struct _swap_chain *chain = &swap_chains[layer_id];
+		uint32_t next;
+		uint8_t old;
+
+		if (!chain->count || chain->queued == SWAP_NONE)
+			continue;
+		/* Reading ISR clears it */
+		if (!(layer->reg_enable[6] & LCDC_BASEISR_DSCR))
+			continue;
+
+		/* The front descriptor loops on itself and also raises DSCR:
+		 * the flip is done only once the queued one is loaded */
+		next = layer->reg_dma_head[3];
+		if (next != (uint32_t)&swap_dma_desc[layer_id][chain->queued])
+			continue;
+
+		layer->reg_enable[4] = LCDC_BASEIDR_DSCR;
+
+		old = chain->front;
+		chain->front = chain->queued;
+		chain->queued = SWAP_NONE;
+		chain->state[chain->front] = SWAP_FRONT;
+		chain->state[old] = SWAP_FREE;
+		layer->data->buffer = chain->buffers[chain->front];
+
+		if (chain->callback)
+			chain->callback(layer_id, chain->buffers[chain->front],
+					chain->arg);
+	}
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -417,6 +559,8 @@ static void _build_color_lut1(volatile uint32_t *clut)
  */
 void lcdc_configure(const struct _lcdc_desc *desc)
 {
+	uint8_t i;
+
 	lcdc_config = *desc;
 
 	/* Reset layer information */
@@ -441,6 +585,11 @@ void lcdc_configure(const struct _lcdc_desc *desc)
 
 	/* No canvas selected */
 	lcdc_canvas.buffer = NULL;
+	lcdc_canvas.damage_count = 0;
+
+	/* No swap chains */
+	for (i = 0; i < LCDC_LAYER_COUNT; i++)
+		lcdc_destroy_swap_chain(i);
 
 	/* Disable LCD controller */
 	lcdc_off();
@@ -771,70 +920,47 @@ void lcdc_set_color_lut(uint8_t layer_id, uint32_t *clut, uint8_t bpp)
 }
 
 /**
- * Display an image on specified layer.
- * (Image scan origion: Left -> Right, Top -> Bottom.)
- * \note w & h should be the rotated result.
- * \note for LCDC_BASE: x, y don't care. w always > 0.
- * \note for LCDC_HEO:imgW & imgH is used.
- * \param layer_id  Layer ID (OVR1 or HEO).
- * \param buffer Pointer to image data.
- * \param bpp     Bits Per Pixel.
- *                - 16: TRGB 1555
- *                - 24:  RGB  888  packed
- *                - 32: ARGB 8888
- * \param x       X position.
- * \param y       Y position.
- * \param w       Width  (<0 means Right  -> Left data).
- * \param h       Height (<0 means Bottom -> Top data).
- * \param imgW    Source image width.
- * \param imgH    Source image height.
- * \param wRotate Rotation (clockwise, 0, 90, 180, 270 accepted).
+ * Compute the register state of an image transform, see
+ * lcdc_prepare_image_transform().
  */
-void * lcdc_put_image_rotated(uint8_t layer_id,
-			     void *buffer, uint8_t bpp,
-			     uint32_t x, uint32_t y,
-			     int32_t w, int32_t h,
-			     uint32_t img_w, uint32_t img_h, int16_t rotation)
+static bool _prepare_image_transform(const struct _layer_info *layer,
+		struct _lcdc_image_transform *transform, uint8_t bpp,
+		uint32_t x, uint32_t y, int32_t w, int32_t h,
+		uint32_t img_w, uint32_t img_h, int16_t rotation)
 {
-	const struct _layer_info *layer = &lcdc_layers[layer_id];
-	struct _layer_data *data = layer->data;
-
 	uint8_t bottom_up = (h < 0);
 	uint8_t right_left = (w < 0);
 	uint32_t padding = 0;
 	int32_t src_w, src_h;
 	uint32_t bits_per_row, bytes_per_row;
 	uint32_t bytes_per_pixel = bpp >> 3;
-
-	void *old_buffer = data->buffer;
-
-	if (!layer->reg_cfg)
-		return old_buffer;
-
-	//printf("Show %x @ %d: (%d,%d)+(%d,%d) img %d x %d * %d\n\r", buffer, layer_id, x, y, w, h, img_w, img_h, bpp);
+	uint32_t cfg0 = layer->reg_cfg[0];
+	uint32_t cfg1 = layer->reg_cfg[1];
+	uint32_t xstride = 0, pstride = 0;
+	uint32_t offset = 0;
 
 	switch (bpp) {
 	/*  RGB 565 */
 	case 16:
 #ifdef LCDC_HEOCFG1_YUVEN
-		if ((layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
-			layer->reg_cfg[1] = layer->reg_cfg[1] & (~LCDC_HEOCFG1_YUVMODE_Msk) | LCDC_HEOCFG1_YUVMODE_16BPP_YCBCR_MODE0;
+		if ((cfg1 & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
+			cfg1 = (cfg1 & ~LCDC_HEOCFG1_YUVMODE_Msk) | LCDC_HEOCFG1_YUVMODE_16BPP_YCBCR_MODE0;
 		} else
 #endif
 		{
-			layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_16BPP_RGB_565;
+			cfg1 = LCDC_HEOCFG1_RGBMODE_16BPP_RGB_565;
 		}
 		break;
 	/*  RGB  888 packed */
 	case 24:
-		layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_24BPP_RGB_888_PACKED;
+		cfg1 = LCDC_HEOCFG1_RGBMODE_24BPP_RGB_888_PACKED;
 		break;
 	/* ARGB 8888 */
 	case 32:
-		layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_32BPP_ARGB_8888;
+		cfg1 = LCDC_HEOCFG1_RGBMODE_32BPP_ARGB_8888;
 		break;
 	default:
-		return old_buffer;
+		return false;
 	}
 
 	/* Windows position & size check */
@@ -842,14 +968,10 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 		h = -h;
 	if (w < 0)
 		w = -w;
-	if (x + w > lcdc_config.width) {
-		//printf("! w %d -> %d\n\r", w, lcdc_config.width-x);
+	if (x + w > lcdc_config.width)
 		w = lcdc_config.width - x;
-	}
-	if (y + h > lcdc_config.height) {
-		//printf("! h %d -> %d\n\r", h, lcdc_config.height-y);
+	if (y + h > lcdc_config.height)
 		h = lcdc_config.height - y;
-	}
 	if (w == 0)
 		w++;
 	if (h == 0)
@@ -872,15 +994,9 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 		rotation += 360;
 		break;
 	default:
-		return NULL;
+		return false;
 	}
 
-	/* Setup display buffer & window */
-	if (buffer)
-		data->buffer = buffer;
-	else
-		buffer = data->buffer;
-
 	/* Set display buffer & mode */
 	bits_per_row = img_w * bpp;
 	bytes_per_row = bits_per_row >> 3;
@@ -898,26 +1014,26 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 	if ((!right_left && !bottom_up && rotation == 0)
 	    || (right_left && bottom_up && rotation == 180)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 &= ~LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+					pstride = LCDC_HEOCFG6_PSTRIDE(0);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0);
+			xstride = LCDC_HEOCFG5_XSTRIDE(0);
 			/* Pointer to Left,Top (x0,y0) */
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* X0 ++ */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+				pstride = LCDC_HEOCFG6_PSTRIDE(0);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(padding);
+			xstride = LCDC_HEOCFG5_XSTRIDE(padding);
 			/* Pointer to Left,Top (x0,y0) */
 		}
 	}
@@ -925,213 +1041,289 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 	else if ((right_left && !bottom_up && rotation == 0)
 		 || (!right_left && bottom_up && rotation == 180)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if ((layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
+		if ((cfg1 & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 &= ~LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel - 4);
+					pstride = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel - 4);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 - 2 * bytes_per_pixel - 4);
+			xstride = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 - 2 * bytes_per_pixel - 4);
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row - 4);
+			offset = bytes_per_row - 4;
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* X1 -- */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
+				pstride = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 + padding - 2 * bytes_per_pixel);
+			xstride = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 + padding - 2 * bytes_per_pixel);
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_pixel * (img_w - 1));
+			offset = bytes_per_pixel * (img_w - 1);
 		}
 	}
 	/* Y mirror: Left,Down -> Right,Top */
 	else if ((!right_left && bottom_up && rotation == 0)
 		 || (right_left && !bottom_up && rotation == 180)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 &= ~LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+					pstride = LCDC_HEOCFG6_PSTRIDE(0);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h - 1));
+			offset = bytes_per_row * (img_h - 1);
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* X0 ++ */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+				pstride = LCDC_HEOCFG6_PSTRIDE(0);
 			/* Y1 -- */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * 2 + padding));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * 2 + padding));
 			/* Pointer to Left,Down (x0,y1) */
-			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1));
+			offset = (bytes_per_row + padding) * (img_h - 1);
 		}
 	}
 	/* X,Y mirror: Right,Top -> Left,Down */
 	else if ((right_left && bottom_up && rotation == 0)
 		 || (!right_left && !bottom_up && rotation == 180)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 &= ~LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-				  layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+				  pstride = LCDC_HEOCFG6_PSTRIDE(0);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h-1));
+			offset = bytes_per_row * (img_h-1);
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* X1 -- */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
+				pstride = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
 			/* Y1 -- */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_pixel * 2 + padding));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_pixel * 2 + padding));
 			/* Pointer to Left,Down (x1,y1) */
-			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1));
+			offset = (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1);
 		}
 	}
 	/* Rotate  90: Down,Left -> Top,Right (with w,h swap) */
 	else if ((!right_left && !bottom_up && rotation == 90)
 		 || (right_left && bottom_up && rotation == 270)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 |= LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
+					pstride = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h-1));
+			xstride = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h-1));
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h - 1));
+			offset = bytes_per_row * (img_h - 1);
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* Y -- as pixels in row */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
+				pstride = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
 			/* X ++ as rows */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE((bytes_per_row + padding) * (img_h - 1));
+			xstride = LCDC_HEOCFG5_XSTRIDE((bytes_per_row + padding) * (img_h - 1));
 			/* Pointer to Bottom,Left */
-			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1));
+			offset = (bytes_per_row + padding) * (img_h - 1);
 		}
 	}
 	/* Rotate 270: Top,Right -> Down,Left (with w,h swap) */
 	else if ((!right_left && !bottom_up && rotation == 270)
 		 || (right_left && bottom_up && rotation == 90)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 |= LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
+					pstride = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE((bytes_per_row * (1 - img_h) - 4 - 4));
+			xstride = LCDC_HEOCFG5_XSTRIDE((bytes_per_row * (1 - img_h) - 4 - 4));
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row - 4);
+			offset = bytes_per_row - 4;
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* Y ++ as pixels in row */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
+				pstride = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
 			/* X -- as rows */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel - (bytes_per_row + padding) * (img_h - 1));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel - (bytes_per_row + padding) * (img_h - 1));
 			/* Pointer to top right */
-			buffer = (void *)((uint32_t) buffer + bytes_per_pixel * (img_w - 1));
+			offset = bytes_per_pixel * (img_w - 1);
 		}
 	}
 	/* Mirror X then Rotate 90: Down,Right -> Top,Left */
 	else if ((right_left && !bottom_up && rotation == 90)
 		 || (!right_left && bottom_up && rotation == 270)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 |= LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
+					pstride = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h - 1) - 2 * bytes_per_pixel - 4);
+			xstride = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h - 1) - 2 * bytes_per_pixel - 4);
 			/* Pointer to Right,Top (x1,y0) */
-			buffer = (void *)((uint32_t) buffer + bytes_per_row * img_h - 4);
+			offset = bytes_per_row * img_h - 4;
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* Y -- as pixels in row */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
+				pstride = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
 			/* X -- as rows */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel + (bytes_per_row + padding) * (img_h - 1));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel + (bytes_per_row + padding) * (img_h - 1));
 			/* Pointer to down right (x1,y1) */
-			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1));
+			offset = (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1);
 		}
 	}
 	/* Mirror Y then Rotate 90: Top,Left -> Down,Right */
 	else if ((!right_left && bottom_up && rotation == 90)
 		 || (right_left && !bottom_up && rotation == 270)) {
 #ifdef LCDC_HEOCFG1_YUVEN
-		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+		if(cfg1 & LCDC_HEOCFG1_YUVEN) {
 			/* No rotation optimization */
-			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
-			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			cfg0 = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			cfg1 |= LCDC_HEOCFG1_YUV422ROT;
 			/* X0 ++ */
 			if (layer->stride_supported)
-					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
+					pstride = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
 			/* Y0 ++ */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * (img_h - 1)));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * (img_h - 1)));
 			/* Pointer to Right,Top (x1,y0) */
 		} else
 #endif
 		{
 			/* No rotation optimization */
-			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			cfg0 |= LCDC_HEOCFG0_ROTDIS;
 			/* Y ++ as pixels in row */
 			if (layer->stride_supported)
-				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
+				pstride = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
 			/* X ++ as rows */
-			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row + padding) * (img_h - 1));
+			xstride = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row + padding) * (img_h - 1));
 			/* Pointer to top left (x0,y0) */
 		}
 	}
 
-	/** DMA is running, just add new descriptor to queue */
-	if (layer->reg_blender[0] & LCDC_HEOCFG12_DMA) {
-		data->dma_desc->addr = (uint32_t)buffer;
-		data->dma_desc->ctrl = LCDC_HEOCTRL_DFETCH;
-		data->dma_desc->next = (uint32_t)data->dma_desc;
-		cache_clean_region(data->dma_desc, sizeof(*(data->dma_desc)));
-		layer->reg_dma_head[0] = (uint32_t)data->dma_desc;
-		layer->reg_enable[0] = LCDC_HEOCHER_A2QEN;
+
+	transform->cfg0 = cfg0;
+	transform->cfg1 = cfg1;
+	transform->xstride = xstride;
+	transform->pstride = pstride;
+	transform->offset = offset;
+
+	/* Window & position */
+	transform->pos = LCDC_HEOCFG2_XPOS(x) | LCDC_HEOCFG2_YPOS(y);
+	transform->size = LCDC_HEOCFG3_XSIZE(w - 1) | LCDC_HEOCFG3_YSIZE(h - 1);
+
+	/* Scaling setup, image size only used in scaling */
+	if (rotation == 90 || rotation == 270) {
+		src_w = img_h;
+		src_h = img_w;
+	} else {
+		src_w = img_w;
+		src_h = img_h;
+	}
+	transform->mem_size = LCDC_HEOCFG4_XMEMSIZE(src_w - 1)
+		| LCDC_HEOCFG4_YMEMSIZE(src_h - 1);
+	if (w != src_w || h != src_h) {
+		/* Scaled */
+		uint16_t scale_w, scale_h;
+		_compute_scaling_factors(transform->size, transform->mem_size,
+				&scale_w, &scale_h);
+		transform->scale = LCDC_HEOCFG13_YFACTOR(scale_h)
+			| LCDC_HEOCFG13_XFACTOR(scale_w)
+			| LCDC_HEOCFG13_SCALEN;
 	} else {
+		/* Disable scaling */
+		transform->scale = 0;
+	}
+
+	return true;
+}
+
+/**
+ * Point the layer DMA to a new frame address. When the DMA is running the
+ * descriptor is queued and loaded at the next frame start.
+ * \return false if the DMA is not running.
+ */
+static bool _queue_image_address(const struct _layer_info *layer,
+		uint32_t addr)
+{
+	struct _lcdc_dma_desc *desc = layer->data->dma_desc;
+
+	if (!(layer->reg_blender[0] & LCDC_HEOCFG12_DMA))
+		return false;
+
+	desc->addr = addr;
+	desc->ctrl = LCDC_HEOCTRL_DFETCH;
+	desc->next = (uint32_t)desc;
+	cache_clean_region(desc, sizeof(*desc));
+	layer->reg_dma_head[0] = (uint32_t)desc;
+	layer->reg_enable[0] = LCDC_HEOCHER_A2QEN;
+	return true;
+}
+
+/**
+ * Write the register state of an image transform and display a buffer.
+ */
+static void *_apply_image_transform(const struct _layer_info *layer,
+		const struct _lcdc_image_transform *transform, void *buffer)
+{
+	struct _layer_data *data = layer->data;
+	void *old_buffer = data->buffer;
+	uint32_t addr;
+
+	/* Setup display buffer & window */
+	if (buffer)
+		data->buffer = buffer;
+	else
+		buffer = data->buffer;
+	addr = (uint32_t)buffer + transform->offset;
+
+	/* Mode, rotation & strides */
+	layer->reg_cfg[1] = transform->cfg1;
+	layer->reg_cfg[0] = transform->cfg0;
+	if (layer->stride_supported)
+		layer->reg_stride[1] = transform->pstride;
+	layer->reg_stride[0] = transform->xstride;
+
+	/** DMA is running, just add new descriptor to queue */
+	if (!_queue_image_address(layer, addr)) {
 		/* 2. Write the channel descriptor (DSCR) structure in the system memory by
 		   writing DSCR.CHXADDR Frame base address, DSCR.CHXCTRL channel control
 		   and DSCR.CHXNEXT next descriptor location.
@@ -1140,43 +1332,22 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 		   4. Write the DSCR.CHXNEXT register with the address location of the
 		   descriptor structure and set DFETCH field of the DSCR.CHXCTRL register
 		   to one. */
-		_set_dma_desc(buffer, data->dma_desc, layer->reg_dma_head);
+		_set_dma_desc((void *)addr, data->dma_desc, layer->reg_dma_head);
 	}
 
 	/* Set window & position */
 	if (layer->reg_win) {
-		layer->reg_win[0] = LCDC_HEOCFG2_XPOS(x) | LCDC_HEOCFG2_YPOS(y);
-		layer->reg_win[1] = LCDC_HEOCFG3_XSIZE(w - 1) | LCDC_HEOCFG3_YSIZE(h - 1);
+		layer->reg_win[0] = transform->pos;
+		layer->reg_win[1] = transform->size;
 	}
 
 	/* Scaling setup */
 	if (layer->reg_win && layer->reg_scale) {
-		/* Image size only used in scaling */
-		/* Scaling target */
-		if (rotation == 90 || rotation == 270) {
-			src_w = img_h;
-			src_h = img_w;
-		} else {
-			src_w = img_w;
-			src_h = img_h;
-		}
-		layer->reg_win[2] = LCDC_HEOCFG4_XMEMSIZE(src_w - 1)
-			| LCDC_HEOCFG4_YMEMSIZE(src_h - 1);
-		/* Scaled */
-		if (w != src_w || h != src_h) {
-			uint16_t scale_w, scale_h;
-			_compute_scaling_factors(layer, &scale_w, &scale_h);
-			layer->reg_scale[0] = LCDC_HEOCFG13_YFACTOR(scale_h)
-				| LCDC_HEOCFG13_XFACTOR(scale_w)
-				| LCDC_HEOCFG13_SCALEN;
-		}
-		/* Disable scaling */
-		else {
-			layer->reg_scale[0] = 0;
-		}
+		layer->reg_win[2] = transform->mem_size;
+		layer->reg_scale[0] = transform->scale;
 	}
 	/* Enable DMA */
-	if (buffer) {
+	if (addr) {
 		layer->reg_blender[0] |= LCDC_HEOCFG12_DMA | LCDC_HEOCFG12_OVR;
 	}
 	/* Enable & Update */
@@ -1189,6 +1360,46 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 
 	return old_buffer;
 }
+/**
+ * Display an image on specified layer.
+ * (Image scan origion: Left -> Right, Top -> Bottom.)
+ * \note w & h should be the rotated result.
+ * \note for LCDC_BASE: x, y don't care. w always > 0.
+ * \note for LCDC_HEO:imgW & imgH is used.
+ * \param layer_id  Layer ID (OVR1 or HEO).
+ * \param buffer Pointer to image data.
+ * \param bpp     Bits Per Pixel.
+ *                - 16: TRGB 1555
+ *                - 24:  RGB  888  packed
+ *                - 32: ARGB 8888
+ * \param x       X position.
+ * \param y       Y position.
+ * \param w       Width  (<0 means Right  -> Left data).
+ * \param h       Height (<0 means Bottom -> Top data).
+ * \param imgW    Source image width.
+ * \param imgH    Source image height.
+ * \param wRotate Rotation (clockwise, 0, 90, 180, 270 accepted).
+ * \return Pointer to old display image data, NULL if bpp or rotation is not
+ * supported.
+ */
+void * lcdc_put_image_rotated(uint8_t layer_id,
+			     void *buffer, uint8_t bpp,
+			     uint32_t x, uint32_t y,
+			     int32_t w, int32_t h,
+			     uint32_t img_w, uint32_t img_h, int16_t rotation)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	struct _lcdc_image_transform transform;
+
+	if (!layer->reg_cfg)
+		return layer->data->buffer;
+
+	if (!_prepare_image_transform(layer, &transform, bpp, x, y, w, h,
+				img_w, img_h, rotation))
+		return NULL;
+
+	return _apply_image_transform(layer, &transform, buffer);
+}
 
 /**
  * Display an image on specified layer.
@@ -1237,6 +1448,71 @@ void * lcdc_put_image(uint8_t layer_id, void *buffer, uint8_t bpp,
 			h < 0 ? -h : h, 0);
 }
 
+/**
+ * Precompute the register state needed to display images with a given
+ * geometry on a layer: mode, rotation, strides, window and scaling. The
+ * parameters are the ones of lcdc_put_image_rotated().
+ * \note The layer input mode (see lcdc_configure_input_mode()) and the LCD
+ * configuration must be set beforehand.
+ * \param transform Transform to fill.
+ * \return 1 on success, 0 if the layer, bpp or rotation is not supported.
+ */
+uint8_t lcdc_prepare_image_transform(struct _lcdc_image_transform *transform,
+		uint8_t layer_id, uint8_t bpp, uint32_t x, uint32_t y,
+		int32_t w, int32_t h, uint32_t img_w, uint32_t img_h,
+		int16_t rotation)
+{
+	const struct _layer_info *layer;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= LCDC_LAYER_COUNT)
+		return 0;
+	layer = &lcdc_layers[layer_id];
+	if (!layer->reg_cfg)
+		return 0;
+
+	if (!_prepare_image_transform(layer, transform, bpp, x, y, w, h,
+				img_w, img_h, rotation))
+		return 0;
+	transform->layer_id = layer_id;
+	return 1;
+}
+
+/**
+ * Display an image with a prepared transform. All the layer registers are
+ * written, as done by lcdc_put_image_rotated().
+ * \param transform Transform from lcdc_prepare_image_transform().
+ * \param buffer    Pointer to image data, NULL to keep the current one.
+ * \return Pointer to old display image data.
+ */
+void *lcdc_apply_image_transform(const struct _lcdc_image_transform *transform,
+		void *buffer)
+{
+	return _apply_image_transform(&lcdc_layers[transform->layer_id],
+			transform, buffer);
+}
+
+/**
+ * Display the next image of a sequence sharing a transform already applied
+ * to the layer with lcdc_apply_image_transform(): only the frame address is
+ * updated, the new image is shown from the next frame start. Falls back to
+ * lcdc_apply_image_transform() if the layer DMA is not running.
+ * \param transform Transform currently applied to the layer.
+ * \param buffer    Pointer to image data.
+ * \return Pointer to old display image data.
+ */
+void *lcdc_update_image_transform(const struct _lcdc_image_transform *transform,
+		void *buffer)
+{
+	const struct _layer_info *layer = &lcdc_layers[transform->layer_id];
+	void *old_buffer = layer->data->buffer;
+
+	if (!_queue_image_address(layer, (uint32_t)buffer + transform->offset))
+		return _apply_image_transform(layer, transform, buffer);
+
+	layer->data->buffer = buffer;
+	return old_buffer;
+}
+
 /**
  * Start display on base layer
  * \param buffer   Pointer to image data.
@@ -1582,20 +1858,287 @@ struct _lcdc_layer *lcdc_get_canvas(void)
 }
 
 /**
- * Flush the current canvas layer*
+ * Flush the damaged regions of the current canvas layer.
+ * Only the cache lines covering each damaged row are cleaned, rows being
+ * merged into larger ranges when they are contiguous in memory. The damage
+ * list is empty on return.
  */
 void lcdc_flush_canvas(void)
 {
-	struct _lcdc_layer *layer;
+	struct _lcdc_layer *layer = &lcdc_canvas;
+	struct _cache_batch batch;
+	uint32_t bytes_per_row;
+	uint32_t first, last;
+	uint8_t *row;
+	uint8_t i;
+	uint16_t j;
+
+	if (!layer->buffer || !layer->bpp) {
+		layer->damage_count = 0;
+		return;
+	}
+
+	/* Rows are 4-byte aligned */
+	bytes_per_row = ((layer->width * layer->bpp + 7) / 8 + 3) & ~3;
+
+	cache_batch_init(&batch, CACHE_OP_CLEAN);
+	for (i = 0; i < layer->damage_count; i++) {
+		const struct _lcdc_rect *r = &layer->damage[i];
+
+		row = (uint8_t *)layer->buffer + r->y * bytes_per_row;
+		if (r->x == 0 && r->w == layer->width) {
+			/* Full rows: one contiguous range */
+			cache_batch_add(&batch, row, r->h * bytes_per_row);
+			continue;
+		}
+		first = (r->x * layer->bpp) / 8;
+		last = ((r->x + r->w) * layer->bpp + 7) / 8;
+		for (j = 0; j < r->h; j++) {
+			cache_batch_add(&batch, row + first, last - first);
+			row += bytes_per_row;
+		}
+	}
+	cache_batch_commit(&batch);
+
+	layer->damage_count = 0;
+}
+
+/**
+ * Register a region of the current canvas as modified.
+ * The region is clipped to the canvas and merged with the regions it
+ * touches. When the list is full, it is merged with the region whose
+ * bounding box grows the least.
+ * \param x  X coordinate of the region.
+ * \param y  Y coordinate of the region.
+ * \param w  Region width.
+ * \param h  Region height.
+ */
+void lcdc_add_canvas_damage(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	struct _lcdc_rect *damage = lcdc_canvas.damage;
+	struct _lcdc_rect rect;
+	uint32_t cost, best_cost;
+	uint8_t i, best;
+
+	if (x >= lcdc_canvas.width || y >= lcdc_canvas.height)
+		return;
+	rect.x = x;
+	rect.y = y;
+	rect.w = min_u32(w, lcdc_canvas.width - x);
+	rect.h = min_u32(h, lcdc_canvas.height - y);
+	if (rect.w == 0 || rect.h == 0)
+		return;
+
+	/* Already covered, the common case for consecutive pixels */
+	for (i = 0; i < lcdc_canvas.damage_count; i++) {
+		if (rect.x >= damage[i].x && rect.y >= damage[i].y &&
+		    rect.x + rect.w <= damage[i].x + damage[i].w &&
+		    rect.y + rect.h <= damage[i].y + damage[i].h)
+			return;
+	}
+
+	for (i = 0; i < lcdc_canvas.damage_count; i++) {
+		if (_rect_touch(&damage[i], &rect)) {
+			_rect_union(&damage[i], &rect);
+			_merge_canvas_damage(i);
+			return;
+		}
+	}
+
+	if (lcdc_canvas.damage_count < LCDC_MAX_DAMAGE_RECTS) {
+		damage[lcdc_canvas.damage_count++] = rect;
+		return;
+	}
+
+	best = 0;
+	best_cost = UINT32_MAX;
+	for (i = 0; i < lcdc_canvas.damage_count; i++) {
+		cost = _rect_union_cost(&damage[i], &rect);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+	_rect_union(&damage[best], &rect);
+	_merge_canvas_damage(best);
+}
+
+/**
+ * Get the regions of the current canvas modified since the last flush.
+ * \param rects  Array receiving the damaged regions.
+ * \param max    Size of the rects array.
+ * \return Number of damaged regions, may exceed max.
+ */
+uint8_t lcdc_get_canvas_damage(struct _lcdc_rect *rects, uint8_t max)
+{
+	uint8_t i;
+
+	for (i = 0; i < lcdc_canvas.damage_count && i < max; i++)
+		rects[i] = lcdc_canvas.damage[i];
+	return lcdc_canvas.damage_count;
+}
+
+/**
+ * Forget the damaged regions of the current canvas without flushing them.
+ */
+void lcdc_reset_canvas_damage(void)
+{
+	lcdc_canvas.damage_count = 0;
+}
+
+/**
+ * Attach a swap chain of 2 or 3 buffers to a running RGB layer.
+ * The layer must already display one of the buffers, e.g. after
+ * lcdc_show_base() or lcdc_put_image(): it becomes the front buffer, the
+ * other ones are free. Buffers share the geometry and format of the layer.
+ * \param layer_id Layer ID.
+ * \param buffers  Array of buffer pointers.
+ * \param count    Number of buffers (2 to LCDC_SWAP_CHAIN_MAX).
+ * \param cb       Callback invoked on each completed flip, may be NULL.
+ * \param arg      Callback argument.
+ * \return 1 on success, 0 if the layer or the buffers are not suitable.
+ */
+uint8_t lcdc_create_swap_chain(uint8_t layer_id, void **buffers,
+		uint8_t count, lcdc_swap_callback_t cb, void *arg)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	uint8_t front = SWAP_NONE;
+	uint8_t i;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= LCDC_LAYER_COUNT)
+		return 0;
+	layer = &lcdc_layers[layer_id];
+	if (!layer->data || !layer->reg_enable || !lcdc_is_layer_on(layer_id))
+		return 0;
+	if (count < 2 || count > LCDC_SWAP_CHAIN_MAX)
+		return 0;
+
+	for (i = 0; i < count; i++)
+		if (buffers[i] == layer->data->buffer)
+			front = i;
+	if (front == SWAP_NONE)
+		return 0;
+
+	lcdc_destroy_swap_chain(layer_id);
+
+	chain = &swap_chains[layer_id];
+	for (i = 0; i < count; i++) {
+		chain->buffers[i] = buffers[i];
+		chain->state[i] = (i == front) ? SWAP_FRONT : SWAP_FREE;
+	}
+	chain->front = front;
+	chain->queued = SWAP_NONE;
+	chain->callback = cb;
+	chain->arg = arg;
+	chain->count = count;
+
+	if (!lcdc_irq_installed) {
+		irq_add_handler(ID_LCDC, _lcdc_handler, NULL);
+		irq_enable(ID_LCDC);
+		lcdc_irq_installed = true;
+	}
+	LCDC->LCDC_LCDIER = layer->irq_mask;
+
+	return 1;
+}
+
+/**
+ * Detach the swap chain of a layer. The layer keeps displaying the current
+ * front buffer, a pending presentation may still take effect.
+ * \param layer_id Layer ID.
+ */
+void lcdc_destroy_swap_chain(uint8_t layer_id)
+{
+	const struct _layer_info *layer;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= LCDC_LAYER_COUNT)
+		return;
+	layer = &lcdc_layers[layer_id];
+	if (!swap_chains[layer_id].count)
+		return;
+
+	layer->reg_enable[4] = LCDC_BASEIDR_DSCR;
+	LCDC->LCDC_LCDIDR = layer->irq_mask;
+	swap_chains[layer_id].count = 0;
+}
+
+/**
+ * Get a buffer of the swap chain to draw the next frame on. Never blocks.
+ * \param layer_id Layer ID.
+ * \return Buffer pointer, NULL if every buffer is displayed or in use.
+ */
+void *lcdc_acquire_back_buffer(uint8_t layer_id)
+{
+	struct _swap_chain *chain;
+	uint8_t i;
+
+	if (layer_id >= LCDC_LAYER_COUNT)
+		return NULL;
+	chain = &swap_chains[layer_id];
+
+	for (i = 0; i < chain->count; i++) {
+		if (chain->state[i] == SWAP_FREE) {
+			chain->state[i] = SWAP_ACQUIRED;
+			return chain->buffers[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Queue an acquired buffer for display. The layer DMA switches to it at the
+ * start of the next frame, the flip being reported by the swap chain
+ * callback. Only one buffer can be pending at a time.
+ * \note The data cache must be cleaned on the buffer beforehand.
+ * \param layer_id Layer ID.
+ * \param buffer   Buffer returned by lcdc_acquire_back_buffer().
+ * \return 1 on success, 0 if the buffer was not acquired or if a buffer is
+ * already pending.
+ */
+uint8_t lcdc_present_buffer(uint8_t layer_id, void *buffer)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	struct _lcdc_dma_desc *desc;
+	uint8_t i;
+
+	if (layer_id >= LCDC_LAYER_COUNT)
+		return 0;
+	layer = &lcdc_layers[layer_id];
+	chain = &swap_chains[layer_id];
+
+	if (chain->queued != SWAP_NONE)
+		return 0;
+	for (i = 0; i < chain->count; i++)
+		if (chain->buffers[i] == buffer)
+			break;
+	if (i == chain->count || chain->state[i] != SWAP_ACQUIRED)
+		return 0;
+
+	desc = &swap_dma_desc[layer_id][i];
+	desc->addr = (uint32_t)buffer;
+	desc->ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_DSCRIEN;
+	desc->next = (uint32_t)desc;
+	cache_clean_region(desc, sizeof(*desc));
+
+	chain->state[i] = SWAP_QUEUED;
+	chain->queued = i;
+
+	/* Drop a stale status, then add the descriptor to the queue: it is
+	 * loaded at the next frame start */
+	(void)layer->reg_enable[6];
+	layer->reg_dma_head[0] = (uint32_t)desc;
+	layer->reg_enable[0] = LCDC_BASECHER_A2QEN;
+	layer->reg_enable[3] = LCDC_BASEIER_DSCR;
 
-	layer = lcdc_get_canvas();
-	cache_clean_region(layer->buffer, layer->height * layer->width * 4);
+	return 1;
 }
 
 /**
  * Select an LCD layer as canvas layer.
  * Then all drawing operations will apply to current display buffer
- * of selected layer.
+ * of selected layer. Damaged regions of the previous canvas are flushed.
  * \note If there is no display buffer for the layer (not running)
  *       selection fails.
  * \param layer_id Layer ID.
@@ -1607,6 +2150,9 @@ uint8_t lcdc_select_canvas(uint8_t layer_id)
 	if (!layer->reg_cfg || !layer->data)
 		return 0;
 
+	/* Pending damage belongs to the previous canvas */
+	lcdc_flush_canvas();
+
 	lcdc_canvas.buffer = (void *)layer->data->buffer;
 	if (layer->reg_win) {
 		lcdc_canvas.width = (layer->reg_win[1] & LCDC_HEOCFG3_XSIZE_Msk) >> LCDC_HEOCFG3_XSIZE_Pos;
@@ -1630,7 +2176,8 @@ uint8_t lcdc_select_canvas(uint8_t layer_id)
  * \param y        Canvas Y coordinate on base.
  * \param w        Canvas width.
  * \param h        Canvas height.
- * \note The content in buffer is destroied.
+ * \note The content in buffer is destroied. Damaged regions of the
+ *       previous canvas are flushed.
  */
 void * lcdc_create_canvas(uint8_t layer_id, void *buffer, uint8_t bpp,
 			  uint16_t x, uint16_t y, uint16_t w, uint16_t h)
@@ -1662,6 +2209,9 @@ void * lcdc_create_canvas(uint8_t layer_id, void *buffer, uint8_t bpp,
 	if (h == 0)
 		h = max_h - y;
 
+	/* Pending damage belongs to the previous canvas */
+	lcdc_flush_canvas();
+
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
@@ -1676,6 +2226,9 @@ void * lcdc_create_canvas(uint8_t layer_id, void *buffer, uint8_t bpp,
 	lcdc_canvas.width = w;
 	lcdc_canvas.height = h;
 
+	/* Cleared buffer must reach memory */
+	lcdc_add_canvas_damage(0, 0, w, h);
+
 	return old_buffer;
 }
 
@@ -1712,6 +2265,9 @@ void *lcdc_create_canvas_yuv_planar(uint8_t layer_id,
 	if (h == 0)
 		h = max_h - y;
 
+	/* Pending damage belongs to the previous canvas */
+	lcdc_flush_canvas();
+
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
@@ -1763,6 +2319,9 @@ void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer_id,
 	if (h == 0)
 		h = max_h - y;
 
+	/* Pending damage belongs to the previous canvas */
+	lcdc_flush_canvas();
+
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
@@ -49,6 +49,11 @@
  * -# lcdc_set_backlight() is used to change LCD backlight level.
  * -# To display a image (BMP format) on LCD, lcdc_put_image_rotated()
  *    lcdc_put_image_scaled() and lcdc_put_image() can be used.
+ * -# To display a sequence of images with the same geometry (e.g. video
+ *    frames), compute the layer settings once with
+ *    lcdc_prepare_image_transform() and lcdc_apply_image_transform(), then
+ *    use lcdc_update_image_transform() for each frame: only the frame
+ *    address is updated.
  * -# To change configuration for an overlay layer, the following functions
  *    can use:
  *    -# lcdc_enable_layer(), lcdc_is_layer_on(): Turn ON/OFF layer, check status.
@@ -63,6 +68,12 @@
  *                            drawing on
  *    -# lcdc_select_canvas(): Select a displayer as canvas to drawing on
  *    -# lcdc_get_canvas():    Get current selected canvas layer
+ *    -# lcdc_add_canvas_damage(): Register a region modified by drawing
+ *    -# lcdc_flush_canvas():  Clean the damaged regions from the data cache
+ * -# Tear-free animation with 2 or 3 buffers per layer:
+ *    -# lcdc_create_swap_chain(): Attach buffers to a layer showing the first
+ *    -# lcdc_acquire_back_buffer(): Get a buffer to draw on, NULL if none
+ *    -# lcdc_present_buffer(): Show a buffer from the next frame start
  *
  * For LCD drawing functions, refer to \ref lcdc_draw.
  *
@@ -119,6 +130,29 @@ enum {
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** Maximum number of damaged regions tracked on the canvas */
+#ifndef LCDC_MAX_DAMAGE_RECTS
+#define LCDC_MAX_DAMAGE_RECTS 8
+#endif
+
+/** Maximum number of buffers in a layer swap chain */
+#define LCDC_SWAP_CHAIN_MAX 3
+
+/**
+ * Swap chain callback, invoked from interrupt context when a presented
+ * buffer has been loaded by the layer DMA at the start of a frame. The
+ * previous front buffer can be acquired again from this point.
+ */
+typedef void (*lcdc_swap_callback_t)(uint8_t layer_id, void *front, void *arg);
+
+/** Rectangle on a layer, in pixels */
+struct _lcdc_rect {
+	uint16_t x;        /**< Left column */
+	uint16_t y;        /**< Top row */
+	uint16_t w;        /**< Width */
+	uint16_t h;        /**< Height */
+};
+
 /** LCD display layer information */
 struct _lcdc_layer {
 	void    *buffer;   /**< Display image buffer */
@@ -126,6 +160,22 @@ struct _lcdc_layer {
 	uint16_t height;   /**< Display image height */
 	uint8_t  bpp;      /**< Image BPP (16,24,32) for RGB mode */
 	uint8_t  layer_id; /**< Layer ID */
+	uint8_t  damage_count; /**< Number of valid entries in damage[] */
+	struct _lcdc_rect damage[LCDC_MAX_DAMAGE_RECTS]; /**< Regions modified since last flush */
+};
+
+/** Layer register state precomputed by lcdc_prepare_image_transform() */
+struct _lcdc_image_transform {
+	uint8_t  layer_id; /**< Layer ID */
+	uint32_t cfg0;     /**< Burst & rotation settings */
+	uint32_t cfg1;     /**< RGB/YUV mode */
+	uint32_t xstride;  /**< Line stride */
+	uint32_t pstride;  /**< Pixel stride */
+	uint32_t pos;      /**< Window position */
+	uint32_t size;     /**< Window size */
+	uint32_t mem_size; /**< Source image size */
+	uint32_t scale;    /**< Scaling factors */
+	uint32_t offset;   /**< Offset of the first fetched byte in the image */
 };
 
 /** LCD configuration information */
@@ -185,6 +235,17 @@ extern void *lcdc_put_image_scaled(uint8_t layer, void *buffer, uint8_t bpp,
 extern void *lcdc_put_image(uint8_t layer, void *buffer, uint8_t bpp,
 		uint32_t x, uint32_t y, int32_t w, int32_t h);
 
+extern uint8_t lcdc_prepare_image_transform(
+		struct _lcdc_image_transform *transform, uint8_t layer_id,
+		uint8_t bpp, uint32_t x, uint32_t y, int32_t w, int32_t h,
+		uint32_t img_w, uint32_t img_h, int16_t rotation);
+
+extern void *lcdc_apply_image_transform(
+		const struct _lcdc_image_transform *transform, void *buffer);
+
+extern void *lcdc_update_image_transform(
+		const struct _lcdc_image_transform *transform, void *buffer);
+
 extern void *lcdc_show_base(void *buffer, uint8_t bpp, bool bottom_up);
 
 extern void lcdc_stop_base(void);
@@ -215,6 +276,21 @@ extern void *lcdc_create_canvas(uint8_t layer, void *buffer, uint8_t bpp,
 
 extern void lcdc_flush_canvas(void);
 
+extern void lcdc_add_canvas_damage(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+extern uint8_t lcdc_get_canvas_damage(struct _lcdc_rect *rects, uint8_t max);
+
+extern void lcdc_reset_canvas_damage(void);
+
+extern uint8_t lcdc_create_swap_chain(uint8_t layer_id, void **buffers,
+		uint8_t count, lcdc_swap_callback_t cb, void *arg);
+
+extern void lcdc_destroy_swap_chain(uint8_t layer_id);
+
+extern void *lcdc_acquire_back_buffer(uint8_t layer_id);
+
+extern uint8_t lcdc_present_buffer(uint8_t layer_id, void *buffer);
+
 extern void lcdc_configure_input_mode(uint8_t layer, uint32_t input_mode);
 
 extern uint32_t lcdc_configure_get_mode(uint8_t layer);
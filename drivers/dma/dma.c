@@ -156,6 +156,27 @@ static inline bool is_dest_periph(struct _dma_channel* channel)
 	return ((channel->dest_txif != 0xff) | (channel->dest_rxif != 0xff));
 }
 
+#if defined(CONFIG_HAVE_XDMAC)
+/**
+ * \brief Memory burst size for memory to memory transfers. The chunk size
+ * only applies to peripheral synchronized transfers, use it as burst length
+ * when both sides are memories.
+ */
+static uint32_t _xdmac_mem_burst(uint32_t chunk_size)
+{
+	switch (chunk_size) {
+	case DMA_CHUNK_SIZE_4:
+		return XDMAC_CC_MBSIZE_FOUR;
+	case DMA_CHUNK_SIZE_8:
+		return XDMAC_CC_MBSIZE_EIGHT;
+	case DMA_CHUNK_SIZE_16:
+		return XDMAC_CC_MBSIZE_SIXTEEN;
+	default:
+		return XDMAC_CC_MBSIZE_SINGLE;
+	}
+}
+#endif
+
 /**
  * \brief Preinitialize all descriptors and pool and link them together
  */
@@ -295,6 +316,7 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 
 	DMA_DESC_SET_SADDR(&desc, cfg->saddr);
 	DMA_DESC_SET_DADDR(&desc, cfg->daddr);
+	channel->loop = false;
 
 #if defined(CONFIG_HAVE_XDMAC)
 	if (src_is_periph || dst_is_periph)
@@ -309,6 +331,7 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 	desc.cfg |= cfg_dma->incr_saddr ? XDMAC_CC_SAM_INCREMENTED_AM : XDMAC_CC_SAM_FIXED_AM;
 	desc.cfg |= cfg_dma->incr_daddr ? XDMAC_CC_DAM_INCREMENTED_AM : XDMAC_CC_DAM_FIXED_AM;
 	desc.cfg |= (src_is_periph || dst_is_periph) ? 0 : XDMAC_CC_SWREQ_SWR_CONNECTED;
+	desc.cfg |= (src_is_periph || dst_is_periph) ? 0 : _xdmac_mem_burst(cfg_dma->chunk_size);
 	desc.ds = 0;
 	desc.sus = 0;
 	desc.dus = 0;
@@ -427,6 +450,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 		curr = DMA_SG_DESC_GET_NEXT(curr);
 	}
 	channel->sg_list = _sg_head;
+	channel->loop = cfg_dma->loop;
 
 	cache_clean_region(_dma_sg_pool.desc, sizeof(_dma_sg_pool.desc));
 
@@ -434,6 +458,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 #if defined(CONFIG_HAVE_XDMAC)
 	struct _xdmacd_cfg xdmacd_cfg;
 	uint32_t desc_ctrl;
+	int err;
 
 	xdmacd_cfg.cfg = (src_is_periph | dst_is_periph) ? XDMAC_CC_TYPE_PER_TRAN : XDMAC_CC_TYPE_MEM_TRAN;
 	xdmacd_cfg.cfg |= src_is_periph ? XDMAC_CC_DSYNC_PER2MEM : XDMAC_CC_DSYNC_MEM2PER;
@@ -444,6 +469,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	xdmacd_cfg.cfg |= cfg_dma->incr_saddr ? XDMAC_CC_SAM_INCREMENTED_AM : XDMAC_CC_SAM_FIXED_AM;
 	xdmacd_cfg.cfg |= cfg_dma->incr_daddr ? XDMAC_CC_DAM_INCREMENTED_AM : XDMAC_CC_DAM_FIXED_AM;
 	xdmacd_cfg.cfg |= (src_is_periph | dst_is_periph) ? 0 : XDMAC_CC_SWREQ_SWR_CONNECTED;
+	xdmacd_cfg.cfg |= (src_is_periph | dst_is_periph) ? 0 : _xdmac_mem_burst(cfg_dma->chunk_size);
 	xdmacd_cfg.bc = 0;
 	xdmacd_cfg.ds = 0;
 	xdmacd_cfg.sus = 0;
@@ -454,7 +480,15 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	           | XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
 	           | XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED;
 
-	return xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	err = xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	if (err < 0)
+		return err;
+
+	/* A looping list never ends: report each completed item instead */
+	if (cfg_dma->loop)
+		xdmac_enable_channel_it(channel->hw, channel->id, XDMAC_CIE_BIE);
+
+	return 0;
 #elif defined(CONFIG_HAVE_DMAC)
 	struct _dmacd_cfg dmacd_cfg;
 
@@ -569,12 +603,16 @@ struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 
 int dma_reset_channel(struct _dma_channel* channel)
 {
-	if (channel->state == DMA_STATE_ALLOCATED)
-		return 0;
-
 	if (channel->state == DMA_STATE_STARTED)
 		return -EBUSY;
 
+	if (channel->state == DMA_STATE_ALLOCATED) {
+		/* Stopped transfers may still own a descriptor list */
+		_dma_sg_desc_free(channel->sg_list);
+		channel->sg_list = NULL;
+		return 0;
+	}
+
 #if defined(CONFIG_HAVE_XDMAC)
 	/* Disable interrupts */
 	xdmac_disable_channel_it(channel->hw, channel->id, -1);
@@ -721,6 +759,24 @@ uint32_t dma_get_transferred_data_len(struct _dma_channel* channel, uint8_t chun
 #endif
 }
 
+uint32_t dma_get_src_addr(struct _dma_channel* channel)
+{
+#if defined(CONFIG_HAVE_XDMAC)
+	return xdmac_get_channel_src_addr(channel->hw, channel->id);
+#elif defined(CONFIG_HAVE_DMAC)
+	return dmac_get_channel_src_addr(channel->hw, channel->id);
+#endif
+}
+
+uint32_t dma_get_dest_addr(struct _dma_channel* channel)
+{
+#if defined(CONFIG_HAVE_XDMAC)
+	return xdmac_get_channel_dest_addr(channel->hw, channel->id);
+#elif defined(CONFIG_HAVE_DMAC)
+	return dmac_get_channel_dest_addr(channel->hw, channel->id);
+#endif
+}
+
 int dma_set_callback(struct _dma_channel* channel, struct _callback* cb)
 {
 	if (channel->state == DMA_STATE_FREE)
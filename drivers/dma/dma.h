@@ -132,6 +132,7 @@ struct _dma_channel {
 	volatile uint32_t rep_count;/* repeat count in auto mode */
 #endif
 	volatile uint8_t state;		/* Channel State */
+	bool loop;					/* Looping linked list, callback per block */
 
 	struct _dma_sg_desc* sg_list;
 };
@@ -147,7 +148,8 @@ struct _dma_cfg {
 	uint32_t chunk_size;
 	bool incr_saddr;
 	bool incr_daddr;
-	bool loop; /* Used by scatter/gather only */
+	bool loop; /* Used by scatter/gather only, the callback is called after
+	              each completed list item and the channel keeps running */
 };
 
 struct _dma_controller {
@@ -275,6 +277,18 @@ extern void dma_fifo_flush(struct _dma_channel* channel);
  */
 extern uint32_t dma_get_transferred_data_len(struct _dma_channel* channel, uint8_t chunk_size, uint32_t len);
 
+/**
+ * \brief Source address the DMA channel is currently working on
+ * \param channel Channel pointer
+ */
+extern uint32_t dma_get_src_addr(struct _dma_channel* channel);
+
+/**
+ * \brief Destination address the DMA channel is currently working on
+ * \param channel Channel pointer
+ */
+extern uint32_t dma_get_dest_addr(struct _dma_channel* channel);
+
 /**
  * \brief DMA interrupt handler
  * \param source Peripheral ID of DMA controller
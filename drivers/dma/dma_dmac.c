@@ -187,6 +187,9 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 				channel->state = DMA_STATE_DONE;
 				exec = 1;
 			}
+		} else if (channel->loop && (gis & (DMAC_EBCISR_BTC0 << chan))) {
+			/* Looping list: one buffer done, channel still running */
+			exec = 1;
 		}
 		/* Execute callback */
 		if (exec)
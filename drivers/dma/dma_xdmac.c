@@ -199,6 +199,10 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 				channel->state = DMA_STATE_DONE;
 				exec = 1;
 			}
+		} else if (channel->loop) {
+			/* Looping list: one block done, channel still running */
+			if (xdmac_get_channel_isr(xdmac, chan) & XDMAC_CIS_BIS)
+				exec = 1;
 		}
 
 		/* Execute callback */
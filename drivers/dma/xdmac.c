@@ -307,6 +307,13 @@ void xdmac_set_dest_microblock_stride(Xdmac *xdmac, uint8_t channel,
 	xdmac->XDMAC_CH[channel].XDMAC_CDUS = dubs;
 }
 
+uint32_t xdmac_get_channel_src_addr(Xdmac *xdmac, uint8_t channel)
+{
+	assert(channel < XDMAC_CHANNELS);
+
+	return xdmac->XDMAC_CH[channel].XDMAC_CSA;
+}
+
 uint32_t xdmac_get_channel_dest_addr(Xdmac *xdmac, uint8_t channel)
 {
 	assert(channel < XDMAC_CHANNELS);
@@ -116,6 +116,14 @@ extern void aic_enable(uint32_t source);
  */
 extern void aic_disable(uint32_t source);
 
+/**
+ * \brief Tell if interrupts coming from the given source (ID_xxx) are
+ * enabled.
+ *
+ * \param source  Interrupt source to check
+ */
+extern bool aic_is_enabled(uint32_t source);
+
 /**
  * \brief Get the current interrupt source number
  *
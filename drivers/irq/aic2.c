@@ -132,6 +132,11 @@ void aic_disable(uint32_t source)
 	AIC->AIC_IDCR = 1 << source;
 }
 
+bool aic_is_enabled(uint32_t source)
+{
+	return (AIC->AIC_IMR & (1 << source)) != 0;
+}
+
 uint32_t aic_get_current_interrupt_source(void)
 {
 	return AIC->AIC_ISR;
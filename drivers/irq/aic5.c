@@ -182,6 +182,13 @@ void aic_disable(uint32_t source)
 	aic->AIC_IDCR = AIC_IDCR_INTD;
 }
 
+bool aic_is_enabled(uint32_t source)
+{
+	Aic* aic = _get_aic_instance(source);
+	aic->AIC_SSR = AIC_SSR_INTSEL(source);
+	return (aic->AIC_IMR & AIC_IMR_INTM) != 0;
+}
+
 uint32_t aic_get_current_interrupt_source(void)
 {
 	return AIC->AIC_ISR;
@@ -226,3 +226,14 @@ void irq_disable(uint32_t source)
 #error Unknown IRQ controller!
 #endif
 }
+
+bool irq_is_enabled(uint32_t source)
+{
+#if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
+	return aic_is_enabled(source);
+#elif defined(CONFIG_HAVE_NVIC)
+	return nvic_is_enabled(source);
+#else
+#error Unknown IRQ controller!
+#endif
+}
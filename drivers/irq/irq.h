@@ -34,6 +34,7 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef void (*irq_handler_t)(uint32_t source, void* user_arg);
@@ -116,6 +117,14 @@ extern void irq_enable(uint32_t source);
  */
 extern void irq_disable(uint32_t source);
 
+/**
+ * \brief Tell if interrupts coming from the given source (ID_xxx) are
+ * enabled.
+ *
+ * \param source  Interrupt source to check
+ */
+extern bool irq_is_enabled(uint32_t source);
+
 #ifdef __cplusplus
 }
 #endif
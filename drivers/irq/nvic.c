@@ -97,6 +97,13 @@ void nvic_disable(uint32_t source)
 	NVIC->NVIC_ICER[index] = bit;
 }
 
+bool nvic_is_enabled(uint32_t source)
+{
+	uint32_t index = source >> 5;
+	uint32_t bit = 1 << (source & 0x1f);
+	return (NVIC->NVIC_ISER[index] & bit) != 0;
+}
+
 uint32_t nvic_get_current_interrupt_source(void)
 {
 	uint32_t ipsr;
@@ -95,6 +95,14 @@ extern void nvic_enable(uint32_t source);
  */
 extern void nvic_disable(uint32_t source);
 
+/**
+ * \brief Tell if interrupts coming from the given source (ID_xxx) are
+ * enabled.
+ *
+ * \param source  Interrupt source to check
+ */
+extern bool nvic_is_enabled(uint32_t source);
+
 /**
  * \brief Get the current interrupt source number
  *
@@ -37,6 +37,55 @@
 #include "mm/l1cache.h"
 #include "mm/l2cache.h"
 
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _cache_batch_process(struct _cache_batch* batch)
+{
+#ifdef CONFIG_HAVE_L1CACHE
+	int i;
+
+	if (!dcache_is_enabled())
+		return;
+
+	if (batch->size >= CACHE_BATCH_WHOLE_THRESHOLD) {
+		/* Invalidating the whole cache would discard unrelated dirty
+		 * lines, so clean them out as well */
+		if (batch->op == CACHE_OP_CLEAN)
+			dcache_clean();
+		else
+			dcache_clean_invalidate();
+#ifdef CONFIG_HAVE_L2CACHE
+		if (batch->op == CACHE_OP_CLEAN)
+			l2cache_clean();
+		else
+			l2cache_clean_invalidate();
+#endif /* CONFIG_HAVE_L2CACHE */
+		return;
+	}
+
+	for (i = 0; i < batch->count; i++) {
+		if (batch->op == CACHE_OP_CLEAN)
+			dcache_clean_region(batch->range[i].start, batch->range[i].end);
+		else
+			dcache_invalidate_region(batch->range[i].start, batch->range[i].end);
+	}
+
+#ifdef CONFIG_HAVE_L2CACHE
+	for (i = 0; i < batch->count; i++) {
+		if (batch->op == CACHE_OP_CLEAN)
+			l2cache_clean_region(batch->range[i].start, batch->range[i].end);
+		else
+			l2cache_invalidate_region(batch->range[i].start, batch->range[i].end);
+	}
+	l2cache_sync();
+#endif /* CONFIG_HAVE_L2CACHE */
+#endif /* CONFIG_HAVE_L1CACHE */
+}
+
 /*----------------------------------------------------------------------------
  *        Functions
  *----------------------------------------------------------------------------*/
@@ -72,3 +121,97 @@ void cache_clean_region(const void *start, uint32_t length)
 	}
 #endif /* CONFIG_HAVE_L1CACHE */
 }
+
+void cache_batch_init(struct _cache_batch* batch, enum _cache_op op)
+{
+	batch->op = op;
+	batch->count = 0;
+	batch->size = 0;
+}
+
+void cache_batch_add(struct _cache_batch* batch, const void* start,
+		uint32_t length)
+{
+	uint32_t first, last;
+	int i, j;
+
+	if (length == 0)
+		return;
+
+	first = ((uint32_t)start) & ~(L1_CACHE_BYTES - 1);
+	last = (((uint32_t)start) + length + L1_CACHE_BYTES - 1) & ~(L1_CACHE_BYTES - 1);
+
+	/* Ranges are kept sorted and disjoint: find insertion point */
+	for (i = 0; i < batch->count; i++)
+		if (first <= batch->range[i].end)
+			break;
+
+	if (i < batch->count && last >= batch->range[i].start) {
+		/* Overlapping or adjacent: extend range i */
+		batch->size -= batch->range[i].end - batch->range[i].start;
+		if (first < batch->range[i].start)
+			batch->range[i].start = first;
+		if (last > batch->range[i].end)
+			batch->range[i].end = last;
+
+		/* Absorb following ranges now covered by range i */
+		for (j = i + 1; j < batch->count; j++) {
+			if (batch->range[j].start > batch->range[i].end)
+				break;
+			batch->size -= batch->range[j].end - batch->range[j].start;
+			if (batch->range[j].end > batch->range[i].end)
+				batch->range[i].end = batch->range[j].end;
+		}
+		if (j > i + 1) {
+			memmove(&batch->range[i + 1], &batch->range[j],
+			        (batch->count - j) * sizeof(batch->range[0]));
+			batch->count -= j - i - 1;
+		}
+		batch->size += batch->range[i].end - batch->range[i].start;
+		return;
+	}
+
+	if (batch->count == CACHE_BATCH_MAX_RANGES) {
+		/* No room left: process pending ranges and start over */
+		cache_batch_commit(batch);
+		i = 0;
+	}
+
+	memmove(&batch->range[i + 1], &batch->range[i],
+	        (batch->count - i) * sizeof(batch->range[0]));
+	batch->range[i].start = first;
+	batch->range[i].end = last;
+	batch->count++;
+	batch->size += last - first;
+}
+
+void cache_batch_commit(struct _cache_batch* batch)
+{
+	if (batch->count)
+		_cache_batch_process(batch);
+
+	batch->count = 0;
+	batch->size = 0;
+}
+
+void cache_clean_regions(const struct _cache_region* regions, uint32_t count)
+{
+	struct _cache_batch batch;
+	uint32_t i;
+
+	cache_batch_init(&batch, CACHE_OP_CLEAN);
+	for (i = 0; i < count; i++)
+		cache_batch_add(&batch, regions[i].start, regions[i].length);
+	cache_batch_commit(&batch);
+}
+
+void cache_invalidate_regions(const struct _cache_region* regions, uint32_t count)
+{
+	struct _cache_batch batch;
+	uint32_t i;
+
+	cache_batch_init(&batch, CACHE_OP_INVALIDATE);
+	for (i = 0; i < count; i++)
+		cache_batch_add(&batch, regions[i].start, regions[i].length);
+	cache_batch_commit(&batch);
+}
@@ -103,6 +103,51 @@
  */
 #define IS_CACHE_ALIGNED(x) ((((uint32_t)(x)) & (L1_CACHE_BYTES - 1)) == 0)
 
+/**
+ * Maximum number of distinct ranges tracked by a cache maintenance batch.
+ * When a batch is full, pending ranges are processed before adding more.
+ */
+#ifndef CACHE_BATCH_MAX_RANGES
+#define CACHE_BATCH_MAX_RANGES 8
+#endif
+
+/**
+ * Total size (in bytes) above which a cache maintenance batch operates on the
+ * whole data cache by set/way instead of walking each range line by line.
+ * Default is the size of the L1 data cache.
+ */
+#ifndef CACHE_BATCH_WHOLE_THRESHOLD
+#define CACHE_BATCH_WHOLE_THRESHOLD \
+	(L1_CACHE_WAYS * L1_CACHE_SETS * L1_CACHE_BYTES)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Cache maintenance operation applied by a batch */
+enum _cache_op {
+	CACHE_OP_CLEAN,      /**< write back dirty lines (before DMA reads memory) */
+	CACHE_OP_INVALIDATE, /**< discard lines (after DMA wrote memory) */
+};
+
+/** Memory region, as given to cache_clean_regions/cache_invalidate_regions */
+struct _cache_region {
+	const void* start;
+	uint32_t length;
+};
+
+/** Batch of cache maintenance ranges, merged and processed in one go */
+struct _cache_batch {
+	enum _cache_op op;
+	uint8_t count;     /**< number of valid entries in range[] */
+	uint32_t size;     /**< total size of all ranges, in bytes */
+	struct {
+		uint32_t start;  /**< first byte, aligned on a cache line */
+		uint32_t end;    /**< end of range (exclusive), aligned on a cache line */
+	} range[CACHE_BATCH_MAX_RANGES];
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -123,4 +168,55 @@ extern void cache_invalidate_region(void *start, uint32_t length);
  */
 extern void cache_clean_region(const void *start, uint32_t length);
 
+/**
+ *  \brief Initialize an empty cache maintenance batch
+ *
+ *  \param batch Pointer to the batch to initialize
+ *  \param op Operation to apply when the batch is processed
+ */
+extern void cache_batch_init(struct _cache_batch* batch, enum _cache_op op);
+
+/**
+ *  \brief Add a memory region to a cache maintenance batch
+ *
+ *  The region is rounded to cache lines and merged with any overlapping or
+ *  adjacent range already in the batch.  If the batch is full, the pending
+ *  ranges are processed first.
+ *
+ *  \param batch Pointer to the batch
+ *  \param start Beginning of the memory region
+ *  \param length Length of the memory region
+ */
+extern void cache_batch_add(struct _cache_batch* batch, const void* start,
+		uint32_t length);
+
+/**
+ *  \brief Process all ranges of a cache maintenance batch
+ *
+ *  If the total size exceeds CACHE_BATCH_WHOLE_THRESHOLD, the whole data cache
+ *  is cleaned (resp. cleaned and invalidated) instead.  The L2 cache is
+ *  synchronized only once, at the end.  The batch is empty on return.
+ *
+ *  \param batch Pointer to the batch
+ */
+extern void cache_batch_commit(struct _cache_batch* batch);
+
+/**
+ *  \brief Clean cache lines corresponding to a list of memory regions
+ *
+ *  \param regions Array of memory regions
+ *  \param count Number of entries in regions
+ */
+extern void cache_clean_regions(const struct _cache_region* regions,
+		uint32_t count);
+
+/**
+ *  \brief Invalidate cache lines corresponding to a list of memory regions
+ *
+ *  \param regions Array of memory regions
+ *  \param count Number of entries in regions
+ */
+extern void cache_invalidate_regions(const struct _cache_region* regions,
+		uint32_t count);
+
 #endif /* #ifndef CACHE_H_ */
@@ -385,6 +385,12 @@ void l2cache_clean_invalidate_region(uint32_t start, uint32_t end)
 	}
 }
 
+void l2cache_sync(void)
+{
+	if (l2cache_is_enabled())
+		l2cc_cache_sync();
+}
+
 void l2cc_configure(const struct _l2cc_config* cfg)
 {
 	assert(!l2cache_is_enabled());
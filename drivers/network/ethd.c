@@ -35,6 +35,7 @@
 
 #include "barriers.h"
 #include "trace.h"
+#include "intmath.h"
 #include "ring.h"
 
 #ifdef CONFIG_HAVE_EMAC
@@ -58,6 +59,64 @@
  *        Local functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * Copy a complete received frame (descriptors from rx_head up to, but not
+ * including, end) into the application buffer.  All RX units of the frame are
+ * invalidated in a single cache maintenance batch before being copied.
+ */
+static uint8_t _ethd_read_frame(struct _ethd_queue* q, uint32_t end,
+		uint8_t* buffer, uint32_t buffer_size, uint32_t* recv_size)
+{
+	struct _eth_desc *desc;
+	struct _cache_batch batch;
+	uint32_t idx, length, frame_size;
+
+	/* Invalidate the frame content (consecutive RX units are merged) */
+	cache_batch_init(&batch, CACHE_OP_INVALIDATE);
+	frame_size = 0;
+	idx = q->rx_head;
+	while (idx != end) {
+		desc = &q->rx_desc[idx];
+		length = min_u32(ETH_RX_UNITSIZE, buffer_size - frame_size);
+		cache_batch_add(&batch, (void*)(desc->addr & ETH_RX_ADDR_MASK), length);
+		frame_size += length;
+		RING_INC(idx, q->rx_size);
+	}
+	cache_batch_commit(&batch);
+
+	/* Copy the buffers into the application frame */
+	frame_size = 0;
+	idx = q->rx_head;
+	while (idx != end) {
+		desc = &q->rx_desc[idx];
+		length = min_u32(ETH_RX_UNITSIZE, buffer_size - frame_size);
+		memcpy(&buffer[frame_size], (void*)(desc->addr & ETH_RX_ADDR_MASK), length);
+		frame_size += length;
+		RING_INC(idx, q->rx_size);
+	}
+
+	/* Frame size and checksum status from the ETH (status of the EOF
+	 * descriptor, the last one before end) */
+	desc = &q->rx_desc[(end + q->rx_size - 1) % q->rx_size];
+	*recv_size = desc->status & ETH_RX_STATUS_LENGTH_MASK;
+	q->rx_csum = desc->status & ETH_RX_STATUS_CSUM_MASK;
+
+	/* Application frame buffer is too small all data have not been
+	 * copied */
+	if (frame_size < *recv_size)
+		return ETH_SIZE_TOO_SMALL;
+
+	/* All data have been copied in the application frame buffer =>
+	 * release descriptors */
+	while (q->rx_head != end) {
+		desc = &q->rx_desc[q->rx_head];
+		desc->addr &= ~ETH_RX_ADDR_OWN;
+		RING_INC(q->rx_head, q->rx_size);
+	}
+
+	return ETH_OK;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -76,6 +135,7 @@ bool ethd_configure(struct _ethd * ethd, enum _eth_type eth_type, void * addr, u
 {
 	ethd->addr = addr;
 	ethd->op = NULL;
+	ethd->offload = 0;
 
 #ifdef CONFIG_HAVE_EMAC
 	if (ETH_TYPE_EMAC == eth_type)
@@ -108,6 +168,7 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 	void* eth = ethd->addr;
 	struct _ethd_queue* q = &ethd->queues[queue];
 	struct _eth_desc* desc;
+	struct _cache_batch batch;
 	uint16_t idx, tx_head;
 	int i;
 
@@ -131,6 +192,28 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 		return ETH_TX_BUSY;
 	}
 
+	/* Copy data into transmission buffers, cleaning them all at once
+	 * (consecutive TX units are merged into a single cache range) */
+	cache_batch_init(&batch, CACHE_OP_CLEAN);
+	idx = q->tx_head;
+	for (i = 0; i < sgl->size; i++) {
+		const struct _eth_sg *sg = &sgl->entries[i];
+
+		if (sg->size > ETH_TX_UNITSIZE) {
+			trace_error("ethd_send_sg: buffer size is too big.\r\n");
+			return ETH_PARAM;
+		}
+
+		if (sg->buffer && sg->size) {
+			desc = &q->tx_desc[idx];
+			memcpy((void*)desc->addr, sg->buffer, sg->size);
+			cache_batch_add(&batch, (void*)desc->addr, sg->size);
+		}
+
+		RING_INC(idx, q->tx_size);
+	}
+	cache_batch_commit(&batch);
+
 	/* Tag end of TX queue */
 	tx_head = fixed_mod(q->tx_head + sgl->size, q->tx_size);
 	idx = tx_head;
@@ -146,11 +229,6 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 		const struct _eth_sg *sg = &sgl->entries[i];
 		uint32_t status;
 
-		if (sg->size > ETH_TX_UNITSIZE) {
-			trace_error("ethd_send_sg: buffer size is too big.\r\n");
-			return ETH_PARAM;
-		}
-
 		RING_DEC(idx, q->tx_size);
 
 		/* Reset TX callback */
@@ -159,12 +237,6 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 
 		desc = &q->tx_desc[idx];
 
-		/* Copy data into transmittion buffer */
-		if (sg->buffer && sg->size) {
-			memcpy((void*)desc->addr, sg->buffer, sg->size);
-			cache_clean_region((void*)desc->addr, sg->size);
-		}
-
 		/* Compute buffer descriptor status word */
 		status = sg->size & ETH_RX_STATUS_LENGTH_MASK;
 		if (i == (sgl->size - 1)) {
@@ -224,14 +296,14 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 	struct _ethd_queue* q = &ethd->queues[queue];
 	struct _eth_desc *desc;
 	uint32_t idx;
-	uint32_t cur_frame_size = 0;
-	uint8_t *cur_frame = 0;
+	bool sof = false;
 
 	if (!buffer)
 		return ETH_PARAM;
 
 	/* Set the default return value */
 	*recv_size = 0;
+	q->rx_csum = ETH_RX_STATUS_CSUM_NONE;
 
 	/* Process RX descriptors */
 	idx = q->rx_head;
@@ -245,15 +317,14 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 				desc->addr &= ~ETH_RX_ADDR_OWN;
 				RING_INC(q->rx_head, q->rx_size);
 			}
-			cur_frame = buffer;
-			cur_frame_size = 0;
+			desc = &q->rx_desc[idx];
+			sof = true;
 		}
 
 		/* Increment the index */
 		RING_INC(idx, q->rx_size);
 
-		/* Copy data in the frame buffer */
-		if (cur_frame) {
+		if (sof) {
 			if (idx == q->rx_head) {
 				trace_info("no EOF (buffers probably too small)\r\n");
 
@@ -265,39 +336,9 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 				return ETH_RX_NULL;
 			}
 
-			/* Copy the buffer into the application frame */
-			uint32_t length = ETH_RX_UNITSIZE;
-			if ((cur_frame_size + length) > buffer_size) {
-				length = buffer_size - cur_frame_size;
-			}
-
-			void* addr = (void*)(desc->addr & ETH_RX_ADDR_MASK);
-			cache_invalidate_region(addr, length);
-			memcpy(cur_frame, addr, length);
-			cur_frame += length;
-			cur_frame_size += length;
-
 			/* An end of frame has been received, return the data */
-			if (desc->status & ETH_RX_STATUS_EOF) {
-				/* Frame size from the ETH */
-				*recv_size = desc->status & ETH_RX_STATUS_LENGTH_MASK;
-
-				/* Application frame buffer is too small all
-				 * data have not been copied */
-				if (cur_frame_size < *recv_size) {
-					return ETH_SIZE_TOO_SMALL;
-				}
-
-				/* All data have been copied in the application
-				 * frame buffer => release descriptors */
-				while (q->rx_head != idx) {
-					desc = &q->rx_desc[q->rx_head];
-					desc->addr &= ~ETH_RX_ADDR_OWN;
-					RING_INC(q->rx_head, q->rx_size);
-				}
-
-				return ETH_OK;
-			}
+			if (desc->status & ETH_RX_STATUS_EOF)
+				return _ethd_read_frame(q, idx, buffer, buffer_size, recv_size);
 		}
 
 		/* SOF has not been detected, skip the fragment */
@@ -333,3 +374,26 @@ uint8_t ethd_set_tx_wakeup_callback(struct _ethd* ethd, uint8_t queue, ethd_wake
 
 	return ETH_OK;
 }
+
+uint8_t ethd_set_offload(struct _ethd* ethd, uint8_t offload)
+{
+	if (!ethd->op->set_offload)
+		return offload ? ETH_PARAM : ETH_OK;
+
+	ethd->op->set_offload(ethd, offload);
+	ethd->offload = offload;
+	return ETH_OK;
+}
+
+uint8_t ethd_get_offload(struct _ethd* ethd)
+{
+	return ethd->offload;
+}
+
+uint32_t ethd_get_rx_checksum(struct _ethd* ethd, uint8_t queue)
+{
+	/* without offload these descriptor bits have another meaning */
+	if (!(ethd->offload & ETH_OFFLOAD_RX_CSUM))
+		return ETH_RX_STATUS_CSUM_NONE;
+	return ethd->queues[queue].rx_csum;
+}
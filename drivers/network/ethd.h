@@ -89,11 +89,23 @@ enum _eth_speed {
 #define ETH_RX_STATUS_SOF         (1u << 14)
 #define ETH_RX_STATUS_EOF         (1u << 15)
 
+/* Checksum status of the EOF RX descriptor, only valid when receive
+ * checksum offload is enabled (see ethd_set_offload) */
+#define ETH_RX_STATUS_CSUM_MASK   (3u << 22)
+#define ETH_RX_STATUS_CSUM_NONE   (0u << 22) /**< not IPv4 or not checked */
+#define ETH_RX_STATUS_CSUM_IP     (1u << 22) /**< IP header checked */
+#define ETH_RX_STATUS_CSUM_TCP    (2u << 22) /**< IP header and TCP checked */
+#define ETH_RX_STATUS_CSUM_UDP    (3u << 22) /**< IP header and UDP checked */
+
 /* Bits contained in struct _eth_desc status when used for TX */
 #define ETH_TX_STATUS_LASTBUF (1u << 15)
 #define ETH_TX_STATUS_WRAP    (1u << 30)
 #define ETH_TX_STATUS_USED    (1u << 31)
 
+/* Offload features (see ethd_set_offload) */
+#define ETH_OFFLOAD_RX_CSUM (1u << 0) /**< verify IP/TCP/UDP checksums */
+#define ETH_OFFLOAD_TX_CSUM (1u << 1) /**< generate IP/TCP/UDP checksums */
+
 /**@}*/
 
 /** \addtogroup eth_buf_size ETH(EMACD/GMACD) Default Buffer Size
@@ -188,6 +200,8 @@ typedef void (*_ethd_set_rx_callback)(void *ethd, uint8_t queue, ethd_callback_t
 
 typedef uint8_t (*_ethd_set_tx_wakeup_callback)(void *ethd, uint8_t queue, ethd_wakeup_cb_t wakeup_callback, uint16_t threshold);
 
+typedef void (*_ethd_set_offload)(void *ethd, uint8_t offload);
+
 /** @}*/
 
 /** \addtogroup ethd_structs
@@ -206,6 +220,7 @@ struct _ethd_op {
 	_ethd_poll poll;
 	_ethd_set_rx_callback set_rx_callback;
 	_ethd_set_tx_wakeup_callback set_tx_wakeup_callback;
+	_ethd_set_offload set_offload; /**< NULL if no offload support */
 };
 
 struct _ethd_queue {
@@ -214,6 +229,7 @@ struct _ethd_queue {
 	uint16_t          rx_size;
 	uint16_t          rx_head;
 	ethd_callback_t   rx_callback;
+	uint32_t          rx_csum; /**< checksum status of the last frame */
 
 	uint8_t          *tx_buffer;
 	struct _eth_desc *tx_desc;
@@ -241,6 +257,7 @@ struct _ethd {
 	};
 	struct _ethd_queue queues[ETH_QUEUE_COUNT];
 	const struct _ethd_op *op;
+	uint8_t offload;          /**< enabled ETH_OFFLOAD_* features */
 };
 
 /** @}*/
@@ -325,6 +342,36 @@ extern void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callbac
  */
 extern uint8_t ethd_set_tx_wakeup_callback(struct _ethd* ethd, uint8_t queue, ethd_wakeup_cb_t callback, uint16_t threshold);
 
+/**
+ * \brief Enable/disable the checksum offload features of the ETH.
+ * When ETH_OFFLOAD_RX_CSUM is enabled, frames with a wrong IP, TCP or UDP
+ * checksum are discarded by the MAC and ethd_get_rx_checksum() tells which
+ * checksums of the last polled frame have been verified.  When
+ * ETH_OFFLOAD_TX_CSUM is enabled, the MAC fills the IP, TCP and UDP
+ * checksums of unfragmented frames.
+ *  \param ethd     Pointer to ETH Driver instance.
+ *  \param offload  Mask of ETH_OFFLOAD_* features to enable.
+ *  \return ETH_OK, or ETH_PARAM if the ETH has no offload support.
+ */
+extern uint8_t ethd_set_offload(struct _ethd* ethd, uint8_t offload);
+
+/**
+ * \brief Get the checksum offload features enabled on the ETH.
+ *  \param ethd     Pointer to ETH Driver instance.
+ *  \return Mask of the ETH_OFFLOAD_* features enabled, 0 if the ETH has
+ *  no offload support.
+ */
+extern uint8_t ethd_get_offload(struct _ethd* ethd);
+
+/**
+ * \brief Get the checksum status of the last frame returned by ethd_poll().
+ *  \param ethd   Pointer to ETH Driver instance.
+ *  \param queue  Queue the frame has been polled from.
+ *  \return One of ETH_RX_STATUS_CSUM_*, always ETH_RX_STATUS_CSUM_NONE if
+ *          receive checksum offload is disabled.
+ */
+extern uint32_t ethd_get_rx_checksum(struct _ethd* ethd, uint8_t queue);
+
 /** @}*/
 
 #ifdef __cplusplus
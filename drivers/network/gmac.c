@@ -56,6 +56,11 @@
 #define GMAC_TSR_UND 0
 #endif
 
+/* some component headers don't describe this flag, the bit is the same */
+#ifndef GMAC_DCFGR_TXCOEN
+#define GMAC_DCFGR_TXCOEN (0x1u << 11)
+#endif
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -152,6 +157,7 @@ bool gmac_configure(Gmac* gmac)
 	/* Disable TX & RX and more */
 	gmac_set_network_control_register(gmac, 0);
 	gmac_set_network_config_register(gmac, GMAC_NCFGR_DBW_DBW32);
+	gmac_tx_checksum_offload(gmac, false);
 
 	/* Disable interrupts */
 	gmac_disable_it(gmac, 0, ~0u);
@@ -356,6 +362,22 @@ void gmac_transmit_enable(Gmac* gmac, bool enable)
 		gmac->GMAC_NCR &= ~GMAC_NCR_TXEN;
 }
 
+void gmac_rx_checksum_offload(Gmac* gmac, bool enable)
+{
+	if (enable)
+		gmac->GMAC_NCFGR |= GMAC_NCFGR_RXCOEN;
+	else
+		gmac->GMAC_NCFGR &= ~GMAC_NCFGR_RXCOEN;
+}
+
+void gmac_tx_checksum_offload(Gmac* gmac, bool enable)
+{
+	if (enable)
+		gmac->GMAC_DCFGR |= GMAC_DCFGR_TXCOEN;
+	else
+		gmac->GMAC_DCFGR &= ~GMAC_DCFGR_TXCOEN;
+}
+
 void gmac_set_rx_desc(Gmac* gmac, uint8_t queue, struct _eth_desc* desc)
 {
 	if (queue == 0) {
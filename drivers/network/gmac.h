@@ -226,6 +226,16 @@ extern void gmac_receive_enable(Gmac* gmac, bool enable);
  */
 extern void gmac_transmit_enable(Gmac* gmac, bool enable);
 
+/**
+ *  \brief Enable/Disable IP/TCP/UDP checksum verification on receive.
+ */
+extern void gmac_rx_checksum_offload(Gmac* gmac, bool enable);
+
+/**
+ *  \brief Enable/Disable IP/TCP/UDP checksum generation on transmit.
+ */
+extern void gmac_tx_checksum_offload(Gmac* gmac, bool enable);
+
 /**
  *  \brief Set RX descriptor address
  */
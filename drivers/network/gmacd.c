@@ -541,6 +541,17 @@ void gmacd_set_rx_callback(struct _ethd* gmacd, uint8_t queue, ethd_callback_t c
 	}
 }
 
+/**
+ * \brief Enable/disable the GMAC checksum offload engines.
+ *  \param gmacd   Pointer to GMAC Driver instance.
+ *  \param offload Mask of ETH_OFFLOAD_* features to enable.
+ */
+void gmacd_set_offload(struct _ethd* gmacd, uint8_t offload)
+{
+	gmac_rx_checksum_offload(gmacd->gmac, (offload & ETH_OFFLOAD_RX_CSUM) != 0);
+	gmac_tx_checksum_offload(gmacd->gmac, (offload & ETH_OFFLOAD_TX_CSUM) != 0);
+}
+
 const struct _ethd_op _gmac_op = {
 	.configure = (_ethd_configure)gmacd_configure,
 	.setup_queue = (_ethd_setup_queue)gmacd_setup_queue,
@@ -554,4 +565,5 @@ const struct _ethd_op _gmac_op = {
 	.poll = (_ethd_poll)ethd_poll,
 	.set_rx_callback = (_ethd_set_rx_callback)gmacd_set_rx_callback,
 	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+	.set_offload = (_ethd_set_offload)gmacd_set_offload,
 };
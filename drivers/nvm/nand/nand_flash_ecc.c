@@ -59,6 +59,54 @@ CACHE_ALIGNED static uint8_t spare_buf[NAND_MAX_PAGE_SPARE_SIZE];
 /*         Local functions                                               */
 /*---------------------------------------------------------------------- */
 
+/**
+ * \brief Checks the PMECC status of the page just read and corrects the data
+ * in place. Pages whose spare area is erased are accepted as is.
+ * Used as nand_raw_read_pages() callback.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param block  Number of block the page was read from.
+ * \param page  Number of page inside given block.
+ * \param data  Data area buffer.
+ * \param spare  Spare area read up to the last ECC byte, NULL to read it
+ * again from the device when needed.
+ * \param arg  Unused.
+ * \return 0 if the data is valid; otherwise returns NAND_ERROR_CORRUPTEDDATA
+ */
+static uint8_t ecc_check_page_with_pmecc(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint8_t *data,
+		const uint8_t *spare, void *arg)
+{
+	volatile uint32_t pmecc_status;
+	uint16_t i, spare_size;
+
+	pmecc_status = pmecc_error_status();
+	if (pmecc_status) {
+		/* Check if the spare area was erased */
+		if (spare) {
+			spare_size = pmecc_get_ecc_end_address();
+		} else {
+			spare_size = nand_model_get_page_spare_size(&nand->model);
+			nand_raw_read_page(nand, block, page, NULL, spare_buf);
+			spare = spare_buf;
+		}
+		for (i = 0 ; i < spare_size; i++) {
+			if (spare[i] != 0xff)
+				break;
+		}
+		if (i == spare_size)
+			pmecc_status = 0;
+	}
+
+	/* bit correction will be done directly in destination buffer. */
+	if (pmecc_status && pmecc_correction(pmecc_status, (uint32_t)data)) {
+		trace_error("ecc_read_page_with_pmecc: at B%d.P%d Unrecoverable data\r\n",
+				block, page);
+		return NAND_ERROR_CORRUPTEDDATA;
+	}
+
+	return 0;
+}
+
 /**
  * \brief Reads the data page of a NANDFLASH chip, and verify that
  * the data is valid by PMECC module. If one
@@ -72,10 +120,7 @@ CACHE_ALIGNED static uint8_t spare_buf[NAND_MAX_PAGE_SPARE_SIZE];
 static uint8_t ecc_read_page_with_pmecc(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page, void *data)
 {
-	volatile uint32_t pmecc_status;
 	uint8_t error;
-	uint16_t i;
-	uint16_t page_spare_size = nand_model_get_page_spare_size(&nand->model);
 
 	if (!data)
 		return NAND_ERROR_ECC_NOT_COMPATIBLE;
@@ -86,30 +131,12 @@ static uint8_t ecc_read_page_with_pmecc(const struct _nand_flash *nand,
 		trace_error("ecc_read_page_with_pmecc: Failed to read page\r\n");
 		return error;
 	}
-	pmecc_status = pmecc_error_status();
-	if (pmecc_status) {
-		/* Check if the spare area was erased */
-		nand_raw_read_page(nand, block, page, NULL, spare_buf);
-		for (i = 0 ; i < page_spare_size; i++) {
-			if (spare_buf[i] != 0xff)
-				break;
-		}
-		if (i == page_spare_size)
-			pmecc_status = 0;
-	}
 
-	/* bit correction will be done directly in destination buffer. */
-	if (pmecc_status && pmecc_correction(pmecc_status, (uint32_t)data)) {
-		pmecc_auto_disable();
-		pmecc_disable();
-		trace_error("ecc_read_page_with_pmecc: at B%d.P%d Unrecoverable data\r\n",
-				block, page);
-		return NAND_ERROR_CORRUPTEDDATA;
-	}
+	error = ecc_check_page_with_pmecc(nand, block, page, data, NULL, NULL);
 
 	pmecc_auto_disable();
 	pmecc_disable();
-	return 0;
+	return error;
 }
 
 /**
@@ -171,6 +198,35 @@ uint8_t nand_ecc_read_page(const struct _nand_flash *nand,
 	return NAND_ERROR_ECC_NOT_COMPATIBLE;
 }
 
+/**
+ * \brief Reads the data area of consecutive pages of a block and verifies
+ * them with the ECC. Sequential cache reads are used when the device supports
+ * them, so that the correction of a page overlaps the array read of the next.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param block  Number of block to read from.
+ * \param page  Number of the first page to read inside given block.
+ * \param count  Number of pages to read.
+ * \param data  Data area buffer, \a count pages long.
+ * \return 0 if the data has been read and is valid; otherwise returns either
+ * NAND_ERROR_CORRUPTEDDATA or ...
+ */
+uint8_t nand_ecc_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data)
+{
+	NAND_TRACE("nand_ecc_read_pages(B#%d:P#%d+%d)\r\n", block, page, count);
+	assert(data);
+
+	if (nand_is_using_pmecc())
+		return nand_raw_read_pages(nand, block, page, count, data,
+				ecc_check_page_with_pmecc, NULL);
+
+	if (nand_is_using_no_ecc())
+		return nand_raw_read_pages(nand, block, page, count, data,
+				NULL, NULL);
+
+	return NAND_ERROR_ECC_NOT_COMPATIBLE;
+}
+
 /**
  * \brief Writes the data and/or spare area of a NANDFLASH page, after calculating an
  * ECC for the data area and storing it in the spare. If no data buffer is
@@ -45,6 +45,9 @@
  * -# nand_ecc_read_page() is used to read a NANDFLASH page with ECC check, the function
  *      will read out data and spare first, then it calculates ECC with data and then compare with
  *      the readout ECC, and feedback the ECC check result to PMECC driver.
+ * -# nand_ecc_read_pages() reads and checks consecutive pages of a block, the
+ *      correction of a page overlapping the array read of the next one when the
+ *      device supports sequential cache reads.
 */
 
 #ifndef NAND_FLASH_ECC_H
@@ -66,6 +69,10 @@ extern uint8_t nand_ecc_read_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
 
+extern uint8_t nand_ecc_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count,
+		void *data);
+
 extern uint8_t nand_ecc_write_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
@@ -155,3 +155,13 @@ bool nand_model_has_small_blocks(const struct _nand_flash_model *model)
 {
 	return model->page_size <= 512 ? 1 : 0;
 }
+
+/**
+ * \brief Returns true if the given NandFlash model supports sequential
+ * cache reads (ONFI READ CACHE SEQUENTIAL / READ CACHE END).
+ * \param model  Pointer to a _nand_flash_model instance.
+*/
+bool nand_model_has_read_cache(const struct _nand_flash_model *model)
+{
+	return model->read_cache;
+}
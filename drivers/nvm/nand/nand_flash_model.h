@@ -84,6 +84,9 @@ struct _nand_flash_model {
 
 	/** Size of one block, in bytes. */
 	uint32_t block_size;
+
+	/** Device supports the READ CACHE SEQUENTIAL/END commands. */
+	bool read_cache;
 };
 
 /*---------------------------------------------------------------------- */
@@ -123,6 +126,9 @@ extern uint8_t nand_model_get_data_bus_width(
 extern bool nand_model_has_small_blocks(
 		const struct _nand_flash_model *model);
 
+extern bool nand_model_has_read_cache(
+		const struct _nand_flash_model *model);
+
 /**@}*/
 
 #endif /* NAND_FLASH_MODEL_H */
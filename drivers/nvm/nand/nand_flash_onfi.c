@@ -134,6 +134,8 @@ static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 		onfi_parameter.onfi_compatible = true;
 		/* Bus width */
 		onfi_parameter.bus_width = (onfi_param_table[6] & 0x01) ? 16 : 8;
+		/* Optional commands supported (bit 1: Read Cache) */
+		onfi_parameter.read_cache = (onfi_param_table[8] & 0x02) != 0;
 		/* Manufacturer */
 		memcpy(onfi_parameter.manufacturer, &onfi_param_table[32], 12);
 		onfi_parameter.manufacturer[12] = 0;
@@ -173,6 +175,8 @@ static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 				(unsigned)onfi_parameter.logical_units);
 		trace_info_wp("ONFI ecc_correctability %d\r\n",
 				onfi_parameter.ecc_correctability);
+		trace_info_wp("ONFI read_cache %d\r\n",
+				onfi_parameter.read_cache);
 		return true;
 	}
 
@@ -243,6 +247,11 @@ uint8_t nand_onfi_get_ecc_correctability(void)
 	return onfi_parameter.ecc_correctability;
 }
 
+bool nand_onfi_has_read_cache(void)
+{
+	return onfi_parameter.read_cache;
+}
+
 /**
  * \brief This function check if the NANDFLASH has an embedded ECC controller.
  * \return false if ONFI not compliant or internal ECC not supported, true if Internal ECC enabled.
@@ -332,6 +341,7 @@ bool nand_onfi_get_model(struct _nand_flash_model *model)
 		model->spare_size = nand_onfi_get_spare_size();
 		model->block_size = nand_onfi_get_pages_per_block() * nand_onfi_get_page_size();
 		model->device_size = ((model->block_size / 1024) * nand_onfi_get_blocks_per_lun()) / 1024;
+		model->read_cache = nand_onfi_has_read_cache();
 		return true;
 	}
 	return false;
@@ -80,6 +80,9 @@ struct _onfi_page_param {
 
 	/** Number of bits of ECC correction */
 	uint8_t ecc_correctability;
+
+	/** Read Cache commands supported */
+	bool read_cache;
 };
 
 /*--------------------------------------------------------------------- */
@@ -110,6 +113,8 @@ extern uint16_t nand_onfi_get_blocks_per_lun(void);
 
 extern uint8_t nand_onfi_get_ecc_correctability(void);
 
+extern bool nand_onfi_has_read_cache(void);
+
 extern bool nand_onfi_get_model(struct _nand_flash_model *model);
 
 #endif /* NAND_FLASH_ONFI_H */
@@ -76,6 +76,10 @@
 
 CACHE_ALIGNED static uint8_t ecc_table[NAND_MAX_PMECC_BYTE_SIZE];
 
+/** Spare area (up to the last ECC byte) of the page being read by
+ * nand_raw_read_pages() */
+CACHE_ALIGNED static uint8_t spare_table[NAND_MAX_PAGE_SPARE_SIZE];
+
 /*------------------------------------------------------------------------*/
 /*        Local Functions                                                 */
 /*------------------------------------------------------------------------*/
@@ -555,6 +559,87 @@ static uint8_t _read_page_with_pmecc(const struct _nand_flash *nand,
 	return 0;
 }
 
+/**
+ * \brief Reads consecutive pages of a block using the READ CACHE SEQUENTIAL
+ * command: the device fetches page N+1 from the array while page N is
+ * transferred and handed to the callback.
+ * \param nand  Pointer to a struct _nand_flash instance.
+ * \param block  Number of the block where the pages reside.
+ * \param page  Number of the first page to read inside the given block.
+ * \param count  Number of pages to read (at least 2).
+ * \param data  Buffer where the data areas will be stored.
+ * \param cb  Function called for each page once transferred, can be NULL.
+ * \param arg  Argument passed to the callback.
+ * \return 0 if the operation has been successful; otherwise the first error
+ * reported by the callback.
+ */
+static uint8_t _read_pages_cached(const struct _nand_flash *nand,
+	uint16_t block, uint16_t page, uint16_t count, uint8_t *data,
+	nand_raw_page_cb_t cb, void *arg)
+{
+	uint32_t data_size = nand_model_get_page_data_size(&nand->model);
+	uint32_t row_address, spare_size = 0;
+	bool pmecc = nand_is_using_pmecc();
+	uint8_t cmd, error = 0;
+	uint16_t i;
+
+	NAND_TRACE("_read_pages_cached(B#%d:P#%d+%d)\r\n", block, page, count);
+
+#ifdef CONFIG_HAVE_NFC
+	if (nand_is_nfc_enabled())
+		nfc_configure(data_size, nand_model_get_page_spare_size(&nand->model),
+		              pmecc, false);
+#endif
+
+	if (pmecc) {
+		spare_size = pmecc_get_ecc_end_address();
+		pmecc_reset();
+		pmecc_enable_read();
+		if (!pmecc_auto_spare_en())
+			pmecc_auto_enable();
+	}
+
+	/* Load the first page into the data register */
+	row_address = block * nand_model_get_block_size_in_pages(&nand->model) + page;
+	_send_cle_ale(nand, ALE_COL_EN | ALE_ROW_EN | CLE_VCMD2_EN,
+	              NAND_CMD_READ_1, NAND_CMD_READ_2, 0, row_address);
+	_nand_wait_ready(nand);
+
+	for (i = 0; i < count; i++) {
+		/* Move page N to the cache register; unless it is the last
+		 * one, the array read of page N+1 starts right away */
+		cmd = (i == count - 1) ? NAND_CMD_READ_CACHE_END : NAND_CMD_READ_CACHE_SEQ;
+		_send_cle_ale(nand, 0, cmd, 0, 0, 0);
+		_nand_wait_ready(nand);
+		_send_cle_ale(nand, 0, NAND_CMD_READ_1, 0, 0, 0);
+
+		if (pmecc) {
+			pmecc_reset();
+			pmecc_start_data_phase();
+		}
+
+		_data_array_in(nand, false, data, data_size);
+		if (pmecc) {
+			_data_array_in(nand, false, spare_table, spare_size);
+			pmecc_wait_ready();
+		}
+
+		/* Correction of page N overlaps the array read of page N+1 */
+		if (cb && !error)
+			error = cb(nand, block, page + i, data,
+			           pmecc ? spare_table : NULL, arg);
+
+		data += data_size;
+	}
+
+	if (pmecc) {
+		pmecc_auto_disable();
+		pmecc_disable();
+	}
+
+	return error;
+}
+
 /**
  * \brief Writes the data and/or the spare area of a page on a NandFlash chip. If one
  * of the buffer pointer is 0, the corresponding area is not written.
@@ -856,6 +941,64 @@ uint8_t nand_raw_read_page(const struct _nand_flash *nand,
 	return NAND_ERROR_ECC_NOT_COMPATIBLE;
 }
 
+/**
+ * \brief Reads the data area of consecutive pages of a block. When the device
+ * supports it, the READ CACHE SEQUENTIAL command is used so that the array
+ * read of a page overlaps the transfer and the ECC handling of the previous
+ * one; otherwise the pages are read one at a time.
+ * The callback is invoked for each page as soon as it has been transferred.
+ * When PMECC is enabled, the PMECC status of the page is still valid at that
+ * time and the \a spare argument of the callback points to the spare area
+ * read up to the last ECC byte (NULL if it was not read).
+ * \param nand  Pointer to a struct _nand_flash instance.
+ * \param block  Number of the block where the pages reside.
+ * \param page  Number of the first page to read inside the given block.
+ * \param count  Number of pages to read.
+ * \param data  Buffer where the data areas will be stored.
+ * \param cb  Function called for each page once transferred, can be NULL.
+ * \param arg  Argument passed to the callback.
+ * \return 0 if the operation has been successful; otherwise the first error
+ * code returned by the callback or NAND_ERROR_OUTOFBOUNDS.
+ */
+uint8_t nand_raw_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data,
+		nand_raw_page_cb_t cb, void *arg)
+{
+	uint32_t data_size = nand_model_get_page_data_size(&nand->model);
+	uint8_t *buf = (uint8_t*)data;
+	uint8_t error;
+	uint16_t i;
+
+	NAND_TRACE("nand_raw_read_pages(B#%d:P#%d+%d)\r\n", block, page, count);
+
+	/* sequential cache reads do not cross block boundaries here */
+	if (page + count > nand_model_get_block_size_in_pages(&nand->model))
+		return NAND_ERROR_OUTOFBOUNDS;
+
+	/* the NFC host SRAM path transfers whole pages on its own */
+	if (count > 1 && nand_model_has_read_cache(&nand->model)
+#ifdef CONFIG_HAVE_NFC
+	    && !nand_is_nfc_sram_enabled()
+#endif
+	   )
+		return _read_pages_cached(nand, block, page, count, buf, cb, arg);
+
+	for (i = 0; i < count; i++) {
+		error = nand_raw_read_page(nand, block, page + i, buf, NULL);
+		if (!error && cb)
+			error = cb(nand, block, page + i, buf, NULL, arg);
+		if (nand_is_using_pmecc()) {
+			pmecc_auto_disable();
+			pmecc_disable();
+		}
+		if (error)
+			return error;
+		buf += data_size;
+	}
+
+	return 0;
+}
+
 /**
  * \brief Writes the data and/or the spare area of a page on a NandFlash chip. If one
  * of the buffer pointer is 0, the corresponding area is not written. Retries
@@ -44,6 +44,8 @@
  * -# nand_raw_read_id() is used to read a NANDFLASH's id.
  * -# nand_raw_erase_block() is used to erase a certain NANDFLASH device's block.
  * -# nand_raw_read_page() and nand_raw_write_page is used to do read/write operation.
+ * -# nand_raw_read_pages() reads consecutive pages of a block, using sequential
+ *      cache reads when the device supports them.
  * -# nand_raw_copy_page() is used to issue copy-page command to NANDFLASH device.
  * -# nand_raw_copy_block() calls nand_raw_copy_page to do a NANDFLASH block copy.
 */
@@ -62,6 +64,15 @@
 
 #include "nand_flash.h"
 
+/*------------------------------------------------------------------------------ */
+/*         Types                                                                 */
+/*------------------------------------------------------------------------------ */
+
+/** Per-page hook of nand_raw_read_pages(), returns 0 or a NAND_ERROR_ code */
+typedef uint8_t (*nand_raw_page_cb_t)(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint8_t *data,
+		const uint8_t *spare, void *arg);
+
 /*------------------------------------------------------------------------------ */
 /*         Exported functions                                                    */
 /*------------------------------------------------------------------------------ */
@@ -80,6 +91,10 @@ extern uint8_t nand_raw_read_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
 
+extern uint8_t nand_raw_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data,
+		nand_raw_page_cb_t cb, void *arg);
+
 extern uint8_t nand_raw_write_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
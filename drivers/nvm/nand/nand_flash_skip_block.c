@@ -253,12 +253,10 @@ uint8_t nand_skipblock_read_page(const struct _nand_flash *nand,
 uint8_t nand_skipblock_read_block(const struct _nand_flash *nand,
 	uint16_t block, void *data)
 {
-	uint32_t num_pages_per_block, page_size;
-	uint16_t i;
+	uint32_t num_pages_per_block;
 	uint8_t error = 0;
 
 	/* Retrieve model information */
-	page_size = nand_model_get_page_data_size(&nand->model);
 	num_pages_per_block = nand_model_get_block_size_in_pages(&nand->model);
 
 	/* Check that the block is not BAD if data is requested */
@@ -269,13 +267,10 @@ uint8_t nand_skipblock_read_block(const struct _nand_flash *nand,
 	}
 
 	/* Read all the pages of the block */
-	for (i = 0; i < num_pages_per_block; i++) {
-		error = nand_ecc_read_page(nand, block, i, data, 0);
-		if (error) {
-			trace_error("nand_skipblock_read_block: Cannot read page %d of block %d.\r\n", i, block);
-			return error;
-		}
-		data = (void*)((uint8_t*)data + page_size);
+	error = nand_ecc_read_pages(nand, block, 0, num_pages_per_block, data);
+	if (error) {
+		trace_error("nand_skipblock_read_block: Cannot read block %d.\r\n", block);
+		return error;
 	}
 
 	return 0;
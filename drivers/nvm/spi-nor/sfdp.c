@@ -137,6 +137,15 @@ enum sfdp_bfpt_dword {
 #define BFPT_DWORD11_PAGE_SIZE_SHIFT     4
 #define BFPT_DWORD11_PAGE_SIZE_MASK      (0xFUL << 4)
 
+/* JESD216A: Suspend/Resume, bit set if NOT supported */
+#define BFPT_DWORD12_SUSPEND_UNSUPPORTED (0x1UL << 31)
+/* Erase Resume to Suspend interval: (N + 1) * 64us */
+#define BFPT_DWORD12_RESUME_INTERVAL_SHIFT 20
+#define BFPT_DWORD12_RESUME_INTERVAL_MASK  (0xFUL << 20)
+
+#define BFPT_DWORD13_RESUME_SHIFT        16
+#define BFPT_DWORD13_SUSPEND_SHIFT       24
+
 /* 15th DWORD. */
 
 /*
@@ -389,6 +398,15 @@ static int spi_flash_parse_bfpt(struct spi_flash *flash,
 	params->page_size >>= BFPT_DWORD11_PAGE_SIZE_SHIFT;
 	params->page_size = (0x1UL << params->page_size);
 
+	/* Erase Suspend/Resume instructions. */
+	if (!(bfpt.dwords[BFPT_DWORD12] & BFPT_DWORD12_SUSPEND_UNSUPPORTED)) {
+		flash->suspend_inst = bfpt.dwords[BFPT_DWORD13] >> BFPT_DWORD13_SUSPEND_SHIFT;
+		flash->resume_inst = bfpt.dwords[BFPT_DWORD13] >> BFPT_DWORD13_RESUME_SHIFT;
+		flash->resume_interval = 64 * (1 +
+			((bfpt.dwords[BFPT_DWORD12] & BFPT_DWORD12_RESUME_INTERVAL_MASK) >>
+			 BFPT_DWORD12_RESUME_INTERVAL_SHIFT));
+	}
+
 	/* Enable Quad I/O. */
 	switch (bfpt.dwords[BFPT_DWORD15] & BFPT_DWORD15_QER_MASK) {
 	default:
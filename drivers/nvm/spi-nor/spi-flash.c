@@ -73,7 +73,7 @@ int spi_flash_write_reg(struct spi_flash *flash, uint8_t inst, const uint8_t *bu
 	return spi_flash_exec(flash, &cmd);
 }
 
-static int spi_flash_is_ready(struct spi_flash *flash)
+int spi_flash_is_ready(struct spi_flash *flash)
 {
 	uint8_t sr, fsr;
 	int rc;
@@ -389,6 +389,8 @@ void spi_flash_command_init(struct spi_flash_command *cmd, uint8_t inst, uint8_t
 void spi_flash_use_aesb(struct spi_flash* flash, bool enable)
 {
 	flash->use_aesb = enable;
+	/* read-ahead data was fetched with the other view */
+	flash->ra_len = 0;
 }
 #endif
 
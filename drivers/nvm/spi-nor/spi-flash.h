@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "callback.h"
 #include "compiler.h"
 #include "intmath.h"
 #include "peripherals/bus.h"
@@ -257,6 +258,8 @@ enum spi_flash_protocol {
  * @data_len:		Number of bytes to be sent during data clock cycles.
  * @tx_data:		Data sent to the SPI slave during data clock cycles.
  * @rx_data:		Data read from the SPI slave during data clock cycles.
+ * @callback:		If not NULL, called once the command completed. The
+ *			controller may return before the data transfer ends.
  */
 struct spi_flash_command {
 	enum spi_flash_protocol proto;
@@ -274,6 +277,7 @@ struct spi_flash_command {
 #ifdef CONFIG_HAVE_AESB
 	bool use_aesb;
 #endif
+	struct _callback *callback;
 };
 
 /**
@@ -373,6 +377,26 @@ struct spi_flash_hwcaps {
  * @size:		The total SPI flash size (in bytes).
  * @page_size:		The page size (in bytes).
  * @erase_map:		The erase map of the SPI flash.
+ * @ra_buf:		Optional read-ahead buffer for sequential reads.
+ * @ra_size:		The size of @ra_buf (in bytes).
+ * @ra_addr:		The flash offset of the data held in @ra_buf.
+ * @ra_len:		The number of valid bytes in @ra_buf.
+ * @suspend_inst:	The Erase Suspend instruction opcode, 0 if unsupported.
+ * @resume_inst:	The Erase Resume instruction opcode.
+ * @resume_interval:	The minimum delay from Resume to Suspend (tRS, in us).
+ * @async_op:		The asynchronous program/erase in progress, if any.
+ * @async_busy:		A program/erase command of @async_op is running.
+ * @async_suspended:	The running erase is suspended.
+ * @async_addr:		The flash offset of the next/running command.
+ * @async_buf:		The data of the next/running page program.
+ * @async_len:		The number of bytes left, including the running command.
+ * @async_chunk:	The number of bytes handled by the running command.
+ * @async_start:	The tick at which the running command was issued,
+ *			moved forward by the time spent suspended.
+ * @async_suspend_tick:	The tick at which the running erase was suspended.
+ * @async_resumed:	The running erase was resumed at @async_resume_tick.
+ * @async_resume_tick:	The tick at which the running erase was last resumed.
+ * @async_cb:		Called once @async_op completes.
  * @ops:		[DRIVER-SPECIFIC] The SPI controller interface.
  * @read:		[FLASH-SPECIFIC] Read data from the SPI flash.
  * @write:		[FLASH-SPECIFIC] Write data into the SPI flash.
@@ -402,6 +426,28 @@ struct spi_flash {
 	size_t page_size;
 	struct spi_flash_erase_map erase_map;
 
+	uint8_t *ra_buf;
+	size_t ra_size;
+	size_t ra_addr;
+	size_t ra_len;
+
+	uint8_t suspend_inst;
+	uint8_t resume_inst;
+	uint16_t resume_interval;
+
+	uint8_t async_op;
+	bool async_busy;
+	bool async_suspended;
+	size_t async_addr;
+	const uint8_t *async_buf;
+	size_t async_len;
+	size_t async_chunk;
+	uint64_t async_start;
+	uint64_t async_suspend_tick;
+	bool async_resumed;
+	uint64_t async_resume_tick;
+	struct _callback async_cb;
+
 	const struct spi_ops *ops;
 
 #ifdef CONFIG_HAVE_AESB
@@ -476,6 +522,8 @@ extern int spi_flash_reset(struct spi_flash *flash);
 
 extern int spi_flash_wait_till_ready(struct spi_flash *flash);
 
+extern int spi_flash_is_ready(struct spi_flash *flash);
+
 #ifdef CONFIG_HAVE_AESB
 extern void spi_flash_use_aesb(struct spi_flash* flash, bool enable);
 #endif
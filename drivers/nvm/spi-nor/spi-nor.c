@@ -45,6 +45,19 @@
 
 //#define SPI_NOR_VERBOSE_DEBUG
 
+/*----------------------------------------------------------------------------
+ *        Local Constants
+ *----------------------------------------------------------------------------*/
+
+#define SPI_NOR_ASYNC_NONE  0
+#define SPI_NOR_ASYNC_WRITE 1
+#define SPI_NOR_ASYNC_ERASE 2
+
+/* Program/erase timeouts (in timer ticks, for 1000 Hz timer) */
+#define SPI_NOR_TIMEOUT_WRITE  800 /* 0.8s */
+#define SPI_NOR_TIMEOUT_ERASE 3000 /* 3s */
+#define SPI_NOR_TIMEOUT_SUSPEND 10 /* 10ms, JESD216 latencies are below 2ms */
+
 /*----------------------------------------------------------------------------
  *        Local Variables
  *----------------------------------------------------------------------------*/
@@ -472,6 +485,9 @@ static int _bus_exec(union spi_flash_priv* priv, const struct spi_flash_command
 	bus_wait_transfer(priv->spi.bus);
 	bus_stop_transaction(priv->spi.bus);
 
+	if (rc == 0 && cmd->callback)
+		callback_call(cmd->callback, NULL);
+
 	return rc;
 }
 
@@ -734,7 +750,7 @@ int spi_nor_configure(struct spi_flash *flash, const struct spi_flash_cfg *cfg)
 	return 0;
 }
 
-int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
+static int spi_nor_read_direct(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len, struct _callback* cb)
 {
 	struct spi_flash_command cmd;
 
@@ -746,124 +762,438 @@ int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
 	cmd.num_wait_states = flash->num_wait_states;
 	cmd.data_len = len;
 	cmd.rx_data = buf;
+	cmd.callback = cb;
 #ifdef CONFIG_HAVE_AESB
 	cmd.use_aesb = flash->use_aesb;
 #endif
 	return spi_flash_exec(flash, &cmd);
 }
 
-int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len)
+static void spi_nor_drop_read_ahead(struct spi_flash *flash, size_t offset, size_t len)
+{
+	if (flash->ra_len &&
+	    offset < flash->ra_addr + flash->ra_len &&
+	    flash->ra_addr < offset + len)
+		flash->ra_len = 0;
+}
+
+void spi_nor_set_read_ahead(struct spi_flash *flash, uint8_t* buf, size_t size)
+{
+	flash->ra_buf = size ? buf : NULL;
+	flash->ra_size = size;
+	flash->ra_len = 0;
+}
+
+static int spi_nor_read_buffered(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
+{
+	size_t count;
+	int rc;
+
+	/* XIP setup, or no read-ahead buffer */
+	if (!buf || !flash->ra_buf)
+		return spi_nor_read_direct(flash, from, buf, len, NULL);
+
+	if (from + len > flash->size)
+		return -EINVAL;
+
+	while (len) {
+		if (from >= flash->ra_addr && from < flash->ra_addr + flash->ra_len) {
+			/* Served from the read-ahead window */
+			count = min_u32(flash->ra_addr + flash->ra_len - from, len);
+			memcpy(buf, flash->ra_buf + (from - flash->ra_addr), count);
+		} else if (len >= flash->ra_size) {
+			/* Too large to be worth buffering */
+			return spi_nor_read_direct(flash, from, buf, len, NULL);
+		} else {
+			/* Fetch the window starting at the requested offset */
+			count = min_u32(flash->ra_size, flash->size - from);
+			/* Never buffer what the pending program/erase will change */
+			if (flash->async_op != SPI_NOR_ASYNC_NONE &&
+			    from < flash->async_addr + flash->async_len &&
+			    flash->async_addr < from + count) {
+				if (from >= flash->async_addr)
+					return spi_nor_read_direct(flash, from, buf, len, NULL);
+				count = flash->async_addr - from;
+			}
+			rc = spi_nor_read_direct(flash, from, flash->ra_buf, count, NULL);
+			if (rc < 0) {
+				flash->ra_len = 0;
+				return rc;
+			}
+			flash->ra_addr = from;
+			flash->ra_len = count;
+			continue;
+		}
+
+		buf += count;
+		from += count;
+		len -= count;
+	}
+
+	return 0;
+}
+
+/*
+ * Asynchronous program/erase engine: one page program or sector erase is
+ * issued at a time, spi_nor_poll() checks the status register once and
+ * issues the next command when the flash is ready.
+ */
+
+static const struct spi_flash_erase_command *spi_nor_select_erase(struct spi_flash *flash, size_t offset, size_t len)
+{
+	const struct spi_flash_erase_map *map = &flash->erase_map;
+	const struct spi_flash_erase_command *erase = NULL;
+	size_t i;
+
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		const struct spi_flash_erase_command *e;
+		uint32_t rem;
+
+		if ((map->uniform_region.cmd_mask & (0x1UL << i))) {
+			e = &map->commands[i];
+			spi_flash_div_by_erase_size(e, offset, &rem);
+			if (rem)
+				continue;
+
+			if (e->size <= len && (!erase || erase->size < e->size))
+				erase = e;
+		}
+	}
+
+	return erase;
+}
+
+static int spi_nor_async_issue(struct spi_flash *flash)
 {
 	struct spi_flash_command cmd;
-	int rc = 0;
+	int rc;
 
-	rc = spi_flash_set_protection(flash, false);
-	if (rc < 0)
-		return rc;
+	if (flash->async_op == SPI_NOR_ASYNC_WRITE) {
+		size_t page_offset = flash->async_addr & (flash->page_size - 1);
+
+		spi_flash_command_init(&cmd, flash->write_inst, flash->addr_len, SFLASH_TYPE_WRITE);
+		cmd.proto = flash->write_proto;
+		flash->async_chunk = min_u32(flash->page_size - page_offset, flash->async_len);
+		cmd.data_len = flash->async_chunk;
+		cmd.tx_data = flash->async_buf;
+	} else {
+		const struct spi_flash_erase_command *erase;
 
-	spi_flash_command_init(&cmd, flash->write_inst, flash->addr_len, SFLASH_TYPE_WRITE);
-	cmd.proto = flash->write_proto;
+		erase = spi_nor_select_erase(flash, flash->async_addr, flash->async_len);
+		if (!erase)
+			return -EINVAL;
+#ifdef SPI_NOR_VERBOSE_DEBUG
+		trace_info("spi-nor: erase params: inst=0x%x\r\n", erase->inst);
+		trace_info("spi-nor: erase params: size=%lu\r\n", erase->size);
+		trace_info("spi-nor: erase params: size_shift=%ld\r\n", erase->size_shift);
+		trace_info("spi-nor: erase params: size_mask=0x%lx\r\n", erase->size_mask);
+#endif
+		spi_flash_command_init(&cmd, erase->inst, flash->addr_len, SFLASH_TYPE_ERASE);
+		cmd.proto = flash->reg_proto;
+		flash->async_chunk = erase->size;
+	}
+	cmd.addr = flash->async_addr;
 #ifdef CONFIG_HAVE_AESB
 	cmd.use_aesb = flash->use_aesb;
 #endif
-	while (len) {
-		size_t page_offset, page_remain;
 
-		page_offset = to & (flash->page_size - 1);
-		page_remain = min_u32(flash->page_size - page_offset, len);
+	rc = spi_flash_write_enable(flash);
+	if (rc < 0)
+		return rc;
 
-		cmd.addr = to;
-		cmd.data_len = page_remain;
-		cmd.tx_data = buf;
+	rc = spi_flash_exec(flash, &cmd);
+	if (rc < 0)
+		return rc;
 
-		rc = spi_flash_write_enable(flash);
-		if (rc < 0)
-			break;
+	flash->async_busy = true;
+	flash->async_start = timer_get_tick();
+	return 0;
+}
 
-		rc = spi_flash_exec(flash, &cmd);
-		if (rc < 0)
-			break;
+static void spi_nor_async_done(struct spi_flash *flash, int rc)
+{
+	flash->async_op = SPI_NOR_ASYNC_NONE;
+	flash->async_busy = false;
+	flash->async_suspended = false;
+	callback_call(&flash->async_cb, (void*)(intptr_t)rc);
+}
 
-		rc = spi_flash_wait_till_ready(flash);
-		if (rc < 0)
-			break;
+/* Check the running command once, account for it when it is over */
+static int spi_nor_async_check(struct spi_flash *flash)
+{
+	uint32_t timeout;
+	int rc;
+
+	rc = spi_flash_is_ready(flash);
+	if (rc < 0)
+		return rc;
 
-		buf += page_remain;
-		to += page_remain;
-		len -= page_remain;
+	if (!rc) {
+		timeout = flash->async_op == SPI_NOR_ASYNC_WRITE ?
+			SPI_NOR_TIMEOUT_WRITE : SPI_NOR_TIMEOUT_ERASE;
+		if (timer_get_interval(flash->async_start, timer_get_tick()) > timeout)
+			return -ETIMEDOUT;
+		return -EAGAIN;
 	}
 
+	flash->async_busy = false;
+	spi_nor_drop_read_ahead(flash, flash->async_addr, flash->async_chunk);
+	if (flash->async_buf)
+		flash->async_buf += flash->async_chunk;
+	flash->async_addr += flash->async_chunk;
+	flash->async_len -= flash->async_chunk;
+	return 0;
+}
+
+/* Let the running command complete, without issuing the next one */
+static int spi_nor_async_wait(struct spi_flash *flash)
+{
+	int rc;
+
+	do {
+		rc = spi_nor_async_check(flash);
+	} while (rc == -EAGAIN);
+
 	return rc;
 }
 
-int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len)
+static int spi_nor_async_start(struct spi_flash *flash, uint8_t op, size_t addr, const uint8_t *buf, size_t len, struct _callback *cb)
 {
-	const struct spi_flash_erase_map *map = &flash->erase_map;
-	struct spi_flash_command cmd;
-	int rc = 0;
+	int rc;
+
+	if (flash->async_op != SPI_NOR_ASYNC_NONE)
+		return -EBUSY;
+
+	if (addr + len > flash->size)
+		return -EINVAL;
+
+	spi_nor_drop_read_ahead(flash, addr, len);
 
 	rc = spi_flash_set_protection(flash, false);
 	if (rc < 0)
 		return rc;
 
-	if (!spi_flash_has_uniform_erase(flash)) {
-		/* @TODO: add support to non uniform erase map. */
-		return -ENOTSUP;
+	if (cb)
+		callback_copy(&flash->async_cb, cb);
+	else
+		callback_set(&flash->async_cb, NULL, NULL);
+
+	flash->async_addr = addr;
+	flash->async_buf = buf;
+	flash->async_len = len;
+	flash->async_busy = false;
+	flash->async_suspended = false;
+	flash->async_resumed = false;
+
+	if (!len) {
+		spi_nor_async_done(flash, 0);
+		return 0;
 	}
 
-	rc = spi_flash_set_protection(flash, false);
-	if (rc < 0)
+	flash->async_op = op;
+	rc = spi_nor_async_issue(flash);
+	if (rc < 0) {
+		flash->async_op = SPI_NOR_ASYNC_NONE;
 		return rc;
+	}
 
-	spi_flash_command_init(&cmd, 0, flash->addr_len, SFLASH_TYPE_ERASE);
-	cmd.proto = flash->reg_proto;
-#ifdef CONFIG_HAVE_AESB
-	cmd.use_aesb = flash->use_aesb;
-#endif
-	while (len) {
-		const struct spi_flash_erase_command *erase = NULL;
-		size_t i;
+	return 0;
+}
 
-		for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
-			const struct spi_flash_erase_command *e;
-			uint32_t rem;
+/* Let the erase progress for tRS since the last resume, otherwise
+ * back-to-back reads could keep it suspended forever */
+static void spi_nor_async_wait_resume_interval(struct spi_flash *flash)
+{
+	uint64_t ticks;
+	uint32_t elapsed, remaining;
+
+	if (!flash->async_resumed)
+		return;
+
+	/* Ticks are 1ms: at least 'ticks - 1' ms went by */
+	ticks = timer_get_interval(flash->async_resume_tick, timer_get_tick());
+	if (ticks > 1 + flash->resume_interval / 1000)
+		return;
+	elapsed = ticks ? (uint32_t)(ticks - 1) * 1000 : 0;
+	if (elapsed >= flash->resume_interval)
+		return;
+
+	remaining = flash->resume_interval - elapsed;
+	if (remaining >= 1000) {
+		msleep(remaining / 1000);
+		remaining %= 1000;
+	}
+	if (remaining)
+		usleep(remaining);
+}
 
-			if ((map->uniform_region.cmd_mask & (0x1UL << i))) {
-				e = &map->commands[i];
-				spi_flash_div_by_erase_size(e, offset, &rem);
-				if (rem)
-					continue;
+/* Make [from, from + len) readable: suspend a running erase or finish a
+ * page program. The sector being erased reads undefined while the erase is
+ * suspended, so that erase is finished instead when the read overlaps it. */
+static int spi_nor_async_pause(struct spi_flash *flash, size_t from, size_t len)
+{
+	uint64_t start;
+	int rc;
 
-				if (e->size <= len && (!erase || erase->size < e->size))
-					erase = e;
-			}
-		}
-		if (!erase)
-			return -1;
+	if (!flash->async_busy || flash->async_suspended)
+		return 0;
 
-#ifdef SPI_NOR_VERBOSE_DEBUG
-		trace_info("spi-nor: erase params: inst=0x%x\r\n", erase->inst);
-		trace_info("spi-nor: erase params: size=%lu\r\n", erase->size);
-		trace_info("spi-nor: erase params: size_shift=%ld\r\n", erase->size_shift);
-		trace_info("spi-nor: erase params: size_mask=0x%lx\r\n", erase->size_mask);
-#endif
-		rc = spi_flash_write_enable(flash);
-		if (rc < 0)
-			break;
+	if (flash->async_op == SPI_NOR_ASYNC_ERASE && flash->suspend_inst &&
+	    (from >= flash->async_addr + flash->async_chunk ||
+	     flash->async_addr >= from + len)) {
+		spi_nor_async_wait_resume_interval(flash);
 
-		cmd.inst = erase->inst;
-		cmd.addr = offset;
-		rc = spi_flash_exec(flash, &cmd);
+		rc = spi_flash_write_reg(flash, flash->suspend_inst, NULL, 0);
 		if (rc < 0)
-			break;
-
-		rc = spi_flash_wait_till_ready(flash);
+			return rc;
+		/* tSUS is a few tens of us, WIP clears once suspended
+		 * (or when the erase completed in the meantime) */
+		start = timer_get_tick();
+		do {
+			rc = spi_flash_is_ready(flash);
+			if (rc == 0 && timer_get_interval(start, timer_get_tick()) > SPI_NOR_TIMEOUT_SUSPEND) {
+				/* Let the erase go on, the read fails */
+				spi_flash_write_reg(flash, flash->resume_inst, NULL, 0);
+				return -ETIMEDOUT;
+			}
+		} while (rc == 0);
 		if (rc < 0)
-			break;
+			return rc;
+		flash->async_suspended = true;
+		flash->async_suspend_tick = timer_get_tick();
+		return 0;
+	}
+
+	rc = spi_nor_async_wait(flash);
+	if (rc < 0)
+		spi_nor_async_done(flash, rc);
+	return rc;
+}
+
+static int spi_nor_async_unpause(struct spi_flash *flash)
+{
+	uint64_t now;
+
+	if (!flash->async_suspended)
+		return 0;
+
+	/* The erase timeout does not run while suspended */
+	now = timer_get_tick();
+	flash->async_start += timer_get_interval(flash->async_suspend_tick, now);
+	flash->async_resume_tick = now;
+	flash->async_resumed = true;
+
+	/* Resume is ignored if the erase completed before the suspend */
+	flash->async_suspended = false;
+	return spi_flash_write_reg(flash, flash->resume_inst, NULL, 0);
+}
+
+int spi_nor_poll(struct spi_flash *flash)
+{
+	int rc;
+
+	if (flash->async_op == SPI_NOR_ASYNC_NONE)
+		return 0;
+
+	if (flash->async_suspended)
+		return -EAGAIN;
+
+	if (flash->async_busy) {
+		rc = spi_nor_async_check(flash);
+		if (rc == -EAGAIN)
+			return rc;
+		if (rc < 0) {
+			spi_nor_async_done(flash, rc);
+			return rc;
+		}
+	}
 
-		offset += erase->size;
-		len -= erase->size;
+	if (!flash->async_len) {
+		spi_nor_async_done(flash, 0);
+		return 0;
 	}
 
+	rc = spi_nor_async_issue(flash);
+	if (rc < 0) {
+		spi_nor_async_done(flash, rc);
+		return rc;
+	}
+
+	return -EAGAIN;
+}
+
+bool spi_nor_is_busy(const struct spi_flash *flash)
+{
+	return flash->async_op != SPI_NOR_ASYNC_NONE;
+}
+
+int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
+{
+	int rc, rc2;
+
+	rc = spi_nor_async_pause(flash, from, len);
+	if (rc < 0)
+		return rc;
+
+	rc = spi_nor_read_buffered(flash, from, buf, len);
+
+	rc2 = spi_nor_async_unpause(flash);
+	return rc < 0 ? rc : rc2;
+}
+
+int spi_nor_read_async(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len, struct _callback* cb)
+{
+	/* an erase could not be resumed once the transfer is over */
+	if (flash->async_op != SPI_NOR_ASYNC_NONE)
+		return -EBUSY;
+
+	return spi_nor_read_direct(flash, from, buf, len, cb);
+}
+
+int spi_nor_write_async(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len, struct _callback* cb)
+{
+	return spi_nor_async_start(flash, SPI_NOR_ASYNC_WRITE, to, buf, len, cb);
+}
+
+int spi_nor_erase_async(struct spi_flash *flash, size_t offset, size_t len, struct _callback* cb)
+{
+	/* @TODO: add support to non uniform erase map. */
+	if (!spi_flash_has_uniform_erase(flash))
+		return -ENOTSUP;
+
+	return spi_nor_async_start(flash, SPI_NOR_ASYNC_ERASE, offset, NULL, len, cb);
+}
+
+int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len)
+{
+	int rc;
+
+	rc = spi_nor_write_async(flash, to, buf, len, NULL);
+	if (rc < 0)
+		return rc;
+
+	/* status is polled back to back: a page program takes less than
+	 * the 1ms period of spi_flash_wait_till_ready() */
+	do {
+		rc = spi_nor_poll(flash);
+	} while (rc == -EAGAIN);
+
+	return rc;
+}
+
+int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len)
+{
+	int rc;
+
+	rc = spi_nor_erase_async(flash, offset, len, NULL);
+	if (rc < 0)
+		return rc;
+
+	do {
+		rc = spi_nor_poll(flash);
+		if (rc == -EAGAIN)
+			msleep(1);
+	} while (rc == -EAGAIN);
+
 	return rc;
 }
@@ -114,9 +114,53 @@ extern const struct spi_nor_info spi_nor_ids[];
 
 int spi_nor_configure(struct spi_flash *flash, const struct spi_flash_cfg *cfg);
 int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len);
+
+/**
+ * Start a read and return without waiting for the data. The callback is
+ * called once the data is in memory, from the DMA interrupt when the
+ * controller can use DMA (QSPI, cache-aligned buffer and length),
+ * otherwise before returning. No other command may be issued until then.
+ * Returns -EBUSY while an asynchronous program/erase is pending.
+ */
+int spi_nor_read_async(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len, struct _callback* cb);
+
+/**
+ * Give spi_nor_read() a buffer to read ahead into, so that small sequential
+ * reads are served from memory. The buffer should be cache-line aligned
+ * with a size multiple of the cache line to be filled by DMA.
+ * A NULL buffer or a zero size disables read-ahead.
+ */
+void spi_nor_set_read_ahead(struct spi_flash *flash, uint8_t* buf, size_t size);
 int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len);
 int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len);
 
+/**
+ * Start programming or erasing and return once the first page program or
+ * sector erase has been issued. The operation then progresses from
+ * spi_nor_poll(), to be called periodically (e.g. from the main loop or a
+ * timer tick), which reads the status register once and issues the next
+ * command when the flash is ready. The callback is called from
+ * spi_nor_poll() on completion, with the status (0 or a negative errno)
+ * cast to a pointer as second argument. The data buffer must stay valid
+ * until then. Only one operation can be pending.
+ *
+ * spi_nor_read() can be used meanwhile: a running erase is suspended for
+ * the read when the flash supports it (SFDP) and the read does not overlap
+ * the sector being erased, otherwise the read waits for the running page
+ * program or sector erase. Data not yet programmed/erased is never kept in
+ * the read-ahead buffer.
+ */
+int spi_nor_write_async(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len, struct _callback* cb);
+int spi_nor_erase_async(struct spi_flash *flash, size_t offset, size_t len, struct _callback* cb);
+
+/**
+ * Advance the pending asynchronous program/erase.
+ * Returns -EAGAIN while in progress, 0 when idle or just completed, or a
+ * negative errno if the operation failed.
+ */
+int spi_nor_poll(struct spi_flash *flash);
+bool spi_nor_is_busy(const struct spi_flash *flash);
+
 int spansion_new_quad_enable(struct spi_flash *flash);
 int spansion_quad_enable(struct spi_flash *flash);
 int macronix_quad_enable(struct spi_flash *flash);
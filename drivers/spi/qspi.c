@@ -56,30 +56,85 @@
  *        LOCAL FUNCTIONS
  *----------------------------------------------------------------------------*/
 
+#ifdef CONFIG_HAVE_QSPI_DMA
+/* Widest DMA beat allowed by the alignment of both sides and the length */
+static uint32_t qspi_dma_width(const void *dst, const void *src, size_t count)
+{
+	uint32_t align = (uint32_t)dst | (uint32_t)src | count;
+
+	if (!(align & 3))
+		return DMA_DATA_WIDTH_WORD;
+	else if (!(align & 1))
+		return DMA_DATA_WIDTH_HALF_WORD;
+	else
+		return DMA_DATA_WIDTH_BYTE;
+}
+
+static int qspi_dma_callback(void *arg, void *arg2)
+{
+	union spi_flash_priv* priv = (union spi_flash_priv*)arg;
+	Qspi* qspi = priv->qspi.addr;
+
+	dma_reset_channel(priv->qspi.dma_ch);
+
+	if (priv->qspi.async) {
+		cache_invalidate_region(priv->qspi.rx_data, priv->qspi.rx_len);
+
+		/* Release the chip-select, the instruction ends a few
+		 * QSPI clock cycles later */
+		qspi->QSPI_CR = QSPI_CR_LASTXFER;
+		while (!(qspi->QSPI_SR & QSPI_SR_INSTRE));
+
+		priv->qspi.async = false;
+		priv->qspi.busy = false;
+		callback_call(&priv->qspi.callback, NULL);
+	} else {
+		priv->qspi.busy = false;
+	}
+
+	return 0;
+}
+
+static int qspi_dma_start(union spi_flash_priv* priv, void *dst, const void *src, size_t count)
+{
+	struct _dma_transfer_cfg cfg = {
+		.daddr = dst,
+		.saddr = src,
+	};
+	struct _dma_cfg dma_cfg = {
+		.incr_saddr = true,
+		.incr_daddr = true,
+		.data_width = qspi_dma_width(dst, src, count),
+		.chunk_size = DMA_CHUNK_SIZE_16,
+		.loop = false,
+	};
+	struct _callback _cb;
+	int rc;
+
+	cfg.len = count / DMA_DATA_WIDTH_IN_BYTE(dma_cfg.data_width);
+	rc = dma_configure_transfer(priv->qspi.dma_ch, &dma_cfg, &cfg, 1);
+	if (rc < 0)
+		return rc;
+	callback_set(&_cb, qspi_dma_callback, priv);
+	dma_set_callback(priv->qspi.dma_ch, &_cb);
+
+	priv->qspi.busy = true;
+	rc = dma_start_transfer(priv->qspi.dma_ch);
+	if (rc < 0)
+		priv->qspi.busy = false;
+
+	return rc;
+}
+#endif /* CONFIG_HAVE_QSPI_DMA */
+
 static void * qspi_memcpy(union spi_flash_priv* priv, uint8_t *dst, const uint8_t *src, int count, bool use_dma)
 {
 #ifdef CONFIG_HAVE_QSPI_DMA
 	if (use_dma) {
-		uint32_t rc;
-		struct _dma_transfer_cfg cfg = {
-			.daddr = (void *)dst,
-			.saddr = (void *)src,
-			.len = count,
-		};
-		static struct _dma_cfg dma_cfg = {
-			.incr_saddr = true,
-			.incr_daddr = true,
-			.data_width = DMA_DATA_WIDTH_BYTE,
-			.chunk_size = DMA_CHUNK_SIZE_1,
-			.loop = false,
-		};
-		dma_configure_transfer(priv->qspi.dma_ch, &dma_cfg, &cfg, 1);
-		rc = dma_start_transfer(priv->qspi.dma_ch);
-		if (rc != 0)
+		if (qspi_dma_start(priv, dst, src, count) != 0)
 			trace_fatal("Couldn't start xDMA transfer\n\r");
-		while (!dma_is_transfer_done(priv->qspi.dma_ch))
+		while (priv->qspi.busy)
 			dma_poll();
-		dma_reset_channel(priv->qspi.dma_ch);
 		dsb();
 
 		return dst;
@@ -309,6 +364,12 @@ static int qspi_exec(union spi_flash_priv* priv, const struct spi_flash_command
 	bool icr_write = false;
 #endif
 
+#ifdef CONFIG_HAVE_QSPI_DMA
+	/* An asynchronous read is still running */
+	if (priv->qspi.busy)
+		return -EBUSY;
+#endif
+
 	iar = 0;
 	icr = 0;
 
@@ -479,10 +540,10 @@ next:
 	(void)qspi->QSPI_IFR;
 
 #ifdef CONFIG_HAVE_QSPI_DMA
-	if (((cmd->flags == QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY) &&
+	if ((((cmd->flags & SFLASH_TYPE_MASK) == SFLASH_TYPE_WRITE) &&
 	     IS_CACHE_ALIGNED(cmd->tx_data) &&
 	     IS_CACHE_ALIGNED(cmd->data_len)) ||
-	    ((cmd->flags == QSPI_IFR_TFRTYP_TRSFR_READ_MEMORY) &&
+	    (((cmd->flags & SFLASH_TYPE_MASK) == SFLASH_TYPE_READ) &&
 	     IS_CACHE_ALIGNED(cmd->rx_data) &&
 	     IS_CACHE_ALIGNED(cmd->data_len)))
 		use_dma = true;
@@ -512,6 +573,22 @@ next:
 #endif
 			ptr = priv->qspi.mem;
 
+#ifdef CONFIG_HAVE_QSPI_DMA
+		if (use_dma && cmd->callback) {
+			/* The DMA callback releases the chip-select and
+			 * completes the command */
+			priv->qspi.async = true;
+			priv->qspi.rx_data = cmd->rx_data;
+			priv->qspi.rx_len = cmd->data_len;
+			callback_copy(&priv->qspi.callback, cmd->callback);
+			if (qspi_dma_start(priv, cmd->rx_data, ptr + offset, cmd->data_len) < 0) {
+				priv->qspi.async = false;
+				qspi->QSPI_CR = QSPI_CR_LASTXFER;
+				return -EIO;
+			}
+			return 0;
+		}
+#endif
 		qspi_memcpy(priv, cmd->rx_data, ptr + offset, cmd->data_len, use_dma);
 #ifdef CONFIG_HAVE_QSPI_DMA
 		if (use_dma)
@@ -558,6 +635,9 @@ no_data:
 	}
 #endif /* QSPI_VERBOSE_DEBUG */
 
+	if (cmd->callback)
+		callback_call(cmd->callback, NULL);
+
 	return 0;
 }
 
@@ -29,6 +29,7 @@
 #ifndef	QSPI_H_
 #define	QSPI_H_
 
+#include "callback.h"
 #ifdef CONFIG_HAVE_QSPI_DMA
 #include "dma/dma.h"
 #include "mm/cache.h"
@@ -50,6 +51,11 @@ struct qspi_priv {
 #endif
 #ifdef CONFIG_HAVE_QSPI_DMA
 	struct _dma_channel *dma_ch;
+	volatile bool busy;         /* DMA transfer in progress */
+	bool async;                 /* command completes from the DMA callback */
+	void *rx_data;              /* async read destination */
+	size_t rx_len;              /* async read length */
+	struct _callback callback;  /* async read completion */
 #endif
 };
 
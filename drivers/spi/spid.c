@@ -142,8 +142,8 @@ static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
 		.chunk_size = DMA_CHUNK_SIZE_1,
 	};
 
+	/* TX buffers have already been cleaned by _spid_clean_dma_buffers() */
 	if (desc->xfer.current->attr & BUS_BUF_ATTR_TX) {
-		cache_clean_region(desc->xfer.current->data, desc->xfer.current->size);
 		tx_cfg.saddr = desc->xfer.current->data;
 		tx_cfg_dma.incr_saddr = true;
 	}
@@ -307,6 +307,23 @@ static void _spid_transfer_next_buffer(struct _spi_desc* desc)
 	}
 }
 
+static void _spid_clean_dma_buffers(struct _buffer* buffers, int buffer_count)
+{
+	struct _cache_batch batch;
+	int i;
+
+	/* Clean all TX buffers that will be sent using DMA at once, instead
+	 * of once per buffer before each DMA transfer */
+	cache_batch_init(&batch, CACHE_OP_CLEAN);
+	for (i = 0; i < buffer_count; i++) {
+		if (buffers[i].size < SPID_POLLING_THRESHOLD)
+			continue;
+		if (buffers[i].attr & BUS_BUF_ATTR_TX)
+			cache_batch_add(&batch, buffers[i].data, buffers[i].size);
+	}
+	cache_batch_commit(&batch);
+}
+
 /*----------------------------------------------------------------------------
  *        Public functions
  *----------------------------------------------------------------------------*/
@@ -336,6 +353,9 @@ int spid_transfer(struct _spi_desc* desc,
 	desc->xfer.last = &buffers[buffer_count - 1];
 	callback_copy(&desc->xfer.callback, cb);
 
+	if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA)
+		_spid_clean_dma_buffers(buffers, buffer_count);
+
 	_spid_transfer_current_buffer(desc);
 
 	return 0;
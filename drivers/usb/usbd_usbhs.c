@@ -52,6 +52,7 @@
 
 #include "barriers.h"
 #include "chip.h"
+#include "intmath.h"
 #include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
@@ -79,6 +80,12 @@
 /** Number of endpoints */
 #define USB_ENDPOINTS FIELD_ARRAY_SIZE(Usbhs, USBHS_DEVEPTCFG)
 
+/** Number of DMA channels */
+#define USB_DMA_CHANNELS      FIELD_ARRAY_SIZE(Usbhs, USBHS_DEVDMA)
+
+/** Maximum number of DMA descriptors chained for one endpoint transfer */
+#define USB_DMA_CHAIN_SIZE    (8)
+
 /** Get Number of buffer in Multi-Buffer-List
  *  \param i    input index
  *  \param o    output index
@@ -109,6 +116,8 @@
  *  - USB_HAL_ENDPOINT_RECEIVING
  *  - USB_HAL_ENDPOINT_SENDINGM
  *  - USB_HAL_ENDPOINT_RECEIVINGM
+ *  - USB_HAL_ENDPOINT_SENDINGQ
+ *  - USB_HAL_ENDPOINT_RECEIVINGQ
  */
 enum _endpoint_state {
 	/**  Endpoint is disabled */
@@ -131,6 +140,12 @@ enum _endpoint_state {
 
 	/**  Endpoint is receiving MBL */
 	USB_HAL_ENDPOINT_RECEIVINGM,
+
+	/**  Endpoint is sending a buffer queue */
+	USB_HAL_ENDPOINT_SENDINGQ,
+
+	/**  Endpoint is receiving a buffer queue */
+	USB_HAL_ENDPOINT_RECEIVINGQ,
 };
 
 /** Describes a single buffer transfer */
@@ -170,6 +185,30 @@ struct _multi_xfer {
 	uint16_t in;
 };
 
+/** Describes a queued buffers transfer */
+struct _queue_xfer {
+	/**  Buffers of the batch being transferred */
+	struct _usbd_transfer_buffer *buffers;
+
+	/**  Number of buffers in the batch being transferred */
+	uint8_t count;
+
+	/**  Buffer being received (OUT endpoints only) */
+	uint8_t current;
+
+	/**  Index of the descriptor chain used by the batch */
+	uint8_t chain;
+
+	/**  Number of buffers in the pending batch (0 if none) */
+	uint8_t next_count;
+
+	/**  Buffers of the batch to start once the current one completes */
+	struct _usbd_transfer_buffer *next_buffers;
+
+	/**  Number of bytes transferred by the batch */
+	uint32_t transferred;
+};
+
 /**
  *  Describes the state of an endpoint of the USB Device controller.
  */
@@ -196,6 +235,7 @@ struct _endpoint {
 		union {
 			struct _single_xfer single;
 			struct _multi_xfer  multi;
+			struct _queue_xfer  queue;
 		};
 	} transfer;
 
@@ -241,6 +281,11 @@ static bool force_full_speed = false;
 /** DMA link list */
 CACHE_ALIGNED static struct _usb_dma_desc dma_desc[4];
 
+/** Per-endpoint DMA descriptor chains (two per channel, so that a queued
+ *  batch can be prepared while the previous one is running) */
+CACHE_ALIGNED static struct _usb_dma_desc
+	dma_chain[USB_DMA_CHANNELS][2][USB_DMA_CHAIN_SIZE];
+
 /*---------------------------------------------------------------------------
  *      Internal Functions
  *---------------------------------------------------------------------------*/
@@ -464,6 +509,15 @@ static void _usbd_hal_endpoint_dma_interrupt_enable(uint8_t ep)
 	USBHS->USBHS_DEVIER = USBHS_DEVIER_DMA_1 << (ep - 1);
 }
 
+/**
+ * Disables endpoint DMA interrupt for a given endpoint
+ */
+static void _usbd_hal_endpoint_dma_interrupt_disable(uint8_t ep)
+{
+	assert(ep > 0);
+	USBHS->USBHS_DEVIDR = USBHS_DEVIDR_DMA_1 << (ep - 1);
+}
+
 /**
  * \brief Read status for a DMA Endpoint
  * \param pUsbhs   Pointer to an USBHS instance.
@@ -561,6 +615,30 @@ static void _usbd_hal_end_of_transfer(uint8_t ep, uint8_t status)
 			}
 		}
 		break;
+	case USB_HAL_ENDPOINT_RECEIVINGQ:
+	case USB_HAL_ENDPOINT_SENDINGQ:
+		{
+			struct _queue_xfer *xfer = &endpoint->transfer.queue;
+
+			USB_HAL_TRACE("EoQT[%s%d:T%d] ",
+					endpoint->state == USB_HAL_ENDPOINT_RECEIVINGQ ? "R" : "S",
+					(unsigned)ep, (unsigned)xfer->transferred);
+
+			/* Stop the descriptor chain, pending batch is dropped */
+			USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL = 0;
+
+			endpoint->state = USB_HAL_ENDPOINT_IDLE;
+			xfer->count = 0;
+			xfer->next_count = 0;
+
+			/* Invoke callback */
+			if (endpoint->transfer.callback) {
+				endpoint->transfer.callback(
+						endpoint->transfer.callback_arg,
+						status, xfer->transferred, 0);
+			}
+		}
+		break;
 	default:
 		break;
 	}
@@ -908,6 +986,231 @@ static void _usbd_hal_dma_single(uint8_t ep, struct _single_xfer *xfer, uint32_t
 	_usbd_hal_endpoint_dma_interrupt_enable(ep);
 }
 
+/**
+ * Start a DMA descriptor chain on an endpoint.
+ * \param ep EP number
+ * \param desc First descriptor of the chain
+ * \param count Number of descriptors in the chain
+ */
+static void _usbd_hal_dma_chain_start(uint8_t ep, struct _usb_dma_desc *desc,
+		uint8_t count)
+{
+	/* Flush DMA descriptors */
+	cache_clean_region(desc, count * sizeof(*desc));
+
+	/* Clear pending status */
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMASTATUS = USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMASTATUS;
+
+	/* Interrupt enable */
+	_usbd_hal_endpoint_dma_interrupt_enable(ep);
+
+	/* Start transfer with LLI */
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMANXTDSC = (uint32_t)desc;
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL = 0;
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL = USBHS_DEVDMACONTROL_LDNXT_DSC;
+}
+
+/**
+ * Terminate a DMA descriptor chain: the last descriptor does not load
+ * another one and is the only one that raises an interrupt.
+ * \param desc First descriptor of the chain
+ * \param count Number of descriptors in the chain
+ */
+static void _usbd_hal_dma_chain_close(struct _usb_dma_desc *desc, uint8_t count)
+{
+	struct _usb_dma_desc *last = &desc[count - 1];
+
+	last->next = NULL;
+	last->ctrl &= ~USBHS_DEVDMACONTROL_LDNXT_DSC;
+	last->ctrl |= USBHS_DEVDMACONTROL_END_BUFFIT;
+}
+
+/**
+ * DMA chained send of a single buffer: the remaining data is split into
+ * DMA_MAX_FIFO_SIZE descriptors, up to USB_DMA_CHAIN_SIZE per chain.
+ * \param ep EP number
+ * \param xfer Pointer to transfer instance
+ */
+static void _usbd_hal_dma_chain_single(uint8_t ep, struct _single_xfer *xfer)
+{
+	struct _usb_dma_desc *desc = dma_chain[ep - 1][0];
+	uint8_t *data = &xfer->data[xfer->transferred];
+	uint32_t remaining = xfer->remaining;
+	uint8_t count;
+
+	xfer->buffered = 0;
+	for (count = 0; count < USB_DMA_CHAIN_SIZE && remaining; count++) {
+		uint32_t len = min_u32(remaining, DMA_MAX_FIFO_SIZE);
+
+		desc[count].next = &desc[count + 1];
+		desc[count].addr = data;
+		desc[count].ctrl = USBHS_DEVDMACONTROL_CHANN_ENB |
+			USBHS_DEVDMACONTROL_BUFF_LENGTH(len) |
+			USBHS_DEVDMACONTROL_END_B_EN |
+			USBHS_DEVDMACONTROL_LDNXT_DSC;
+		desc[count].reserved = 0;
+
+		data += len;
+		remaining -= len;
+		xfer->buffered += len;
+	}
+	_usbd_hal_dma_chain_close(desc, count);
+
+	_usbd_hal_dma_chain_start(ep, desc, count);
+}
+
+/**
+ * Build the descriptor chain sending a batch of queued buffers, one
+ * descriptor per buffer.
+ * \param ep EP number
+ * \param chain Index of the descriptor chain to fill
+ * \param buffers Buffers to send
+ * \param count Number of buffers
+ */
+static void _usbd_hal_dma_queue_prepare_tx(uint8_t ep, uint8_t chain,
+		struct _usbd_transfer_buffer *buffers, uint8_t count)
+{
+	struct _usb_dma_desc *desc = dma_chain[ep - 1][chain];
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		desc[i].next = &desc[i + 1];
+		desc[i].addr = buffers[i].buffer;
+		desc[i].ctrl = USBHS_DEVDMACONTROL_CHANN_ENB |
+			USBHS_DEVDMACONTROL_BUFF_LENGTH(buffers[i].size) |
+			USBHS_DEVDMACONTROL_END_B_EN |
+			USBHS_DEVDMACONTROL_LDNXT_DSC;
+		desc[i].reserved = 0;
+	}
+	_usbd_hal_dma_chain_close(desc, count);
+}
+
+/**
+ * Arm the DMA for the current buffer of a received batch.
+ * \param ep EP number
+ */
+static void _usbd_hal_dma_queue_rx(uint8_t ep)
+{
+	struct _queue_xfer *xfer = &endpoints[ep].transfer.queue;
+	struct _usbd_transfer_buffer *buffer = &xfer->buffers[xfer->current];
+
+	buffer->buffered = buffer->size;
+
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMAADDRESS = (uint32_t)buffer->buffer;
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMASTATUS = USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMASTATUS;
+
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL = 0;
+	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL = USBHS_DEVDMACONTROL_END_TR_EN |
+		USBHS_DEVDMACONTROL_END_TR_IT |
+		USBHS_DEVDMACONTROL_END_B_EN |
+		USBHS_DEVDMACONTROL_END_BUFFIT |
+		USBHS_DEVDMACONTROL_CHANN_ENB |
+		USBHS_DEVDMACONTROL_BUFF_LENGTH(buffer->size);
+
+	_usbd_hal_endpoint_dma_interrupt_enable(ep);
+}
+
+/**
+ * Start the batch of buffers described by the queue transfer.
+ * \param ep EP number
+ */
+static void _usbd_hal_dma_queue_start(uint8_t ep)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _queue_xfer *xfer = &endpoint->transfer.queue;
+
+	xfer->current = 0;
+	xfer->transferred = 0;
+
+	if (endpoint->state == USB_HAL_ENDPOINT_SENDINGQ)
+		_usbd_hal_dma_chain_start(ep, dma_chain[ep - 1][xfer->chain],
+				xfer->count);
+	else
+		_usbd_hal_dma_queue_rx(ep);
+}
+
+/**
+ * Endpoint DMA interrupt handler for queued buffers.
+ * Sent batches complete with a single interrupt. Received batches complete
+ * when all buffers are full or on a short packet. The pending batch, if
+ * any, is started before the completion callback is invoked so that the
+ * endpoint stays armed.
+ * \param ep Index of endpoint
+ * \param dma_status DMA channel status
+ */
+static void _usbd_hal_dma_queue_handler(uint8_t ep, uint32_t dma_status)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _queue_xfer *xfer = &endpoint->transfer.queue;
+	struct _usbd_transfer_buffer *buffer;
+	uint32_t remaining, transferred;
+	uint8_t i;
+
+	if (!(dma_status & (USBHS_DEVDMASTATUS_END_BF_ST |
+			USBHS_DEVDMASTATUS_END_TR_ST))) {
+		trace_error("_usbd_hal_dma_queue_handler: ST 0x%x\n\r",
+				(unsigned)dma_status);
+		_usbd_hal_end_of_transfer(ep, USBD_STATUS_ABORTED);
+		return;
+	}
+
+	/* BUFF_COUNT holds the number of bytes left in the last buffer */
+	remaining = (dma_status & USBHS_DEVDMASTATUS_BUFF_COUNT_Msk)
+		>> USBHS_DEVDMASTATUS_BUFF_COUNT_Pos;
+
+	if (endpoint->state == USB_HAL_ENDPOINT_SENDINGQ) {
+		/* The chain ran to its end, all buffers have been sent */
+		for (i = 0; i < xfer->count; i++) {
+			buffer = &xfer->buffers[i];
+			buffer->transferred = buffer->size;
+			buffer->buffered = 0;
+			buffer->remaining = 0;
+			xfer->transferred += buffer->size;
+		}
+		buffer = &xfer->buffers[xfer->count - 1];
+		buffer->transferred -= remaining;
+		buffer->remaining = remaining;
+		xfer->transferred -= remaining;
+	} else {
+		buffer = &xfer->buffers[xfer->current];
+		buffer->transferred = buffer->size - remaining;
+		buffer->buffered = 0;
+		buffer->remaining = remaining;
+		xfer->transferred += buffer->transferred;
+		if (buffer->transferred)
+			cache_invalidate_region(buffer->buffer, buffer->transferred);
+
+		/* Continue with next buffer unless a short packet ended the batch */
+		xfer->current++;
+		if (!(dma_status & USBHS_DEVDMASTATUS_END_TR_ST) &&
+				xfer->current < xfer->count) {
+			_usbd_hal_dma_queue_rx(ep);
+			return;
+		}
+	}
+
+	USB_HAL_TRACE("EoQ%d(%d) ", ep, (unsigned)xfer->transferred);
+
+	transferred = xfer->transferred;
+	if (xfer->next_count) {
+		/* Start pending batch */
+		xfer->buffers = xfer->next_buffers;
+		xfer->count = xfer->next_count;
+		xfer->chain ^= 1;
+		xfer->next_count = 0;
+		_usbd_hal_dma_queue_start(ep);
+	} else {
+		endpoint->state = USB_HAL_ENDPOINT_IDLE;
+		xfer->count = 0;
+	}
+
+	/* Invoke callback */
+	if (endpoint->transfer.callback) {
+		endpoint->transfer.callback(endpoint->transfer.callback_arg,
+				USBD_STATUS_SUCCESS, transferred, 0);
+	}
+}
+
 /**
  * Endpoint DMA interrupt handler.
  * This function handles DMA interrupts.
@@ -934,6 +1237,13 @@ static void _usbd_hal_dma_handler(uint8_t ep)
 	USBHS->USBHS_DEVDMA[ep - 1].USBHS_DEVDMACONTROL &=
 		~(USBHS_DEVDMACONTROL_END_TR_EN | USBHS_DEVDMACONTROL_END_B_EN);
 
+	/* Queued buffers */
+	if (endpoint->state == USB_HAL_ENDPOINT_SENDINGQ ||
+		endpoint->state == USB_HAL_ENDPOINT_RECEIVINGQ) {
+		_usbd_hal_dma_queue_handler(ep, dma_status);
+		return;
+	}
+
 	if (dma_status & USBHS_DEVDMASTATUS_END_BF_ST) {
 		USB_HAL_TRACE("EoDmaB ");
 
@@ -953,7 +1263,11 @@ static void _usbd_hal_dma_handler(uint8_t ep)
 				   (int)xfer->transferred, (int)xfer->remaining);
 
 		/* There is still data */
-		if (xfer->remaining + xfer->buffered > 0) {
+		if (endpoint->state == USB_HAL_ENDPOINT_SENDING &&
+				xfer->remaining > 0) {
+			/* Chain the next part of the buffer */
+			_usbd_hal_dma_chain_single(ep, xfer);
+		} else if (xfer->remaining + xfer->buffered > 0) {
 			if (xfer->remaining > DMA_MAX_FIFO_SIZE) {
 				xfer->buffered = DMA_MAX_FIFO_SIZE;
 			} else {
@@ -1039,17 +1353,8 @@ static uint8_t _usbd_hal_write(uint8_t ep,
 		/* Enable automatic bank switch for DMA */
 		_usbd_auto_switch_bank_enable(ep, true);
 
-		if (xfer->remaining > DMA_MAX_FIFO_SIZE) {
-			xfer->buffered = DMA_MAX_FIFO_SIZE;
-		} else {
-			xfer->buffered = xfer->remaining;
-		}
-
-		/* Single transfer */
-		_usbd_hal_dma_single(ep, xfer,
-				USBHS_DEVDMACONTROL_END_B_EN |
-				USBHS_DEVDMACONTROL_END_BUFFIT |
-				USBHS_DEVDMACONTROL_CHANN_ENB);
+		/* Whole buffer as one descriptor chain */
+		_usbd_hal_dma_chain_single(ep, xfer);
 	} else {
 		/* Wait for the bank to be free before disabling the automatic bank switch in order
 		 * to transfer data in FIFO mode correctly when the last is done with DMA.
@@ -1802,6 +2107,98 @@ uint8_t usbd_hal_read(uint8_t ep, void *data, uint32_t data_len)
 	}
 }
 
+/**
+ * Queues a batch of buffers on a DMA endpoint. The batch is described by a
+ * single descriptor chain on IN endpoints and completes with one
+ * interrupt; each buffer is sent as a separate USB transfer. On OUT
+ * endpoints the buffers are filled in order and the batch completes when
+ * they are all full or on a short packet.
+ *
+ * While a batch is in progress a second one can be queued: it is started
+ * from the interrupt handler as soon as the first completes, before the
+ * transfer callback is invoked, so that the endpoint stays armed.
+ *
+ * The callback set by usbd_hal_set_transfer_callback() is invoked once per
+ * batch with the total number of bytes transferred; the transferred field
+ * of each buffer is updated. *The buffers and the list must be kept
+ * allocated until the batch is finished*.
+ *
+ * \param ep Endpoint number.
+ * \param buffers List of buffers (buffer and size fields must be set).
+ * \param count Number of buffers, up to USB_DMA_CHAIN_SIZE.
+ * \return USBD_STATUS_SUCCESS if the batch has been started or queued;
+ *         otherwise, the corresponding error code.
+ */
+uint8_t usbd_hal_queue_buffers(uint8_t ep,
+		struct _usbd_transfer_buffer *buffers, uint8_t count)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _queue_xfer *xfer = &endpoint->transfer.queue;
+	enum _endpoint_state state;
+	uint8_t i;
+
+	if (!CHIP_USB_ENDPOINT_HAS_DMA(ep))
+		return USBD_STATUS_HW_NOT_SUPPORTED;
+
+	if (endpoint->transfer.use_multi)
+		return USBD_STATUS_SW_NOT_SUPPORTED;
+
+	if (count == 0 || count > USB_DMA_CHAIN_SIZE)
+		return USBD_STATUS_INVALID_PARAMETER;
+
+	if (_usbd_hal_endpoint_get_config(ep) & USBHS_DEVEPTCFG_EPDIR)
+		state = USB_HAL_ENDPOINT_SENDINGQ;
+	else
+		state = USB_HAL_ENDPOINT_RECEIVINGQ;
+
+	for (i = 0; i < count; i++) {
+		if (buffers[i].size == 0 || buffers[i].size > DMA_MAX_FIFO_SIZE)
+			return USBD_STATUS_INVALID_PARAMETER;
+		buffers[i].transferred = 0;
+		buffers[i].buffered = 0;
+		buffers[i].remaining = buffers[i].size;
+		if (state == USB_HAL_ENDPOINT_SENDINGQ)
+			cache_clean_region(buffers[i].buffer, buffers[i].size);
+	}
+
+	USB_HAL_TRACE("Q%d(%d) ", ep, (unsigned)count);
+
+	/* Keep the DMA handler away while the queue is updated */
+	if (endpoint->state == state)
+		_usbd_hal_endpoint_dma_interrupt_disable(ep);
+
+	if (endpoint->state == USB_HAL_ENDPOINT_IDLE) {
+		endpoint->state = state;
+		xfer->buffers = buffers;
+		xfer->count = count;
+		xfer->chain = 0;
+		xfer->next_count = 0;
+		if (state == USB_HAL_ENDPOINT_SENDINGQ) {
+			_usbd_auto_switch_bank_enable(ep, true);
+			_usbd_hal_dma_queue_prepare_tx(ep, 0, buffers, count);
+		}
+		_usbd_hal_dma_queue_start(ep);
+		return USBD_STATUS_SUCCESS;
+	}
+
+	if (endpoint->state != state || xfer->next_count) {
+		if (endpoint->state == state)
+			_usbd_hal_endpoint_dma_interrupt_enable(ep);
+		trace_warning("usbd_hal_queue_buffers: EP%d not ready\n\r", ep);
+		return USBD_STATUS_LOCKED;
+	}
+
+	/* Prepare the pending batch in the idle chain */
+	if (state == USB_HAL_ENDPOINT_SENDINGQ)
+		_usbd_hal_dma_queue_prepare_tx(ep, xfer->chain ^ 1, buffers, count);
+	xfer->next_buffers = buffers;
+	xfer->next_count = count;
+
+	_usbd_hal_endpoint_dma_interrupt_enable(ep);
+
+	return USBD_STATUS_SUCCESS;
+}
+
 
 /**
  *  \brief Enable Pull-up, connect.
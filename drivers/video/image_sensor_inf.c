@@ -33,18 +33,34 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "chip.h"
 #include "errno.h"
 #include "i2c/twid.h"
+#include "mm/cache.h"
 #include "peripherals/bus.h"
 #include "timer.h"
 #include "trace.h"
 #include "video/image_sensor_inf.h"
 
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** One register write, possibly covering several consecutive registers */
+struct _sensor_burst {
+	uint8_t data[SENSOR_BURST_MAX * 2];
+	uint8_t addr[2];
+	struct _buffer buf[2];
+};
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
+/** Register writes, one is prepared while the other is sent */
+CACHE_ALIGNED static struct _sensor_burst sensor_burst[2];
+
 /** Supported sensor profiles */
 static const struct sensor_profile* sensor_profiles[SENSOR_SUPPORTED_NUMBER] = {
 	&ov2640_profile,
@@ -120,64 +136,6 @@ static int sensor_twi_read_reg(uint8_t twi_mode, uint8_t bus, uint8_t addr,
 	return err;
 }
 
-/**
- * \brief  Write a value to a register in an dedicated sensor device.
- * \param bus  TWI bus
- * \param addr Sensor TWI addr
- * \param reg Register to be written
- * \param data Data written
- * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
- */
-static int sensor_twi_write_reg(uint8_t twi_mode, uint8_t bus, uint8_t addr,
-				uint16_t reg, uint8_t *data)
-{
-	int err;
-	uint8_t addr_buf[2];
-	struct _buffer buf[2] = {
-		{
-			.data = addr_buf,
-			/* .size */
-			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX,
-		},
-		{
-			.data = data,
-			/* .size */
-			.attr = BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
-		},
-	};
-
-	switch (twi_mode){
-	case SENSOR_TWI_REG_BYTE_DATA_BYTE:
-		buf[0].size = 1;
-		buf[1].size = 1;
-		addr_buf[0] = reg & 0xff;
-
-		break;
-
-	case SENSOR_TWI_REG_2BYTE_DATA_BYTE:
-		buf[0].size = 2;
-		buf[1].size = 1;
-		addr_buf[0] = (reg >> 8) & 0xff;
-		addr_buf[1] = reg & 0xff;
-		break;
-
-	case SENSOR_TWI_REG_BYTE_DATA_2BYTE:
-		buf[0].size = 1;
-		buf[1].size = 2;
-		addr_buf[0] = reg & 0xff;
-		break;
-
-	default:
-		return -EINVAL;
-	}
-
-	bus_start_transaction(bus);
-	err = bus_transfer(bus, addr, buf, 2, NULL);
-	bus_stop_transaction(bus);
-
-	return err;
-}
-
 /**
  * \brief Read and check sensor product ID.
  * \param twi_bus  TWI bus
@@ -215,9 +173,72 @@ static uint32_t sensor_check_pid(uint8_t twi_bus, struct sensor_profile* sensor_
 		return SENSOR_ID_ERROR;
 }
 
+/**
+ * \brief Build the next write of a register list. Consecutive registers are
+ * merged into one auto-increment write, up to the sensor burst length.
+ * \param sensor_profile   Sensor private profile
+ * \param next First register list entry to write
+ * \param burst Burst to fill
+ * \return number of list entries consumed, 0 on error
+ */
+static uint32_t sensor_burst_prepare(const struct sensor_profile* sensor_profile,
+				     const struct sensor_reg* next,
+				     struct _sensor_burst* burst)
+{
+	uint32_t max = sensor_profile->burst_len;
+	uint32_t data_len = 1;
+	uint32_t count = 0;
+
+	switch (sensor_profile->twi_inf_mode) {
+	case SENSOR_TWI_REG_BYTE_DATA_BYTE:
+		burst->buf[0].size = 1;
+		burst->addr[0] = next->reg & 0xff;
+		break;
+
+	case SENSOR_TWI_REG_2BYTE_DATA_BYTE:
+		burst->buf[0].size = 2;
+		burst->addr[0] = (next->reg >> 8) & 0xff;
+		burst->addr[1] = next->reg & 0xff;
+		break;
+
+	case SENSOR_TWI_REG_BYTE_DATA_2BYTE:
+		burst->buf[0].size = 1;
+		burst->addr[0] = next->reg & 0xff;
+		data_len = 2;
+		break;
+
+	default:
+		return 0;
+	}
+
+	if (max < 1)
+		max = 1;
+	else if (max > SENSOR_BURST_MAX)
+		max = SENSOR_BURST_MAX;
+
+	while (count < max &&
+	       next[count].reg == next->reg + count &&
+	       next[count].reg != SENSOR_REG_DELAY &&
+	       !((next[count].reg == SENSOR_REG_TERM) && (next[count].val == SENSOR_VAL_TERM))) {
+		memcpy(&burst->data[count * data_len], &next[count].val, data_len);
+		count++;
+	}
+
+	burst->buf[0].data = burst->addr;
+	burst->buf[0].attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX;
+	burst->buf[1].data = burst->data;
+	burst->buf[1].size = count * data_len;
+	burst->buf[1].attr = BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP;
+
+	return count;
+}
+
 /**
  * \brief  Initialize a list of registers.
  * The list of registers is terminated by the pair of values
+ * SENSOR_REG_TERM/SENSOR_VAL_TERM. SENSOR_REG_DELAY entries wait for the
+ * given number of milliseconds once the previous writes are done.
+ * Each write is prepared while the previous one is on the bus.
  * \param twi_bus  TWI bus
  * \param sensor_profile   Sensor private profile
  * \param reglist Register list to be written
@@ -227,21 +248,50 @@ static uint32_t sensor_twi_write_regs(uint8_t twi_bus,
 									  struct sensor_profile* sensor_profile,
 									  const struct sensor_reg* reglist)
 {
-	int status;
+	int status = 0;
 	const struct sensor_reg *next = reglist;
+	uint8_t index = 0;
+
+	bus_start_transaction(twi_bus);
 
 	while (!((next->reg == SENSOR_REG_TERM) && (next->val == SENSOR_VAL_TERM))) {
-		status = sensor_twi_write_reg(sensor_profile->twi_inf_mode,
-									  twi_bus,
-									  sensor_profile->addr,
-									  next->reg,
-									  (uint8_t *)(&next->val));
-		msleep(2);
+		struct _sensor_burst* burst = &sensor_burst[index];
+		uint32_t count;
+
+		if (next->reg == SENSOR_REG_DELAY) {
+			status = bus_wait_transfer(twi_bus);
+			if (status < 0)
+				break;
+			msleep(next->val);
+			next++;
+			continue;
+		}
+
+		/* The other burst may still be on the bus */
+		count = sensor_burst_prepare(sensor_profile, next, burst);
+		if (count == 0) {
+			status = -EINVAL;
+			break;
+		}
+
+		status = bus_wait_transfer(twi_bus);
+		if (status < 0)
+			break;
+		status = bus_transfer(twi_bus, sensor_profile->addr, burst->buf, 2, NULL);
 		if (status < 0)
-			return SENSOR_TWI_ERROR;
-		next++;
+			break;
+
+		next += count;
+		index ^= 1;
 	}
 
+	if (bus_wait_transfer(twi_bus) < 0)
+		status = -ETIMEDOUT;
+	bus_stop_transaction(twi_bus);
+
+	if (status < 0)
+		return SENSOR_TWI_ERROR;
+
 	return SENSOR_OK;
 }
 
@@ -255,6 +305,8 @@ uint32_t sensor_setup(uint8_t twi_bus, struct sensor_profile* sensor_profile,
 {
 	uint8_t i;
 	uint8_t found = 0;
+	uint32_t status;
+	uint64_t start;
 
 	for (i = 0; i < SENSOR_SUPPORTED_OUTPUTS; i++) {
 		if (sensor_profile->output_conf[i]->supported){
@@ -269,8 +321,13 @@ uint32_t sensor_setup(uint8_t twi_bus, struct sensor_profile* sensor_profile,
 	if (found == 0)
 		return SENSOR_RESOLUTION_NOT_SUPPORTED;
 
-	return sensor_twi_write_regs(twi_bus, sensor_profile,
-								 sensor_profile->output_conf[i]->output_setting);
+	start = timer_get_tick();
+	status = sensor_twi_write_regs(twi_bus, sensor_profile,
+								   sensor_profile->output_conf[i]->output_setting);
+	trace_debug("SENSOR setup in %u ms\r\n",
+		    (unsigned)timer_get_interval(start, timer_get_tick()));
+
+	return status;
 }
 
 struct sensor_profile* sensor_detect(uint8_t twi_bus, bool detect_auto, uint8_t id)
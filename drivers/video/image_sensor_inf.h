@@ -57,6 +57,11 @@
 #define SENSOR_REG_TERM         0xFF
 /** terminating list entry for value in configuration file */
 #define SENSOR_VAL_TERM         0xFF
+/** delay list entry for register, the value is the delay in ms */
+#define SENSOR_REG_DELAY        0xFFFF
+
+/** maximum number of registers written in one auto-increment burst */
+#define SENSOR_BURST_MAX        64
 
 /*----------------------------------------------------------------------------
  *        Types
@@ -139,6 +144,7 @@ struct sensor_profile {
 	uint16_t pid_low;             /** product ID low byte */
 	uint16_t version_mask;        /** version mask */
 	const struct sensor_output* output_conf[SENSOR_SUPPORTED_OUTPUTS]; /** sensor settings */
+	uint8_t burst_len;            /** max registers per auto-increment write, 0 to write them one by one */
 };
 
 /*----------------------------------------------------------------------------
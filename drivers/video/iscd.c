@@ -183,7 +183,7 @@ static void _isc_handler(uint32_t source, void* arg)
 		else
 			iscd->pipe.frame_idx++;
 		if (iscd->dma.callback)
-			iscd->dma.callback(iscd->pipe.frame_idx);
+			iscd->dma.callback(iscd->pipe.frame_buf[iscd->pipe.frame_idx]);
 	}
 	if ((status & ISC_INTSR_HISDONE) == ISC_INTSR_HISDONE)
 		awb.dma.dma_histo_ready = true;
@@ -199,6 +199,9 @@ static uint8_t _iscd_configure_dma(struct _iscd_desc* desc)
 	struct _isc_dma_view1* dma_view1;
 	struct _isc_dma_view2* dma_view2;
 
+	for (i = 0; i < desc->cfg.multi_bufs; i++)
+		desc->pipe.frame_buf[i] = i;
+
 	switch (desc->cfg.layout) {
 	case ISCD_LAYOUT_PACKED8:
 	case ISCD_LAYOUT_PACKED16:
@@ -425,6 +428,53 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 	return ISCD_OK;
 }
 
+/**
+ * \brief Select the buffer filled by the frame after the current one.
+ * To be called from the dma callback, which is given the index of the
+ * buffer being filled: the DMA descriptor fetched at the next frame start
+ * is pointed to buffer 'buffer' of the ring (dma.address0 + buffer *
+ * dma.size). Without it, buffers are filled in ring order.
+ */
+void iscd_set_next_buffer(struct _iscd_desc* desc, uint8_t buffer)
+{
+	uint8_t next;
+	uint32_t offset = buffer * desc->dma.size;
+
+	next = (desc->pipe.frame_idx == (desc->cfg.multi_bufs - 1)) ?
+		0 : desc->pipe.frame_idx + 1;
+	desc->pipe.frame_buf[next] = buffer;
+
+	switch (desc->cfg.layout) {
+	case ISCD_LAYOUT_PACKED8:
+	case ISCD_LAYOUT_PACKED16:
+	case ISCD_LAYOUT_PACKED32:
+		_isc_dma_view_pool.view0[next].addr = desc->dma.address0 + offset;
+		cache_clean_region(&_isc_dma_view_pool.view0[next],
+				sizeof(struct _isc_dma_view0));
+		break;
+
+	case ISCD_LAYOUT_YC420SP:
+	case ISCD_LAYOUT_YC422SP:
+		_isc_dma_view_pool.view1[next].addr0 = desc->dma.address0 + offset;
+		_isc_dma_view_pool.view1[next].addr1 = desc->dma.address1 + offset;
+		cache_clean_region(&_isc_dma_view_pool.view1[next],
+				sizeof(struct _isc_dma_view1));
+		break;
+
+	case ISCD_LAYOUT_YC422P:
+	case ISCD_LAYOUT_YC420P:
+		_isc_dma_view_pool.view2[next].addr0 = desc->dma.address0 + offset;
+		_isc_dma_view_pool.view2[next].addr1 = desc->dma.address1 + offset;
+		_isc_dma_view_pool.view2[next].addr2 = desc->dma.address2 + offset;
+		cache_clean_region(&_isc_dma_view_pool.view2[next],
+				sizeof(struct _isc_dma_view2));
+		break;
+
+	default:
+		break;
+	}
+}
+
 /**
  * \brief Image tuning for AWB, this is a reference algrothm only.
  */
@@ -139,6 +139,8 @@ struct _iscd_desc {
 		struct _color_correct* color_correction;
 		enum _iscd_rlp_mode rlp_mode;
 		uint8_t frame_idx;
+		/* buffer captured through each DMA descriptor */
+		uint8_t frame_buf[ISCD_MAX_DMA_DESC];
 	} pipe;
 	struct {
 		uint32_t address0;
@@ -167,6 +169,8 @@ struct _iscd_awb {
 
 extern uint8_t iscd_pipe_start(struct _iscd_desc* desc);
 
+extern void iscd_set_next_buffer(struct _iscd_desc* desc, uint8_t buffer);
+
 extern void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf);
 
 #endif /* ISCD_H_ */
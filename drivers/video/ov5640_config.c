@@ -56,7 +56,7 @@
 static const struct sensor_reg ov5640_raw_qvga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 5},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -187,7 +187,7 @@ static const struct sensor_reg ov5640_raw_qvga[] = {
 static const struct sensor_reg ov5640_yuv_qvga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 5},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -490,7 +490,7 @@ static const struct sensor_reg ov5640_yuv_qvga[] = {
 static const struct sensor_reg ov5640_yuv_vga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 5},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -790,7 +790,7 @@ static const struct sensor_reg ov5640_yuv_vga[] = {
 static const struct sensor_reg ov5640_yuv_wxga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 5},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -5273,5 +5273,6 @@ const struct sensor_profile ov5640_profile =
 		&ov5640_output_af,
 		0,
 		0
-	}
+	},
+	32                               /* registers per auto-increment write */
 };
@@ -197,6 +197,7 @@
 
 static const struct sensor_reg ov7670_yuv_vga[] = {
 	{ REG_COM7, COM7_RESET },
+	{ SENSOR_REG_DELAY, 5 },
 
 	{ REG_CLKRC, 0x1 },     /* OV: clock scale (30 fps) */
 	{ REG_TSLB,  0x04 },    /* OV */
@@ -381,6 +382,7 @@ static const struct sensor_reg ov7670_yuv_vga[] = {
 
 static const struct sensor_reg ov7670_qvga_raw[] = {
 	{ REG_COM7, COM7_RESET },
+	{ SENSOR_REG_DELAY, 5 },
 
 	{ REG_CLKRC, 0x1 },     /* OV: clock scale (30 fps) */
 	{ REG_TSLB,  0x04 },    /* OV */
@@ -571,6 +573,7 @@ static const struct sensor_reg ov7670_qvga_raw[] = {
 
 static const struct sensor_reg ov7670_qvga_yuv[] = {
 	{ REG_COM7, COM7_RESET },
+	{ SENSOR_REG_DELAY, 5 },
 	{ REG_CLKRC, 0x1 },     /* OV: clock scale (30 fps) */
 	{ REG_TSLB,  0x04 },    /* OV */
 	{ REG_COM7,  0x10 },    /* QVGA */
@@ -44,6 +44,12 @@
 #define LWIP_IPV6                       0
 #define LWIP_PERF                       0
 
+/* IP/TCP/UDP checksums are offloaded to the GMAC when available */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+
+/* Checksum TCP payload while copying it in tcp_write() (LWIP_CHKSUM_COPY) */
+#define LWIP_CHECKSUM_ON_COPY           1
+
 #define LWIP_PROVIDE_ERRNO              1
 
 #endif /* LWIPOPTS_H */
@@ -0,0 +1,325 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page gfx_bench Graphics library benchmark
+ *
+ *  \section Purpose
+ *
+ *  The example measures the throughput of the libgfx raster operations on
+ *  off-screen frame buffers located in DDR.
+ *
+ *  \section Requirements
+ *
+ *  This package can be used with SAMA5 and SAM9XX5.
+ *
+ *  \section Description
+ *
+ *  For each supported depth (16, 24 and 32 bits per pixel), every operation
+ *  is run repeatedly for about half a second and its throughput is reported
+ *  in megapixels per second:
+ *  - a per-pixel fill, as done by the LCD example before libgfx,
+ *  - full screen and small rectangle fills,
+ *  - blits of a quarter of the screen,
+ *  - alpha blending of an ARGB 8888 sprite,
+ *  - text rendering through a glyph cache.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board. Please
+ *     refer to the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/6421B.pdf">
+ *     SAM-BA User Guide</a>, the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *     GNU-Based Software Development</a>
+ *     application note or to the
+ *     <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *     IAR EWARM User Guide</a>,
+ *     depending on your chosen solution.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Start the application.
+ *  -# In the terminal window, the following text should appear:
+ *     \code
+ *      -- Graphics Benchmark Example xxx --
+ *      -- 16 bpp --
+ *      per-pixel fill       : xx.xx Mpixel/s
+ *      ...
+ *     \endcode
+ *
+ *  \section References
+ *  - gfx_bench/main.c
+ *  - gfx.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the graphics benchmark
+ *  example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+#include "compiler.h"
+#include "timer.h"
+
+#include "mm/cache.h"
+#include "serial/console.h"
+
+#include "libgfx/gfx.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the off-screen frame buffers */
+#define BENCH_WIDTH 480
+#define BENCH_HEIGHT 272
+
+/** Minimum duration of each measurement, in ms */
+#define BENCH_DURATION 500
+
+/** Size of the blended sprite */
+#define SPRITE_SIZE 64
+
+/** Size of the rectangles of the small fill test */
+#define SMALL_RECT_W 37
+#define SMALL_RECT_H 23
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _bench {
+	const char *name;
+	void (*run)(void);
+	uint32_t pixels;  /**< pixels processed by one run */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED_DDR static uint8_t dst_buffer[BENCH_WIDTH * BENCH_HEIGHT * 4];
+CACHE_ALIGNED_DDR static uint8_t src_buffer[BENCH_WIDTH * BENCH_HEIGHT * 4];
+CACHE_ALIGNED_DDR static uint32_t sprite[SPRITE_SIZE * SPRITE_SIZE];
+
+static struct _gfx_surface dst;
+static struct _gfx_surface src;
+
+static const char bench_text[] = "The quick brown fox jumps over the lazy dog";
+
+/** Synthetic 8x12 font, glyphs are derived from the character code */
+static bool _bench_font_pixel(const struct _gfx_font *font, uint8_t c,
+		uint8_t x, uint8_t y)
+{
+	return ((c >> (y & 7)) ^ (x * 3 + y)) & 1;
+}
+
+static const struct _gfx_font bench_font = {
+	.width = 8,
+	.height = 12,
+	.spacing = 1,
+	.first = 32,
+	.count = 96,
+	.pixel = _bench_font_pixel,
+	.data = NULL,
+};
+
+static struct _gfx_glyph_cache glyph_cache;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Fill the whole surface one pixel at a time, the way the LCD example
+ * drew rectangles before libgfx. Used as a reference.
+ */
+static void _bench_pixel_fill(void)
+{
+	uint32_t color = 0x00123456;
+	uint32_t bytes = dst.bpp / 8;
+	uint32_t x, y;
+
+	for (y = 0; y < dst.height; y++) {
+		uint8_t *row = (uint8_t*)dst.buffer + y * dst.stride;
+		for (x = 0; x < dst.width; x++)
+			memcpy(row + x * bytes, &color, bytes);
+	}
+}
+
+static void _bench_fill(void)
+{
+	gfx_fill_rect(&dst, 0, 0, dst.width, dst.height, 0x00654321);
+}
+
+static void _bench_small_fill(void)
+{
+	int x, y;
+
+	for (y = 0; y + SMALL_RECT_H <= dst.height; y += SMALL_RECT_H)
+		for (x = 0; x + SMALL_RECT_W <= dst.width; x += SMALL_RECT_W)
+			gfx_fill_rect(&dst, x, y, SMALL_RECT_W, SMALL_RECT_H,
+					(uint32_t)(x ^ y));
+}
+
+static void _bench_blit(void)
+{
+	gfx_blit(&dst, dst.width / 4 + 1, dst.height / 4,
+			&src, 0, 0, dst.width / 2, dst.height / 2);
+}
+
+static void _bench_blend(void)
+{
+	gfx_blend(&dst, 13, 7, sprite, SPRITE_SIZE * 4,
+			SPRITE_SIZE, SPRITE_SIZE, 0xC0);
+}
+
+static void _bench_text(void)
+{
+	uint32_t bg = 0;
+	int y;
+
+	for (y = 0; y + bench_font.height <= dst.height;
+	     y += bench_font.height + bench_font.spacing)
+		gfx_draw_text(&dst, &glyph_cache, 3, y, bench_text,
+				0x00FFFFFF, &bg);
+}
+
+static const struct _bench benches[] = {
+	{
+		.name = "per-pixel fill",
+		.run = _bench_pixel_fill,
+		.pixels = BENCH_WIDTH * BENCH_HEIGHT,
+	},
+	{
+		.name = "gfx_fill_rect",
+		.run = _bench_fill,
+		.pixels = BENCH_WIDTH * BENCH_HEIGHT,
+	},
+	{
+		.name = "gfx_fill_rect 37x23",
+		.run = _bench_small_fill,
+		.pixels = (BENCH_WIDTH / SMALL_RECT_W) * SMALL_RECT_W *
+		          (BENCH_HEIGHT / SMALL_RECT_H) * SMALL_RECT_H,
+	},
+	{
+		.name = "gfx_blit",
+		.run = _bench_blit,
+		.pixels = (BENCH_WIDTH / 2) * (BENCH_HEIGHT / 2),
+	},
+	{
+		.name = "gfx_blend",
+		.run = _bench_blend,
+		.pixels = SPRITE_SIZE * SPRITE_SIZE,
+	},
+	{
+		.name = "gfx_draw_text",
+		.run = _bench_text,
+		.pixels = (sizeof(bench_text) - 1) * 8 * 12 *
+		          ((BENCH_HEIGHT - 12) / 13 + 1),
+	},
+};
+
+/**
+ * \brief Run a benchmark for at least BENCH_DURATION ms and print its
+ * throughput.
+ */
+static void _run_bench(const struct _bench *bench)
+{
+	uint64_t start, elapsed;
+	uint64_t pixels = 0;
+	uint32_t rate;
+
+	start = timer_get_tick();
+	do {
+		bench->run();
+		pixels += bench->pixels;
+		elapsed = timer_get_tick() - start;
+	} while (elapsed < BENCH_DURATION);
+
+	/* pixels per ms is kpixel/s, keep two decimals of Mpixel/s */
+	rate = (uint32_t)(pixels * 100 / (elapsed * 1000));
+	printf("%-22s: %3u.%02u Mpixel/s\r\n", bench->name,
+			(unsigned)(rate / 100), (unsigned)(rate % 100));
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Application entry point for the graphics benchmark example.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	static const uint8_t depths[] = { 16, 24, 32 };
+	uint32_t i, j;
+
+	/* Output example information */
+	console_example_info("Graphics Benchmark Example");
+
+	for (i = 0; i < ARRAY_SIZE(src_buffer); i++)
+		src_buffer[i] = (uint8_t)(i * 7);
+	for (i = 0; i < ARRAY_SIZE(sprite); i++)
+		sprite[i] = ((i * 4) << 24) | (i * 0x010305);
+
+	gfx_init_glyph_cache(&glyph_cache, &bench_font);
+
+	for (i = 0; i < ARRAY_SIZE(depths); i++) {
+		gfx_init_surface(&dst, dst_buffer, BENCH_WIDTH, BENCH_HEIGHT,
+				depths[i]);
+		gfx_init_surface(&src, src_buffer, BENCH_WIDTH, BENCH_HEIGHT,
+				depths[i]);
+
+		printf("-- %u bpp --\r\n", (unsigned)depths[i]);
+		for (j = 0; j < ARRAY_SIZE(benches); j++)
+			_run_bench(&benches[j]);
+	}
+
+	while (1);
+}
@@ -44,6 +44,7 @@
 #include "compiler.h"
 
 #include "display/lcdc.h"
+#include "libgfx/gfx.h"
 
 #include "lcd_draw.h"
 #include "lcd_font.h"
@@ -97,39 +98,14 @@ static void _set_front_color(uint32_t color)
  */
 static void _draw_pixel(uint32_t dwX, uint32_t dwY)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffer = pDisp->buffer;
-	uint16_t w = pDisp->width;
-	//uint16_t h = pDisp->height;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	//uint8_t  r, g, b;
-	uint8_t *pPix;
+	struct _gfx_surface surface;
 
-	if (buffer == NULL)
+	lcd_get_canvas_surface(&surface);
+	if (surface.buffer == NULL)
 		return;
 
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[dwY * rw + cw * dwX];
-
-	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		break;
-	case 24:		/*  RGB  888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		break;
-	case 32:		/* ARGB 8888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		pPix[3] = (front_color >> 24) & 0xFF;
-		break;
-	}
+	gfx_draw_pixel(&surface, dwX, dwY, front_color);
+	lcdc_add_canvas_damage(dwX, dwY, 1, 1);
 }
 
 /**
@@ -141,56 +117,15 @@ static void _draw_pixel(uint32_t dwX, uint32_t dwY)
  */
 static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t w = pDisp->width;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *base;
-	uint8_t *buffer = pDisp->buffer;
-	uint32_t fillStart, fillEnd;
-	uint32_t i;
-	if (buffer == NULL)
-		return;
+	struct _gfx_surface surface;
 
-	/* 4-byte aligned rows */
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;
-	/* Buffer address for the starting row */
-	base = &buffer[dwY1 * rw];
-
-	fillStart = dwX1 * cw;
-	fillEnd = dwX2 * cw;
-
-#if 1				/* Memcopy pixel */
-	buffer = base;
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = fillStart; i <= fillEnd; i += cw) {
-			memcpy(&buffer[i], &front_color, cw);
-		}
-		buffer = &buffer[rw];
-	}
-#endif
-
-#if 0				/* Pixel by pixel */
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = dwX1; i <= dwX2; i++) {
-			_draw_pixel(i, dwY1);
-		}
-	}
-#endif
+	lcd_get_canvas_surface(&surface);
+	if (surface.buffer == NULL)
+		return;
 
-#if 0				/* Optimized */
-	/* First row */
-	for (i = fillStart; i <= fillEnd; i += cw) {
-		memcpy(&base[i], &front_color, cw);
-	}
-	/* Next rows, copy first */
-	buffer = &base[rw + fillStart];
-	for (i = dwY1 + 1; i <= dwY2; i++) {
-		memcpy(buffer, &base[fillStart], fillEnd - fillStart + cw);
-		buffer = &buffer[rw];
-	}
-#endif
+	gfx_fill_rect(&surface, dwX1, dwY1, dwX2 - dwX1 + 1, dwY2 - dwY1 + 1,
+			front_color);
+	lcdc_add_canvas_damage(dwX1, dwY1, dwX2 - dwX1 + 1, dwY2 - dwY1 + 1);
 }
 
 /**
@@ -281,6 +216,19 @@ static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief Describe the current canvas as a graphics surface.
+ *
+ * \param surface  Surface to initialize.
+ */
+void lcd_get_canvas_surface(struct _gfx_surface *surface)
+{
+	struct _lcdc_layer *pDisp = lcdc_get_canvas();
+
+	gfx_init_surface(surface, pDisp->buffer, pDisp->width, pDisp->height,
+			pDisp->bpp);
+}
+
 /**
  * \brief Fills the given LCD buffer with a particular color.
  *
@@ -315,6 +263,8 @@ void lcd_fill_yuv422(void)
 	uint32_t i;
 	uint32_t h = pDisp->width;
 	uint32_t v = pDisp->height;
+
+	lcdc_add_canvas_damage(0, 0, h, v);
 	for(i=0;i<h*v*2/8;) {
 		if(((i/h)%2)==0) {
 			buffur[i++]=81; buffur[i++]=239;buffur[i++]=81;buffur[i++]=90;
@@ -719,24 +669,16 @@ void lcd_get_string_size(const char *p_string, uint32_t * p_width, uint32_t * p_
 void lcd_draw_image(uint32_t dwX, uint32_t dwY, const uint8_t * pImage,
 		     uint32_t width, uint32_t height)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = pDisp->width * cw;	/* Row width in bytes */
-	uint32_t rws = width * cw;	/* Source Row Width */
-	uint32_t rl = (rw & 0x3) ? ((rw | 0x3) + 1) : rw;	/* Aligned length */
-	uint32_t rls = (rws & 0x3) ? ((rws | 0x3) + 1) : rws;	/* Aligned length */
-	uint8_t *pSrc, *pDst;
-	uint32_t i;
+	struct _gfx_surface surface, image;
 
-	pSrc = (uint8_t *) pImage;
-	pDst = pDisp->buffer;
-	pDst = &pDst[dwX * cw + dwY * rl];
+	lcd_get_canvas_surface(&surface);
+	if (surface.buffer == NULL)
+		return;
 
-	for (i = 0; i < height; i++) {
-		memcpy(pDst, pSrc, rws);
-		pSrc = &pSrc[rls];
-		pDst = &pDst[rl];
-	}
+	/* Source rows are 4-byte aligned too */
+	gfx_init_surface(&image, (void *)pImage, width, height, surface.bpp);
+	gfx_blit(&surface, dwX, dwY, &image, 0, 0, width, height);
+	lcdc_add_canvas_damage(dwX, dwY, width, height);
 }
 
 /**
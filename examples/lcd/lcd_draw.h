@@ -62,6 +62,8 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include "libgfx/gfx.h"
+
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -74,6 +76,8 @@
 
 	 /** \addtogroup lcdc_draw_func LCD Drawing Functions */
 /** @{*/
+extern void lcd_get_canvas_surface(struct _gfx_surface *surface);
+
 extern void lcd_fill_white(void);
 
 extern void lcd_fill(uint32_t color);
@@ -42,7 +42,11 @@
 
 #include "font.h"
 
+#include "display/lcdc.h"
+#include "libgfx/gfx.h"
+
 #include <assert.h>
+#include <stddef.h>
 
 /*----------------------------------------------------------------------------
  *        Local variables
@@ -53,12 +57,102 @@
 
 static uint8_t font_sel = FONT10x14;
 
+/** Glyph cache of the selected font */
+static struct _gfx_glyph_cache glyph_cache;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Decode one pixel of a character from the font tables. Coordinates are
+ * given in the glyph box as drawn on screen: fonts 10x8 and 8x8 are stored
+ * rotated.
+ */
+static bool _font_pixel(const struct _gfx_font *font, uint8_t c,
+		uint8_t x, uint8_t y)
+{
+	const struct _font_parameters *param = font->data;
+	const uint8_t *pfont = param->pfont;
+	uint32_t index = c - 0x20;
+
+	switch (param - font_param) {
+	case FONT10x14:
+		/* Two bytes per column, MSB first */
+		return (pfont[index * 20 + x * 2 + y / 8] >> (7 - (y % 8))) & 1;
+	case FONT10x8:
+		/* Column 0 is blank, stored rows are mirrored screen columns */
+		if (x == 0)
+			return false;
+		return (pfont[index * param->width + y] >> (param->height - x)) & 1;
+	case FONT8x8:
+		return (pfont[index * param->width + y] >> x) & 1;
+	case FONT6x8:
+		return (pfont[index * param->width + x] >> y) & 1;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Describe a font of font.c for the glyph cache.
+ */
+static void _get_gfx_font(uint8_t font, struct _gfx_font *gfx_font)
+{
+	const struct _font_parameters *param = &font_param[font];
+
+	gfx_font->first = 0x20;
+	gfx_font->count = 0x80 - 0x20;
+	gfx_font->spacing = param->char_space;
+	gfx_font->pixel = _font_pixel;
+	gfx_font->data = param;
+	switch (font) {
+	case FONT10x8:
+		gfx_font->width = param->height + 1;
+		gfx_font->height = param->width;
+		break;
+	case FONT8x8:
+		gfx_font->width = param->height;
+		gfx_font->height = param->width;
+		break;
+	default:
+		gfx_font->width = param->width;
+		gfx_font->height = param->height;
+		break;
+	}
+}
+
+/**
+ * Draw a character of the selected font through the glyph cache.
+ */
+static void _draw_glyph(uint32_t x, uint32_t y, uint8_t c, uint32_t color,
+		const uint32_t *bg_color)
+{
+	static struct _gfx_font gfx_font;
+	struct _gfx_surface surface;
+
+	assert((c >= 0x20) && (c <= 0x7F));
+
+	if (glyph_cache.font == NULL) {
+		_get_gfx_font(font_sel, &gfx_font);
+		gfx_init_glyph_cache(&glyph_cache, &gfx_font);
+	}
+
+	lcd_get_canvas_surface(&surface);
+	if (surface.buffer == NULL)
+		return;
+	gfx_draw_glyph(&surface, &glyph_cache, x, y, c, color, bg_color);
+	lcdc_add_canvas_damage(x, y, gfx_font.width, gfx_font.height);
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
 struct _font_parameters* lcd_select_font (_FONT_enum font)
 {
+	if (font != font_sel)
+		glyph_cache.font = NULL;
 	font_sel = font;
 	return &font_param[font];
 }
@@ -70,64 +164,16 @@ uint8_t lcd_get_selected_font (void)
 
 void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
-	assert((c >= 0x20) && (c <= 0x7F));
-
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, color) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, color) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, color) ;
-              }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, color) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, color) ;
-              }
-            }
-          }
-        }
-        break;
-    }
+	_draw_glyph(x, y, c, color, NULL);
 }
 
 /**
  * \brief Draws an ASCII character on LCD with given background color.
  *
+ * The background covers the whole glyph box. The former per-pixel code
+ * left blank font columns (spaces, gaps inside some glyphs) and column 0
+ * of FONT10x8 untouched, so whatever was on screen showed through there.
+ *
  * \param x          X-coordinate of character upper-left corner.
  * \param y          Y-coordinate of character upper-left corner.
  * \param c          Character to output.
@@ -137,68 +183,5 @@ void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 void lcd_draw_char_with_bgcolor(uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor,
 			 uint32_t bgColor)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
-	assert((c >= 0x20) && (c <= 0x7F));
-
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row, bgColor) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row+8, bgColor) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, fontColor) ;
-			  }
-			  else {
-				  lcd_draw_pixel( x+(height-row), y+col, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, fontColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, fontColor) ;
-              }
-			  else {
-				  if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, bgColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-    }
+	_draw_glyph(x, y, c, fontColor, &bgColor);
 }
@@ -317,7 +317,7 @@ static void _LcdOn(void)
 	lcdc_create_canvas(LCDC_HEO, _heo_buffer_yuv, heo_bpp, 0, 0,
 						heo_img_w, heo_img_h);
 	lcd_fill_yuv422();
-	cache_clean_region(_heo_buffer_yuv, sizeof(_heo_buffer_yuv));
+	lcdc_flush_canvas();
 #endif
 	/* Show magnified 'F' for rotate test */
 	heo_img_w = 20 * EXAMPLE_LCD_SCALE;
@@ -340,7 +340,7 @@ static void _LcdOn(void)
 				   13 * EXAMPLE_LCD_SCALE,
 				   13 * EXAMPLE_LCD_SCALE, COLOR_BLACK);
 
-	cache_clean_region(_heo_buffer_rgb, sizeof(_heo_buffer_rgb));
+	lcdc_flush_canvas();
 	lcdc_put_image_rotated(LCDC_HEO, _heo_buffer_rgb, heo_bpp, SCR_X(heo_x),
 			      SCR_Y(heo_y), heo_w, heo_h, heo_img_w,
 			      heo_img_h, 0);
@@ -360,7 +360,7 @@ static void _LcdOn(void)
 	/* Display message font 8x8 */
 	lcd_select_font(FONT8x8);
 	lcd_draw_string(8, 56, "ATMEL RFO", COLOR_BLACK);
-	cache_clean_region(_ovr2_buffer, sizeof(_ovr2_buffer));
+	lcdc_flush_canvas();
 #endif /* CONFIG_HAVE_LCDC_OVR2 */
 
 #ifdef CONFIG_HAVE_LCDC_OVR1
@@ -372,7 +372,7 @@ static void _LcdOn(void)
 	lcdc_create_canvas(LCDC_OVR1, _ovr1_buffer, 24, SCR_X(ovr1_x),
 			   SCR_Y(ovr1_y), orv1_w, ovr1_h);
 	lcd_fill(OVR1_BG);
-	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
+	lcdc_flush_canvas();
 #endif /* CONFIG_HAVE_LCDC_OVR1 */
 
 	printf("- LCD ON\r\n");
@@ -604,7 +604,7 @@ static void _draws(void)
 			"graphic functionnalities\n"
 			"       on a SAMA5", COLOR_BLACK);
 
-	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
+	lcdc_flush_canvas();
 }
 
 #endif /* CONFIG_HAVE_LCDC_OVR1 */
@@ -0,0 +1,258 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page mixer_bench Audio mixer benchmark
+ *
+ *  \section Purpose
+ *
+ *  The example measures the cost of the software mixer of libaudio, in
+ *  processor cycles per output frame and per stream.
+ *
+ *  \section Requirements
+ *
+ *  This package can be used with SAMA5 and SAM9XX5.
+ *
+ *  \section Description
+ *
+ *  From one to MIXER_MAX_STREAMS 16-bit stereo streams are mixed to a
+ *  16-bit stereo output for about half a second, first with a constant
+ *  gain and then with a gain ramp running on every stream. For each case
+ *  the example reports the number of cycles spent per output frame and per
+ *  stream, and the processor load needed to mix all the streams at 48 kHz.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board. Please
+ *     refer to the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/6421B.pdf">
+ *     SAM-BA User Guide</a>, the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *     GNU-Based Software Development</a>
+ *     application note or to the
+ *     <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *     IAR EWARM User Guide</a>,
+ *     depending on your chosen solution.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Start the application.
+ *  -# In the terminal window, the following text should appear:
+ *     \code
+ *      -- Audio Mixer Benchmark Example xxx --
+ *      1 stream(s), constant gain: xxx cycles/frame/stream, xx.x% at 48 kHz
+ *      ...
+ *     \endcode
+ *
+ *  \section References
+ *  - mixer_bench/main.c
+ *  - mixer.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the audio mixer benchmark
+ *  example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+#include "compiler.h"
+#include "timer.h"
+
+#include "peripherals/pmc.h"
+#include "serial/console.h"
+
+#include "libaudio/mixer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of frames of each synthetic source */
+#define SOURCE_FRAMES 1024
+
+/** Number of frames mixed by each call */
+#define BENCH_FRAMES 256
+
+/** Minimum duration of each measurement, in ms */
+#define BENCH_DURATION 500
+
+/** Output rate used to express the processor load */
+#define BENCH_OUTPUT_RATE 48000
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _bench_source {
+	const int16_t* samples;
+	uint32_t position;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static int16_t source[SOURCE_FRAMES * 2];
+
+static int16_t output[BENCH_FRAMES * 2];
+
+static struct _bench_source sources[MIXER_MAX_STREAMS];
+
+static struct _mixer_stream streams[MIXER_MAX_STREAMS];
+
+static struct _mixer mixer;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Stream callback, loops over the synthetic source.
+ */
+static uint32_t _source_read(void* arg, void* buffer, uint32_t frames)
+{
+	struct _bench_source* src = (struct _bench_source*)arg;
+	int16_t* out = (int16_t*)buffer;
+	uint32_t i;
+
+	for (i = 0; i < frames; i++) {
+		out[2 * i] = src->samples[2 * src->position];
+		out[2 * i + 1] = src->samples[2 * src->position + 1];
+		if (++src->position == SOURCE_FRAMES)
+			src->position = 0;
+	}
+	return frames;
+}
+
+/**
+ * \brief Fill the source with a half scale stereo triangle wave.
+ */
+static void _build_source(void)
+{
+	int32_t level = 0, step = 256;
+	uint32_t i;
+
+	for (i = 0; i < SOURCE_FRAMES; i++) {
+		level += step;
+		if (level >= 16384 || level <= -16384)
+			step = -step;
+		source[2 * i] = (int16_t)level;
+		source[2 * i + 1] = (int16_t)-level;
+	}
+}
+
+/**
+ * \brief Mix the given number of streams repeatedly and report the cost
+ * per output frame and per stream.
+ */
+static void _run_bench(uint32_t count, bool ramp)
+{
+	uint64_t start, elapsed, cycles;
+	uint64_t frames = 0;
+	uint32_t per_frame, load, i;
+	bool down[MIXER_MAX_STREAMS] = { false };
+
+	mixer_init(&mixer, 16, 2);
+	for (i = 0; i < count; i++) {
+		sources[i].samples = source;
+		sources[i].position = (i * 97) % SOURCE_FRAMES;
+		streams[i].read = _source_read;
+		streams[i].arg = &sources[i];
+		streams[i].bits = 16;
+		streams[i].channels = 2;
+		mixer_add_stream(&mixer, &streams[i], MIXER_GAIN_UNITY / count, 0);
+	}
+
+	start = timer_get_tick();
+	do {
+		/* keep a ramp running on every stream */
+		if (ramp)
+			for (i = 0; i < count; i++)
+				if (!mixer_stream_is_ramping(&streams[i])) {
+					down[i] = !down[i];
+					mixer_set_gain(&streams[i],
+						down[i] ? 0 : MIXER_GAIN_UNITY / count,
+						BENCH_OUTPUT_RATE / 10);
+				}
+		mixer_mix(&mixer, output, BENCH_FRAMES);
+		frames += BENCH_FRAMES;
+		elapsed = timer_get_tick() - start;
+	} while (elapsed < BENCH_DURATION);
+
+	cycles = elapsed * (pmc_get_processor_clock() / 1000);
+	per_frame = (uint32_t)(cycles / frames);
+
+	/* load in tenths of percent */
+	load = (uint32_t)((uint64_t)per_frame * BENCH_OUTPUT_RATE * 1000 /
+			pmc_get_processor_clock());
+	printf("%u stream(s), %s: %4u cycles/frame/stream, %2u.%u%% at 48 kHz\r\n",
+			(unsigned)count, ramp ? "gain ramp    " : "constant gain",
+			(unsigned)(per_frame / count),
+			(unsigned)(load / 10), (unsigned)(load % 10));
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Application entry point for the audio mixer benchmark example.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	uint32_t count;
+
+	/* Output example information */
+	console_example_info("Audio Mixer Benchmark Example");
+
+	_build_source();
+
+	for (count = 1; count <= MIXER_MAX_STREAMS; count++) {
+		_run_bench(count, false);
+		_run_bench(count, true);
+	}
+
+	while (1);
+}
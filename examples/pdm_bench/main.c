@@ -0,0 +1,214 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page pdm_bench PDM decimation benchmark
+ *
+ *  \section Purpose
+ *
+ *  The example measures the cost of the software PDM to PCM conversion of
+ *  libaudio, in processor cycles per output sample.
+ *
+ *  \section Requirements
+ *
+ *  This package can be used with SAMA5 and SAM9XX5.
+ *
+ *  \section Description
+ *
+ *  A synthetic bitstream (a first order sigma-delta modulation of a
+ *  triangle wave) is converted repeatedly for about half a second with
+ *  several decimation ratios. For each ratio the example reports the
+ *  number of cycles spent per output sample and the processor load needed
+ *  to convert one microphone at 48 kHz.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board. Please
+ *     refer to the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/6421B.pdf">
+ *     SAM-BA User Guide</a>, the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *     GNU-Based Software Development</a>
+ *     application note or to the
+ *     <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *     IAR EWARM User Guide</a>,
+ *     depending on your chosen solution.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Start the application.
+ *  -# In the terminal window, the following text should appear:
+ *     \code
+ *      -- PDM Decimation Benchmark Example xxx --
+ *      decimation  32: xxxx cycles/sample, xx.x% at 48 kHz
+ *      ...
+ *     \endcode
+ *
+ *  \section References
+ *  - pdm_bench/main.c
+ *  - pdm.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the PDM decimation
+ *  benchmark example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+#include "compiler.h"
+#include "timer.h"
+
+#include "peripherals/pmc.h"
+#include "serial/console.h"
+
+#include "libaudio/pdm.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the synthetic bitstream, in bytes */
+#define BITSTREAM_SIZE 4096
+
+/** Minimum duration of each measurement, in ms */
+#define BENCH_DURATION 500
+
+/** Output rate used to express the processor load */
+#define BENCH_OUTPUT_RATE 48000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t bitstream[BITSTREAM_SIZE];
+
+static int16_t pcm[BITSTREAM_SIZE * 8 / PDM_MIN_DECIMATION + 1];
+
+static struct _pdm_decimator decimator;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Fill the bitstream with a first order sigma-delta modulation of a
+ * triangle wave at half scale.
+ */
+static void _build_bitstream(void)
+{
+	int32_t level = 0, step = 64, acc = 0;
+	uint32_t i, j;
+
+	for (i = 0; i < BITSTREAM_SIZE; i++) {
+		uint8_t b = 0;
+
+		for (j = 0; j < 8; j++) {
+			level += step;
+			if (level >= 16384 || level <= -16384)
+				step = -step;
+			acc += level;
+			if (acc >= 0) {
+				b |= 1 << (7 - j);
+				acc -= 32768;
+			} else {
+				acc += 32768;
+			}
+		}
+		bitstream[i] = b;
+	}
+}
+
+/**
+ * \brief Convert the bitstream repeatedly and report the cost per output
+ * sample.
+ */
+static void _run_bench(uint16_t decimation)
+{
+	uint64_t start, elapsed, cycles;
+	uint64_t samples = 0;
+	uint32_t per_sample, load;
+
+	pdm_decimator_init(&decimator, decimation);
+
+	start = timer_get_tick();
+	do {
+		samples += pdm_decimate(&decimator, bitstream, BITSTREAM_SIZE,
+				pcm, 1);
+		elapsed = timer_get_tick() - start;
+	} while (elapsed < BENCH_DURATION);
+
+	cycles = elapsed * (pmc_get_processor_clock() / 1000);
+	per_sample = (uint32_t)(cycles / samples);
+
+	/* load in tenths of percent */
+	load = (uint32_t)((uint64_t)per_sample * BENCH_OUTPUT_RATE * 1000 /
+			pmc_get_processor_clock());
+	printf("decimation %3u: %5u cycles/sample, %2u.%u%% at 48 kHz\r\n",
+			(unsigned)decimation, (unsigned)per_sample,
+			(unsigned)(load / 10), (unsigned)(load % 10));
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Application entry point for the PDM decimation benchmark example.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	static const uint16_t ratios[] = { 32, 48, 64, 128 };
+	uint32_t i;
+
+	/* Output example information */
+	console_example_info("PDM Decimation Benchmark Example");
+
+	_build_bitstream();
+
+	for (i = 0; i < ARRAY_SIZE(ratios); i++)
+		_run_bench(ratios[i]);
+
+	while (1);
+}
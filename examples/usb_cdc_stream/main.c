@@ -0,0 +1,331 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+/** \cond usb_cdc_stream
+ * \page usb_cdc_stream USB CDC Stream Example
+ *
+ * \section Purpose
+ *
+ * This example measures the throughput of the CDC serial stream layer
+ * (cdcd_serial_stream): continuously armed OUT buffers feeding a receive
+ * ring, and coalesced IN transfers.
+ *
+ * \section Description
+ *
+ * The board enumerates as a USB CDC serial port. Once the host opens the
+ * port (DTR set) the stream is started in one of the following modes,
+ * selected from the console:
+ * - loopback: data received from the host is sent back,
+ * - sink: data received from the host is discarded,
+ * - source: the board sends a counting pattern to the host.
+ *
+ * The receive and transmit throughputs are printed on the console every
+ * second.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board.
+ * -# On the computer, open and configure a terminal application on the
+ *    console port (115200 bauds, 8 bits, no parity, 1 stop bit).
+ * -# Start the application and connect the USB cable.
+ * -# Open the CDC serial port on the host, then for example:
+ *    - loopback: run a program that writes a file to the port and reads it
+ *      back,
+ *    - sink: <tt>dd if=/dev/zero of=/dev/ttyACM0 bs=64k count=1024</tt>,
+ *    - source: <tt>dd if=/dev/ttyACM0 of=/dev/null bs=64k count=1024</tt>.
+ *
+ * \section References
+ * - usb_cdc_stream/main.c
+ * - usb: USB Framework, USB CDC driver and UDP interface driver
+ *    - \ref usbd_framework
+ *       - \ref usbd_api
+ *    - \ref usbd_cdc
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * usb_cdc_stream example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "chip.h"
+
+#include "trace.h"
+#include "compiler.h"
+#include "timer.h"
+
+#include "mm/cache.h"
+#include "serial/console.h"
+
+#include "usb/device/cdc/cdcd_serial_driver.h"
+#include "usb/device/cdc/cdcd_serial_stream.h"
+#include "usb/device/usbd.h"
+#include "usb/device/usbd_hal.h"
+
+#include "../usb_common/main_usb_common.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *      Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of receive slots */
+#define RX_SLOTS            4
+
+/** Size of a receive slot in bytes */
+#define RX_SLOT_SIZE        (4 * 1024)
+
+/** Number of transmit buffers */
+#define TX_BUFFERS          3
+
+/** Size of a transmit buffer in bytes */
+#define TX_BUFFER_SIZE      (4 * 1024)
+
+/** Delay before a partially filled transmit buffer is sent (ms) */
+#define TX_TIMEOUT          2
+
+/** Throughput report period (ms) */
+#define REPORT_PERIOD       1000
+
+/** Benchmark modes */
+enum _bench_mode {
+	BENCH_LOOPBACK,
+	BENCH_SINK,
+	BENCH_SOURCE,
+};
+
+/*----------------------------------------------------------------------------
+ *      External variables
+ *----------------------------------------------------------------------------*/
+
+extern const USBDDriverDescriptors cdcd_serial_driver_descriptors;
+
+/*----------------------------------------------------------------------------
+ *      Internal variables
+ *----------------------------------------------------------------------------*/
+
+/** Receive slots */
+CACHE_ALIGNED static uint8_t rx_pool[RX_SLOTS * RX_SLOT_SIZE];
+
+/** Transmit buffers */
+CACHE_ALIGNED static uint8_t tx_pool[TX_BUFFERS * TX_BUFFER_SIZE];
+
+/** Pattern sent in source mode */
+static uint8_t pattern[256];
+
+static struct _cdcd_serial_stream stream;
+
+static const struct _cdcd_serial_stream_config stream_cfg = {
+	.rx_pool = rx_pool,
+	.rx_slot_size = RX_SLOT_SIZE,
+	.rx_slots = RX_SLOTS,
+	.tx_pool = tx_pool,
+	.tx_buffer_size = TX_BUFFER_SIZE,
+	.tx_buffers = TX_BUFFERS,
+	.tx_timeout = TX_TIMEOUT,
+};
+
+static enum _bench_mode mode = BENCH_LOOPBACK;
+
+static const char *mode_names[] = {
+	[BENCH_LOOPBACK] = "loopback",
+	[BENCH_SINK] = "sink",
+	[BENCH_SOURCE] = "source",
+};
+
+/*-----------------------------------------------------------------------------
+ *         Callback re-implementation
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * Invoked when the configuration of the device changes. Parse used endpoints.
+ * \param cfgnum New configuration number.
+ */
+void usbd_driver_callbacks_configuration_changed(unsigned char cfgnum)
+{
+	cdcd_serial_driver_configuration_changed_handler(cfgnum);
+}
+
+/**
+ * Invoked when a new SETUP request is received from the host. Forwards the
+ * request to the CDC serial device driver handler function.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+void usbd_callbacks_request_received(const USBGenericRequest *request)
+{
+	cdcd_serial_driver_request_handler(request);
+}
+
+/*----------------------------------------------------------------------------
+ *         Internal functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * console help dump
+ */
+static void _debug_help(void)
+{
+	printf("-- 'l' loopback, 'k' sink, 's' source --\n\r");
+	printf("-- Mode: %s --\n\r", mode_names[mode]);
+}
+
+/**
+ * Run the selected benchmark mode once.
+ */
+static void _bench_process(void)
+{
+	const uint8_t *data;
+	uint32_t len;
+	static uint8_t offset;
+
+	switch (mode) {
+	case BENCH_LOOPBACK:
+		/* Send received data back directly from the receive slot */
+		len = cdcd_serial_stream_rx_peek(&stream, &data);
+		if (len) {
+			len = cdcd_serial_stream_write(&stream, data, len);
+			cdcd_serial_stream_rx_release(&stream, len);
+		}
+		break;
+	case BENCH_SINK:
+		len = cdcd_serial_stream_rx_peek(&stream, &data);
+		if (len)
+			cdcd_serial_stream_rx_release(&stream, len);
+		break;
+	case BENCH_SOURCE:
+		len = cdcd_serial_stream_write(&stream, &pattern[offset],
+				sizeof(pattern) - offset);
+		offset = (offset + len) % sizeof(pattern);
+		/* Also drain anything the host sends */
+		len = cdcd_serial_stream_rx_peek(&stream, &data);
+		if (len)
+			cdcd_serial_stream_rx_release(&stream, len);
+		break;
+	}
+
+	cdcd_serial_stream_poll(&stream);
+}
+
+/**
+ * Print the throughput since the last report.
+ */
+static void _bench_report(void)
+{
+	static struct _cdcd_serial_stream_stats last;
+	struct _cdcd_serial_stream_stats stats;
+
+	cdcd_serial_stream_get_stats(&stream, &stats);
+	printf("RX %5u KB/s  TX %5u KB/s  (%u transfers, %u stalls)\n\r",
+			(unsigned)((stats.rx_bytes - last.rx_bytes) / 1024),
+			(unsigned)((stats.tx_bytes - last.tx_bytes) / 1024),
+			(unsigned)(stats.tx_transfers - last.tx_transfers),
+			(unsigned)(stats.rx_stalls - last.rx_stalls));
+	last = stats;
+}
+
+/*----------------------------------------------------------------------------
+ *          Main
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief usb_cdc_stream Application entry point.
+ */
+int main(void)
+{
+	struct _timeout report;
+	uint32_t i;
+
+	/* Output example information */
+	console_example_info("USB Device CDC Stream Example");
+
+	for (i = 0; i < sizeof(pattern); i++)
+		pattern[i] = (uint8_t)i;
+
+	/* Initialize all USB power (off) */
+	usb_power_configure();
+
+	/* CDC serial driver initialization */
+	cdcd_serial_driver_initialize(&cdcd_serial_driver_descriptors);
+	cdcd_serial_stream_initialize(&stream, cdcd_serial_driver_get_port(),
+			&stream_cfg);
+
+	_debug_help();
+
+	/* connect if needed */
+	usb_vbus_configure();
+
+	timer_start_timeout(&report, REPORT_PERIOD);
+
+	/* Driver loop */
+	while (1) {
+		bool port_open = usbd_get_state() >= USBD_STATE_CONFIGURED &&
+			(cdcd_serial_driver_get_control_line_state() &
+			 CDCControlLineState_DTR);
+
+		if (port_open && !cdcd_serial_stream_is_running(&stream)) {
+			if (cdcd_serial_stream_start(&stream) == USBD_STATUS_SUCCESS)
+				printf("-- Stream started (%s) --\n\r",
+						usbd_is_high_speed() ? "HS" : "FS");
+		} else if (!port_open && cdcd_serial_stream_is_running(&stream)) {
+			cdcd_serial_stream_stop(&stream);
+			printf("-- Stream stopped --\n\r");
+		}
+
+		if (cdcd_serial_stream_is_running(&stream)) {
+			_bench_process();
+
+			if (timer_timeout_reached(&report)) {
+				timer_reset_timeout(&report);
+				_bench_report();
+			}
+		}
+
+		if (console_is_rx_ready()) {
+			uint8_t key = console_get_char();
+
+			if (key == 'l')
+				mode = BENCH_LOOPBACK;
+			else if (key == 'k')
+				mode = BENCH_SINK;
+			else if (key == 's')
+				mode = BENCH_SOURCE;
+			_debug_help();
+		}
+	}
+}
+/** \endcond */
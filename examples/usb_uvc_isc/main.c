@@ -139,7 +139,9 @@
  *----------------------------------------------------------------------------*/
 #define FRAME_DEBUG_ENABLED
 
-#define NUM_FRAME_BUFFER     4
+/* Triple buffering: capture skips the frame being streamed, provided USB
+ * sends a frame within a frame period */
+#define NUM_FRAME_BUFFER     3
 #define SENSOR_TWI_BUS BOARD_ISC_TWI_BUS
 #define COUNTER_FREQ         1
 
@@ -190,7 +192,7 @@ static void isc_vd_callback(uint8_t frame_idx)
 #ifdef FRAME_DEBUG_ENABLED
 	_isc_frame_count++;
 #endif
-	uvc_function_update_frame_idx(frame_idx);
+	iscd_set_next_buffer(&iscd, uvc_function_capture_next(frame_idx));
 }
 
 /**
@@ -261,10 +263,17 @@ void usbd_driver_callbacks_interface_setting_changed(uint8_t interface, uint8_t
 #ifdef FRAME_DEBUG_ENABLED
 static int _tc_counter_callback(void* arg, void* arg2)
 {
+	struct _uvc_stream_stats stats;
+
+	uvc_function_get_stats(&stats);
 	printf("ISC %lu frames, UVC %lu frames per second\r\n",
 			_isc_frame_count, uvc_get_frame_count());
+	printf("  dropped %u, repeated %u, torn %u\r\n",
+			(unsigned)stats.dropped, (unsigned)stats.repeated,
+			(unsigned)stats.torn);
 	_isc_frame_count = 0;
 	uvc_reset_frame_count();
+	uvc_function_reset_stats();
 	return 0;
 }
 
@@ -0,0 +1,272 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "libaudio/asrc.h"
+
+#include <string.h>
+
+#include "errno.h"
+
+/*---------------------------------------------------------------------------
+ *         Local definitions
+ *---------------------------------------------------------------------------*/
+
+/** Number of tabulated filter phases, as a power of 2 */
+#define ASRC_PHASE_BITS 6
+
+/** Fill error low-pass: new value weight is 2^-ASRC_ERROR_SHIFT */
+#define ASRC_ERROR_SHIFT 6
+
+/** Proportional gain: 2^-15 relative ratio per frame of error */
+#define ASRC_KP_SHIFT 9
+
+/** Integral gain: 2^-26 relative ratio per frame of error per call */
+#define ASRC_KI_SHIFT 2
+
+/** Largest ratio correction, relative Q0.32 (about 1950 ppm) */
+#define ASRC_MAX_CORRECTION (1 << 23)
+
+/*---------------------------------------------------------------------------
+ *         Local constants
+ *---------------------------------------------------------------------------*/
+
+/**
+ * Kaiser-windowed (beta 8) sinc, cut at 0.43 of the input rate, Q15.
+ * Row p gives the weights of the history frames for an output located
+ * p / 64 frame after the 8th frame; each row sums to 32768. The extra row
+ * allows interpolation up to the next frame.
+ */
+static const int16_t _asrc_coefs[(1 << ASRC_PHASE_BITS) + 1][ASRC_TAPS] = {
+	{ 2, -69, 332, -945, 1954, -3170, 4188, 28183, 4188, -3170, 1954, -945, 332, -69, 2, 1 },
+	{ 4, -73, 337, -940, 1910, -3021, 3743, 28173, 4641, -3316, 1995, -948, 326, -65, 1, 1 },
+	{ 5, -77, 341, -934, 1863, -2870, 3307, 28147, 5101, -3459, 2034, -950, 320, -61, -1, 2 },
+	{ 6, -80, 344, -926, 1813, -2717, 2878, 28105, 5568, -3599, 2069, -949, 312, -56, -2, 2 },
+	{ 7, -83, 347, -916, 1762, -2563, 2459, 28042, 6042, -3735, 2101, -946, 304, -51, -4, 2 },
+	{ 8, -86, 349, -904, 1708, -2407, 2049, 27963, 6522, -3868, 2130, -942, 295, -45, -6, 2 },
+	{ 9, -88, 350, -892, 1652, -2251, 1649, 27867, 7008, -3996, 2156, -936, 285, -40, -8, 3 },
+	{ 10, -90, 350, -877, 1594, -2093, 1258, 27753, 7500, -4120, 2177, -927, 274, -34, -10, 3 },
+	{ 11, -92, 349, -862, 1534, -1936, 877, 27625, 7996, -4238, 2195, -917, 262, -27, -12, 3 },
+	{ 12, -94, 348, -845, 1473, -1778, 507, 27478, 8496, -4352, 2210, -904, 249, -21, -14, 3 },
+	{ 13, -95, 346, -827, 1411, -1621, 147, 27313, 9001, -4460, 2220, -890, 236, -14, -16, 4 },
+	{ 13, -96, 344, -808, 1347, -1464, -202, 27134, 9509, -4562, 2226, -873, 221, -7, -18, 4 },
+	{ 14, -97, 341, -787, 1282, -1307, -539, 26934, 10020, -4658, 2228, -854, 206, 1, -21, 5 },
+	{ 14, -97, 337, -766, 1216, -1152, -866, 26722, 10534, -4747, 2226, -833, 190, 8, -23, 5 },
+	{ 15, -98, 333, -744, 1149, -998, -1181, 26494, 11049, -4830, 2220, -810, 173, 16, -25, 5 },
+	{ 15, -98, 328, -720, 1081, -846, -1485, 26250, 11566, -4905, 2209, -785, 155, 25, -28, 6 },
+	{ 15, -98, 323, -696, 1013, -695, -1777, 25992, 12084, -4973, 2193, -758, 136, 33, -30, 6 },
+	{ 15, -97, 317, -672, 944, -547, -2057, 25718, 12603, -5033, 2173, -728, 116, 42, -33, 7 },
+	{ 16, -97, 310, -646, 876, -401, -2326, 25429, 13121, -5085, 2149, -696, 96, 50, -35, 7 },
+	{ 16, -96, 304, -620, 807, -257, -2582, 25124, 13639, -5128, 2120, -663, 75, 60, -38, 7 },
+	{ 16, -95, 297, -593, 738, -116, -2826, 24807, 14155, -5163, 2086, -627, 53, 69, -41, 8 },
+	{ 16, -94, 289, -566, 669, 22, -3058, 24477, 14670, -5189, 2047, -589, 31, 78, -43, 8 },
+	{ 16, -93, 281, -539, 600, 157, -3278, 24133, 15183, -5205, 2003, -549, 8, 88, -46, 9 },
+	{ 16, -91, 273, -511, 532, 289, -3486, 23778, 15692, -5213, 1955, -507, -16, 97, -49, 9 },
+	{ 15, -90, 264, -483, 465, 417, -3682, 23410, 16198, -5210, 1902, -462, -41, 107, -52, 10 },
+	{ 15, -88, 255, -454, 398, 542, -3865, 23027, 16701, -5198, 1844, -416, -66, 117, -54, 10 },
+	{ 15, -86, 246, -426, 331, 663, -4036, 22634, 17199, -5175, 1781, -368, -91, 127, -57, 11 },
+	{ 15, -84, 237, -397, 266, 780, -4195, 22231, 17692, -5142, 1713, -319, -117, 137, -60, 11 },
+	{ 15, -82, 227, -368, 202, 893, -4342, 21815, 18179, -5098, 1640, -267, -144, 148, -62, 12 },
+	{ 14, -80, 218, -340, 138, 1002, -4478, 21393, 18661, -5043, 1563, -214, -171, 158, -65, 12 },
+	{ 14, -78, 208, -311, 76, 1107, -4601, 20959, 19135, -4977, 1481, -159, -198, 168, -68, 12 },
+	{ 14, -75, 198, -283, 15, 1207, -4712, 20514, 19603, -4900, 1394, -102, -226, 178, -70, 13 },
+	{ 13, -73, 188, -254, -44, 1303, -4812, 20063, 20063, -4812, 1303, -44, -254, 188, -73, 13 },
+	{ 13, -70, 178, -226, -102, 1394, -4900, 19603, 20514, -4712, 1207, 15, -283, 198, -75, 14 },
+	{ 12, -68, 168, -198, -159, 1481, -4977, 19135, 20959, -4601, 1107, 76, -311, 208, -78, 14 },
+	{ 12, -65, 158, -171, -214, 1563, -5043, 18661, 21393, -4478, 1002, 138, -340, 218, -80, 14 },
+	{ 12, -62, 148, -144, -267, 1640, -5098, 18179, 21815, -4342, 893, 202, -368, 227, -82, 15 },
+	{ 11, -60, 137, -117, -319, 1713, -5142, 17692, 22231, -4195, 780, 266, -397, 237, -84, 15 },
+	{ 11, -57, 127, -91, -368, 1781, -5175, 17199, 22634, -4036, 663, 331, -426, 246, -86, 15 },
+	{ 10, -54, 117, -66, -416, 1844, -5198, 16701, 23027, -3865, 542, 398, -454, 255, -88, 15 },
+	{ 10, -52, 107, -41, -462, 1902, -5210, 16198, 23410, -3682, 417, 465, -483, 264, -90, 15 },
+	{ 9, -49, 97, -16, -507, 1955, -5213, 15692, 23778, -3486, 289, 532, -511, 273, -91, 16 },
+	{ 9, -46, 88, 8, -549, 2003, -5205, 15183, 24133, -3278, 157, 600, -539, 281, -93, 16 },
+	{ 8, -43, 78, 31, -589, 2047, -5189, 14670, 24477, -3058, 22, 669, -566, 289, -94, 16 },
+	{ 8, -41, 69, 53, -627, 2086, -5163, 14155, 24807, -2826, -116, 738, -593, 297, -95, 16 },
+	{ 7, -38, 60, 75, -663, 2120, -5128, 13639, 25124, -2582, -257, 807, -620, 304, -96, 16 },
+	{ 7, -35, 50, 96, -696, 2149, -5085, 13121, 25429, -2326, -401, 876, -646, 310, -97, 16 },
+	{ 7, -33, 42, 116, -728, 2173, -5033, 12603, 25718, -2057, -547, 944, -672, 317, -97, 15 },
+	{ 6, -30, 33, 136, -758, 2193, -4973, 12084, 25992, -1777, -695, 1013, -696, 323, -98, 15 },
+	{ 6, -28, 25, 155, -785, 2209, -4905, 11566, 26250, -1485, -846, 1081, -720, 328, -98, 15 },
+	{ 5, -25, 16, 173, -810, 2220, -4830, 11049, 26494, -1181, -998, 1149, -744, 333, -98, 15 },
+	{ 5, -23, 8, 190, -833, 2226, -4747, 10534, 26722, -866, -1152, 1216, -766, 337, -97, 14 },
+	{ 5, -21, 1, 206, -854, 2228, -4658, 10020, 26934, -539, -1307, 1282, -787, 341, -97, 14 },
+	{ 4, -18, -7, 221, -873, 2226, -4562, 9509, 27134, -202, -1464, 1347, -808, 344, -96, 13 },
+	{ 4, -16, -14, 236, -890, 2220, -4460, 9001, 27313, 147, -1621, 1411, -827, 346, -95, 13 },
+	{ 3, -14, -21, 249, -904, 2210, -4352, 8496, 27478, 507, -1778, 1473, -845, 348, -94, 12 },
+	{ 3, -12, -27, 262, -917, 2195, -4238, 7996, 27625, 877, -1936, 1534, -862, 349, -92, 11 },
+	{ 3, -10, -34, 274, -927, 2177, -4120, 7500, 27753, 1258, -2093, 1594, -877, 350, -90, 10 },
+	{ 3, -8, -40, 285, -936, 2156, -3996, 7008, 27867, 1649, -2251, 1652, -892, 350, -88, 9 },
+	{ 2, -6, -45, 295, -942, 2130, -3868, 6522, 27963, 2049, -2407, 1708, -904, 349, -86, 8 },
+	{ 2, -4, -51, 304, -946, 2101, -3735, 6042, 28042, 2459, -2563, 1762, -916, 347, -83, 7 },
+	{ 2, -2, -56, 312, -949, 2069, -3599, 5568, 28105, 2878, -2717, 1813, -926, 344, -80, 6 },
+	{ 2, -1, -61, 320, -950, 2034, -3459, 5101, 28147, 3307, -2870, 1863, -934, 341, -77, 5 },
+	{ 1, 1, -65, 326, -948, 1995, -3316, 4641, 28173, 3743, -3021, 1910, -940, 337, -73, 4 },
+	{ 1, 2, -69, 332, -945, 1954, -3170, 4188, 28183, 4188, -3170, 1954, -945, 332, -69, 2 },
+};
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/** Append an input frame to the history, written twice so that the filter
+ * window is always contiguous */
+static void _asrc_push(struct _asrc *asrc, const int16_t *frame)
+{
+	uint8_t c;
+
+	for (c = 0; c < asrc->channels; c++) {
+		asrc->history[c][asrc->pos] = frame[c];
+		asrc->history[c][asrc->pos + ASRC_TAPS] = frame[c];
+	}
+	asrc->pos = (asrc->pos + 1) & (ASRC_TAPS - 1);
+}
+
+/** Compute an output frame at the current position */
+static void _asrc_filter(struct _asrc *asrc, int16_t *frame)
+{
+	uint32_t phase = asrc->frac >> (32 - ASRC_PHASE_BITS);
+	int32_t weight = (asrc->frac >> (17 - ASRC_PHASE_BITS)) & 0x7fff;
+	const int16_t *c0 = _asrc_coefs[phase];
+	const int16_t *c1 = _asrc_coefs[phase + 1];
+	int32_t coefs[ASRC_TAPS];
+	uint8_t c, k;
+
+	/* Weights of the exact position, shared by all channels */
+	for (k = 0; k < ASRC_TAPS; k++)
+		coefs[k] = c0[k] + (((c1[k] - c0[k]) * weight) >> 15);
+
+	for (c = 0; c < asrc->channels; c++) {
+		const int16_t *x = &asrc->history[c][asrc->pos];
+		int32_t acc = 1 << 14;
+
+		for (k = 0; k < ASRC_TAPS; k++)
+			acc += coefs[k] * x[k];
+		acc >>= 15;
+		if (acc > INT16_MAX)
+			acc = INT16_MAX;
+		else if (acc < INT16_MIN)
+			acc = INT16_MIN;
+		frame[c] = (int16_t)acc;
+	}
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+int asrc_init(struct _asrc *asrc, uint8_t channels,
+		uint32_t in_rate, uint32_t out_rate)
+{
+	if (channels == 0 || channels > ASRC_MAX_CHANNELS)
+		return -EINVAL;
+	if (in_rate == 0 || out_rate == 0 || in_rate >= 2 * (uint64_t)out_rate)
+		return -EINVAL;
+
+	memset(asrc, 0, sizeof(*asrc));
+	asrc->channels = channels;
+	asrc->nominal = ((uint64_t)in_rate << 32) / out_rate;
+	asrc->step = asrc->nominal;
+	asrc->pending = 1;
+
+	return 0;
+}
+
+void asrc_track(struct _asrc *asrc, int32_t fill_error)
+{
+	const int32_t max_integral = ASRC_MAX_CORRECTION << ASRC_KI_SHIFT;
+	int64_t correction;
+
+	if (fill_error > (1 << 20))
+		fill_error = 1 << 20;
+	else if (fill_error < -(1 << 20))
+		fill_error = -(1 << 20);
+
+	/* Smooth the steps of the fill level, which moves by whole packets */
+	asrc->error += ((fill_error << 8) - asrc->error) >> ASRC_ERROR_SHIFT;
+
+	asrc->integral += asrc->error;
+	if (asrc->integral > max_integral)
+		asrc->integral = max_integral;
+	else if (asrc->integral < -max_integral)
+		asrc->integral = -max_integral;
+
+	correction = ((int64_t)asrc->error << ASRC_KP_SHIFT) +
+		(asrc->integral >> ASRC_KI_SHIFT);
+	if (correction > ASRC_MAX_CORRECTION)
+		correction = ASRC_MAX_CORRECTION;
+	else if (correction < -ASRC_MAX_CORRECTION)
+		correction = -ASRC_MAX_CORRECTION;
+
+	asrc->step = asrc->nominal +
+		(((int64_t)asrc->nominal * correction) >> 32);
+}
+
+int32_t asrc_get_correction_ppm(const struct _asrc *asrc)
+{
+	int64_t delta = (int64_t)(asrc->step - asrc->nominal);
+
+	return (int32_t)(delta * 1000000 / (int64_t)asrc->nominal);
+}
+
+uint32_t asrc_process(struct _asrc *asrc, const int16_t *in,
+		uint32_t *in_frames, int16_t *out, uint32_t out_frames)
+{
+	uint32_t consumed = 0;
+	uint32_t produced = 0;
+	uint64_t next;
+
+	for (;;) {
+		while (asrc->pending) {
+			if (consumed == *in_frames)
+				goto done;
+			_asrc_push(asrc, in + consumed * asrc->channels);
+			consumed++;
+			asrc->pending--;
+		}
+		if (produced == out_frames)
+			break;
+
+		_asrc_filter(asrc, out + produced * asrc->channels);
+		produced++;
+
+		next = asrc->frac + asrc->step;
+		asrc->frac = (uint32_t)next;
+		asrc->pending = (uint32_t)(next >> 32);
+	}
+
+done:
+	*in_frames = consumed;
+	return produced;
+}
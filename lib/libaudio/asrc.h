@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Asynchronous sample-rate converter, for audio streams whose source and
+ *  sink run on different clocks (e.g. USB audio frames against an audio
+ *  DMA paced by the codec, CLASSD or PDMIC clock).
+ *
+ *  Samples are interleaved signed 16-bit frames. The converter is a
+ *  16-tap windowed-sinc polyphase filter: 64 phases are tabulated and
+ *  the coefficients of the exact output position are interpolated
+ *  between the two nearest phases. The band edge is fixed at 0.43 of the
+ *  input rate, which suits drift correction and upsampling.
+ *
+ *  The conversion ratio starts at in_rate / out_rate and is corrected by
+ *  asrc_track() from the fill level of the buffer between source and
+ *  sink. Typical use with an audio ring on the sink side, once per USB
+ *  frame:
+ *  - add the frames received from USB to a 'received' counter,
+ *  - read the sink position with audio_ring_get_position(),
+ *  - pass (received - played - target level) to asrc_track(),
+ *  - convert the USB frame with asrc_process() into the ring periods.
+ */
+
+#ifndef ASRC_H
+#define ASRC_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum number of interleaved channels */
+#ifndef ASRC_MAX_CHANNELS
+#define ASRC_MAX_CHANNELS 8
+#endif
+
+/** Filter length in input frames */
+#define ASRC_TAPS 16
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Converter state */
+struct _asrc {
+	uint8_t  channels;   /**< Interleaved channels per frame */
+
+	/* following fields are used internally */
+	uint64_t nominal;    /**< in_rate / out_rate, Q32.32 */
+	uint64_t step;       /**< Input frames per output frame, Q32.32 */
+	uint32_t frac;       /**< Output position between input frames, Q0.32 */
+	uint32_t pending;    /**< Input frames to load before the next output */
+	int32_t  error;      /**< Filtered fill error, Q8 frames */
+	int32_t  integral;   /**< Accumulated fill error, Q8 frames */
+	uint8_t  pos;        /**< Oldest frame of the history window */
+	int16_t  history[ASRC_MAX_CHANNELS][2 * ASRC_TAPS];
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a converter, its history being silence.
+ * \param channels  Number of interleaved channels, 1 to ASRC_MAX_CHANNELS
+ * \param in_rate   Nominal input sample rate
+ * \param out_rate  Nominal output sample rate, in_rate / out_rate below 2
+ * \return 0 on success, -EINVAL otherwise
+ */
+extern int asrc_init(struct _asrc *asrc, uint8_t channels,
+		uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * \brief Correct the conversion ratio from the buffer fill level.
+ * Must be called at a regular rate, about 1 kHz (once per USB frame):
+ * the loop then settles within a few seconds and follows drifts up to
+ * about +/-1900 ppm. The level must be exact to the frame, as given by
+ * audio_ring_get_position(): a sink position counted in whole periods
+ * makes the ratio hunt and the output wobble.
+ * \param fill_error  Frames buffered between source and sink, minus the
+ * target level: positive when the sink is too slow.
+ */
+extern void asrc_track(struct _asrc *asrc, int32_t fill_error);
+
+/**
+ * \brief Get the current ratio correction in ppm
+ */
+extern int32_t asrc_get_correction_ppm(const struct _asrc *asrc);
+
+/**
+ * \brief Convert frames until the input is exhausted or the output full.
+ * \param in         Input frames
+ * \param in_frames  Number of input frames, updated with the number of
+ * frames consumed
+ * \param out        Output frames
+ * \param out_frames Room in the output, in frames
+ * \return number of frames written to the output
+ */
+extern uint32_t asrc_process(struct _asrc *asrc, const int16_t *in,
+		uint32_t *in_frames, int16_t *out, uint32_t out_frames);
+
+#endif /* ASRC_H */
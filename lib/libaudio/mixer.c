@@ -0,0 +1,323 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "libaudio/mixer.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "errno.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------------------------
+ *         Local definitions
+ *---------------------------------------------------------------------------*/
+
+/** Largest Q31 gain, used for MIXER_GAIN_UNITY */
+#define MIXER_Q31_UNITY INT32_MAX
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+static int32_t _mixer_q31_gain(uint16_t gain)
+{
+	if (gain >= MIXER_GAIN_UNITY)
+		return MIXER_Q31_UNITY;
+	return (int32_t)gain << 16;
+}
+
+static inline int32_t _mixer_sat_add(int32_t a, int32_t b)
+{
+	int64_t sum = (int64_t)a + b;
+
+	if (sum > INT32_MAX)
+		return INT32_MAX;
+	if (sum < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)sum;
+}
+
+/** Q31 product, as computed by the NEON saturating doubling multiply */
+static inline int32_t _mixer_scale(int32_t x, int32_t gain)
+{
+	return (int32_t)(((int64_t)x * gain) >> 31);
+}
+
+/** Convert n samples of the stream format to Q31 */
+static void _mixer_to_q31(const struct _mixer_stream *stream,
+		const void *raw, int32_t *out, uint32_t n)
+{
+	uint32_t i = 0;
+
+	switch (stream->bits) {
+	case 8:
+		{
+			const uint8_t *in = raw;
+			for (; i < n; i++)
+				out[i] = (int32_t)((in[i] ^ 0x80u) << 24);
+		}
+		break;
+	case 16:
+		{
+			const int16_t *in = raw;
+#ifdef __ARM_NEON
+			for (; i + 4 <= n; i += 4)
+				vst1q_s32(out + i, vshll_n_s16(vld1_s16(in + i), 16));
+#endif
+			for (; i < n; i++)
+				out[i] = (int32_t)((uint32_t)in[i] << 16);
+		}
+		break;
+	case 24:
+		{
+			const uint8_t *in = raw;
+			for (; i < n; i++, in += 3)
+				out[i] = (int32_t)(((uint32_t)in[0] << 8) |
+						((uint32_t)in[1] << 16) |
+						((uint32_t)in[2] << 24));
+		}
+		break;
+	case 32:
+		memcpy(out, raw, n * sizeof(int32_t));
+		break;
+	}
+}
+
+/** Convert frames to the output channel count, in place when widening is
+ * not needed */
+static void _mixer_map_channels(int32_t *samples, uint32_t frames,
+		uint8_t in_channels, uint8_t out_channels)
+{
+	uint32_t i;
+
+	if (in_channels == out_channels)
+		return;
+
+	if (in_channels == 1) {
+		/* mono to stereo, from the end to work in place */
+		for (i = frames; i > 0; i--) {
+			samples[2 * i - 1] = samples[i - 1];
+			samples[2 * i - 2] = samples[i - 1];
+		}
+	} else {
+		/* stereo to mono */
+		for (i = 0; i < frames; i++)
+			samples[i] = (samples[2 * i] >> 1) + (samples[2 * i + 1] >> 1);
+	}
+}
+
+/** Add a stream block to the accumulator */
+static void _mixer_accumulate(struct _mixer_stream *stream, int32_t *acc,
+		const int32_t *x, uint32_t frames, uint8_t channels)
+{
+	uint32_t n = frames * channels;
+	uint32_t i = 0;
+	uint8_t c;
+
+	if (stream->ramp) {
+		/* The gain changes on each frame */
+		for (; i < n; i += channels) {
+			for (c = 0; c < channels; c++)
+				acc[i + c] = _mixer_sat_add(acc[i + c],
+						_mixer_scale(x[i + c], stream->gain));
+			if (stream->ramp) {
+				stream->gain += stream->step;
+				if (--stream->ramp == 0)
+					stream->gain = stream->target;
+			}
+		}
+	} else if (stream->gain == MIXER_Q31_UNITY) {
+#ifdef __ARM_NEON
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(acc + i, vqaddq_s32(vld1q_s32(acc + i),
+					vld1q_s32(x + i)));
+#endif
+		for (; i < n; i++)
+			acc[i] = _mixer_sat_add(acc[i], x[i]);
+	} else if (stream->gain != 0) {
+#ifdef __ARM_NEON
+		int32x4_t gain = vdupq_n_s32(stream->gain);
+
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(acc + i, vqaddq_s32(vld1q_s32(acc + i),
+					vqdmulhq_s32(vld1q_s32(x + i), gain)));
+#endif
+		for (; i < n; i++)
+			acc[i] = _mixer_sat_add(acc[i],
+					_mixer_scale(x[i], stream->gain));
+	}
+}
+
+/** Advance a gain ramp over frames mixed as silence */
+static void _mixer_skip_ramp(struct _mixer_stream *stream, uint32_t frames)
+{
+	if (frames >= stream->ramp) {
+		stream->ramp = 0;
+		stream->gain = stream->target;
+	} else {
+		stream->ramp -= frames;
+		stream->gain += stream->step * (int32_t)frames;
+	}
+}
+
+/** Write Q31 samples in the output format */
+static void _mixer_output(const struct _mixer *mixer, const int32_t *acc,
+		void *out, uint32_t n)
+{
+	uint32_t i = 0;
+
+	if (mixer->bits == 32) {
+		memcpy(out, acc, n * sizeof(int32_t));
+	} else {
+		int16_t *o = out;
+#ifdef __ARM_NEON
+		for (; i + 4 <= n; i += 4)
+			vst1_s16(o + i, vqrshrn_n_s32(vld1q_s32(acc + i), 16));
+#endif
+		for (; i < n; i++) {
+			int32_t v = (int32_t)(((int64_t)acc[i] + 0x8000) >> 16);
+			o[i] = v > INT16_MAX ? INT16_MAX : (int16_t)v;
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+int mixer_init(struct _mixer *mixer, uint8_t bits, uint8_t channels)
+{
+	if ((bits != 16 && bits != 32) || channels < 1 || channels > 2)
+		return -EINVAL;
+
+	memset(mixer, 0, sizeof(*mixer));
+	mixer->bits = bits;
+	mixer->channels = channels;
+
+	return 0;
+}
+
+int mixer_add_stream(struct _mixer *mixer, struct _mixer_stream *stream,
+		uint16_t gain, uint32_t ramp_frames)
+{
+	int i;
+
+	if (!stream->read || stream->channels < 1 || stream->channels > 2)
+		return -EINVAL;
+	if (stream->bits != 8 && stream->bits != 16 &&
+	    stream->bits != 24 && stream->bits != 32)
+		return -EINVAL;
+
+	for (i = 0; i < MIXER_MAX_STREAMS; i++) {
+		if (!mixer->streams[i]) {
+			stream->gain = 0;
+			stream->ramp = 0;
+			mixer_set_gain(stream, gain, ramp_frames);
+			mixer->streams[i] = stream;
+			return 0;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+void mixer_remove_stream(struct _mixer *mixer, struct _mixer_stream *stream)
+{
+	int i;
+
+	for (i = 0; i < MIXER_MAX_STREAMS; i++)
+		if (mixer->streams[i] == stream)
+			mixer->streams[i] = NULL;
+}
+
+void mixer_set_gain(struct _mixer_stream *stream, uint16_t gain,
+		uint32_t ramp_frames)
+{
+	stream->target = _mixer_q31_gain(gain);
+	if (ramp_frames == 0 || stream->target == stream->gain) {
+		stream->gain = stream->target;
+		stream->ramp = 0;
+	} else {
+		stream->step = (int32_t)(((int64_t)stream->target - stream->gain) /
+				(int32_t)ramp_frames);
+		stream->ramp = ramp_frames;
+	}
+}
+
+bool mixer_stream_is_ramping(const struct _mixer_stream *stream)
+{
+	return stream->ramp != 0;
+}
+
+void mixer_mix(struct _mixer *mixer, void *out, uint32_t frames)
+{
+	uint8_t *o = out;
+	uint32_t frame_size = mixer->channels * (mixer->bits / 8);
+
+	while (frames) {
+		uint32_t n = frames < MIXER_BLOCK_FRAMES ? frames : MIXER_BLOCK_FRAMES;
+		int i;
+
+		memset(mixer->acc, 0, n * mixer->channels * sizeof(int32_t));
+
+		for (i = 0; i < MIXER_MAX_STREAMS; i++) {
+			struct _mixer_stream *stream = mixer->streams[i];
+			uint32_t got;
+
+			if (!stream)
+				continue;
+
+			got = stream->read(stream->arg, mixer->raw, n);
+			if (got > n)
+				got = n;
+			_mixer_to_q31(stream, mixer->raw, mixer->conv,
+					got * stream->channels);
+			_mixer_map_channels(mixer->conv, got, stream->channels,
+					mixer->channels);
+			_mixer_accumulate(stream, mixer->acc, mixer->conv, got,
+					mixer->channels);
+			if (got < n && stream->ramp)
+				_mixer_skip_ramp(stream, n - got);
+		}
+
+		_mixer_output(mixer, mixer->acc, o, n * mixer->channels);
+		o += n * frame_size;
+		frames -= n;
+	}
+}
@@ -0,0 +1,160 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Software mixer combining several audio producers (tone generators, WAV
+ *  files, USB audio streams...) into one output stream, e.g. the periods of
+ *  an audio ring.
+ *
+ *  Each stream provides a read callback delivering frames in its own
+ *  format: 8-bit unsigned, 16-bit, 24-bit packed or 32-bit signed little
+ *  endian samples, mono or stereo. Samples are converted to Q31, scaled by
+ *  the stream gain and summed with saturation; the result is written as
+ *  16 or 32-bit samples, mono or stereo. Gain changes are ramped linearly
+ *  to avoid clicks.
+ *
+ *  Conversion and mixing of streams at constant gain use NEON when built
+ *  with CONFIG_NEON=y (SAMA5D2, SAMA5D4), with results identical to the C
+ *  implementation.
+ */
+
+#ifndef MIXER_H
+#define MIXER_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum number of streams mixed together */
+#ifndef MIXER_MAX_STREAMS
+#define MIXER_MAX_STREAMS 8
+#endif
+
+/** Frames processed per pass, sizes the mixer scratch buffers */
+#define MIXER_BLOCK_FRAMES 64
+
+/** Gain leaving samples unchanged, gains range from 0 to unity */
+#define MIXER_GAIN_UNITY 32768
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Stream read callback: store up to 'frames' frames to 'buffer' and return
+ * the number of frames stored. Missing frames are mixed as silence.
+ */
+typedef uint32_t (*mixer_read_t)(void *arg, void *buffer, uint32_t frames);
+
+/** Mixer input */
+struct _mixer_stream {
+	mixer_read_t read;
+	void *arg;         /**< Argument of the read callback */
+	uint8_t bits;      /**< Bits per sample: 8, 16, 24 or 32 */
+	uint8_t channels;  /**< 1 or 2 */
+
+	/* following fields are used internally */
+	int32_t gain;      /**< Current gain, Q31 */
+	int32_t target;    /**< Gain at the end of the ramp, Q31 */
+	int32_t step;      /**< Gain change per frame while ramping */
+	uint32_t ramp;     /**< Frames left in the ramp */
+};
+
+/** Mixer state */
+struct _mixer {
+	uint8_t bits;      /**< Output bits per sample: 16 or 32 */
+	uint8_t channels;  /**< Output channels: 1 or 2 */
+
+	/* following fields are used internally */
+	struct _mixer_stream *streams[MIXER_MAX_STREAMS];
+	int32_t acc[MIXER_BLOCK_FRAMES * 2];
+	int32_t conv[MIXER_BLOCK_FRAMES * 2];
+	uint32_t raw[MIXER_BLOCK_FRAMES * 2];
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a mixer without streams.
+ * \param bits      Output bits per sample, 16 or 32
+ * \param channels  Output channels, 1 or 2
+ * \return 0 on success, -EINVAL otherwise
+ */
+extern int mixer_init(struct _mixer *mixer, uint8_t bits, uint8_t channels);
+
+/**
+ * \brief Add a stream to the mixer, its gain ramping up from 0.
+ * \param gain        Target gain, 0 to MIXER_GAIN_UNITY
+ * \param ramp_frames Duration of the ramp in output frames, 0 to apply the
+ * gain at once
+ * \return 0 on success, -EINVAL for an unsupported format, -ENOSPC when
+ * MIXER_MAX_STREAMS streams are already mixed
+ */
+extern int mixer_add_stream(struct _mixer *mixer, struct _mixer_stream *stream,
+		uint16_t gain, uint32_t ramp_frames);
+
+/**
+ * \brief Remove a stream from the mixer. To avoid a click, ramp its gain
+ * down to 0 first and wait for mixer_stream_is_ramping() to return false.
+ */
+extern void mixer_remove_stream(struct _mixer *mixer, struct _mixer_stream *stream);
+
+/**
+ * \brief Change the gain of a stream.
+ * \param gain        New gain, 0 to MIXER_GAIN_UNITY
+ * \param ramp_frames Duration of the ramp in output frames, 0 to apply the
+ * gain at once
+ */
+extern void mixer_set_gain(struct _mixer_stream *stream, uint16_t gain,
+		uint32_t ramp_frames);
+
+/**
+ * \brief Check whether a gain ramp is in progress
+ */
+extern bool mixer_stream_is_ramping(const struct _mixer_stream *stream);
+
+/**
+ * \brief Read all streams and write their mix.
+ * \param out     Output frames, in the mixer format
+ * \param frames  Number of frames to write
+ */
+extern void mixer_mix(struct _mixer *mixer, void *out, uint32_t frames);
+
+#endif /* MIXER_H */
@@ -0,0 +1,232 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "libaudio/pdm.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "errno.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------------------------
+ *         Local constants
+ *---------------------------------------------------------------------------*/
+
+/**
+ * Decimate-by-2 low-pass, Kaiser-windowed (beta 8), with the inverse
+ * response of the sinc^4 stages in the passband. Q15, sums to 32768.
+ */
+static const int16_t _pdm_fir[PDM_FIR_TAPS] = {
+	-2, 1, 7, -1, -17, 1, 33, 1,
+	-60, -7, 99, 18, -156, -38, 237, 72,
+	-348, -129, 500, 224, -705, -380, 984, 644,
+	-1370, -1105, 1935, 2005, -2876, -4296, 4768, 16345,
+	16345, 4768, -4296, -2876, 2005, 1935, -1105, -1370,
+	644, 984, -380, -705, 224, 500, -129, -348,
+	72, 237, -38, -156, 18, 99, -7, -60,
+	1, 33, 1, -17, -1, 7, 1, -2,
+};
+
+/*---------------------------------------------------------------------------
+ *         Local variables
+ *---------------------------------------------------------------------------*/
+
+/**
+ * Contribution of a bitstream byte to the sinc^4 decimate-by-8 output,
+ * for each of the four bytes spanned by the filter (0 being the newest).
+ */
+static int16_t _pdm_sinc[4][256];
+
+static bool _pdm_sinc_ready;
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/** Build the sinc^4 tables from the impulse response of 4 cascaded
+ * 8-sample moving sums (29 taps, sum 4096) */
+static void _pdm_build_sinc_tables(void)
+{
+	int16_t h[32], tmp[32];
+	int i, j, k, b;
+
+	memset(h, 0, sizeof(h));
+	h[0] = 1;
+	for (k = 0; k < 4; k++) {
+		memcpy(tmp, h, sizeof(tmp));
+		for (i = 0; i < 32; i++) {
+			h[i] = 0;
+			for (j = 0; j < 8 && j <= i; j++)
+				h[i] += tmp[i - j];
+		}
+	}
+
+	/* bit 0 of a byte is its newest sample, a set bit counts +1 and a
+	 * cleared bit -1 */
+	for (k = 0; k < 4; k++) {
+		for (b = 0; b < 256; b++) {
+			int16_t sum = 0;
+			for (i = 0; i < 8; i++)
+				sum += (b & (1 << i)) ? h[8 * k + i] : -h[8 * k + i];
+			_pdm_sinc[k][b] = sum;
+		}
+	}
+
+	_pdm_sinc_ready = true;
+}
+
+/** FIR output for the current window, Q14 samples and Q15 weights */
+static int16_t _pdm_fir_output(const int16_t *x)
+{
+	int32_t acc;
+	int i;
+
+#ifdef __ARM_NEON
+	int32x4_t sum = vdupq_n_s32(0);
+	int32x2_t half;
+
+	for (i = 0; i < PDM_FIR_TAPS; i += 8) {
+		int16x8_t v = vld1q_s16(x + i);
+		int16x8_t c = vld1q_s16(_pdm_fir + i);
+		sum = vmlal_s16(sum, vget_low_s16(v), vget_low_s16(c));
+		sum = vmlal_s16(sum, vget_high_s16(v), vget_high_s16(c));
+	}
+	half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	acc = vget_lane_s32(vpadd_s32(half, half), 0);
+#else
+	/* The filter is symmetric, add the samples sharing a weight first */
+	acc = 0;
+	for (i = 0; i < PDM_FIR_TAPS / 2; i++)
+		acc += _pdm_fir[i] * (x[i] + x[PDM_FIR_TAPS - 1 - i]);
+#endif
+
+	acc = (acc + (1 << 13)) >> 14;
+	if (acc > INT16_MAX)
+		return INT16_MAX;
+	if (acc < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)acc;
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+int pdm_decimator_init(struct _pdm_decimator *pdm, uint16_t decimation)
+{
+	uint32_t m = decimation / 16;
+	int64_t gain;
+
+	if (decimation < PDM_MIN_DECIMATION || decimation > PDM_MAX_DECIMATION ||
+	    (decimation % 16) != 0)
+		return -EINVAL;
+
+	if (!_pdm_sinc_ready)
+		_pdm_build_sinc_tables();
+
+	memset(pdm, 0, sizeof(*pdm));
+	pdm->cic_decimation = m;
+
+	/* Silence is a bitstream of alternate ones and zeros */
+	memset(pdm->bytes, 0x55, sizeof(pdm->bytes));
+
+	/* DC gain of the sinc and CIC stages is 4096 * m^4, at most 2^28 */
+	gain = 4096LL * m * m * m * m;
+	pdm->norm = (1LL << 46) / gain;
+
+	return 0;
+}
+
+uint32_t pdm_decimate(struct _pdm_decimator *pdm, const uint8_t *bits,
+		uint32_t len, int16_t *pcm, uint32_t stride)
+{
+	uint32_t count = 0;
+	uint32_t n;
+
+	for (n = 0; n < len; n++) {
+		uint8_t b = bits[n];
+		uint32_t y, t;
+		int32_t x;
+		int64_t q;
+
+		/* sinc^4, decimate by 8 */
+		x = _pdm_sinc[0][b] + _pdm_sinc[1][pdm->bytes[0]] +
+			_pdm_sinc[2][pdm->bytes[1]] + _pdm_sinc[3][pdm->bytes[2]];
+		pdm->bytes[2] = pdm->bytes[1];
+		pdm->bytes[1] = pdm->bytes[0];
+		pdm->bytes[0] = b;
+
+		/* CIC integrators, wrapping arithmetic is intended: it is done
+		 * unsigned, only the comb output is a signed value */
+		pdm->integrator[0] += (uint32_t)x;
+		pdm->integrator[1] += pdm->integrator[0];
+		pdm->integrator[2] += pdm->integrator[1];
+		pdm->integrator[3] += pdm->integrator[2];
+		if (++pdm->cic_phase < pdm->cic_decimation)
+			continue;
+		pdm->cic_phase = 0;
+
+		/* CIC combs at the decimated rate */
+		y = pdm->integrator[3];
+		t = y - pdm->comb[0]; pdm->comb[0] = y; y = t;
+		t = y - pdm->comb[1]; pdm->comb[1] = y; y = t;
+		t = y - pdm->comb[2]; pdm->comb[2] = y; y = t;
+		t = y - pdm->comb[3]; pdm->comb[3] = y; y = t;
+
+		/* Q14 samples leave room for the FIR overshoot */
+		q = ((int32_t)y * pdm->norm) >> 32;
+		if (q > INT16_MAX)
+			q = INT16_MAX;
+		else if (q < INT16_MIN)
+			q = INT16_MIN;
+
+		/* FIR history, written twice to keep the window contiguous */
+		pdm->history[pdm->fir_pos] = (int16_t)q;
+		pdm->history[pdm->fir_pos + PDM_FIR_TAPS] = (int16_t)q;
+		pdm->fir_pos = (pdm->fir_pos + 1) & (PDM_FIR_TAPS - 1);
+		if (++pdm->fir_phase < 2)
+			continue;
+		pdm->fir_phase = 0;
+
+		pcm[count * stride] = _pdm_fir_output(&pdm->history[pdm->fir_pos]);
+		count++;
+	}
+
+	return count;
+}
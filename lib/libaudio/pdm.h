@@ -0,0 +1,114 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  PDM to PCM conversion in software, for microphones whose raw bitstream
+ *  is captured by a serial receiver (e.g. the SSC receiver clocking the
+ *  microphone, with 8-bit MSB-first words).
+ *
+ *  The bitstream is decimated in three stages:
+ *  - a 4th order sinc filter decimating by 8, computed from lookup tables
+ *    indexed by the last four bitstream bytes,
+ *  - a 4th order CIC filter decimating by 1 to 16,
+ *  - a 64-tap FIR filter decimating by 2, compensating the droop of the
+ *    sinc filters, flat up to 0.42 of the output rate.
+ *
+ *  The overall decimation ratio is thus a multiple of 16 from 16 to 256,
+ *  e.g. 64 to convert a 3.072 MHz bitstream to 48 kHz. The FIR stage uses
+ *  NEON when built with CONFIG_NEON=y. Decimators with the same ratio have the same group
+ *  delay, so one instance per microphone gives aligned channels for
+ *  beamforming.
+ */
+
+#ifndef PDM_H
+#define PDM_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Length of the last decimation filter */
+#define PDM_FIR_TAPS 64
+
+/** Supported decimation ratios: multiples of 16 up to 256 */
+#define PDM_MIN_DECIMATION 16
+#define PDM_MAX_DECIMATION 256
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Decimator state, one per microphone */
+struct _pdm_decimator {
+	/* following fields are used internally */
+	uint8_t  cic_decimation; /**< Decimation of the CIC stage */
+	uint8_t  cic_phase;      /**< Sinc outputs accumulated by the CIC */
+	uint8_t  fir_phase;      /**< CIC outputs pending for the FIR */
+	uint8_t  fir_pos;        /**< Oldest sample of the FIR window */
+	uint8_t  bytes[3];       /**< Previous bitstream bytes, newest first */
+	uint32_t integrator[4];  /**< CIC integrators, modulo 2^32 */
+	uint32_t comb[4];        /**< CIC comb delays, modulo 2^32 */
+	int64_t  norm;           /**< CIC output to Q14 scale, Q32 */
+	int16_t  history[2 * PDM_FIR_TAPS];
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a decimator, its history being silence.
+ * \param decimation  Bitstream bits per output sample, a multiple of 16
+ * from PDM_MIN_DECIMATION to PDM_MAX_DECIMATION
+ * \return 0 on success, -EINVAL otherwise
+ */
+extern int pdm_decimator_init(struct _pdm_decimator *pdm, uint16_t decimation);
+
+/**
+ * \brief Convert a chunk of bitstream into signed 16-bit samples.
+ * Chunks may have any length, the state is kept between calls.
+ * \param bits    Bitstream, oldest bit in the MSB of the first byte
+ * \param len     Length of the bitstream in bytes
+ * \param pcm     Output samples, room for len * 8 / decimation + 1
+ * \param stride  Distance between output samples, e.g. the number of
+ * microphones to write interleaved frames
+ * \return number of samples written
+ */
+extern uint32_t pdm_decimate(struct _pdm_decimator *pdm, const uint8_t *bits,
+		uint32_t len, int16_t *pcm, uint32_t stride);
+
+#endif /* PDM_H */
@@ -0,0 +1,441 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "libaudio/wav_stream.h"
+
+#include <string.h>
+
+#include "errno.h"
+
+/*---------------------------------------------------------------------------
+ *         Local definitions
+ *---------------------------------------------------------------------------*/
+
+/** Little endian chunk identifiers */
+#define WAV_ID_RIFF 0x46464952
+#define WAV_ID_WAVE 0x45564157
+#define WAV_ID_FMT  0x20746D66
+#define WAV_ID_JUNK 0x4B4E554A
+#define WAV_ID_DATA 0x61746164
+
+/** PCM format tags */
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+/** Size of the RIFF header and of the format chunk in front of JUNK */
+#define WAV_FMT_END 36
+
+/** Offset of the data chunk size in recorded files */
+#define WAV_DATA_SIZE_OFFSET (WAV_STREAM_DATA_OFFSET - 4)
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+static uint32_t _wav_get32(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void _wav_put32(uint8_t* p, uint32_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static void _wav_put16(uint8_t* p, uint16_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static int _wav_read(FIL* file, void* buffer, uint32_t size)
+{
+	UINT count;
+
+	if (f_read(file, buffer, size, &count) != FR_OK || count != size)
+		return -EIO;
+	return 0;
+}
+
+static int _wav_write(FIL* file, const void* buffer, uint32_t size)
+{
+	UINT count;
+
+	if (f_write(file, buffer, size, &count) != FR_OK || count != size)
+		return -EIO;
+	return 0;
+}
+
+static bool _wav_format_is_valid(const struct _wav_header* header)
+{
+	if (header->num_channels == 0)
+		return false;
+	if (header->bits_per_sample != 8 && header->bits_per_sample != 16 &&
+	    header->bits_per_sample != 24 && header->bits_per_sample != 32)
+		return false;
+	return header->block_align ==
+		header->num_channels * (header->bits_per_sample / 8);
+}
+
+/**
+ * \brief Walk the RIFF chunks up to the data chunk and fill the canonical
+ * header from the format chunk.
+ */
+static int _wav_parse(struct _wav_stream* stream)
+{
+	struct _wav_header* header = &stream->header;
+	uint8_t chunk[16];
+	bool has_format = false;
+	uint32_t id, size, available;
+
+	if (_wav_read(&stream->file, chunk, 12) < 0)
+		return -EINVAL;
+	if (_wav_get32(chunk) != WAV_ID_RIFF || _wav_get32(chunk + 8) != WAV_ID_WAVE)
+		return -EINVAL;
+
+	memset(header, 0, sizeof(*header));
+	header->chunk_id = WAV_ID_RIFF;
+	header->chunk_size = _wav_get32(chunk + 4);
+	header->format = WAV_ID_WAVE;
+	header->subchunk1_id = WAV_ID_FMT;
+	header->subchunk1_size = 16;
+
+	while (true) {
+		if (_wav_read(&stream->file, chunk, 8) < 0)
+			return -EINVAL;
+		id = _wav_get32(chunk);
+		size = _wav_get32(chunk + 4);
+
+		if (id == WAV_ID_DATA)
+			break;
+
+		if (id == WAV_ID_FMT) {
+			if (size < 16 || _wav_read(&stream->file, chunk, 16) < 0)
+				return -EINVAL;
+			header->audio_format = chunk[0] | (chunk[1] << 8);
+			header->num_channels = chunk[2] | (chunk[3] << 8);
+			header->sample_rate = _wav_get32(chunk + 4);
+			header->byte_rate = _wav_get32(chunk + 8);
+			header->block_align = chunk[12] | (chunk[13] << 8);
+			header->bits_per_sample = chunk[14] | (chunk[15] << 8);
+			has_format = true;
+			size -= 16;
+		}
+
+		/* Skip the chunk remainder and its pad byte */
+		if (f_lseek(&stream->file, f_tell(&stream->file) + size + (size & 1)) != FR_OK)
+			return -EIO;
+	}
+
+	if (!has_format || !_wav_format_is_valid(header))
+		return -EINVAL;
+	if (header->audio_format != WAV_FORMAT_PCM &&
+	    header->audio_format != WAV_FORMAT_EXTENSIBLE)
+		return -EINVAL;
+
+	/* Clip the data to the file, recorders may leave sizes unset */
+	stream->data_offset = f_tell(&stream->file);
+	available = f_size(&stream->file) - stream->data_offset;
+	if (size > available)
+		size = available;
+	size -= size % header->block_align;
+
+	header->audio_format = WAV_FORMAT_PCM;
+	header->subchunk2_id = WAV_ID_DATA;
+	header->subchunk2_size = size;
+	stream->data_size = size;
+
+	return 0;
+}
+
+/** Read the next period of the file, padding with silence after the end */
+static int _wav_fill(struct _wav_stream* stream, uint8_t* data, uint32_t size)
+{
+	uint32_t count = size < stream->remaining ? size : stream->remaining;
+
+	if (count && _wav_read(&stream->file, data, count) < 0)
+		return -EIO;
+	stream->remaining -= count;
+
+	if (count < size)
+		memset(data + count, stream->ring->silence, size - count);
+
+	return 0;
+}
+
+static int _wav_poll_play(struct _wav_stream* stream)
+{
+	struct _audio_ring* ring = stream->ring;
+	struct _audio_period period;
+
+	while (stream->remaining && audio_ring_peek(ring, &period)) {
+		if (_wav_fill(stream, period.data, period.size) < 0)
+			return -EIO;
+		audio_ring_release(ring);
+		stream->end = ((uint64_t)period.sequence + 1) * ring->period_size;
+	}
+
+	if (!stream->remaining && audio_ring_get_position(ring) >= stream->end)
+		return 0;
+	return 1;
+}
+
+static int _wav_poll_record(struct _wav_stream* stream)
+{
+	struct _audio_ring* ring = stream->ring;
+	struct _audio_period period;
+	uint32_t size;
+
+	while (stream->data_size < stream->capacity &&
+	       audio_ring_peek(ring, &period)) {
+		size = stream->capacity - stream->data_size;
+		if (size > period.size)
+			size = period.size;
+		if (_wav_write(&stream->file, period.data, size) < 0)
+			return -EIO;
+		audio_ring_release(ring);
+		stream->data_size += size;
+	}
+
+	return stream->data_size < stream->capacity ? 1 : 0;
+}
+
+/** Build the header of a recorded file, data starting at
+ * WAV_STREAM_DATA_OFFSET after a JUNK chunk */
+static void _wav_build_header(const struct _wav_header* header, uint8_t* out)
+{
+	memset(out, 0, WAV_STREAM_DATA_OFFSET);
+	_wav_put32(out, WAV_ID_RIFF);
+	_wav_put32(out + 4, header->chunk_size);
+	_wav_put32(out + 8, WAV_ID_WAVE);
+	_wav_put32(out + 12, WAV_ID_FMT);
+	_wav_put32(out + 16, 16);
+	_wav_put16(out + 20, header->audio_format);
+	_wav_put16(out + 22, header->num_channels);
+	_wav_put32(out + 24, header->sample_rate);
+	_wav_put32(out + 28, header->byte_rate);
+	_wav_put16(out + 32, header->block_align);
+	_wav_put16(out + 34, header->bits_per_sample);
+	_wav_put32(out + WAV_FMT_END, WAV_ID_JUNK);
+	_wav_put32(out + WAV_FMT_END + 4, WAV_DATA_SIZE_OFFSET - 4 - WAV_FMT_END - 8);
+	_wav_put32(out + WAV_DATA_SIZE_OFFSET - 4, WAV_ID_DATA);
+	_wav_put32(out + WAV_DATA_SIZE_OFFSET, header->subchunk2_size);
+}
+
+/** Reserve the file space, contiguous when FatFs allows it */
+static int _wav_preallocate(FIL* file, FSIZE_t size)
+{
+#if _USE_EXPAND
+	if (f_expand(file, size, 1) == FR_OK)
+		return 0;
+#endif
+	/* Extending the file allocates the clusters now, possibly
+	 * fragmented */
+	if (f_lseek(file, size) != FR_OK)
+		return -EIO;
+	if (f_tell(file) != size)
+		return -ENOSPC;
+	return f_lseek(file, 0) == FR_OK ? 0 : -EIO;
+}
+
+static int _wav_finish_record(struct _wav_stream* stream)
+{
+	uint8_t size[4];
+	int err = 0;
+
+	/* Pad the data chunk to an even size */
+	if (stream->data_size & 1)
+		err = _wav_write(&stream->file, "", 1);
+
+#if _FS_MINIMIZE == 0
+	/* Release the unused preallocated space, otherwise it stays after
+	 * the RIFF chunk */
+	if (!err && f_truncate(&stream->file) != FR_OK)
+		err = -EIO;
+#endif
+
+	if (!err) {
+		stream->header.subchunk2_size = stream->data_size;
+		stream->header.chunk_size = (uint32_t)f_tell(&stream->file) - 8;
+
+		_wav_put32(size, stream->header.chunk_size);
+		if (f_lseek(&stream->file, 4) != FR_OK ||
+		    _wav_write(&stream->file, size, 4) < 0)
+			err = -EIO;
+
+		_wav_put32(size, stream->header.subchunk2_size);
+		if (!err && (f_lseek(&stream->file, WAV_DATA_SIZE_OFFSET) != FR_OK ||
+		    _wav_write(&stream->file, size, 4) < 0))
+			err = -EIO;
+	}
+
+	return err;
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+int wav_stream_open_play(struct _wav_stream *stream, const char *path,
+		struct _audio_ring *ring)
+{
+	uint32_t i;
+	int err;
+
+	memset(stream, 0, sizeof(*stream));
+	stream->ring = ring;
+
+	if (ring->periods < 2 || ring->periods > AUDIO_RING_MAX_PERIODS)
+		return -EINVAL;
+
+	if (f_open(&stream->file, path, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+		return -EIO;
+
+	err = _wav_parse(stream);
+	if (!err && (ring->period_size % stream->header.block_align))
+		err = -EINVAL;
+	if (!err && f_lseek(&stream->file, stream->data_offset) != FR_OK)
+		err = -EIO;
+	if (err < 0) {
+		f_close(&stream->file);
+		return err;
+	}
+	stream->remaining = stream->data_size;
+
+	/* 8-bit WAV samples are unsigned, silence is the mid-scale */
+	ring->silence = stream->header.bits_per_sample == 8 ? 0x80 : 0;
+
+	/* Prefetch the whole ring before the DMA starts */
+	for (i = 0; i < ring->periods && stream->remaining; i++) {
+		if (_wav_fill(stream, ring->buffer + i * ring->period_size,
+			      ring->period_size) < 0) {
+			f_close(&stream->file);
+			return -EIO;
+		}
+	}
+	ring->prefilled = i;
+	stream->end = (uint64_t)i * ring->period_size;
+
+	return 0;
+}
+
+int wav_stream_open_record(struct _wav_stream *stream, const char *path,
+		struct _audio_ring *ring, uint32_t sample_rate, uint16_t channels,
+		uint16_t bits, uint32_t max_size)
+{
+	struct _wav_header* header = &stream->header;
+	uint8_t buffer[WAV_STREAM_DATA_OFFSET];
+	int err;
+
+	memset(stream, 0, sizeof(*stream));
+	stream->ring = ring;
+	stream->record = true;
+	stream->data_offset = WAV_STREAM_DATA_OFFSET;
+
+	header->chunk_id = WAV_ID_RIFF;
+	header->format = WAV_ID_WAVE;
+	header->subchunk1_id = WAV_ID_FMT;
+	header->subchunk1_size = 16;
+	header->audio_format = WAV_FORMAT_PCM;
+	header->num_channels = channels;
+	header->sample_rate = sample_rate;
+	header->bits_per_sample = bits;
+	header->block_align = channels * (bits / 8);
+	header->byte_rate = sample_rate * header->block_align;
+	header->subchunk2_id = WAV_ID_DATA;
+
+	if (!_wav_format_is_valid(header) || (ring->period_size % header->block_align))
+		return -EINVAL;
+
+	/* Keep the RIFF size within 32 bits, including the pad byte */
+	if (max_size > UINT32_MAX - WAV_STREAM_DATA_OFFSET - 1)
+		max_size = UINT32_MAX - WAV_STREAM_DATA_OFFSET - 1;
+	stream->capacity = max_size - max_size % header->block_align;
+	if (stream->capacity == 0)
+		return -EINVAL;
+
+	if (f_open(&stream->file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return -EIO;
+
+	err = _wav_preallocate(&stream->file,
+			(FSIZE_t)WAV_STREAM_DATA_OFFSET + stream->capacity);
+	if (!err) {
+		/* Sizes are set when closing */
+		_wav_build_header(header, buffer);
+		err = _wav_write(&stream->file, buffer, sizeof(buffer));
+	}
+	if (err < 0) {
+		f_close(&stream->file);
+		return err;
+	}
+
+	return 0;
+}
+
+int wav_stream_poll(struct _wav_stream *stream)
+{
+	if (!stream->ring->desc)
+		return 0;
+
+	if (stream->record)
+		return _wav_poll_record(stream);
+	else
+		return _wav_poll_play(stream);
+}
+
+int wav_stream_close(struct _wav_stream *stream)
+{
+	int err = 0;
+
+	if (stream->ring->desc) {
+		if (stream->record)
+			err = _wav_poll_record(stream);
+		audio_ring_stop(stream->ring);
+	}
+
+	if (stream->record) {
+		int res = _wav_finish_record(stream);
+		if (err >= 0)
+			err = res;
+	}
+
+	if (f_close(&stream->file) != FR_OK && err >= 0)
+		err = -EIO;
+
+	return err < 0 ? err : 0;
+}
@@ -0,0 +1,161 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Streaming of WAV files between a FatFs volume and an audio ring, for
+ *  playback and recording of files much larger than the memory.
+ *
+ *  The audio ring itself is the prefetch buffer: periods are read from the
+ *  file straight into the free periods of a playback ring, and recorded
+ *  periods are written straight from the ring to the file. The DMA keeps
+ *  looping over the ring while the file system is busy, so the ring must
+ *  hold more audio than the worst case latency of the medium (SD cards
+ *  can stall for a few hundred milliseconds while erasing); e.g. 16
+ *  periods of 32 KB cover 340 ms of 8 channels of 32-bit samples at
+ *  48 kHz. wav_stream_poll() is the state machine moving the data; call
+ *  it from the main loop often enough to service each period.
+ *
+ *  Recorded files are preallocated when opened, as one contiguous block
+ *  when FatFs is configured with _USE_EXPAND, so that no FAT update
+ *  happens while recording. Audio data starts on a 512 byte boundary, after
+ *  a JUNK chunk, so that with periods multiple of 512 bytes FatFs writes
+ *  whole sectors straight from the ring. The sizes in the header are set
+ *  when closing, and the file is trimmed to the recorded data when FatFs
+ *  provides f_truncate() (_FS_MINIMIZE 0).
+ *
+ *  Typical recording sequence:
+ *  \code
+ *  wav_stream_open_record(&stream, "0:rec.wav", &ring, 48000, 8, 32, max);
+ *  audio_ring_start(&desc, &ring);
+ *  while (wav_stream_poll(&stream) > 0 && !stop_requested);
+ *  wav_stream_close(&stream);
+ *  \endcode
+ *
+ *  For playback, wav_stream_open_play() parses the file and fills the ring
+ *  before audio_ring_start(); stream->header then gives the format to
+ *  configure the audio device with. Samples are copied unchanged, the
+ *  audio device must use the same sample layout as the file.
+ */
+
+#ifndef WAV_STREAM_H
+#define WAV_STREAM_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ff.h"
+
+#include "audio/audio_device.h"
+#include "wav.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Offset of the audio data in recorded files */
+#define WAV_STREAM_DATA_OFFSET 512
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+struct _wav_stream {
+	/** File format, canonical PCM header (valid after open) */
+	struct _wav_header header;
+
+	/* following fields are used internally */
+	FIL file;
+	struct _audio_ring* ring;
+	bool record;
+	uint32_t data_offset;   /*< offset of the audio data in the file */
+	uint32_t data_size;     /*< play: data bytes, record: bytes written */
+	uint32_t remaining;     /*< play: data bytes not read yet */
+	uint32_t capacity;      /*< record: preallocated data bytes */
+	uint64_t end;           /*< play: ring position after the last data */
+};
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Open a WAV file for playback and prefill the ring.
+ * The ring buffer, period_size and periods must be set, the period size
+ * must be a multiple of the file block alignment. On success the ring is
+ * ready for audio_ring_start() with the prefilled periods and the
+ * silence value of the file format.
+ * \param stream  Stream to initialize
+ * \param path    File path
+ * \param ring    Playback ring, not started
+ * \return 0 on success, -EINVAL for an invalid or unsupported file,
+ * -EIO on file system errors
+ */
+extern int wav_stream_open_play(struct _wav_stream *stream, const char *path,
+		struct _audio_ring *ring);
+
+/**
+ * \brief Create a WAV file for recording and preallocate its space.
+ * The ring period size must be a multiple of the frame size.
+ * \param stream       Stream to initialize
+ * \param path         File path, an existing file is overwritten
+ * \param ring         Record ring, started after this call
+ * \param sample_rate  Sample rate in Hz
+ * \param channels     Number of channels
+ * \param bits         Bits per sample: 8, 16, 24 or 32
+ * \param max_size     Maximum size of the audio data in bytes, limited to
+ * the 4 GB of the WAV format
+ * \return 0 on success, -EINVAL for invalid parameters, -ENOSPC if the
+ * space cannot be allocated, -EIO on file system errors
+ */
+extern int wav_stream_open_record(struct _wav_stream *stream, const char *path,
+		struct _audio_ring *ring, uint32_t sample_rate, uint16_t channels,
+		uint16_t bits, uint32_t max_size);
+
+/**
+ * \brief Move the available periods between the ring and the file.
+ * \return 1 while streaming, 0 once playback is over (all data played)
+ * or the recording file is full, -EIO on file system errors
+ */
+extern int wav_stream_poll(struct _wav_stream *stream);
+
+/**
+ * \brief Stop the ring if still running and close the file.
+ * Recorded periods completed before the call are written, then the file
+ * is trimmed to the recorded data and its header updated.
+ * \return 0 on success, -EIO on file system errors
+ */
+extern int wav_stream_close(struct _wav_stream *stream);
+
+#endif /* WAV_STREAM_H */
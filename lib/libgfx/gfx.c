@@ -0,0 +1,602 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "libgfx/gfx.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------------------------
+ *         Local types
+ *---------------------------------------------------------------------------*/
+
+/** Fill n pixels starting at p with a color */
+typedef void (*_span_fill_t)(uint8_t *p, uint32_t n, uint32_t color);
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Fill n 32-bit words, using 64-bit (or NEON 128-bit, with
+ * CONFIG_NEON=y) stores for the aligned part.
+ */
+static void _fill_words(uint32_t *p, uint32_t n, uint32_t w)
+{
+#ifdef __ARM_NEON
+	uint32x4_t v = vdupq_n_u32(w);
+
+	while (n >= 8) {
+		vst1q_u32(p, v);
+		vst1q_u32(p + 4, v);
+		p += 8;
+		n -= 8;
+	}
+#else
+	uint64_t d = ((uint64_t)w << 32) | w;
+	uint64_t *q;
+
+	if (n && ((uintptr_t)p & 4)) {
+		*p++ = w;
+		n--;
+	}
+	q = (uint64_t *)p;
+	while (n >= 8) {
+		q[0] = d;
+		q[1] = d;
+		q[2] = d;
+		q[3] = d;
+		q += 4;
+		n -= 8;
+	}
+	while (n >= 2) {
+		*q++ = d;
+		n -= 2;
+	}
+	p = (uint32_t *)q;
+#endif
+	while (n--)
+		*p++ = w;
+}
+
+static void _fill_span16(uint8_t *row, uint32_t n, uint32_t color)
+{
+	uint16_t *p = (uint16_t *)row;
+	uint32_t c = color & 0xFFFF;
+
+	if (n && ((uintptr_t)p & 2)) {
+		*p++ = c;
+		n--;
+	}
+	_fill_words((uint32_t *)p, n >> 1, c | (c << 16));
+	if (n & 1)
+		p[n - 1] = c;
+}
+
+static void _fill_span24(uint8_t *p, uint32_t n, uint32_t color)
+{
+	const uint8_t c[3] = { color, color >> 8, color >> 16 };
+	uint32_t pattern[3];
+	uint8_t *b = (uint8_t *)pattern;
+	uint32_t bytes = n * 3;
+	uint32_t phase = 0;
+	uint32_t *q;
+	uint32_t i;
+
+	/* Byte stores up to word alignment */
+	while (bytes && ((uintptr_t)p & 3)) {
+		*p++ = c[phase];
+		phase = (phase == 2) ? 0 : phase + 1;
+		bytes--;
+	}
+
+	/* Four pixels are three words, starting at the current phase */
+	for (i = 0; i < 12; i++)
+		b[i] = c[(phase + i) % 3];
+	q = (uint32_t *)p;
+	while (bytes >= 12) {
+		q[0] = pattern[0];
+		q[1] = pattern[1];
+		q[2] = pattern[2];
+		q += 3;
+		bytes -= 12;
+	}
+
+	p = (uint8_t *)q;
+	for (i = 0; i < bytes; i++)
+		p[i] = b[i];
+}
+
+static void _fill_span32(uint8_t *p, uint32_t n, uint32_t color)
+{
+	_fill_words((uint32_t *)p, n, color);
+}
+
+static _span_fill_t _get_span_fill(uint8_t bpp)
+{
+	switch (bpp) {
+	case 16:
+		return _fill_span16;
+	case 24:
+		return _fill_span24;
+	case 32:
+		return _fill_span32;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * \brief Clip a rectangle to a surface.
+ * \return false if nothing is left.
+ */
+static bool _clip(const struct _gfx_surface *surface,
+		int *x, int *y, int *w, int *h)
+{
+	if (*x < 0) {
+		*w += *x;
+		*x = 0;
+	}
+	if (*y < 0) {
+		*h += *y;
+		*y = 0;
+	}
+	if (*x + *w > surface->width)
+		*w = surface->width - *x;
+	if (*y + *h > surface->height)
+		*h = surface->height - *y;
+	return *w > 0 && *h > 0;
+}
+
+static uint8_t *_pixel_address(const struct _gfx_surface *surface,
+		int x, int y)
+{
+	return (uint8_t *)surface->buffer + y * surface->stride +
+		x * (surface->bpp / 8);
+}
+
+/**
+ * \brief Fill a rectangle already clipped to the surface.
+ */
+static void _fill(const struct _gfx_surface *surface, _span_fill_t fill,
+		int x, int y, int w, int h, uint32_t color)
+{
+	uint8_t *row = _pixel_address(surface, x, y);
+
+	/* Whole rows without padding: a single span */
+	if (w == surface->width &&
+	    surface->stride == (uint32_t)w * (surface->bpp / 8)) {
+		fill(row, w * h, color);
+		return;
+	}
+	while (h--) {
+		fill(row, w, color);
+		row += surface->stride;
+	}
+}
+
+/**
+ * \brief Blend an opaque RGB 888 source over a destination, a being the
+ * source weight in 0..256. Red/blue and green are mixed in parallel.
+ */
+static uint32_t _mix(uint32_t s, uint32_t d, uint32_t a)
+{
+	uint32_t rb, g;
+
+	rb = ((s & 0xFF00FF) * a + (d & 0xFF00FF) * (256 - a)) >> 8;
+	g = ((s & 0x00FF00) * a + (d & 0x00FF00) * (256 - a)) >> 8;
+	return (rb & 0xFF00FF) | (g & 0x00FF00);
+}
+
+static void _blend_row16(uint8_t *dst, const uint32_t *src, int w,
+		uint32_t alpha)
+{
+	uint16_t *p = (uint16_t *)dst;
+	uint32_t s, d, a;
+	int i;
+
+	for (i = 0; i < w; i++) {
+		s = src[i];
+		a = ((s >> 24) * alpha) >> 8;
+		if (a == 0)
+			continue;
+		if (a < 255) {
+			d = p[i];
+			/* RGB 565 to RGB 888, replicating the high bits */
+			d = ((d & 0xF800) << 8) | ((d & 0xE000) << 3) |
+			    ((d & 0x07E0) << 5) | ((d & 0x0600) >> 1) |
+			    ((d & 0x001F) << 3) | ((d & 0x001C) >> 2);
+			s = _mix(s, d, a + (a >> 7));
+		}
+		p[i] = ((s >> 8) & 0xF800) | ((s >> 5) & 0x07E0) |
+		       ((s >> 3) & 0x001F);
+	}
+}
+
+static void _blend_row24(uint8_t *p, const uint32_t *src, int w,
+		uint32_t alpha)
+{
+	uint32_t s, d, a;
+	int i;
+
+	for (i = 0; i < w; i++, p += 3) {
+		s = src[i];
+		a = ((s >> 24) * alpha) >> 8;
+		if (a == 0)
+			continue;
+		if (a < 255) {
+			d = p[0] | (p[1] << 8) | (p[2] << 16);
+			s = _mix(s, d, a + (a >> 7));
+		}
+		p[0] = s;
+		p[1] = s >> 8;
+		p[2] = s >> 16;
+	}
+}
+
+static void _blend_row32(uint8_t *dst, const uint32_t *src, int w,
+		uint32_t alpha)
+{
+	uint32_t *p = (uint32_t *)dst;
+	uint32_t s, d, a, da;
+	int i;
+
+	for (i = 0; i < w; i++) {
+		s = src[i];
+		a = ((s >> 24) * alpha) >> 8;
+		if (a == 0)
+			continue;
+		if (a == 255) {
+			p[i] = s | 0xFF000000;
+			continue;
+		}
+		d = p[i];
+		a += a >> 7;
+		/* Resulting coverage: source over destination */
+		da = d >> 24;
+		da += ((255 - da) * a) >> 8;
+		p[i] = (da << 24) | _mix(s, d, a);
+	}
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Describe a frame buffer whose rows are padded to 4 bytes.
+ * \param surface Surface to initialize.
+ * \param buffer  First pixel.
+ * \param width   Width in pixels.
+ * \param height  Height in pixels.
+ * \param bpp     Bits per pixel (16, 24 or 32).
+ */
+void gfx_init_surface(struct _gfx_surface *surface, void *buffer,
+		uint16_t width, uint16_t height, uint8_t bpp)
+{
+	surface->buffer = buffer;
+	surface->width = width;
+	surface->height = height;
+	surface->bpp = bpp;
+	surface->stride = ((width * bpp + 7) / 8 + 3) & ~3;
+}
+
+/**
+ * \brief Fill a rectangle with a color, clipped to the surface.
+ * \param surface Destination surface.
+ * \param x       Left column.
+ * \param y       Top row.
+ * \param w       Width in pixels.
+ * \param h       Height in pixels.
+ * \param color   Color in the surface format.
+ */
+void gfx_fill_rect(const struct _gfx_surface *surface,
+		int x, int y, int w, int h, uint32_t color)
+{
+	_span_fill_t fill = _get_span_fill(surface->bpp);
+
+	if (!fill || !_clip(surface, &x, &y, &w, &h))
+		return;
+	_fill(surface, fill, x, y, w, h, color);
+}
+
+/**
+ * \brief Set a single pixel, ignored when outside of the surface.
+ */
+void gfx_draw_pixel(const struct _gfx_surface *surface,
+		int x, int y, uint32_t color)
+{
+	uint8_t *p;
+
+	if (x < 0 || y < 0 || x >= surface->width || y >= surface->height)
+		return;
+	p = _pixel_address(surface, x, y);
+
+	switch (surface->bpp) {
+	case 16:
+		*(uint16_t *)p = color;
+		break;
+	case 24:
+		p[0] = color;
+		p[1] = color >> 8;
+		p[2] = color >> 16;
+		break;
+	case 32:
+		*(uint32_t *)p = color;
+		break;
+	}
+}
+
+/**
+ * \brief Copy a rectangle between two surfaces of the same depth.
+ * Overlapping areas of the same buffer are handled.
+ * \param dst Destination surface.
+ * \param x   Destination left column.
+ * \param y   Destination top row.
+ * \param src Source surface.
+ * \param sx  Source left column.
+ * \param sy  Source top row.
+ * \param w   Width in pixels.
+ * \param h   Height in pixels.
+ */
+void gfx_blit(const struct _gfx_surface *dst, int x, int y,
+		const struct _gfx_surface *src, int sx, int sy, int w, int h)
+{
+	uint32_t bytes_per_pixel = dst->bpp / 8;
+	int32_t dst_stride = dst->stride;
+	int32_t src_stride = src->stride;
+	const uint8_t *s;
+	uint8_t *d;
+	uint32_t len;
+
+	if (dst->bpp != src->bpp || !_get_span_fill(dst->bpp))
+		return;
+
+	/* Clip to the source, then to the destination */
+	x -= sx;
+	y -= sy;
+	if (!_clip(src, &sx, &sy, &w, &h))
+		return;
+	x += sx;
+	y += sy;
+	sx -= x;
+	sy -= y;
+	if (!_clip(dst, &x, &y, &w, &h))
+		return;
+	sx += x;
+	sy += y;
+
+	d = _pixel_address(dst, x, y);
+	s = _pixel_address(src, sx, sy);
+	len = w * bytes_per_pixel;
+
+	/* Contiguous rows on both sides: a single copy */
+	if (dst_stride == src_stride && len == (uint32_t)dst_stride) {
+		memmove(d, s, len * h);
+		return;
+	}
+
+	/* Same buffer, destination below the source: copy bottom-up */
+	if (dst->buffer == src->buffer && d > s) {
+		d += (h - 1) * dst_stride;
+		s += (h - 1) * src_stride;
+		dst_stride = -dst_stride;
+		src_stride = -src_stride;
+	}
+	while (h--) {
+		memmove(d, s, len);
+		d += dst_stride;
+		s += src_stride;
+	}
+}
+
+/**
+ * \brief Blend an ARGB 8888 image over a surface.
+ * \param dst        Destination surface.
+ * \param x          Destination left column.
+ * \param y          Destination top row.
+ * \param src        First pixel of the source image.
+ * \param src_stride Distance between source rows in bytes.
+ * \param w          Width in pixels.
+ * \param h          Height in pixels.
+ * \param alpha      Global opacity, multiplied with the per-pixel alpha.
+ */
+void gfx_blend(const struct _gfx_surface *dst, int x, int y,
+		const uint32_t *src, uint32_t src_stride, int w, int h,
+		uint8_t alpha)
+{
+	void (*blend_row)(uint8_t *, const uint32_t *, int, uint32_t);
+	int x0 = x, y0 = y;
+	uint8_t *d;
+
+	switch (dst->bpp) {
+	case 16:
+		blend_row = _blend_row16;
+		break;
+	case 24:
+		blend_row = _blend_row24;
+		break;
+	case 32:
+		blend_row = _blend_row32;
+		break;
+	default:
+		return;
+	}
+	if (alpha == 0 || !_clip(dst, &x, &y, &w, &h))
+		return;
+
+	src = (const uint32_t *)((const uint8_t *)src + (y - y0) * src_stride)
+		+ (x - x0);
+	d = _pixel_address(dst, x, y);
+	while (h--) {
+		/* alpha 255 must not attenuate: use a 0..256 weight */
+		blend_row(d, src, w, alpha + (alpha >> 7));
+		d += dst->stride;
+		src = (const uint32_t *)((const uint8_t *)src + src_stride);
+	}
+}
+
+/**
+ * \brief Attach a font to a glyph cache, glyphs being decoded on first use.
+ * \return false if the font does not fit the cache limits.
+ */
+bool gfx_init_glyph_cache(struct _gfx_glyph_cache *cache,
+		const struct _gfx_font *font)
+{
+	if (!font->pixel || font->width == 0 || font->width > 32 ||
+	    font->height == 0 || font->height > GFX_GLYPH_MAX_HEIGHT)
+		return false;
+
+	cache->font = font;
+	memset(cache->loaded, 0, sizeof(cache->loaded));
+	return true;
+}
+
+/**
+ * \brief Get the row masks of a glyph, decoding it if needed.
+ * \return NULL for characters out of the font or of the cache.
+ */
+static const uint32_t *_get_glyph(struct _gfx_glyph_cache *cache, uint8_t c)
+{
+	const struct _gfx_font *font = cache->font;
+	uint32_t index = c - font->first;
+	uint32_t *rows;
+	uint32_t mask;
+	uint8_t x, y;
+
+	if (c < font->first || index >= font->count ||
+	    index >= GFX_GLYPH_CACHE_SIZE)
+		return NULL;
+
+	rows = cache->rows[index];
+	if (cache->loaded[index / 32] & (1u << (index % 32)))
+		return rows;
+
+	for (y = 0; y < font->height; y++) {
+		mask = 0;
+		for (x = 0; x < font->width; x++)
+			if (font->pixel(font, c, x, y))
+				mask |= 1u << x;
+		rows[y] = mask;
+	}
+	cache->loaded[index / 32] |= 1u << (index % 32);
+	return rows;
+}
+
+/**
+ * \brief Draw a character from a glyph cache. Each row is drawn as runs
+ * of identical pixels, through the span fillers.
+ * \param surface  Destination surface.
+ * \param cache    Glyph cache of the font.
+ * \param x        Left column of the glyph box.
+ * \param y        Top row of the glyph box.
+ * \param c        Character.
+ * \param color    Foreground color.
+ * \param bg_color Background color, NULL for a transparent background.
+ */
+void gfx_draw_glyph(const struct _gfx_surface *surface,
+		struct _gfx_glyph_cache *cache, int x, int y, uint8_t c,
+		uint32_t color, const uint32_t *bg_color)
+{
+	const struct _gfx_font *font = cache->font;
+	_span_fill_t fill = _get_span_fill(surface->bpp);
+	const uint32_t *rows;
+	uint32_t mask, bit;
+	int bx = x, by = y, bw = font->width, bh = font->height;
+	int row, x0, x1;
+
+	if (!fill || !_clip(surface, &bx, &by, &bw, &bh))
+		return;
+
+	rows = _get_glyph(cache, c);
+	if (!rows) {
+		if (bg_color)
+			_fill(surface, fill, bx, by, bw, bh, *bg_color);
+		return;
+	}
+
+	for (row = by - y; row < by - y + bh; row++) {
+		mask = rows[row];
+		if (!mask && !bg_color)
+			continue;
+		/* Runs restricted to the visible columns */
+		x0 = bx - x;
+		while (x0 < bx - x + bw) {
+			bit = (mask >> x0) & 1;
+			x1 = x0 + 1;
+			while (x1 < bx - x + bw && ((mask >> x1) & 1) == bit)
+				x1++;
+			if (bit)
+				fill(_pixel_address(surface, x + x0, y + row),
+				     x1 - x0, color);
+			else if (bg_color)
+				fill(_pixel_address(surface, x + x0, y + row),
+				     x1 - x0, *bg_color);
+			x0 = x1;
+		}
+	}
+}
+
+/**
+ * \brief Draw a string, honoring line breaks.
+ * \param surface  Destination surface.
+ * \param cache    Glyph cache of the font.
+ * \param x        Left column of the first glyph.
+ * \param y        Top row of the first glyph.
+ * \param text     Null-terminated string.
+ * \param color    Foreground color.
+ * \param bg_color Background color, NULL for a transparent background.
+ */
+void gfx_draw_text(const struct _gfx_surface *surface,
+		struct _gfx_glyph_cache *cache, int x, int y, const char *text,
+		uint32_t color, const uint32_t *bg_color)
+{
+	const struct _gfx_font *font = cache->font;
+	int x_start = x;
+
+	for (; *text; text++) {
+		if (*text == '\n') {
+			x = x_start;
+			y += font->height + font->spacing;
+			continue;
+		}
+		gfx_draw_glyph(surface, cache, x, y, *text, color, bg_color);
+		x += font->width + font->spacing;
+	}
+}
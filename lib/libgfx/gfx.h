@@ -0,0 +1,140 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Software 2D raster operations on linear frame buffers: rectangle fills,
+ *  blits, alpha blending and cached glyph rendering.
+ *
+ *  Pixels are stored little-endian, rows being padded to 4 bytes as done by
+ *  the LCDC driver. Supported depths:
+ *  - 16 bpp: RGB 565 (blending) or any 16-bit format (fill, blit),
+ *  - 24 bpp: RGB 888, blue in the first byte,
+ *  - 32 bpp: ARGB 8888.
+ *
+ *  Colors are given in the native format of the surface.
+ */
+
+#ifndef GFX_H
+#define GFX_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum glyph height supported by the glyph cache */
+#ifndef GFX_GLYPH_MAX_HEIGHT
+#define GFX_GLYPH_MAX_HEIGHT 16
+#endif
+
+/** Number of characters held by a glyph cache */
+#ifndef GFX_GLYPH_CACHE_SIZE
+#define GFX_GLYPH_CACHE_SIZE 96
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Frame buffer description */
+struct _gfx_surface {
+	void     *buffer;  /**< First pixel of the first row */
+	uint16_t  width;   /**< Width in pixels */
+	uint16_t  height;  /**< Height in pixels */
+	uint32_t  stride;  /**< Distance between rows in bytes */
+	uint8_t   bpp;     /**< Bits per pixel: 16, 24 or 32 */
+};
+
+struct _gfx_font;
+
+/**
+ * Glyph decoder: tell whether pixel (x, y) of the glyph box of character c
+ * is set. Only used when a glyph is loaded into a cache.
+ */
+typedef bool (*gfx_glyph_pixel_t)(const struct _gfx_font *font, uint8_t c,
+		uint8_t x, uint8_t y);
+
+/** Bitmap font description */
+struct _gfx_font {
+	uint8_t width;      /**< Glyph box width, 32 at most */
+	uint8_t height;     /**< Glyph box height, GFX_GLYPH_MAX_HEIGHT at most */
+	uint8_t spacing;    /**< Horizontal and vertical space between glyphs */
+	uint8_t first;      /**< Code of the first character */
+	uint8_t count;      /**< Number of characters */
+	gfx_glyph_pixel_t pixel;
+	const void *data;   /**< Font data, for the decoder */
+};
+
+/** Glyphs decoded as one bit mask per row, bit 0 being the leftmost pixel */
+struct _gfx_glyph_cache {
+	const struct _gfx_font *font;
+	uint32_t loaded[(GFX_GLYPH_CACHE_SIZE + 31) / 32];
+	uint32_t rows[GFX_GLYPH_CACHE_SIZE][GFX_GLYPH_MAX_HEIGHT];
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void gfx_init_surface(struct _gfx_surface *surface, void *buffer,
+		uint16_t width, uint16_t height, uint8_t bpp);
+
+extern void gfx_fill_rect(const struct _gfx_surface *surface,
+		int x, int y, int w, int h, uint32_t color);
+
+extern void gfx_draw_pixel(const struct _gfx_surface *surface,
+		int x, int y, uint32_t color);
+
+extern void gfx_blit(const struct _gfx_surface *dst, int x, int y,
+		const struct _gfx_surface *src, int sx, int sy, int w, int h);
+
+extern void gfx_blend(const struct _gfx_surface *dst, int x, int y,
+		const uint32_t *src, uint32_t src_stride, int w, int h,
+		uint8_t alpha);
+
+extern bool gfx_init_glyph_cache(struct _gfx_glyph_cache *cache,
+		const struct _gfx_font *font);
+
+extern void gfx_draw_glyph(const struct _gfx_surface *surface,
+		struct _gfx_glyph_cache *cache, int x, int y, uint8_t c,
+		uint32_t color, const uint32_t *bg_color);
+
+extern void gfx_draw_text(const struct _gfx_surface *surface,
+		struct _gfx_glyph_cache *cache, int x, int y, const char *text,
+		uint32_t color, const uint32_t *bg_color);
+
+#endif /* GFX_H */
@@ -0,0 +1,901 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the media layer for NAND flash (log-structured FTL).
+ *
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "trace.h"
+#include "media.h"
+#include "media_nand.h"
+#include "media_private.h"
+
+#include "nvm/nand/nand_flash_ecc.h"
+#include "nvm/nand/nand_flash_model.h"
+#include "nvm/nand/nand_flash_raw.h"
+#include "nvm/nand/nand_flash_skip_block.h"
+
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Constants
+ *------------------------------------------------------------------------------*/
+
+/** Summary page signature ("NFTL") */
+#define FTL_MAGIC 0x4c54464eu
+
+/** Free blocks kept for garbage collection */
+#define FTL_GC_RESERVE 2
+
+/** Bit flips tolerated in a page still considered erased */
+#define FTL_ERASED_MAX_ZEROS 8
+
+/** Marks a free block found at mount, erased again before it is used */
+#define FTL_MOUNT_ERASE 0xffff
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Summary page, programmed in the data area (the spare area is owned by
+ * the ECC) */
+struct _ftl_summary {
+	uint32_t magic;
+	uint32_t seq;
+	uint32_t erase_count;
+	uint16_t page;            /**< page of the summary in its block */
+	uint16_t pages_per_block;
+	uint32_t crc;             /**< over header (crc=0) and lpn[0..page-1] */
+	uint32_t lpn[];           /**< logical page of each preceding page */
+};
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+static uint8_t _ftl_program(struct _nand_ftl *ftl, uint32_t lpn, const void *data);
+
+static uint32_t _ftl_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+	static const uint32_t table[16] = {
+		0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+		0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+		0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+		0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+	};
+	const uint8_t *p = (const uint8_t*)data;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ table[crc & 15];
+		crc = (crc >> 4) ^ table[crc & 15];
+	}
+	return ~crc;
+}
+
+static inline uint32_t _ftl_ppn(const struct _nand_ftl *ftl, uint32_t block, uint32_t page)
+{
+	return block * ftl->pages_per_block + page;
+}
+
+static inline uint16_t _ftl_nand_block(const struct _nand_ftl *ftl, uint32_t block)
+{
+	return ftl->first_block + block;
+}
+
+static uint16_t _ftl_default_reserved(uint16_t num_blocks)
+{
+	return num_blocks / 50 + NAND_FTL_MIN_RESERVED;
+}
+
+/** Update the map and the valid page counters */
+static void _ftl_map(struct _nand_ftl *ftl, uint32_t lpn, uint32_t ppn)
+{
+	uint32_t old = ftl->map[lpn];
+
+	if (old != NAND_FTL_NONE)
+		ftl->blocks[old / ftl->pages_per_block].valid--;
+	ftl->map[lpn] = ppn;
+	if (ppn != NAND_FTL_NONE)
+		ftl->blocks[ppn / ftl->pages_per_block].valid++;
+}
+
+static uint8_t _ftl_read_page(struct _nand_ftl *ftl, uint32_t ppn, void *data)
+{
+	uint8_t err;
+
+	err = nand_ecc_read_page(ftl->nand,
+			_ftl_nand_block(ftl, ppn / ftl->pages_per_block),
+			ppn % ftl->pages_per_block, data, NULL);
+	if (err) {
+		ftl->stats.read_errors++;
+		trace_error("nand_ftl: cannot read page %u (err %u)\r\n",
+			(unsigned)ppn, err);
+	}
+	return err;
+}
+
+static uint32_t _ftl_count_zeros(const uint8_t *buf, uint32_t size, uint32_t max)
+{
+	const uint32_t *w = (const uint32_t*)buf;
+	uint32_t i, zeros = 0;
+
+	for (i = 0; i < size / 4 && zeros <= max; i++) {
+		if (w[i] != 0xffffffffu)
+			zeros += 32 - __builtin_popcount(w[i]);
+	}
+	return zeros;
+}
+
+/**
+ * Check (raw) whether a page is erased, tolerating a few bit flips. The
+ * spare area is checked too, so that a data page full of 0xff is not taken
+ * for an erased one (its ECC is programmed).
+ */
+static bool _ftl_page_erased(struct _nand_ftl *ftl, uint32_t block, uint32_t page)
+{
+	uint32_t spare_size = nand_model_get_page_spare_size(&ftl->nand->model);
+	uint32_t zeros;
+
+	if (nand_raw_read_page(ftl->nand, _ftl_nand_block(ftl, block), page,
+			ftl->meta_buf, ftl->spare_buf))
+		return false;
+
+	zeros = _ftl_count_zeros(ftl->meta_buf, ftl->page_size, FTL_ERASED_MAX_ZEROS);
+	if (zeros <= FTL_ERASED_MAX_ZEROS)
+		zeros += _ftl_count_zeros(ftl->spare_buf, spare_size, FTL_ERASED_MAX_ZEROS);
+	return zeros <= FTL_ERASED_MAX_ZEROS;
+}
+
+/** Read and check a summary page into meta_buf */
+static uint8_t _ftl_read_summary(struct _nand_ftl *ftl, uint32_t block, uint32_t page)
+{
+	struct _ftl_summary *s = (struct _ftl_summary*)ftl->meta_buf;
+	uint32_t crc;
+
+	if (nand_ecc_read_page(ftl->nand, _ftl_nand_block(ftl, block), page,
+			ftl->meta_buf, NULL))
+		return NAND_ERROR_CANNOTREAD;
+
+	if (s->magic != FTL_MAGIC || s->page != page ||
+	    s->pages_per_block != ftl->pages_per_block)
+		return NAND_ERROR_MAPPINGNOTFOUND;
+
+	crc = s->crc;
+	s->crc = 0;
+	if (_ftl_crc32(0, s, sizeof(*s) + page * sizeof(uint32_t)) != crc)
+		return NAND_ERROR_MAPPINGNOTFOUND;
+	s->crc = crc;
+	return 0;
+}
+
+/** Erase a block and put it in the free pool, retire it on failure */
+static uint8_t _ftl_erase(struct _nand_ftl *ftl, uint32_t block)
+{
+	struct _nand_ftl_block *b = &ftl->blocks[block];
+
+	if (nand_raw_erase_block(ftl->nand, _ftl_nand_block(ftl, block))) {
+		trace_warning("nand_ftl: erase failed, block %u retired\r\n",
+			(unsigned)_ftl_nand_block(ftl, block));
+		nand_skipblock_tag_block(ftl->nand, _ftl_nand_block(ftl, block), true);
+		b->state = NAND_FTL_BLOCK_BAD;
+		ftl->bad_blocks++;
+		return NAND_ERROR_CANNOTERASE;
+	}
+
+	b->erase_count++;
+	b->state = NAND_FTL_BLOCK_FREE;
+	b->seq = 0;
+	b->valid = 0;
+	b->sum_page = 0;
+	ftl->free_blocks++;
+	ftl->wl_counter++;
+	ftl->stats.erases++;
+	return 0;
+}
+
+/** Append a summary to the open block, closes it when it is full */
+static uint8_t _ftl_write_summary(struct _nand_ftl *ftl)
+{
+	struct _ftl_summary *s = (struct _ftl_summary*)ftl->meta_buf;
+	struct _nand_ftl_block *b = &ftl->blocks[ftl->open_block];
+	uint32_t page = ftl->open_page;
+	uint8_t err;
+
+	memset(ftl->meta_buf, 0xff, ftl->page_size);
+	s->magic = FTL_MAGIC;
+	s->seq = b->seq;
+	s->erase_count = b->erase_count;
+	s->page = page;
+	s->pages_per_block = ftl->pages_per_block;
+	s->crc = 0;
+	memcpy(s->lpn, ftl->open_lpn, page * sizeof(uint32_t));
+	s->crc = _ftl_crc32(0, s, sizeof(*s) + page * sizeof(uint32_t));
+
+	err = nand_ecc_write_page(ftl->nand,
+			_ftl_nand_block(ftl, ftl->open_block), page,
+			ftl->meta_buf, NULL);
+	ftl->stats.nand_pages++;
+	if (err)
+		return err;
+
+	ftl->open_lpn[page] = NAND_FTL_NONE;
+	ftl->open_page++;
+	ftl->open_dirty = false;
+	b->sum_page = page;
+	/* no room left for data and a summary */
+	if (ftl->open_page >= ftl->pages_per_block - 1) {
+		b->state = NAND_FTL_BLOCK_CLOSED;
+		ftl->open_block = NAND_FTL_NONE;
+	}
+	return 0;
+}
+
+/**
+ * Move the valid pages listed in lpns out of a block. The pages are
+ * appended to the open block.
+ */
+static uint8_t _ftl_relocate(struct _nand_ftl *ftl, uint32_t block,
+		const uint32_t *lpns, uint32_t count)
+{
+	uint32_t i, lpn;
+	uint8_t err;
+
+	for (i = 0; i < count; i++) {
+		lpn = lpns[i];
+		if (lpn >= ftl->num_lpages ||
+		    ftl->map[lpn] != _ftl_ppn(ftl, block, i))
+			continue;
+
+		if (_ftl_read_page(ftl, _ftl_ppn(ftl, block, i), ftl->page_buf)) {
+			/* data is lost, do not keep a mapping on a dead page */
+			_ftl_map(ftl, lpn, NAND_FTL_NONE);
+			continue;
+		}
+		err = _ftl_program(ftl, lpn, ftl->page_buf);
+		if (err)
+			return err;
+		ftl->stats.relocated++;
+	}
+	return 0;
+}
+
+/**
+ * Program failure on the open block: move its data to another block and
+ * mark it bad.
+ */
+static uint8_t _ftl_retire_open(struct _nand_ftl *ftl)
+{
+	uint32_t block = ftl->open_block;
+	struct _nand_ftl_block *b = &ftl->blocks[block];
+	uint32_t count = ftl->open_page;
+	uint8_t err;
+
+	trace_warning("nand_ftl: program failed, retiring block %u\r\n",
+		(unsigned)_ftl_nand_block(ftl, block));
+
+	/* a second failure while retiring is not recovered */
+	if (ftl->in_retire)
+		return NAND_ERROR_CANNOTWRITE;
+	ftl->in_retire = true;
+
+	memcpy(ftl->retire_lpn, ftl->open_lpn, count * sizeof(uint32_t));
+	b->state = NAND_FTL_BLOCK_CLOSED;
+	ftl->open_block = NAND_FTL_NONE;
+
+	err = _ftl_relocate(ftl, block, ftl->retire_lpn, count);
+	if (!err && ftl->open_block != NAND_FTL_NONE && ftl->open_dirty)
+		err = _ftl_write_summary(ftl);
+	ftl->in_retire = false;
+	if (err)
+		return err;
+
+	nand_skipblock_tag_block(ftl->nand, _ftl_nand_block(ftl, block), true);
+	b->state = NAND_FTL_BLOCK_BAD;
+	ftl->bad_blocks++;
+	return 0;
+}
+
+/** Make the content of the open block persistent */
+static uint8_t _ftl_commit(struct _nand_ftl *ftl)
+{
+	uint8_t err;
+
+	while (ftl->open_block != NAND_FTL_NONE && ftl->open_dirty) {
+		if (!_ftl_write_summary(ftl))
+			break;
+		err = _ftl_retire_open(ftl);
+		if (err)
+			return err;
+	}
+	return 0;
+}
+
+/** Empty a closed block and erase it */
+static uint8_t _ftl_recycle(struct _nand_ftl *ftl, uint32_t block)
+{
+	struct _nand_ftl_block *b = &ftl->blocks[block];
+	const struct _ftl_summary *s = (const struct _ftl_summary*)ftl->meta_buf;
+	uint32_t i, count = b->sum_page;
+	uint8_t err;
+
+	ftl->in_gc = true;
+
+	if (_ftl_read_summary(ftl, block, b->sum_page) == 0) {
+		memcpy(ftl->victim_lpn, s->lpn, count * sizeof(uint32_t));
+	} else {
+		/* summary unreadable, find the pages of the block in the map */
+		for (i = 0; i < count; i++)
+			ftl->victim_lpn[i] = NAND_FTL_NONE;
+		for (i = 0; i < ftl->num_lpages; i++) {
+			uint32_t ppn = ftl->map[i];
+			if (ppn != NAND_FTL_NONE && ppn / ftl->pages_per_block == block)
+				ftl->victim_lpn[ppn % ftl->pages_per_block] = i;
+		}
+	}
+
+	err = _ftl_relocate(ftl, block, ftl->victim_lpn, count);
+	/* the copies must be persistent before the originals are erased */
+	if (!err)
+		err = _ftl_commit(ftl);
+	if (!err) {
+		ftl->stats.gc_runs++;
+		_ftl_erase(ftl, block);
+	}
+
+	ftl->in_gc = false;
+	return err;
+}
+
+/** Reclaim the closed block with the fewest valid pages */
+static uint8_t _ftl_gc(struct _nand_ftl *ftl)
+{
+	uint32_t block, victim = NAND_FTL_NONE;
+	uint32_t best = ftl->pages_per_block - 1;
+
+	for (block = 0; block < ftl->num_blocks; block++) {
+		const struct _nand_ftl_block *b = &ftl->blocks[block];
+		if (b->state == NAND_FTL_BLOCK_CLOSED && b->valid < best) {
+			best = b->valid;
+			victim = block;
+		}
+	}
+	if (victim == NAND_FTL_NONE)
+		return NAND_ERROR_NOMOREBLOCKS;
+
+	return _ftl_recycle(ftl, victim);
+}
+
+/** Static wear leveling: recycle the least worn closed block if it lags */
+static void _ftl_wear_level(struct _nand_ftl *ftl)
+{
+	uint32_t block, cold = NAND_FTL_NONE;
+	uint32_t min_erase = UINT32_MAX, max_erase = 0;
+
+	ftl->wl_counter = 0;
+	for (block = 0; block < ftl->num_blocks; block++) {
+		const struct _nand_ftl_block *b = &ftl->blocks[block];
+		if (b->state == NAND_FTL_BLOCK_BAD)
+			continue;
+		if (b->erase_count > max_erase)
+			max_erase = b->erase_count;
+		if (b->state == NAND_FTL_BLOCK_CLOSED && b->erase_count < min_erase) {
+			min_erase = b->erase_count;
+			cold = block;
+		}
+	}
+
+	if (cold != NAND_FTL_NONE && max_erase - min_erase > NAND_FTL_WL_THRESHOLD) {
+		ftl->stats.wl_runs++;
+		_ftl_recycle(ftl, cold);
+	}
+}
+
+/** Open the least worn free block, collecting garbage first if needed */
+static uint8_t _ftl_open_block(struct _nand_ftl *ftl)
+{
+	uint32_t block, best = NAND_FTL_NONE;
+	struct _nand_ftl_block *b;
+
+	if (!ftl->in_gc && !ftl->in_retire) {
+		for (block = 0; block < ftl->num_blocks &&
+				ftl->free_blocks <= FTL_GC_RESERVE; block++) {
+			if (_ftl_gc(ftl))
+				break;
+		}
+		if (ftl->wl_counter >= NAND_FTL_WL_INTERVAL &&
+		    ftl->free_blocks > FTL_GC_RESERVE)
+			_ftl_wear_level(ftl);
+		/* relocations may have opened a block */
+		if (ftl->open_block != NAND_FTL_NONE)
+			return 0;
+	}
+
+	for (;;) {
+		best = NAND_FTL_NONE;
+		for (block = 0; block < ftl->num_blocks; block++) {
+			b = &ftl->blocks[block];
+			if (b->state != NAND_FTL_BLOCK_FREE)
+				continue;
+			if (best == NAND_FTL_NONE ||
+			    b->erase_count < ftl->blocks[best].erase_count)
+				best = block;
+		}
+		if (best == NAND_FTL_NONE) {
+			trace_error("nand_ftl: no free block\r\n");
+			return NAND_ERROR_NOMOREBLOCKS;
+		}
+
+		/* free blocks found at mount are erased on first use */
+		b = &ftl->blocks[best];
+		if (b->sum_page != FTL_MOUNT_ERASE)
+			break;
+		ftl->free_blocks--;
+		_ftl_erase(ftl, best);
+	}
+
+	b->state = NAND_FTL_BLOCK_OPEN;
+	b->seq = ++ftl->seq;
+	b->valid = 0;
+	ftl->free_blocks--;
+	ftl->open_block = best;
+	ftl->open_page = 0;
+	ftl->open_dirty = false;
+	memset(ftl->open_lpn, 0xff, sizeof(ftl->open_lpn));
+	return 0;
+}
+
+/** Append a logical page to the open block */
+static uint8_t _ftl_program(struct _nand_ftl *ftl, uint32_t lpn, const void *data)
+{
+	uint32_t block, page;
+	uint8_t err;
+
+	for (;;) {
+		if (ftl->open_block == NAND_FTL_NONE) {
+			err = _ftl_open_block(ftl);
+			if (err)
+				return err;
+		}
+		block = ftl->open_block;
+		page = ftl->open_page;
+
+		err = nand_ecc_write_page(ftl->nand, _ftl_nand_block(ftl, block),
+				page, (void*)data, NULL);
+		ftl->stats.nand_pages++;
+		if (!err)
+			break;
+
+		err = _ftl_retire_open(ftl);
+		if (err)
+			return err;
+	}
+
+	ftl->open_lpn[page] = lpn;
+	ftl->open_page++;
+	ftl->open_dirty = true;
+	_ftl_map(ftl, lpn, _ftl_ppn(ftl, block, page));
+
+	/* the last page of a block is always a summary */
+	if (ftl->open_page == ftl->pages_per_block - 1)
+		return _ftl_commit(ftl);
+	return 0;
+}
+
+static uint8_t _ftl_flush_cache(struct _nand_ftl *ftl)
+{
+	if (!ftl->cache_dirty)
+		return 0;
+	ftl->cache_dirty = false;
+	ftl->stats.host_pages++;
+	return _ftl_program(ftl, ftl->cache_lpn, ftl->cache_buf);
+}
+
+static uint8_t _ftl_read(struct _nand_ftl *ftl, uint32_t sector,
+		uint8_t *data, uint32_t count)
+{
+	uint32_t lpn, offset, n;
+	const uint8_t *src;
+	uint8_t err;
+
+	while (count) {
+		lpn = sector / ftl->sectors_per_page;
+		offset = sector % ftl->sectors_per_page;
+		n = ftl->sectors_per_page - offset;
+		if (n > count)
+			n = count;
+
+		if (lpn == ftl->cache_lpn) {
+			src = ftl->cache_buf;
+		} else if (ftl->map[lpn] == NAND_FTL_NONE) {
+			src = NULL;
+		} else if (!ftl->cache_dirty) {
+			/* keep the page cached for the next sectors */
+			ftl->cache_lpn = NAND_FTL_NONE;
+			err = _ftl_read_page(ftl, ftl->map[lpn], ftl->cache_buf);
+			if (err)
+				return err;
+			ftl->cache_lpn = lpn;
+			src = ftl->cache_buf;
+		} else {
+			err = _ftl_read_page(ftl, ftl->map[lpn], ftl->page_buf);
+			if (err)
+				return err;
+			src = ftl->page_buf;
+		}
+
+		if (src)
+			memcpy(data, src + offset * NAND_FTL_SECTOR_SIZE,
+					n * NAND_FTL_SECTOR_SIZE);
+		else
+			memset(data, 0, n * NAND_FTL_SECTOR_SIZE);
+
+		data += n * NAND_FTL_SECTOR_SIZE;
+		sector += n;
+		count -= n;
+	}
+	return 0;
+}
+
+static uint8_t _ftl_write(struct _nand_ftl *ftl, uint32_t sector,
+		const uint8_t *data, uint32_t count)
+{
+	uint32_t lpn, offset, n;
+	uint8_t err;
+
+	while (count) {
+		lpn = sector / ftl->sectors_per_page;
+		offset = sector % ftl->sectors_per_page;
+		n = ftl->sectors_per_page - offset;
+		if (n > count)
+			n = count;
+
+		if (lpn != ftl->cache_lpn) {
+			err = _ftl_flush_cache(ftl);
+			if (err)
+				return err;
+			ftl->cache_lpn = NAND_FTL_NONE;
+			/* partial page: read-modify-write */
+			if (n < ftl->sectors_per_page) {
+				if (ftl->map[lpn] == NAND_FTL_NONE) {
+					memset(ftl->cache_buf, 0, ftl->page_size);
+				} else {
+					err = _ftl_read_page(ftl, ftl->map[lpn],
+							ftl->cache_buf);
+					if (err)
+						return err;
+				}
+			}
+			ftl->cache_lpn = lpn;
+		}
+
+		memcpy(ftl->cache_buf + offset * NAND_FTL_SECTOR_SIZE, data,
+				n * NAND_FTL_SECTOR_SIZE);
+		ftl->cache_dirty = true;
+
+		/* page complete, program it */
+		if (offset + n == ftl->sectors_per_page) {
+			err = _ftl_flush_cache(ftl);
+			if (err)
+				return err;
+		}
+
+		data += n * NAND_FTL_SECTOR_SIZE;
+		sector += n;
+		count -= n;
+	}
+	return 0;
+}
+
+/** Rebuild the FTL state from the NAND content */
+static uint8_t _ftl_mount(struct _nand_ftl *ftl)
+{
+	const struct _ftl_summary *s = (const struct _ftl_summary*)ftl->meta_buf;
+	uint32_t block, page, last, i, lpn, old, newest = NAND_FTL_NONE;
+	uint32_t known = 0;
+	uint64_t erase_sum = 0;
+	struct _nand_ftl_block *b;
+
+	memset(ftl->map, 0xff, ftl->num_lpages * sizeof(uint32_t));
+
+	for (block = 0; block < ftl->num_blocks; block++) {
+		b = &ftl->blocks[block];
+		memset(b, 0, sizeof(*b));
+
+		if (nand_skipblock_check_block(ftl->nand,
+				_ftl_nand_block(ftl, block)) != GOODBLOCK) {
+			b->state = NAND_FTL_BLOCK_BAD;
+			ftl->bad_blocks++;
+			continue;
+		}
+
+		/* closed blocks end with a summary, look for an earlier one
+		 * in partially programmed blocks */
+		last = ftl->pages_per_block - 1;
+		if (_ftl_read_summary(ftl, block, last) == 0) {
+			page = last;
+		} else {
+			page = 0;
+			if (!_ftl_page_erased(ftl, block, last) ||
+			    !_ftl_page_erased(ftl, block, 0)) {
+				for (page = last; page > 0; page--) {
+					if (_ftl_read_summary(ftl, block, page - 1) == 0)
+						break;
+				}
+			}
+			if (page == 0) {
+				/* no persistent content: the block may hold an
+				 * interrupted erase or program, erase it again
+				 * before it is reused */
+				b->state = NAND_FTL_BLOCK_FREE;
+				b->sum_page = FTL_MOUNT_ERASE;
+				ftl->free_blocks++;
+				continue;
+			}
+			page--;
+		}
+
+		b->state = NAND_FTL_BLOCK_CLOSED;
+		b->seq = s->seq;
+		b->erase_count = s->erase_count;
+		b->sum_page = page;
+		erase_sum += b->erase_count;
+		known++;
+		if (b->seq > ftl->seq)
+			ftl->seq = b->seq;
+		if (newest == NAND_FTL_NONE || b->seq > ftl->blocks[newest].seq)
+			newest = block;
+
+		/* replay: newer blocks and later pages win */
+		for (i = 0; i < page; i++) {
+			lpn = s->lpn[i];
+			if (lpn >= ftl->num_lpages)
+				continue;
+			old = ftl->map[lpn];
+			if (old == NAND_FTL_NONE ||
+			    old / ftl->pages_per_block == block ||
+			    ftl->blocks[old / ftl->pages_per_block].seq < b->seq)
+				ftl->map[lpn] = _ftl_ppn(ftl, block, i);
+		}
+	}
+
+	/* blocks with unknown wear get the average erase count */
+	for (block = 0; block < ftl->num_blocks; block++) {
+		b = &ftl->blocks[block];
+		if (b->state != NAND_FTL_BLOCK_FREE)
+			continue;
+		b->erase_count = known ? (uint32_t)(erase_sum / known) : 0;
+	}
+
+	for (lpn = 0; lpn < ftl->num_lpages; lpn++) {
+		if (ftl->map[lpn] != NAND_FTL_NONE)
+			ftl->blocks[ftl->map[lpn] / ftl->pages_per_block].valid++;
+	}
+
+	/* newest block was flushed but not full and nothing was programmed
+	 * after its summary: continue appending to it */
+	ftl->open_block = NAND_FTL_NONE;
+	if (newest != NAND_FTL_NONE &&
+	    ftl->blocks[newest].sum_page + 2 < ftl->pages_per_block) {
+		b = &ftl->blocks[newest];
+		if (_ftl_page_erased(ftl, newest, b->sum_page + 1) &&
+		    _ftl_read_summary(ftl, newest, b->sum_page) == 0) {
+			memset(ftl->open_lpn, 0xff, sizeof(ftl->open_lpn));
+			memcpy(ftl->open_lpn, s->lpn, b->sum_page * sizeof(uint32_t));
+			b->state = NAND_FTL_BLOCK_OPEN;
+			ftl->open_block = newest;
+			ftl->open_page = b->sum_page + 1;
+			ftl->open_dirty = false;
+		}
+	}
+
+	trace_info("nand_ftl: %u blocks, %u free, %u bad, %u logical pages\r\n",
+		ftl->num_blocks, ftl->free_blocks, ftl->bad_blocks,
+		(unsigned)ftl->num_lpages);
+	return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Media operations
+ *------------------------------------------------------------------------------*/
+
+static uint8_t media_nand_read(struct _media *media, uint32_t address,
+		void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _nand_ftl *ftl = (struct _nand_ftl*)media->interface;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _ftl_read(ftl, address, (uint8_t*)data, length) ?
+		MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+static uint8_t media_nand_write(struct _media *media, uint32_t address,
+		void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _nand_ftl *ftl = (struct _nand_ftl*)media->interface;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if (media->write_protected)
+		return MEDIA_STATUS_PROTECTED;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _ftl_write(ftl, address, (const uint8_t*)data, length) ?
+		MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+	if (ftl->bad_blocks + FTL_GC_RESERVE >= ftl->reserved) {
+		trace_error("nand_ftl: out of spare blocks, media is now read-only\r\n");
+		media->write_protected = true;
+	}
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+static uint8_t media_nand_flush(struct _media *media)
+{
+	struct _nand_ftl *ftl = (struct _nand_ftl*)media->interface;
+	uint8_t err;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	media->state = MEDIA_STATE_BUSY;
+	err = _ftl_flush_cache(ftl);
+	if (!err)
+		err = _ftl_commit(ftl);
+	media->state = MEDIA_STATE_READY;
+
+	return err ? MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+uint32_t media_nand_map_entries(const struct _nand_flash *nand,
+		uint16_t num_blocks, uint16_t reserved)
+{
+	uint32_t ppb = nand_model_get_block_size_in_pages(&nand->model);
+
+	if (!reserved)
+		reserved = _ftl_default_reserved(num_blocks);
+	if (num_blocks <= reserved)
+		return 0;
+	return (num_blocks - reserved) * (ppb - 1);
+}
+
+uint8_t media_nand_initialize(struct _media *media,
+		struct _nand_ftl *ftl, struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks, uint16_t reserved,
+		uint32_t *map)
+{
+	uint32_t ppb = nand_model_get_block_size_in_pages(&nand->model);
+	uint32_t page_size = nand_model_get_page_data_size(&nand->model);
+
+	memset(media, 0, sizeof(*media));
+	media->state = MEDIA_STATE_NOT_READY;
+
+	if (!reserved)
+		reserved = _ftl_default_reserved(num_blocks);
+
+	if (num_blocks > NAND_FTL_MAX_BLOCKS ||
+	    num_blocks <= reserved + FTL_GC_RESERVE ||
+	    ppb < 4 || ppb > NAND_MAX_NUM_PAGES_PER_BLOCK ||
+	    page_size < NAND_FTL_SECTOR_SIZE ||
+	    page_size > NAND_MAX_PAGE_DATA_SIZE ||
+	    sizeof(struct _ftl_summary) + ppb * sizeof(uint32_t) > page_size) {
+		trace_error("nand_ftl: unsupported geometry\r\n");
+		return MEDIA_STATUS_ERROR;
+	}
+
+	ftl->nand = nand;
+	ftl->first_block = first_block;
+	ftl->num_blocks = num_blocks;
+	ftl->reserved = reserved;
+	ftl->pages_per_block = ppb;
+	ftl->page_size = page_size;
+	ftl->sectors_per_page = page_size / NAND_FTL_SECTOR_SIZE;
+	ftl->map = map;
+	ftl->num_lpages = media_nand_map_entries(nand, num_blocks, reserved);
+	ftl->seq = 0;
+	ftl->free_blocks = 0;
+	ftl->bad_blocks = 0;
+	ftl->wl_counter = 0;
+	ftl->in_gc = false;
+	ftl->in_retire = false;
+	ftl->cache_lpn = NAND_FTL_NONE;
+	ftl->cache_dirty = false;
+	memset(&ftl->stats, 0, sizeof(ftl->stats));
+
+	if (_ftl_mount(ftl))
+		return MEDIA_STATUS_ERROR;
+
+	media->write = media_nand_write;
+	media->read = media_nand_read;
+	media->flush = media_nand_flush;
+
+	media->interface = ftl;
+	media->block_size = NAND_FTL_SECTOR_SIZE;
+	media->base_address = 0;
+	media->size = ftl->num_lpages * ftl->sectors_per_page;
+	media->write_protected = ftl->bad_blocks + FTL_GC_RESERVE >= reserved;
+	media->removable = false;
+	media->state = MEDIA_STATE_READY;
+
+	return MEDIA_STATUS_SUCCESS;
+}
+
+uint8_t media_nand_format(struct _media *media,
+		struct _nand_ftl *ftl, struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks, uint16_t reserved,
+		uint32_t *map)
+{
+	uint16_t block;
+
+	for (block = first_block; block < first_block + num_blocks; block++) {
+		if (nand_skipblock_check_block(nand, block) != GOODBLOCK)
+			continue;
+		if (nand_raw_erase_block(nand, block))
+			nand_skipblock_tag_block(nand, block, true);
+	}
+
+	return media_nand_initialize(media, ftl, nand, first_block,
+			num_blocks, reserved, map);
+}
@@ -0,0 +1,207 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Media layer for NAND flash, backed by a log-structured, page-mapped
+ *  flash translation layer (FTL).
+ *
+ *  \section Purpose
+ *
+ *  Logical pages (one NAND page each) are appended to an open erase block.
+ *  Every block ends with a summary page listing the logical page numbers
+ *  of its data pages; a summary is also appended to the open block on
+ *  media_flush(), so that everything written before the flush survives a
+ *  power loss.  The mapping is rebuilt from the summaries at mount.
+ *
+ *  Free blocks are allocated least worn first (dynamic wear leveling).
+ *  Garbage collection reclaims the closed block with the fewest valid pages,
+ *  and every NAND_FTL_WL_INTERVAL erases the least worn closed block is
+ *  recycled when it lags behind by more than NAND_FTL_WL_THRESHOLD erases
+ *  (static wear leveling).
+ *
+ *  \section Usage
+ *  -# Initialize the NAND driver (nand_raw_initialize(), ECC type).
+ *  -# Call media_nand_initialize() with a cache-aligned struct _nand_ftl
+ *     and a map of at least media_nand_map_entries() entries.
+ *  -# Use the media (512-byte blocks) through the media_*() functions,
+ *     call media_flush() to make the written data persistent.
+ */
+
+#ifndef _MEDIA_NAND_H
+#define _MEDIA_NAND_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "libstoragemedia/media.h"
+#include "mm/cache.h"
+#include "nvm/nand/nand_flash.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Media block size exported by the FTL */
+#define NAND_FTL_SECTOR_SIZE 512
+
+/** Maximum number of erase blocks handled by the FTL */
+#ifndef NAND_FTL_MAX_BLOCKS
+#define NAND_FTL_MAX_BLOCKS NAND_MAXNUM_BLOCKS
+#endif
+
+/** Minimum number of spare blocks (bad blocks and garbage collection) */
+#define NAND_FTL_MIN_RESERVED 4
+
+/** Erases between two static wear leveling checks */
+#define NAND_FTL_WL_INTERVAL 64
+
+/** Erase count gap triggering static wear leveling */
+#define NAND_FTL_WL_THRESHOLD 256
+
+/** Unmapped logical page / no block */
+#define NAND_FTL_NONE 0xFFFFFFFFu
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+enum _nand_ftl_block_state {
+	NAND_FTL_BLOCK_FREE = 0, /**< erased, ready to be opened */
+	NAND_FTL_BLOCK_OPEN,     /**< being programmed */
+	NAND_FTL_BLOCK_CLOSED,   /**< holds a summary, read only */
+	NAND_FTL_BLOCK_BAD,
+};
+
+struct _nand_ftl_block {
+	uint32_t erase_count;
+	uint32_t seq;       /**< sequence number given when opened */
+	uint16_t valid;     /**< number of valid data pages */
+	uint16_t sum_page;  /**< page of the last summary (closed blocks) */
+	uint8_t  state;
+};
+
+struct _nand_ftl_stats {
+	uint32_t host_pages;    /**< logical pages written by the host */
+	uint32_t nand_pages;    /**< pages programmed (data, relocations, summaries) */
+	uint32_t relocated;     /**< pages moved by garbage collection */
+	uint32_t erases;
+	uint32_t gc_runs;
+	uint32_t wl_runs;       /**< static wear leveling migrations */
+	uint32_t read_errors;   /**< uncorrectable page reads */
+};
+
+/** FTL instance, must be cache aligned (declare it CACHE_ALIGNED) */
+struct _nand_ftl {
+	struct _nand_flash *nand;
+	uint16_t first_block;
+	uint16_t num_blocks;
+	uint16_t reserved;
+	uint16_t pages_per_block;
+	uint32_t page_size;
+	uint32_t sectors_per_page;
+
+	uint32_t *map;          /**< logical page -> physical page */
+	uint32_t num_lpages;    /**< exported logical pages */
+
+	uint32_t seq;
+	uint16_t free_blocks;
+	uint16_t bad_blocks;
+	uint16_t wl_counter;
+	bool     in_gc;
+	bool     in_retire;
+
+	/* open block */
+	uint32_t open_block;
+	uint16_t open_page;
+	bool     open_dirty;    /**< pages written since the last summary */
+
+	/* write-back cache of one logical page */
+	uint32_t cache_lpn;
+	bool     cache_dirty;
+
+	struct _nand_ftl_stats stats;
+
+	struct _nand_ftl_block blocks[NAND_FTL_MAX_BLOCKS];
+	uint32_t open_lpn[NAND_MAX_NUM_PAGES_PER_BLOCK];
+	uint32_t victim_lpn[NAND_MAX_NUM_PAGES_PER_BLOCK];
+	uint32_t retire_lpn[NAND_MAX_NUM_PAGES_PER_BLOCK];
+
+	ALIGNED(L1_CACHE_BYTES) uint8_t cache_buf[NAND_MAX_PAGE_DATA_SIZE];
+	ALIGNED(L1_CACHE_BYTES) uint8_t page_buf[NAND_MAX_PAGE_DATA_SIZE];
+	ALIGNED(L1_CACHE_BYTES) uint8_t meta_buf[NAND_MAX_PAGE_DATA_SIZE];
+	ALIGNED(L1_CACHE_BYTES) uint8_t spare_buf[NAND_MAX_PAGE_SPARE_SIZE];
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Number of map entries needed for a NAND partition.
+ * \param nand         Initialized NAND flash.
+ * \param num_blocks   Number of erase blocks given to the FTL.
+ * \param reserved     Spare blocks, 0 for the default (2% + NAND_FTL_MIN_RESERVED).
+ * Spare blocks not taken by bad blocks are what garbage collection works
+ * with: on a full media, write amplification grows quickly when they are
+ * only a few percent of the partition.
+ */
+extern uint32_t media_nand_map_entries(const struct _nand_flash *nand,
+		uint16_t num_blocks, uint16_t reserved);
+
+/**
+ * \brief Mount the FTL on a range of NAND blocks and expose it as a media.
+ * Blocks without valid FTL content become free blocks; they are not erased
+ * here but when they are first allocated.
+ * \param media        Media instance to initialize.
+ * \param ftl          FTL instance.
+ * \param nand         Initialized NAND flash.
+ * \param first_block  First erase block of the partition.
+ * \param num_blocks   Number of erase blocks of the partition.
+ * \param reserved     Spare blocks, 0 for the default.
+ * \param map          Logical to physical map, media_nand_map_entries() entries.
+ * \return MEDIA_STATUS_SUCCESS or MEDIA_STATUS_ERROR.
+ */
+extern uint8_t media_nand_initialize(struct _media *media,
+		struct _nand_ftl *ftl, struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks, uint16_t reserved,
+		uint32_t *map);
+
+/**
+ * \brief Erase the whole partition and mount an empty FTL on it.
+ * Parameters are the same as media_nand_initialize().
+ */
+extern uint8_t media_nand_format(struct _media *media,
+		struct _nand_ftl *ftl, struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks, uint16_t reserved,
+		uint32_t *map);
+
+#endif /* _MEDIA_NAND_H */
@@ -0,0 +1,393 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the media layer for SPI-NOR / QSPI flash.
+ *
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "trace.h"
+#include "media.h"
+#include "media_spi_nor.h"
+#include "media_private.h"
+
+#include "nvm/spi-nor/spi-flash.h"
+#include "nvm/spi-nor/spi-nor.h"
+
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+/** Largest erase size of the flash fitting in \a buf_size, 0 if none */
+static uint32_t _nor_erase_size(const struct spi_flash *flash, uint32_t buf_size)
+{
+	const struct spi_flash_erase_map *map = &flash->erase_map;
+	uint32_t i, size = 0;
+
+	/* spi_nor_erase() only handles uniform erase maps */
+	if (!spi_flash_has_uniform_erase(flash))
+		return 0;
+
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		if (!(map->uniform_region.cmd_mask & (1u << i)))
+			continue;
+		if (map->commands[i].size <= buf_size &&
+		    map->commands[i].size > size)
+			size = map->commands[i].size;
+	}
+
+	return size;
+}
+
+static bool _nor_is_blank(const uint8_t *data, uint32_t len)
+{
+	while (len--) {
+		if (*data++ != 0xFF)
+			return false;
+	}
+	return true;
+}
+
+/** Write back the cached sector if it was modified */
+static int _nor_write_back(struct _spi_nor_media *nor)
+{
+	uint32_t base, page_size, start, end;
+	int rc;
+
+	if (!nor->dirty)
+		return 0;
+
+	base = nor->offset + nor->sector * nor->sector_size;
+	nor->stats.write_backs++;
+
+	if (!nor->need_erase) {
+		/* only 1 -> 0 transitions: program the modified bytes */
+		rc = spi_nor_write(nor->flash, base + nor->dirty_start,
+				nor->buf + nor->dirty_start,
+				nor->dirty_end - nor->dirty_start);
+		if (rc < 0)
+			return rc;
+		nor->stats.erases_saved++;
+		nor->stats.pages += (nor->dirty_end - nor->dirty_start +
+				nor->flash->page_size - 1) / nor->flash->page_size;
+		nor->dirty = false;
+		return 0;
+	}
+
+	rc = spi_nor_erase(nor->flash, base, nor->sector_size);
+	if (rc < 0)
+		return rc;
+	nor->stats.erases++;
+	if (nor->erase_counts)
+		nor->erase_counts[nor->sector]++;
+
+	/* program runs of non-blank pages */
+	page_size = nor->flash->page_size;
+	for (start = 0; start < nor->sector_size; start = end) {
+		if (_nor_is_blank(nor->buf + start, page_size)) {
+			end = start + page_size;
+			continue;
+		}
+		for (end = start + page_size; end < nor->sector_size; end += page_size) {
+			if (_nor_is_blank(nor->buf + end, page_size))
+				break;
+		}
+		rc = spi_nor_write(nor->flash, base + start, nor->buf + start,
+				end - start);
+		if (rc < 0)
+			return rc;
+		nor->stats.pages += (end - start) / page_size;
+	}
+
+	nor->need_erase = false;
+	nor->dirty = false;
+	return 0;
+}
+
+/** Make \a sector the cached sector */
+static int _nor_load(struct _spi_nor_media *nor, uint32_t sector)
+{
+	int rc;
+
+	if (nor->sector == sector)
+		return 0;
+
+	rc = _nor_write_back(nor);
+	if (rc < 0)
+		return rc;
+
+	nor->sector = SPI_NOR_MEDIA_NONE;
+	rc = spi_nor_read(nor->flash, nor->offset + sector * nor->sector_size,
+			nor->buf, nor->sector_size);
+	if (rc < 0)
+		return rc;
+
+	nor->sector = sector;
+	nor->dirty = false;
+	nor->need_erase = false;
+	return 0;
+}
+
+static int _nor_read(struct _spi_nor_media *nor, uint32_t addr,
+		uint8_t *data, uint32_t len)
+{
+	uint32_t cache_start, cache_end, start, end;
+	int rc;
+
+	if (nor->sector == SPI_NOR_MEDIA_NONE)
+		return spi_nor_read(nor->flash, nor->offset + addr, data, len);
+
+	/* serve the part overlapping the cached sector from RAM */
+	cache_start = nor->sector * nor->sector_size;
+	cache_end = cache_start + nor->sector_size;
+	start = addr > cache_start ? addr : cache_start;
+	end = addr + len < cache_end ? addr + len : cache_end;
+	if (start >= end)
+		return spi_nor_read(nor->flash, nor->offset + addr, data, len);
+
+	if (addr < start) {
+		rc = spi_nor_read(nor->flash, nor->offset + addr, data, start - addr);
+		if (rc < 0)
+			return rc;
+	}
+	memcpy(data + (start - addr), nor->buf + (start - cache_start), end - start);
+	if (end < addr + len) {
+		rc = spi_nor_read(nor->flash, nor->offset + end,
+				data + (end - addr), addr + len - end);
+		if (rc < 0)
+			return rc;
+	}
+	return 0;
+}
+
+static int _nor_write(struct _spi_nor_media *nor, uint32_t addr,
+		const uint8_t *data, uint32_t len)
+{
+	uint32_t sector, pos, chunk, i;
+	uint8_t *cache;
+	int rc;
+
+	while (len) {
+		sector = addr / nor->sector_size;
+		pos = addr % nor->sector_size;
+		chunk = nor->sector_size - pos;
+		if (chunk > len)
+			chunk = len;
+
+		rc = _nor_load(nor, sector);
+		if (rc < 0)
+			return rc;
+
+		cache = nor->buf + pos;
+		if (memcmp(cache, data, chunk)) {
+			if (!nor->need_erase) {
+				for (i = 0; i < chunk; i++) {
+					if ((cache[i] & data[i]) != data[i]) {
+						nor->need_erase = true;
+						break;
+					}
+				}
+			}
+			memcpy(cache, data, chunk);
+			if (!nor->dirty) {
+				nor->dirty_start = pos;
+				nor->dirty_end = pos + chunk;
+				nor->dirty = true;
+			} else {
+				if (pos < nor->dirty_start)
+					nor->dirty_start = pos;
+				if (pos + chunk > nor->dirty_end)
+					nor->dirty_end = pos + chunk;
+			}
+		}
+
+		addr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Media operations
+ *------------------------------------------------------------------------------*/
+
+static uint8_t media_spi_nor_read(struct _media *media, uint32_t address,
+		void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _spi_nor_media *nor = (struct _spi_nor_media*)media->interface;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _nor_read(nor, address * media->block_size, (uint8_t*)data,
+			length * media->block_size) < 0 ?
+		MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+static uint8_t media_spi_nor_write(struct _media *media, uint32_t address,
+		void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _spi_nor_media *nor = (struct _spi_nor_media*)media->interface;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if (media->write_protected)
+		return MEDIA_STATUS_PROTECTED;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _nor_write(nor, address * media->block_size,
+			(const uint8_t*)data, length * media->block_size) < 0 ?
+		MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+static uint8_t media_spi_nor_flush(struct _media *media)
+{
+	struct _spi_nor_media *nor = (struct _spi_nor_media*)media->interface;
+	int rc;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	media->state = MEDIA_STATE_BUSY;
+	rc = _nor_write_back(nor);
+	media->state = MEDIA_STATE_READY;
+
+	return rc < 0 ? MEDIA_STATUS_ERROR : MEDIA_STATUS_SUCCESS;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+uint32_t media_spi_nor_sector_count(const struct spi_flash *flash,
+		uint32_t size, uint32_t buf_size)
+{
+	uint32_t sector_size = _nor_erase_size(flash, buf_size);
+
+	if (!sector_size)
+		return 0;
+	if (!size)
+		size = flash->size;
+	return size / sector_size;
+}
+
+uint32_t media_spi_nor_get_erase_count(const struct _spi_nor_media *nor,
+		uint32_t sector)
+{
+	if (!nor->erase_counts || sector >= nor->num_sectors)
+		return 0;
+	return nor->erase_counts[sector];
+}
+
+uint8_t media_spi_nor_initialize(struct _media *media,
+		struct _spi_nor_media *nor, struct spi_flash *flash,
+		uint32_t offset, uint32_t size,
+		uint8_t *buf, uint32_t buf_size, uint32_t *erase_counts)
+{
+	uint32_t sector_size;
+
+	memset(media, 0, sizeof(*media));
+	media->state = MEDIA_STATE_NOT_READY;
+
+	if (!size && offset < flash->size)
+		size = flash->size - offset;
+
+	sector_size = _nor_erase_size(flash, buf_size);
+	if (!sector_size || !size || offset + size > flash->size ||
+	    (offset % sector_size) || (size % sector_size) ||
+	    (sector_size % SPI_NOR_MEDIA_BLOCK_SIZE)) {
+		trace_error("spi-nor media: unsupported region or erase map\r\n");
+		return MEDIA_STATUS_ERROR;
+	}
+
+	nor->flash = flash;
+	nor->offset = offset;
+	nor->sector_size = sector_size;
+	nor->num_sectors = size / sector_size;
+	nor->erase_counts = erase_counts;
+	nor->buf = buf;
+	nor->sector = SPI_NOR_MEDIA_NONE;
+	nor->dirty = false;
+	nor->need_erase = false;
+	memset(&nor->stats, 0, sizeof(nor->stats));
+	if (erase_counts)
+		memset(erase_counts, 0, nor->num_sectors * sizeof(uint32_t));
+
+	trace_info("spi-nor media: %u KB, %u sectors of %u KB\r\n",
+		(unsigned)(size / 1024), (unsigned)nor->num_sectors,
+		(unsigned)(sector_size / 1024));
+
+	media->write = media_spi_nor_write;
+	media->read = media_spi_nor_read;
+	media->flush = media_spi_nor_flush;
+
+	media->interface = nor;
+	media->block_size = SPI_NOR_MEDIA_BLOCK_SIZE;
+	media->base_address = 0;
+	media->size = size / SPI_NOR_MEDIA_BLOCK_SIZE;
+	media->write_protected = false;
+	media->removable = false;
+	media->state = MEDIA_STATE_READY;
+
+	return MEDIA_STATUS_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  Media layer for SPI-NOR / QSPI flash.
+ *
+ *  \section Purpose
+ *
+ *  The flash is exported as 512-byte media blocks.  Writes are gathered in a
+ *  RAM copy of one erase sector, the largest erase size of the SFDP erase
+ *  map that fits in the cache buffer.  The sector is written back when
+ *  another sector is written, or on media_flush():
+ *  - not at all if the written data matches the flash content;
+ *  - by programming the modified pages only, when no bit has to go from 0
+ *    to 1;
+ *  - by erasing the sector and programming its non-blank pages otherwise.
+ *
+ *  The number of erases of each sector since initialization is counted.
+ *
+ *  \section Usage
+ *  -# Configure the flash with spi_nor_configure().
+ *  -# Call media_spi_nor_initialize() with a cache buffer of at least one
+ *     erase sector (the smallest erase size of the flash).
+ *  -# Use the media through the media_*() functions, call media_flush()
+ *     to write back the cached sector.
+ */
+
+#ifndef _MEDIA_SPI_NOR_H
+#define _MEDIA_SPI_NOR_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "libstoragemedia/media.h"
+#include "nvm/spi-nor/spi-nor.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Media block size exported for SPI-NOR */
+#define SPI_NOR_MEDIA_BLOCK_SIZE 512
+
+/** No sector cached */
+#define SPI_NOR_MEDIA_NONE 0xFFFFFFFFu
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+struct _spi_nor_media_stats {
+	uint32_t write_backs;   /**< dirty sectors written back */
+	uint32_t erases;        /**< sector erases */
+	uint32_t erases_saved;  /**< write-backs done without erase */
+	uint32_t pages;         /**< pages programmed */
+};
+
+struct _spi_nor_media {
+	struct spi_flash *flash;
+	uint32_t offset;        /**< flash offset of the first media block */
+	uint32_t sector_size;   /**< erase size used for write-back */
+	uint32_t num_sectors;
+
+	uint32_t *erase_counts; /**< erases per sector, can be NULL */
+
+	/* write-back cache of one erase sector */
+	uint8_t *buf;
+	uint32_t sector;        /**< cached sector, SPI_NOR_MEDIA_NONE if none */
+	uint32_t dirty_start;   /**< modified bytes, [start, end) in the sector */
+	uint32_t dirty_end;
+	bool     dirty;
+	bool     need_erase;    /**< some bit goes from 0 to 1 */
+
+	struct _spi_nor_media_stats stats;
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a media on a region of a SPI-NOR flash.
+ * \param media         Media instance to initialize.
+ * \param nor           Media state, must stay valid while the media is used.
+ * \param flash         Configured flash (see spi_nor_configure()).
+ * \param offset        Start of the region, aligned on the erase size.
+ * \param size          Size of the region in bytes, 0 for the end of flash.
+ * \param buf           Sector cache (cache-line aligned for DMA).
+ * \param buf_size      Size of \a buf, limits the erase size used.
+ * \param erase_counts  Optional array of one counter per erase sector, see
+ *                      media_spi_nor_sector_count().
+ * \return MEDIA_STATUS_SUCCESS or MEDIA_STATUS_ERROR.
+ */
+extern uint8_t media_spi_nor_initialize(struct _media *media,
+		struct _spi_nor_media *nor, struct spi_flash *flash,
+		uint32_t offset, uint32_t size,
+		uint8_t *buf, uint32_t buf_size, uint32_t *erase_counts);
+
+/**
+ * \brief Number of erase sectors of a region, i.e. the size of the
+ * erase_counts array of media_spi_nor_initialize().
+ */
+extern uint32_t media_spi_nor_sector_count(const struct spi_flash *flash,
+		uint32_t size, uint32_t buf_size);
+
+/**
+ * \brief Number of erases of a sector since the media was initialized.
+ */
+extern uint32_t media_spi_nor_get_erase_count(const struct _spi_nor_media *nor,
+		uint32_t sector);
+
+#endif /* _MEDIA_SPI_NOR_H */
@@ -0,0 +1,228 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Internet checksum routines for lwIP (LWIP_CHKSUM and LWIP_CHKSUM_COPY).
+ *
+ * The data is summed as 32-bit words into a 64-bit accumulator, so that the
+ * carries are simply kept in the upper half and folded once at the end
+ * (the compiler emits an add-with-carry chain).  When built with NEON
+ * (CONFIG_NEON=y), large buffers are summed 16 bytes at a time with pairwise
+ * widening adds.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "arch/cc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/** Fold a 64-bit accumulator into a 16-bit one's complement sum */
+static inline uint16_t _chksum_fold(uint64_t acc)
+{
+	uint32_t sum;
+
+	acc = (acc & 0xffffffffu) + (acc >> 32);
+	acc = (acc & 0xffffffffu) + (acc >> 32);
+	sum = (uint32_t)acc;
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t)sum;
+}
+
+#ifdef __ARM_NEON
+/** Sum 16-byte blocks, returns the number of bytes consumed */
+static uint32_t _chksum_neon(const uint8_t *data, uint32_t len, uint64_t *acc)
+{
+	uint32_t done = 0;
+
+	while (len - done >= 16) {
+		uint32x4_t sum = vdupq_n_u32(0);
+		uint32x2_t half;
+		/* each lane grows by at most 2 * 0xffff per block */
+		uint32_t blocks = (len - done) / 16;
+		if (blocks > 0x7fff)
+			blocks = 0x7fff;
+		done += blocks * 16;
+		while (blocks--) {
+			sum = vpadalq_u16(sum, vreinterpretq_u16_u8(vld1q_u8(data)));
+			data += 16;
+		}
+		half = vadd_u32(vget_low_u32(sum), vget_high_u32(sum));
+		*acc += (uint64_t)vget_lane_u32(half, 0) + vget_lane_u32(half, 1);
+	}
+	return done;
+}
+#endif
+
+/**
+ * Sum a 4-byte aligned buffer as 32-bit words, optionally copying it.
+ * Trailing bytes (len % 4) are left to the caller.
+ */
+static uint64_t _chksum_words(uint32_t *dst, const uint32_t *src, uint32_t len)
+{
+	uint64_t acc = 0;
+
+#ifdef __ARM_NEON
+	if (!dst) {
+		uint32_t done = _chksum_neon((const uint8_t*)src, len, &acc);
+		src += done / 4;
+		len -= done;
+	}
+#endif
+
+	if (dst) {
+		while (len >= 16) {
+			uint32_t w0 = src[0], w1 = src[1], w2 = src[2], w3 = src[3];
+			dst[0] = w0;
+			dst[1] = w1;
+			dst[2] = w2;
+			dst[3] = w3;
+			acc += (uint64_t)w0 + w1 + w2 + w3;
+			src += 4;
+			dst += 4;
+			len -= 16;
+		}
+		while (len >= 4) {
+			*dst++ = *src;
+			acc += *src++;
+			len -= 4;
+		}
+	} else {
+		while (len >= 32) {
+			acc += (uint64_t)src[0] + src[1] + src[2] + src[3];
+			acc += (uint64_t)src[4] + src[5] + src[6] + src[7];
+			src += 8;
+			len -= 32;
+		}
+		while (len >= 4) {
+			acc += *src++;
+			len -= 4;
+		}
+	}
+
+	return acc;
+}
+
+/**
+ * Common implementation of the checksum, with an optional copy to dst.
+ * dst and src must have the same alignment modulo 4 when dst is set.
+ */
+static uint16_t _chksum(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint64_t acc = 0;
+	uint16_t head = 0, tail = 0;
+	uint32_t words;
+	bool odd = ((uintptr_t)src & 1) != 0;
+	uint16_t sum;
+
+	/* An odd start address is handled by summing the byte-swapped
+	 * stream: the first byte goes to the upper half of a word and the
+	 * result is swapped back at the end */
+	if (odd && len > 0) {
+		((uint8_t*)&head)[1] = *src;
+		if (dst)
+			*dst++ = *src;
+		src++;
+		len--;
+	}
+	if (((uintptr_t)src & 2) && len > 1) {
+		acc += *(const uint16_t*)src;
+		if (dst) {
+			*(uint16_t*)dst = *(const uint16_t*)src;
+			dst += 2;
+		}
+		src += 2;
+		len -= 2;
+	}
+	acc += head;
+
+	words = len & ~3u;
+	acc += _chksum_words((uint32_t*)dst, (const uint32_t*)src, words);
+	src += words;
+	if (dst)
+		dst += words;
+	len -= words;
+
+	if (len > 1) {
+		acc += *(const uint16_t*)src;
+		if (dst) {
+			*(uint16_t*)dst = *(const uint16_t*)src;
+			dst += 2;
+		}
+		src += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		((uint8_t*)&tail)[0] = *src;
+		if (dst)
+			*dst = *src;
+		acc += tail;
+	}
+
+	sum = _chksum_fold(acc);
+	if (odd)
+		sum = (uint16_t)((sum << 8) | (sum >> 8));
+	return sum;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint16_t lwip_arch_chksum(const void *data, int len)
+{
+	if (len <= 0)
+		return 0;
+	return _chksum(NULL, (const uint8_t*)data, (uint32_t)len);
+}
+
+uint16_t lwip_arch_chksum_copy(void *dst, const void *src, uint16_t len)
+{
+	/* word copies need the same alignment on both sides */
+	if (((uintptr_t)dst ^ (uintptr_t)src) & 3) {
+		memcpy(dst, src, len);
+		return lwip_arch_chksum(dst, len);
+	}
+	return _chksum((uint8_t*)dst, (const uint8_t*)src, len);
+}
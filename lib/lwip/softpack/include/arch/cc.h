@@ -30,6 +30,7 @@
 #ifndef _CC_H
 #define _CC_H
 
+#include <stdint.h>
 #include <stdio.h>
 
 /* Define platform endianness */
@@ -68,6 +69,12 @@
     #error "This compiler does not support."
 #endif
 
+/* Optimized checksum routines (see arch/chksum.c) */
+extern uint16_t lwip_arch_chksum(const void *data, int len);
+extern uint16_t lwip_arch_chksum_copy(void *dst, const void *src, uint16_t len);
+#define LWIP_CHKSUM lwip_arch_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_arch_chksum_copy(dst, src, len)
+
 /* No assert */
 #define LWIP_NOASSERT
 
@@ -70,6 +70,20 @@
 #define IFNAME0 'e'
 #define IFNAME1 'n'
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/* Checksums left to lwIP when the ETH offloads them. ICMP is never handled by
+ * the MAC, and UDP datagrams reassembled from IP fragments cannot be checked
+ * by it either. */
+#if IP_REASSEMBLY
+#define ETHIF_CHECKSUM_CTRL (NETIF_CHECKSUM_GEN_ICMP | NETIF_CHECKSUM_GEN_ICMP6 |\
+		NETIF_CHECKSUM_CHECK_UDP | NETIF_CHECKSUM_CHECK_ICMP |\
+		NETIF_CHECKSUM_CHECK_ICMP6)
+#else
+#define ETHIF_CHECKSUM_CTRL (NETIF_CHECKSUM_GEN_ICMP | NETIF_CHECKSUM_GEN_ICMP6 |\
+		NETIF_CHECKSUM_CHECK_ICMP | NETIF_CHECKSUM_CHECK_ICMP6)
+#endif
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -155,7 +169,47 @@ static void glow_level_init(struct netif *netif, struct _ethd* ethd)
 	netif->mtu = 1500;
 	/* device capabilities */
 	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET| NETIF_FLAG_LINK_UP;
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+	/* let the MAC compute IP/TCP/UDP checksums when it can */
+	if (ethd_set_offload(ethd, ETH_OFFLOAD_RX_CSUM | ETH_OFFLOAD_TX_CSUM) == ETH_OK)
+		NETIF_SET_CHECKSUM_CTRL(netif, ETHIF_CHECKSUM_CTRL);
+#endif
+}
+
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/**
+ * With receive checksum offload, frames with a wrong checksum never reach
+ * us, but IPv4 fragments are passed unchecked. Drop the TCP/UDP ones whose
+ * checksum lwIP will not verify either.
+ *
+ * @return 1 if the frame can be passed to lwIP
+ */
+static int glow_level_checksum_ok(struct netif *netif, const uint8_t *frame, uint32_t len)
+{
+    struct _ethd *ethd = board_get_eth(netif->num);
+    uint32_t csum;
+
+    if (!(ethd_get_offload(ethd) & ETH_OFFLOAD_RX_CSUM))
+        return 1;
+    /* the frame starts with the Ethernet header, without padding */
+    if (len < 14 + IP_HLEN)
+        return 1;
+    if (((frame[12] << 8) | frame[13]) != ETHTYPE_IP)
+        return 1;
+
+    csum = ethd_get_rx_checksum(ethd, 0);
+    switch (frame[14 + 9]) { /* IPv4 protocol field */
+    case IP_PROTO_TCP:
+        return csum == ETH_RX_STATUS_CSUM_TCP ||
+            (netif->chksum_flags & NETIF_CHECKSUM_CHECK_TCP);
+    case IP_PROTO_UDP:
+        return csum == ETH_RX_STATUS_CSUM_UDP ||
+            (netif->chksum_flags & NETIF_CHECKSUM_CHECK_UDP);
+    default:
+        return 1;
+    }
 }
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
 
 /**
  * This function should do the actual transmission of the packet. The packet is
@@ -230,6 +284,14 @@ static struct pbuf *glow_level_input(struct netif *netif)
     }
     len = frmlen;
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+    if (!glow_level_checksum_ok(netif, buf, frmlen)) {
+        LINK_STATS_INC(link.chkerr);
+        LINK_STATS_INC(link.drop);
+        return NULL;
+    }
+#endif
+
 #if ETH_PAD_SIZE
     len += ETH_PAD_SIZE;      /* allow room for Ethernet padding */
 #endif
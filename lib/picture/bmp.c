@@ -34,6 +34,9 @@
  *----------------------------------------------------------------------------*/
 
 #include "board.h"
+#include "trace.h"
+#include "picture/bmp.h"
+
 #include <string.h>
 
 /*----------------------------------------------------------------------------
@@ -0,0 +1,509 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2011, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "picture/bmp.h"
+#include "picture/bmp_stream.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Size of the BMP file header */
+#define BMP_FILE_HEADER_SIZE 14
+
+/** Maximum number of bytes fetched at once by the row decoder */
+#define BMP_PIECE_SIZE (BMP_STREAM_CHUNK_SIZE / 2)
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint16_t _le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t _le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * \brief Return a pointer to the next size bytes of the file, refilling the
+ * chunk buffer when needed.
+ * \return NULL on read error or end of file.
+ */
+static const uint8_t *_fetch(struct _bmp_stream *bmp, uint32_t size)
+{
+	uint32_t avail = bmp->chunk_len - bmp->chunk_pos;
+	const uint8_t *p;
+
+	if (avail < size) {
+		UINT read;
+
+		memmove(bmp->chunk, bmp->chunk + bmp->chunk_pos, avail);
+		bmp->chunk_pos = 0;
+		bmp->chunk_len = avail;
+		if (f_read(bmp->file, bmp->chunk + avail,
+				sizeof(bmp->chunk) - avail, &read) != FR_OK)
+			return NULL;
+		bmp->chunk_len += read;
+		if (bmp->chunk_len < size)
+			return NULL;
+	}
+
+	p = bmp->chunk + bmp->chunk_pos;
+	bmp->chunk_pos += size;
+	return p;
+}
+
+/**
+ * \brief Move to a file offset and drop the chunk buffer content.
+ */
+static int _seek(struct _bmp_stream *bmp, uint32_t offset)
+{
+	bmp->chunk_pos = 0;
+	bmp->chunk_len = 0;
+	return f_lseek(bmp->file, offset) == FR_OK ? 0 : -EIO;
+}
+
+/**
+ * \brief Convert a 0xRRGGBB color to the destination pixel format.
+ */
+static uint32_t _convert_color(uint8_t bpp, uint32_t rgb)
+{
+	switch (bpp) {
+	case 16:
+		return ((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0)
+			| ((rgb >> 3) & 0x001F);
+	case 24:
+		return rgb;
+	default:
+		return 0xFF000000 | rgb;
+	}
+}
+
+static void _store_pixel(uint8_t *p, uint8_t bpp, uint32_t color)
+{
+	switch (bpp) {
+	case 16:
+		*(uint16_t *)p = color;
+		break;
+	case 24:
+		p[0] = color;
+		p[1] = color >> 8;
+		p[2] = color >> 16;
+		break;
+	default:
+		*(uint32_t *)p = color;
+		break;
+	}
+}
+
+/**
+ * \brief Clip a span of n pixels starting at (x, y) to the surface.
+ * \param n     Number of pixels, updated with the visible count.
+ * \param skip  Set to the number of pixels clipped on the left side.
+ * \return Destination of the first visible pixel, NULL if none is visible.
+ */
+static uint8_t *_clip_span(const struct _gfx_surface *dst, int x, int y,
+		uint32_t *n, uint32_t *skip)
+{
+	int end = x + (int)*n;
+
+	*skip = 0;
+	if (y < 0 || y >= dst->height)
+		return NULL;
+	if (x < 0) {
+		*skip = -x;
+		x = 0;
+	}
+	if (end > dst->width)
+		end = dst->width;
+	if (end <= x)
+		return NULL;
+	*n = end - x;
+	return (uint8_t *)dst->buffer + y * dst->stride + x * (dst->bpp >> 3);
+}
+
+/**
+ * \brief Convert n BGR(X) pixels, step being 3 or 4 bytes.
+ */
+static void _convert_rgb(uint8_t *p, uint8_t bpp, const uint8_t *s,
+		uint32_t n, uint32_t step)
+{
+	uint32_t i;
+
+	switch (bpp) {
+	case 16:
+	{
+		uint16_t *d = (uint16_t *)p;
+		for (i = 0; i < n; i++, s += step)
+			d[i] = ((s[2] & 0xF8) << 8) | ((s[1] & 0xFC) << 3)
+				| (s[0] >> 3);
+		break;
+	}
+	case 24:
+		if (step == 3) {
+			/* Same byte order as the LCDC packed format */
+			memcpy(p, s, n * 3);
+		} else {
+			for (i = 0; i < n; i++, s += step, p += 3) {
+				p[0] = s[0];
+				p[1] = s[1];
+				p[2] = s[2];
+			}
+		}
+		break;
+	default:
+	{
+		uint32_t *d = (uint32_t *)p;
+		for (i = 0; i < n; i++, s += step)
+			d[i] = 0xFF000000 | (s[2] << 16) | (s[1] << 8) | s[0];
+		break;
+	}
+	}
+}
+
+/**
+ * \brief Convert n palette indexes starting at index first of s.
+ */
+static void _convert_indexed(const struct _bmp_stream *bmp, uint8_t *p,
+		uint8_t bpp, uint8_t bits, const uint8_t *s, uint32_t first,
+		uint32_t n)
+{
+	uint32_t mask = (1u << bits) - 1;
+	uint32_t step = bpp >> 3;
+	uint32_t i, pos;
+
+	for (i = 0; i < n; i++, p += step) {
+		pos = (first + i) * bits;
+		_store_pixel(p, bpp, bmp->lut[(s[pos >> 3] >>
+				(8 - bits - (pos & 7))) & mask]);
+	}
+}
+
+/**
+ * \brief Write n pixels of the file format read from s at (x, y).
+ */
+static void _put_pixels(const struct _bmp_stream *bmp,
+		const struct _gfx_surface *dst, uint8_t bits, int x, int y,
+		const uint8_t *s, uint32_t n)
+{
+	uint32_t skip;
+	uint8_t *p = _clip_span(dst, x, y, &n, &skip);
+
+	if (!p)
+		return;
+
+	if (bits >= 24)
+		_convert_rgb(p, dst->bpp, s + skip * (bits >> 3), n, bits >> 3);
+	else
+		_convert_indexed(bmp, p, dst->bpp, bits, s, skip, n);
+}
+
+/**
+ * \brief Write a RLE run of n pixels at (x, y), alternating colors c0 and c1.
+ */
+static void _put_run(const struct _gfx_surface *dst, int x, int y,
+		uint32_t n, uint32_t c0, uint32_t c1)
+{
+	uint32_t skip, i;
+	uint32_t step = dst->bpp >> 3;
+	uint8_t *p = _clip_span(dst, x, y, &n, &skip);
+
+	if (!p)
+		return;
+
+	for (i = skip; i < skip + n; i++, p += step)
+		_store_pixel(p, dst->bpp, (i & 1) ? c1 : c0);
+}
+
+/**
+ * \brief Read the palette and convert it to the destination format.
+ */
+static int _load_palette(struct _bmp_stream *bmp, uint8_t bpp)
+{
+	const uint8_t *p;
+	uint32_t i;
+	int err;
+
+	err = _seek(bmp, bmp->palette_offset);
+	if (err < 0)
+		return err;
+
+	for (i = 0; i < bmp->palette_size; i++) {
+		p = _fetch(bmp, 4);
+		if (!p)
+			return -EIO;
+		bmp->lut[i] = _convert_color(bpp, (p[2] << 16) | (p[1] << 8) | p[0]);
+	}
+	for (; i < 256; i++)
+		bmp->lut[i] = _convert_color(bpp, 0);
+
+	return 0;
+}
+
+/**
+ * \brief Decode uncompressed rows, in pieces of at most BMP_PIECE_SIZE bytes.
+ */
+static int _decode_rows(struct _bmp_stream *bmp,
+		const struct _gfx_surface *dst, int x, int y)
+{
+	uint32_t data_bytes = (bmp->width * bmp->bits + 7) / 8;
+	uint32_t row_bytes = ((bmp->width * bmp->bits + 31) / 32) * 4;
+	uint32_t piece = ((BMP_PIECE_SIZE * 8) / bmp->bits) & ~7u;
+	const uint8_t *p;
+	uint32_t row, col, n;
+	int dy;
+
+	for (row = 0; row < bmp->height; row++) {
+		dy = y + (int)(bmp->top_down ? row : bmp->height - 1 - row);
+		for (col = 0; col < bmp->width; col += n) {
+			n = bmp->width - col;
+			if (n > piece)
+				n = piece;
+			p = _fetch(bmp, (n * bmp->bits + 7) / 8);
+			if (!p)
+				return -EIO;
+			_put_pixels(bmp, dst, bmp->bits, x + col, dy, p, n);
+		}
+		/* Row padding, may be missing at end of file */
+		if (row + 1 < bmp->height && row_bytes > data_bytes)
+			if (!_fetch(bmp, row_bytes - data_bytes))
+				return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Decode RLE8 or RLE4 data. Rows are always stored bottom-up.
+ */
+static int _decode_rle(struct _bmp_stream *bmp,
+		const struct _gfx_surface *dst, int x, int y)
+{
+	const uint8_t *p;
+	uint32_t row = 0, col = 0;
+	uint32_t count, n;
+	uint8_t value;
+	int dy;
+
+	while (row < bmp->height) {
+		p = _fetch(bmp, 2);
+		if (!p)
+			return -EIO;
+		count = p[0];
+		value = p[1];
+		dy = y + (int)(bmp->height - 1 - row);
+
+		if (count) {
+			/* Encoded run */
+			n = col < bmp->width ? bmp->width - col : 0;
+			if (n > count)
+				n = count;
+			if (bmp->bits == 8)
+				_put_run(dst, x + col, dy, n, bmp->lut[value],
+						bmp->lut[value]);
+			else
+				_put_run(dst, x + col, dy, n, bmp->lut[value >> 4],
+						bmp->lut[value & 0xF]);
+			col += count;
+			continue;
+		}
+
+		switch (value) {
+		case 0:
+			/* End of line */
+			row++;
+			col = 0;
+			break;
+		case 1:
+			/* End of bitmap */
+			return 0;
+		case 2:
+			/* Delta */
+			p = _fetch(bmp, 2);
+			if (!p)
+				return -EIO;
+			col += p[0];
+			row += p[1];
+			break;
+		default:
+			/* Absolute mode, padded to 16 bits */
+			count = value;
+			p = _fetch(bmp, (((count * bmp->bits + 7) / 8) + 1) & ~1u);
+			if (!p)
+				return -EIO;
+			n = col < bmp->width ? bmp->width - col : 0;
+			if (n > count)
+				n = count;
+			_put_pixels(bmp, dst, bmp->bits, x + col, dy, p, n);
+			col += count;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Read and check the headers of a BMP file.
+ * \param bmp   Decoding state to initialize.
+ * \param file  File opened for reading.
+ * \return 0 on success, -EIO on read error, -EINVAL if the file is not a
+ * valid BMP file, -ENOTSUP for unsupported formats.
+ */
+int bmp_stream_open(struct _bmp_stream *bmp, FIL *file)
+{
+	const uint8_t *p;
+	uint32_t header_size, colors;
+	int32_t width, height;
+	int err;
+
+	bmp->file = file;
+	err = _seek(bmp, 0);
+	if (err < 0)
+		return err;
+
+	p = _fetch(bmp, BMP_FILE_HEADER_SIZE + BITMAPINFOHEADER);
+	if (!p)
+		return -EIO;
+	if (_le16(p) != BMP_TYPE)
+		return -EINVAL;
+	bmp->data_offset = _le32(p + 10);
+
+	/* Info header, BITMAPINFOHEADER or later version */
+	p += BMP_FILE_HEADER_SIZE;
+	header_size = _le32(p);
+	if (header_size < BITMAPINFOHEADER)
+		return -ENOTSUP;
+	width = (int32_t)_le32(p + 4);
+	height = (int32_t)_le32(p + 8);
+	if (width <= 0 || height == 0 || _le16(p + 12) != 1)
+		return -EINVAL;
+	bmp->width = width;
+	bmp->top_down = height < 0;
+	bmp->height = height < 0 ? -height : height;
+	bmp->bits = _le16(p + 14);
+	bmp->compression = _le32(p + 16);
+	colors = _le32(p + 32);
+
+	switch (bmp->compression) {
+	case BMP_COMPRESSION_RGB:
+		if (bmp->bits != 1 && bmp->bits != 4 && bmp->bits != 8
+		    && bmp->bits != 24 && bmp->bits != 32)
+			return -ENOTSUP;
+		break;
+	case BMP_COMPRESSION_RLE8:
+	case BMP_COMPRESSION_RLE4:
+		if (bmp->bits != (bmp->compression == BMP_COMPRESSION_RLE8 ? 8 : 4))
+			return -EINVAL;
+		if (bmp->top_down)
+			return -EINVAL;
+		break;
+	case BMP_COMPRESSION_BITFIELDS:
+		/* Only BGRX layouts, masks follow the BITMAPINFOHEADER part */
+		if (bmp->bits != 32)
+			return -ENOTSUP;
+		p = _fetch(bmp, 12);
+		if (!p)
+			return -EIO;
+		if (_le32(p) != 0x00FF0000 || _le32(p + 4) != 0x0000FF00
+		    || _le32(p + 8) != 0x000000FF)
+			return -ENOTSUP;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	bmp->palette_offset = BMP_FILE_HEADER_SIZE + header_size;
+	if (bmp->bits <= 8) {
+		bmp->palette_size = 1 << bmp->bits;
+		if (colors && colors < bmp->palette_size)
+			bmp->palette_size = colors;
+	} else {
+		bmp->palette_size = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Decode the image into a surface, its top left corner being placed
+ * at (x, y). Parts outside of the surface are skipped. Pixels left out by
+ * RLE deltas and end-of-line codes are not modified. The alpha channel of
+ * 32 bpp images is ignored.
+ * \note If the surface is read by a DMA (e.g. LCDC canvas), the data cache
+ * must be cleaned afterwards.
+ * \param bmp  Decoding state from bmp_stream_open().
+ * \param dst  Destination surface, 16, 24 or 32 bpp.
+ * \param x    Destination column of the image left side.
+ * \param y    Destination row of the image top side.
+ * \return 0 on success, -EIO on read error or truncated file, -EINVAL for
+ * an unsupported surface.
+ */
+int bmp_stream_decode(struct _bmp_stream *bmp,
+		const struct _gfx_surface *dst, int x, int y)
+{
+	int err;
+
+	if (dst->bpp != 16 && dst->bpp != 24 && dst->bpp != 32)
+		return -EINVAL;
+
+	if (bmp->palette_size) {
+		err = _load_palette(bmp, dst->bpp);
+		if (err < 0)
+			return err;
+	}
+
+	err = _seek(bmp, bmp->data_offset);
+	if (err < 0)
+		return err;
+
+	if (bmp->compression == BMP_COMPRESSION_RLE8
+	    || bmp->compression == BMP_COMPRESSION_RLE4)
+		return _decode_rle(bmp, dst, x, y);
+	else
+		return _decode_rows(bmp, dst, x, y);
+}
@@ -0,0 +1,114 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2011, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *  \section Purpose
+ *
+ *  Streaming BMP decoder: pixel rows are read from a FatFs file through a
+ *  small chunk buffer and converted on the fly to the pixel format of the
+ *  destination, so that no copy of the file or of the image is needed.
+ *
+ *  Supported input:
+ *  - uncompressed 1, 4, 8 (palette), 24 and 32 bpp images, bottom-up or
+ *    top-down,
+ *  - 32 bpp images with BGRX bit fields, alpha being ignored,
+ *  - RLE8 and RLE4 compressed images.
+ *
+ *  Supported output: RGB 565, RGB 888 packed and ARGB 8888 surfaces, see
+ *  libgfx/gfx.h. To decode into the LCDC canvas, build a surface from the
+ *  canvas buffer and geometry with gfx_init_surface().
+ *
+ *  Peak memory is the bmp_stream structure: one chunk buffer and the
+ *  converted palette.
+ */
+
+#ifndef BMP_STREAM_H
+#define BMP_STREAM_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fatfs/src/ff.h"
+#include "libgfx/gfx.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the read chunk, at least 256 bytes */
+#ifndef BMP_STREAM_CHUNK_SIZE
+#define BMP_STREAM_CHUNK_SIZE 512
+#endif
+
+/** \addtogroup bmp_compression BMP compression methods
+ *      @{
+ */
+#define BMP_COMPRESSION_RGB       0
+#define BMP_COMPRESSION_RLE8      1
+#define BMP_COMPRESSION_RLE4      2
+#define BMP_COMPRESSION_BITFIELDS 3
+/**     @}*/
+
+/*------------------------------------------------------------------------------
+ *         Exported types
+ *------------------------------------------------------------------------------*/
+
+/** BMP decoding state */
+struct _bmp_stream {
+	FIL      *file;
+	uint32_t  width;          /**< Image width in pixels */
+	uint32_t  height;         /**< Image height in pixels */
+	bool      top_down;       /**< Rows stored from top to bottom */
+	uint8_t   bits;           /**< Bits per pixel in the file */
+	uint32_t  compression;    /**< BMP_COMPRESSION_xxx */
+	uint32_t  data_offset;    /**< File offset of the pixel data */
+	uint32_t  palette_offset; /**< File offset of the palette */
+	uint16_t  palette_size;   /**< Number of palette entries */
+
+	uint32_t  chunk_pos;
+	uint32_t  chunk_len;
+	uint8_t   chunk[BMP_STREAM_CHUNK_SIZE];
+	uint32_t  lut[256];       /**< Palette in destination format */
+};
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern int bmp_stream_open(struct _bmp_stream *bmp, FIL *file);
+
+extern int bmp_stream_decode(struct _bmp_stream *bmp,
+		const struct _gfx_surface *dst, int x, int y);
+
+#endif /* BMP_STREAM_H */
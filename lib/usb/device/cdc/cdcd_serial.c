@@ -170,6 +170,15 @@ uint32_t cdcd_serial_write(void *data, uint32_t size,
 			callback, callback_arg);
 }
 
+/**
+ * Returns the serial port function instance, e.g. to attach a
+ * cdcd_serial_stream to it.
+ */
+const CDCDSerialPort *cdcd_serial_get_port(void)
+{
+	return &cdcd_serial;
+}
+
 /**
  * Returns the current control line state of the RS-232 line.
  */
@@ -200,6 +200,14 @@ static inline uint32_t cdcd_serial_driver_read(
 	return cdcd_serial_read(data, size, callback, argument);
 }
 
+/**
+ * Returns the serial port function of the driver.
+ */
+static inline const CDCDSerialPort *cdcd_serial_driver_get_port(void)
+{
+	return cdcd_serial_get_port();
+}
+
 /**
  * Copy current line coding settings to pointed space.
  * \param pLineCoding Pointer to CDCLineCoding instance.
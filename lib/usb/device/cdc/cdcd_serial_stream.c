@@ -0,0 +1,446 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ * Implementation of the CDC serial stream layer.
+ */
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "compiler.h"
+#include "intmath.h"
+#include "trace.h"
+
+#include "usb/device/cdc/cdcd_serial_stream.h"
+#include "usb/device/usbd.h"
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Queue free receive slots on the OUT endpoint, keeping one slot in progress
+ * and one pending in the USB driver.
+ * Called from the transfer callback, or by the application when the stream
+ * is stalled (no transfer in progress).
+ * \param stream Pointer to the stream instance.
+ */
+static void _rx_arm(struct _cdcd_serial_stream *stream)
+{
+	struct _usbd_transfer_buffer *xfer;
+	uint32_t slot;
+
+	while (stream->running &&
+	       stream->rx_armed - stream->rx_head < 2 &&
+	       stream->rx_armed - stream->rx_tail < stream->cfg.rx_slots) {
+		slot = stream->rx_armed % stream->cfg.rx_slots;
+		xfer = &stream->rx_xfer[slot];
+		xfer->buffer = stream->cfg.rx_pool + slot * stream->cfg.rx_slot_size;
+		xfer->size = stream->cfg.rx_slot_size;
+		if (usbd_hal_queue_buffers(stream->ep_out, xfer, 1) != USBD_STATUS_SUCCESS)
+			break;
+		stream->rx_armed++;
+	}
+
+	if (stream->running && stream->rx_armed == stream->rx_head) {
+		stream->rx_stalled = true;
+		stream->stats.rx_stalls++;
+	}
+}
+
+/**
+ * Callback invoked when a receive slot has been filled.
+ */
+static void _rx_done(void *arg, uint8_t status, uint32_t transferred,
+		uint32_t remaining)
+{
+	struct _cdcd_serial_stream *stream = (struct _cdcd_serial_stream *)arg;
+
+	if (status != USBD_STATUS_SUCCESS) {
+		trace_warning("cdcd_serial_stream: RX status %u\r\n",
+				(unsigned)status);
+		stream->running = false;
+		return;
+	}
+
+	/* The slot data and length are valid before the index moves */
+	stream->stats.rx_bytes += transferred;
+	COMPILER_BARRIER();
+	stream->rx_head++;
+
+	_rx_arm(stream);
+}
+
+/**
+ * Callback invoked when a transmit buffer has been sent.
+ */
+static void _tx_done(void *arg, uint8_t status, uint32_t transferred,
+		uint32_t remaining)
+{
+	struct _cdcd_serial_stream *stream = (struct _cdcd_serial_stream *)arg;
+
+	if (status != USBD_STATUS_SUCCESS) {
+		trace_warning("cdcd_serial_stream: TX status %u\r\n",
+				(unsigned)status);
+		stream->running = false;
+		return;
+	}
+
+	stream->stats.tx_bytes += transferred;
+	stream->stats.tx_transfers++;
+	stream->tx_completed++;
+}
+
+/**
+ * Send the buffer being filled. At most two buffers are in the USB driver
+ * at any time (one in progress, one pending).
+ * \param stream Pointer to the stream instance.
+ * \return true if the buffer has been submitted.
+ */
+static bool _tx_submit(struct _cdcd_serial_stream *stream)
+{
+	struct _usbd_transfer_buffer *xfer;
+
+	if (!stream->running || stream->tx_fill == 0)
+		return false;
+
+	if (stream->tx_submitted - stream->tx_completed >= 2)
+		return false;
+
+	xfer = &stream->tx_xfer[stream->tx_submitted % stream->cfg.tx_buffers];
+	xfer->size = stream->tx_fill;
+	if (usbd_hal_queue_buffers(stream->ep_in, xfer, 1) != USBD_STATUS_SUCCESS)
+		return false;
+
+	stream->tx_submitted++;
+	stream->tx_fill = 0;
+	return true;
+}
+
+/**
+ * Skip the receive slots that have been fully consumed.
+ * \param stream Pointer to the stream instance.
+ * \return Pointer to the slot at the consumer index, NULL if none is ready.
+ */
+static struct _usbd_transfer_buffer *_rx_current(struct _cdcd_serial_stream *stream)
+{
+	struct _usbd_transfer_buffer *xfer;
+
+	while (stream->rx_tail != stream->rx_head) {
+		xfer = &stream->rx_xfer[stream->rx_tail % stream->cfg.rx_slots];
+		if (stream->rx_offset < xfer->transferred)
+			return xfer;
+		stream->rx_offset = 0;
+		stream->rx_tail++;
+	}
+
+	return NULL;
+}
+
+/**
+ * Re-arm the OUT endpoint once the application has freed slots.
+ * \param stream Pointer to the stream instance.
+ */
+static void _rx_restart(struct _cdcd_serial_stream *stream)
+{
+	/* When stalled no transfer is in progress, so the interrupt does not
+	 * touch the ring */
+	if (stream->rx_stalled &&
+	    stream->rx_armed - stream->rx_tail < stream->cfg.rx_slots) {
+		stream->rx_stalled = false;
+		_rx_arm(stream);
+	}
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initializes a stream on a CDC serial port function.
+ * \param stream Pointer to the stream instance.
+ * \param port Pointer to the serial port function.
+ * \param cfg Buffers and timeout configuration.
+ * \return USBD_STATUS_SUCCESS or USBD_STATUS_INVALID_PARAMETER.
+ */
+uint8_t cdcd_serial_stream_initialize(struct _cdcd_serial_stream *stream,
+		const CDCDSerialPort *port,
+		const struct _cdcd_serial_stream_config *cfg)
+{
+	uint8_t i;
+
+	if (cfg->rx_slots < 2 || cfg->rx_slots > CDCD_SERIAL_STREAM_MAX_RX_SLOTS ||
+	    cfg->tx_buffers < 2 || cfg->tx_buffers > CDCD_SERIAL_STREAM_MAX_TX_BUFFERS)
+		return USBD_STATUS_INVALID_PARAMETER;
+
+	/* Whole packets at both speeds */
+	if (!cfg->rx_slot_size || !cfg->tx_buffer_size ||
+	    cfg->rx_slot_size % CDCDSerialPort_BULK_MAXPACKETSIZE_HS ||
+	    cfg->tx_buffer_size % CDCDSerialPort_BULK_MAXPACKETSIZE_HS)
+		return USBD_STATUS_INVALID_PARAMETER;
+
+	memset(stream, 0, sizeof(*stream));
+	stream->port = port;
+	stream->cfg = *cfg;
+
+	for (i = 0; i < cfg->tx_buffers; i++)
+		stream->tx_xfer[i].buffer = cfg->tx_pool + i * cfg->tx_buffer_size;
+
+	return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Starts streaming on the bulk endpoints of the serial port. Must be called
+ * once the device is configured; pending data from a previous run is
+ * discarded.
+ * \param stream Pointer to the stream instance.
+ * \return USBD_STATUS_SUCCESS if the OUT endpoint has been armed;
+ *         otherwise, the corresponding error code.
+ */
+uint8_t cdcd_serial_stream_start(struct _cdcd_serial_stream *stream)
+{
+	uint8_t rc;
+
+	stream->ep_in = stream->port->bBulkInPIPE;
+	stream->ep_out = stream->port->bBulkOutPIPE;
+
+	stream->rx_armed = stream->rx_head = stream->rx_tail = 0;
+	stream->rx_offset = 0;
+	stream->rx_stalled = false;
+	stream->tx_submitted = stream->tx_completed = 0;
+	stream->tx_fill = 0;
+	memset(&stream->stats, 0, sizeof(stream->stats));
+
+	/* Cancel transfers left over from a previous run */
+	stream->running = false;
+	usbd_hal_reset_endpoints((1 << stream->ep_in) | (1 << stream->ep_out),
+			USBD_STATUS_CANCELED, true);
+
+	rc = usbd_hal_set_transfer_callback(stream->ep_out, _rx_done, stream);
+	if (rc != USBD_STATUS_SUCCESS)
+		return rc;
+	rc = usbd_hal_set_transfer_callback(stream->ep_in, _tx_done, stream);
+	if (rc != USBD_STATUS_SUCCESS)
+		return rc;
+
+	stream->running = true;
+	_rx_arm(stream);
+	if (stream->rx_armed == 0) {
+		stream->running = false;
+		return USBD_STATUS_LOCKED;
+	}
+
+	return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Stops streaming and cancels the transfers in progress.
+ * \param stream Pointer to the stream instance.
+ */
+void cdcd_serial_stream_stop(struct _cdcd_serial_stream *stream)
+{
+	stream->running = false;
+	usbd_hal_reset_endpoints((1 << stream->ep_in) | (1 << stream->ep_out),
+			USBD_STATUS_CANCELED, true);
+}
+
+/**
+ * Tells if the stream is running (started and no transfer error since).
+ * \param stream Pointer to the stream instance.
+ */
+bool cdcd_serial_stream_is_running(const struct _cdcd_serial_stream *stream)
+{
+	return stream->running;
+}
+
+/**
+ * Background processing, to be called periodically by the application:
+ * sends the buffer being filled once the flush timeout has expired and
+ * re-arms the OUT endpoint if the receive ring was full.
+ * \param stream Pointer to the stream instance.
+ */
+void cdcd_serial_stream_poll(struct _cdcd_serial_stream *stream)
+{
+	if (!stream->running)
+		return;
+
+	if (stream->tx_fill && timer_timeout_reached(&stream->tx_timeout))
+		_tx_submit(stream);
+
+	_rx_restart(stream);
+}
+
+/**
+ * Gets the received data available in place, without copy.
+ * \param stream Pointer to the stream instance.
+ * \param data Set to the first byte available.
+ * \return Number of contiguous bytes available at *data (0 if none).
+ */
+uint32_t cdcd_serial_stream_rx_peek(struct _cdcd_serial_stream *stream,
+		const uint8_t **data)
+{
+	struct _usbd_transfer_buffer *xfer = _rx_current(stream);
+
+	if (!xfer)
+		return 0;
+
+	*data = xfer->buffer + stream->rx_offset;
+	return xfer->transferred - stream->rx_offset;
+}
+
+/**
+ * Releases received data obtained with cdcd_serial_stream_rx_peek().
+ * \param stream Pointer to the stream instance.
+ * \param size Number of bytes consumed, at most the value returned by the
+ *             last cdcd_serial_stream_rx_peek().
+ */
+void cdcd_serial_stream_rx_release(struct _cdcd_serial_stream *stream,
+		uint32_t size)
+{
+	struct _usbd_transfer_buffer *xfer = _rx_current(stream);
+
+	if (!xfer)
+		return;
+
+	stream->rx_offset += min_u32(size, xfer->transferred - stream->rx_offset);
+	if (stream->rx_offset == xfer->transferred) {
+		stream->rx_offset = 0;
+		stream->rx_tail++;
+	}
+
+	_rx_restart(stream);
+}
+
+/**
+ * Copies received data.
+ * \param stream Pointer to the stream instance.
+ * \param data Destination buffer.
+ * \param size Size of the destination buffer.
+ * \return Number of bytes copied.
+ */
+uint32_t cdcd_serial_stream_read(struct _cdcd_serial_stream *stream,
+		void *data, uint32_t size)
+{
+	uint8_t *dst = (uint8_t *)data;
+	const uint8_t *src;
+	uint32_t count = 0;
+	uint32_t len;
+
+	while (count < size) {
+		len = cdcd_serial_stream_rx_peek(stream, &src);
+		if (!len)
+			break;
+		len = min_u32(len, size - count);
+		memcpy(dst + count, src, len);
+		cdcd_serial_stream_rx_release(stream, len);
+		count += len;
+	}
+
+	return count;
+}
+
+/**
+ * Queues data for transmission. The data is copied into the transmit
+ * buffers, which are sent when full; a partially filled buffer is sent by
+ * cdcd_serial_stream_flush() or after the flush timeout.
+ * \param stream Pointer to the stream instance.
+ * \param data Data to send.
+ * \param size Number of bytes to send.
+ * \return Number of bytes accepted, less than size if all buffers are busy.
+ */
+uint32_t cdcd_serial_stream_write(struct _cdcd_serial_stream *stream,
+		const void *data, uint32_t size)
+{
+	const uint8_t *src = (const uint8_t *)data;
+	struct _usbd_transfer_buffer *xfer;
+	uint32_t count = 0;
+	uint32_t len;
+
+	while (stream->running && count < size) {
+		/* Buffer full, send it if the USB driver accepts it */
+		if (stream->tx_fill == stream->cfg.tx_buffer_size &&
+		    !_tx_submit(stream))
+			break;
+
+		/* All buffers in use */
+		if (stream->tx_submitted - stream->tx_completed >=
+		    stream->cfg.tx_buffers)
+			break;
+
+		xfer = &stream->tx_xfer[stream->tx_submitted % stream->cfg.tx_buffers];
+		if (stream->tx_fill == 0)
+			timer_start_timeout(&stream->tx_timeout,
+					stream->cfg.tx_timeout);
+
+		len = min_u32(size - count,
+				stream->cfg.tx_buffer_size - stream->tx_fill);
+		memcpy(xfer->buffer + stream->tx_fill, src + count, len);
+		stream->tx_fill += len;
+		count += len;
+	}
+
+	/* Send a full buffer right away */
+	if (stream->tx_fill == stream->cfg.tx_buffer_size)
+		_tx_submit(stream);
+
+	return count;
+}
+
+/**
+ * Sends the buffer being filled without waiting for the flush timeout.
+ * \param stream Pointer to the stream instance.
+ * \return true if nothing is left to submit.
+ */
+bool cdcd_serial_stream_flush(struct _cdcd_serial_stream *stream)
+{
+	if (stream->tx_fill)
+		_tx_submit(stream);
+	return stream->tx_fill == 0;
+}
+
+/**
+ * Gets the stream statistics.
+ * \param stream Pointer to the stream instance.
+ * \param stats Filled with the statistics.
+ */
+void cdcd_serial_stream_get_stats(const struct _cdcd_serial_stream *stream,
+		struct _cdcd_serial_stream_stats *stats)
+{
+	*stats = stream->stats;
+}
+
+/**@}*/
@@ -0,0 +1,186 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Streaming layer for the CDC serial port function.
+ *
+ * The bulk OUT endpoint is kept armed on a ring of receive slots that the
+ * DMA fills in place; the application reads from the slots directly
+ * (cdcd_serial_stream_rx_peek/release) or through a copy
+ * (cdcd_serial_stream_read). Small writes are coalesced into transmit
+ * buffers that are sent when full, on cdcd_serial_stream_flush() or when
+ * the flush timeout expires in cdcd_serial_stream_poll().
+ *
+ * The receive ring is lock-free: the USB interrupt only moves the producer
+ * index and the application only moves the consumer index.
+ */
+
+#ifndef CDCD_SERIAL_STREAM_H
+#define CDCD_SERIAL_STREAM_H
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timer.h"
+
+#include "usb/device/cdc/cdcd_serial_port.h"
+#include "usb/device/usbd_hal.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum number of receive slots */
+#define CDCD_SERIAL_STREAM_MAX_RX_SLOTS     8
+
+/** Maximum number of transmit buffers */
+#define CDCD_SERIAL_STREAM_MAX_TX_BUFFERS   4
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** CDC serial stream configuration */
+struct _cdcd_serial_stream_config {
+	/** Receive slots, rx_slots * rx_slot_size bytes (cache aligned) */
+	uint8_t *rx_pool;
+	/** Size of a receive slot, multiple of the bulk max packet size */
+	uint16_t rx_slot_size;
+	/** Number of receive slots (2..CDCD_SERIAL_STREAM_MAX_RX_SLOTS) */
+	uint8_t rx_slots;
+
+	/** Transmit buffers, tx_buffers * tx_buffer_size bytes (cache aligned) */
+	uint8_t *tx_pool;
+	/** Size of a transmit buffer, multiple of the bulk max packet size */
+	uint16_t tx_buffer_size;
+	/** Number of transmit buffers (2..CDCD_SERIAL_STREAM_MAX_TX_BUFFERS) */
+	uint8_t tx_buffers;
+
+	/** Time in ms after which a partially filled buffer is sent */
+	uint32_t tx_timeout;
+};
+
+/** CDC serial stream statistics */
+struct _cdcd_serial_stream_stats {
+	/** Bytes received */
+	uint32_t rx_bytes;
+	/** Times the receive ring was full and the endpoint left unarmed */
+	uint32_t rx_stalls;
+	/** Bytes sent */
+	uint32_t tx_bytes;
+	/** USB transfers sent */
+	uint32_t tx_transfers;
+};
+
+/** CDC serial stream instance */
+struct _cdcd_serial_stream {
+	/** Serial port function the stream runs on */
+	const CDCDSerialPort *port;
+	/** Configuration */
+	struct _cdcd_serial_stream_config cfg;
+	/** Bulk endpoints in use */
+	uint8_t ep_in, ep_out;
+	/** Stream started and no transfer error since */
+	volatile bool running;
+
+	/** Receive slot descriptors */
+	struct _usbd_transfer_buffer rx_xfer[CDCD_SERIAL_STREAM_MAX_RX_SLOTS];
+	/** Slots queued on the endpoint (written by the application when
+	 *  stalled, by the interrupt otherwise) */
+	volatile uint32_t rx_armed;
+	/** Slots received (written by the interrupt) */
+	volatile uint32_t rx_head;
+	/** Slots released by the application */
+	volatile uint32_t rx_tail;
+	/** Bytes consumed in the slot at rx_tail */
+	uint32_t rx_offset;
+	/** No slot queued on the endpoint because the ring was full */
+	volatile bool rx_stalled;
+
+	/** Transmit buffer descriptors */
+	struct _usbd_transfer_buffer tx_xfer[CDCD_SERIAL_STREAM_MAX_TX_BUFFERS];
+	/** Buffers submitted (written by the application) */
+	volatile uint32_t tx_submitted;
+	/** Buffers sent (written by the interrupt) */
+	volatile uint32_t tx_completed;
+	/** Bytes in the buffer being filled */
+	uint32_t tx_fill;
+	/** Flush timeout of the buffer being filled */
+	struct _timeout tx_timeout;
+
+	/** Statistics */
+	struct _cdcd_serial_stream_stats stats;
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint8_t cdcd_serial_stream_initialize(struct _cdcd_serial_stream *stream,
+		const CDCDSerialPort *port,
+		const struct _cdcd_serial_stream_config *cfg);
+
+extern uint8_t cdcd_serial_stream_start(struct _cdcd_serial_stream *stream);
+
+extern void cdcd_serial_stream_stop(struct _cdcd_serial_stream *stream);
+
+extern bool cdcd_serial_stream_is_running(const struct _cdcd_serial_stream *stream);
+
+extern void cdcd_serial_stream_poll(struct _cdcd_serial_stream *stream);
+
+extern uint32_t cdcd_serial_stream_rx_peek(struct _cdcd_serial_stream *stream,
+		const uint8_t **data);
+
+extern void cdcd_serial_stream_rx_release(struct _cdcd_serial_stream *stream,
+		uint32_t size);
+
+extern uint32_t cdcd_serial_stream_read(struct _cdcd_serial_stream *stream,
+		void *data, uint32_t size);
+
+extern uint32_t cdcd_serial_stream_write(struct _cdcd_serial_stream *stream,
+		const void *data, uint32_t size);
+
+extern bool cdcd_serial_stream_flush(struct _cdcd_serial_stream *stream);
+
+extern void cdcd_serial_stream_get_stats(const struct _cdcd_serial_stream *stream,
+		struct _cdcd_serial_stream_stats *stats);
+
+/**@}*/
+
+#endif /* CDCD_SERIAL_STREAM_H */
@@ -110,6 +110,9 @@ extern uint8_t usbd_hal_write_with_header(uint8_t endpoint,
 		const void *header, uint32_t header_length,
 		const void *data, uint32_t data_length);
 
+extern uint8_t usbd_hal_queue_buffers(uint8_t endpoint,
+		struct _usbd_transfer_buffer *buffers, uint8_t count);
+
 extern uint16_t usbd_hal_get_data_size(uint8_t endpoint);
 
 extern uint8_t usbd_hal_read(uint8_t endpoint,
@@ -57,6 +57,11 @@ void uvc_driver_initialize(const USBDDriverDescriptors *descriptors, uint32_t bu
 	uvc_driver.is_frame_xfring = 0;
 	uvc_driver.buf_start_addr = buff_addr;
 	uvc_driver.multi_buffers = multi_buffers;
+	uvc_driver.frm_ready = 0;
+	uvc_driver.frm_taken = 0;
+	uvc_driver.frm_last = UVC_FRAME_NONE;
+	uvc_driver.frm_sending = UVC_FRAME_NONE;
+	uvc_driver.frm_writing = UVC_FRAME_NONE;
 
 	/* Initialize USBD Driver instance */
 	usbd_driver_initialize(descriptors, uvc_driver.alternate_interfaces, sizeof(uvc_driver.alternate_interfaces));
@@ -131,6 +136,10 @@ void uvc_driver_interface_setting_changed_handler(uint8_t interface,
 		uvc_driver.is_video_on = 1;
 		uvc_driver.frm_count = 0;
 		uvc_driver.frm_offset = 0;
+		/* Only stream frames captured from now on */
+		uvc_driver.frm_taken = uvc_driver.frm_ready >> UVC_FRAME_SEQ_SHIFT;
+		uvc_driver.frm_last = UVC_FRAME_NONE;
+		uvc_driver.frm_writing = UVC_FRAME_NONE;
 	} else {
 		uvc_driver.is_video_on = 0;
 		uvc_driver.is_frame_xfring = 0;
@@ -50,8 +50,35 @@
  *         Internal Types
  *-----------------------------------------------------------------------------*/
 
+/** No frame buffer owned by the streaming side */
+#define UVC_FRAME_NONE          0xFF
+
+/** frm_ready layout: capture sequence number and buffer index */
+#define UVC_FRAME_SEQ_SHIFT     8
+#define UVC_FRAME_SEQ_MASK      0x00FFFFFF
+#define UVC_FRAME_BUFFER_MASK   0xFF
+
+/**
+ * \brief Frame hand-off statistics between capture and USB streaming.
+ */
+struct _uvc_stream_stats {
+	uint32_t captured;  /**< frames completed by the capture DMA */
+	uint32_t sent;      /**< frames completely sent to the host */
+	uint32_t dropped;   /**< captured frames replaced before being sent */
+	uint32_t repeated;  /**< frames sent again, no new capture was ready */
+	uint32_t torn;      /**< frames overwritten by capture while sent */
+};
+
 /**
  * \brief USB Video class driver struct.
+ *
+ * Capture DMAs that can fill the ring in any order take their next buffer
+ * from uvc_function_capture_next(): with four buffers or more, capture
+ * never writes the frame being sent; with three, it does not as long as
+ * sending a frame takes less than a frame period. Capture DMAs filling the
+ * ring in a fixed order (uvc_function_update_frame_idx()) overwrite a frame
+ * N - 1 frame periods after its capture completed with N buffers.
+ * Overwritten frames are counted in stats.torn.
  */
 struct _uvc_driver {
 	volatile uint8_t is_video_on;
@@ -62,6 +89,17 @@ struct _uvc_driver {
 	uint32_t stream_frm_index;
 	uint32_t buf_start_addr;
 	uint8_t  multi_buffers;
+	/** Latest complete frame, written by capture only (sequence | index) */
+	volatile uint32_t frm_ready;
+	/** Sequence number of the last frame taken for streaming */
+	uint32_t frm_taken;
+	/** Buffer of the last frame taken for streaming */
+	uint8_t frm_last;
+	/** Buffer currently locked by USB, UVC_FRAME_NONE when idle */
+	volatile uint8_t frm_sending;
+	/** Buffer being written by capture, UVC_FRAME_NONE before the first */
+	uint8_t frm_writing;
+	struct _uvc_stream_stats stats;
 	/** Array for storing the current setting of each interface */
 	uint8_t alternate_interfaces[4];
 };
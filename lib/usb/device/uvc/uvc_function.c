@@ -32,6 +32,7 @@
  *------------------------------------------------------------------------------*/
 #include "chip.h"
 
+#include "irqflags.h"
 #include "trace.h"
 #include "mm/cache.h"
 #include "usb/common/uvc/usb_video.h"
@@ -40,7 +41,6 @@
 #include "usb/device/usbd.h"
 #include "usb/device/usbd_hal.h"
 #include "usb/device/uvc/uvc_function.h"
-#include "timer.h"
 #include <string.h>
 
 /** Probe & Commit Controls */
@@ -84,8 +84,6 @@ CACHE_ALIGNED static uint8_t stream_header[32];
 
 static struct _uvc_driver *uvc_driver;
 
-static volatile uint32_t frame_buffer_addr;
-
 static uint32_t uvc_frame_count = 0;
 /*-----------------------------------------------------------------------------
  *      Exported functions
@@ -280,22 +278,75 @@ uint32_t uvc_get_frame_count(void)
 	return uvc_frame_count;
 }
 
+/**
+ * Pick the frame buffer to stream next. Called at the start of each frame
+ * from the transfer callback. The latest complete capture is taken when
+ * there is one; otherwise the previous buffer is sent again so that the
+ * isochronous pipe keeps running. Returns UVC_FRAME_NONE until a frame is
+ * captured after streaming started.
+ */
+static uint8_t uvc_function_take_frame(void)
+{
+	uint32_t ready, seq;
+	uint8_t buffer;
+
+	/* Capture picks its next buffer from frm_ready and frm_sending */
+	arch_irq_disable();
+	ready = uvc_driver->frm_ready;
+	seq = ready >> UVC_FRAME_SEQ_SHIFT;
+	if (seq == uvc_driver->frm_taken) {
+		buffer = uvc_driver->frm_last;
+		if (buffer != UVC_FRAME_NONE)
+			uvc_driver->stats.repeated++;
+	} else {
+		buffer = ready & UVC_FRAME_BUFFER_MASK;
+		/* Frames completed after the previous take but never sent */
+		uvc_driver->stats.dropped += (seq - uvc_driver->frm_taken - 1) &
+				UVC_FRAME_SEQ_MASK;
+		uvc_driver->frm_taken = seq;
+		uvc_driver->frm_last = buffer;
+	}
+	uvc_driver->frm_sending = buffer;
+	arch_irq_enable();
+	return buffer;
+}
+
 /**
  * Callback that invoked when USB packet is sent.
+ * The payload is sent straight from the capture buffer, the UVC header
+ * being prepended by the HAL DMA descriptors.
  */
 void uvc_function_payload_sent(void *arg, uint8_t state,
 		uint32_t transferred, uint32_t remaining)
 {
 	uint32_t dma_transfer_size;
 	uint32_t frame_size = FRAME_BUFFER_SIZEC(frm_width, frm_height);
-	uint8_t *uncompressed_stream = (uint8_t*)(uvc_driver->buf_start_addr +
-									frame_buffer_addr * FRAME_BUFFER_SIZEC(frm_width, frm_height));
+	uint8_t *uncompressed_stream;
 	USBVideoPayloadHeader *header = (USBVideoPayloadHeader*)stream_header;
 	uint32_t max_pkt_size = usbd_is_high_speed() ? frm_max_pkt_size : FRAME_PACKET_SIZE_FS;
-	if (remaining){
 
+	if (remaining || state == USBD_STATUS_CANCELED)
+		return;
+	if (!uvc_driver->is_video_on) {
+		uvc_driver->frm_sending = UVC_FRAME_NONE;
 		return;
 	}
+
+	if (uvc_driver->frm_offset == 0 &&
+	    uvc_function_take_frame() == UVC_FRAME_NONE) {
+		/* No frame captured yet, keep the pipe running with
+		 * header-only payloads */
+		header->bHeaderLength = FRAME_PAYLOAD_HDR_SIZE;
+		header->bmHeaderInfo.B = 0;
+		header->bmHeaderInfo.bm.FID = (uvc_driver->frm_count & 1);
+		header->bmHeaderInfo.bm.EOH = 1;
+		usbd_hal_write(VIDCAMD_IsoInEndpointNum, header,
+				header->bHeaderLength);
+		return;
+	}
+	uncompressed_stream = (uint8_t*)(uvc_driver->buf_start_addr +
+			uvc_driver->frm_sending * frame_size);
+
 	dma_transfer_size = frame_size - uvc_driver->frm_offset;
 	header->bHeaderLength = FRAME_PAYLOAD_HDR_SIZE;
 	header->bmHeaderInfo.B = 0;
@@ -309,16 +360,13 @@ void uvc_function_payload_sent(void *arg, uint8_t state,
 		uvc_driver->frm_offset = 0;
 		header->bmHeaderInfo.bm.EoF = 1;
 		uvc_frame_count++;
-		frame_buffer_addr = uvc_driver ->stream_frm_index;
-		frame_buffer_addr = (frame_buffer_addr == 0) ?
-							(uvc_driver->multi_buffers - 1): (frame_buffer_addr -1);
-		if (uvc_driver->is_frame_xfring)
-			uvc_driver->is_frame_xfring = 0;
+		uvc_driver->stats.sent++;
+		uvc_driver->is_frame_xfring = 0;
 	} else {
 		header->bmHeaderInfo.bm.EoF = 0;
+		uvc_driver->is_frame_xfring = 1;
 	}
 	header->bmHeaderInfo.bm.EOH =  1;
-	usleep(500);
 	usbd_hal_write_with_header(VIDCAMD_IsoInEndpointNum, header,
 		header->bHeaderLength, uncompressed_stream, dma_transfer_size);
 }
@@ -339,9 +387,85 @@ uint8_t uvc_function_get_frame_format(void)
 	return (uint8_t)uvc_driver->frm_format;
 }
 
-void uvc_function_update_frame_idx(uint32_t idx)
+/* Account for the start of a capture into buffer idx, publish the frame
+ * completed in the previous buffer */
+static void uvc_function_capture_started(uint32_t idx)
 {
+	uint8_t done = uvc_driver->frm_writing;
+	uint32_t seq;
+
+	uvc_driver->frm_writing = idx;
 	uvc_driver->stream_frm_index = idx;
+	/* Capture wrapped around onto the frame being streamed */
+	if (uvc_driver->is_frame_xfring && uvc_driver->frm_sending == idx)
+		uvc_driver->stats.torn++;
+	/* First frame period: no complete frame yet */
+	if (done == UVC_FRAME_NONE)
+		return;
+
+	uvc_driver->stats.captured++;
+	seq = ((uvc_driver->frm_ready >> UVC_FRAME_SEQ_SHIFT) + 1) &
+			UVC_FRAME_SEQ_MASK;
+	/* Publish index and sequence in a single store */
+	uvc_driver->frm_ready = (seq << UVC_FRAME_SEQ_SHIFT) | done;
+}
+
+/**
+ * Hand a captured frame over to the streaming side.
+ * To be called from the capture "vertical sync" interrupt with the index of
+ * the buffer the capture DMA has just started to fill: the buffer it filled
+ * before then holds a complete frame and becomes the one to stream.
+ * Buffers are never copied, capture and USB only exchange indexes.
+ * \param idx Index of the buffer now being written by the capture DMA.
+ */
+void uvc_function_update_frame_idx(uint32_t idx)
+{
+	arch_irq_disable();
+	uvc_function_capture_started(idx);
+	arch_irq_enable();
+}
+
+/**
+ * Same as uvc_function_update_frame_idx(), for capture DMAs that can fill
+ * the buffers of the ring in any order. Also returns the buffer to fill
+ * from the next frame start on: never the frame just completed, which USB
+ * takes next, and a buffer USB does not hold when there is one. With three
+ * buffers, this is the buffer USB is sending: USB moves on to the newer
+ * frame once it is sent, which happens before the next frame start as long
+ * as sending a frame takes less than a frame period.
+ * \param idx Index of the buffer now being written by the capture DMA.
+ * \return Index of the buffer to capture the next frame into.
+ */
+uint8_t uvc_function_capture_next(uint32_t idx)
+{
+	uint8_t done, sending, next;
+	uint8_t i;
+
+	arch_irq_disable();
+	done = uvc_driver->frm_writing;
+	sending = uvc_driver->frm_sending;
+	next = (sending != UVC_FRAME_NONE && sending != idx) ? sending :
+		(idx + 1) % uvc_driver->multi_buffers;
+	for (i = 1; i < uvc_driver->multi_buffers; i++) {
+		uint8_t buffer = (idx + i) % uvc_driver->multi_buffers;
+		if (buffer != done && buffer != sending) {
+			next = buffer;
+			break;
+		}
+	}
+	uvc_function_capture_started(idx);
+	arch_irq_enable();
+	return next;
+}
+
+void uvc_function_get_stats(struct _uvc_stream_stats *stats)
+{
+	*stats = uvc_driver->stats;
+}
+
+void uvc_function_reset_stats(void)
+{
+	memset(&uvc_driver->stats, 0, sizeof(uvc_driver->stats));
 }
 
 /**@}*/
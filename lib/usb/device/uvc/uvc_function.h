@@ -61,8 +61,11 @@ extern void uvc_function_set_cur(const USBGenericRequest *request);
 extern uint8_t uvc_function_is_video_on(void);
 extern uint8_t uvc_function_get_frame_format(void);
 extern void uvc_function_update_frame_idx(uint32_t idx);
+extern uint8_t uvc_function_capture_next(uint32_t idx);
 extern void uvc_reset_frame_count(void);
 extern uint32_t uvc_get_frame_count(void);
+extern void uvc_function_get_stats(struct _uvc_stream_stats *stats);
+extern void uvc_function_reset_stats(void);
 /**@}*/
 
 #endif /* UVCDRIVER_H */
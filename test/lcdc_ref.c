@@ -0,0 +1,472 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Reference copy of lcdc_put_image_rotated() and _compute_scaling_factors()
+ * as they were before the image transform was split in a prepare and an
+ * apply step. Only the names changed. Included by test_lcdc_transform.c
+ * after drivers/display/lcdc.c.
+ */
+
+/* Kept verbatim, including its warnings */
+#pragma GCC diagnostic ignored "-Wparentheses"
+
+static void _ref_compute_scaling_factors(const struct _layer_info *layer,
+		uint16_t* xfactor, uint16_t* yfactor)
+{
+	uint16_t xmemsize, ymemsize;
+	uint16_t xsize, ysize;
+#ifdef LCDC_HEOCFG41_XPHIDEF
+	uint16_t xfactor_1st, yfactor_1st;
+#endif
+
+	xmemsize = (layer->reg_win[2] & LCDC_HEOCFG4_XMEMSIZE_Msk) >> LCDC_HEOCFG4_XMEMSIZE_Pos;
+	ymemsize = (layer->reg_win[2] & LCDC_HEOCFG4_YMEMSIZE_Msk) >> LCDC_HEOCFG4_YMEMSIZE_Pos;
+	xsize = (layer->reg_win[1] & LCDC_HEOCFG3_XSIZE_Msk) >> LCDC_HEOCFG3_XSIZE_Pos;
+	ysize = (layer->reg_win[1] & LCDC_HEOCFG3_YSIZE_Msk) >> LCDC_HEOCFG3_YSIZE_Pos;
+
+#ifdef LCDC_HEOCFG41_XPHIDEF
+	/* we assume that XPHIDEF & YPHIDEF are 0 */
+	xfactor_1st = (2048 * xmemsize / xsize) + 1;
+	yfactor_1st = (2048 * ymemsize / ysize) + 1;
+
+	if ((xfactor_1st * xsize / 2048) > xmemsize)
+		*xfactor = xfactor_1st - 1;
+	else
+		*xfactor = xfactor_1st;
+
+	if ((yfactor_1st * ysize / 2048) > ymemsize)
+		*yfactor = yfactor_1st - 1;
+	else
+		*yfactor = yfactor_1st;
+#else
+	*xfactor = 1024 * (xmemsize + 1) / (xsize + 1);
+	*yfactor = 1024 * (ymemsize + 1) / (ysize + 1);
+#endif
+}
+
+static void *_ref_put_image_rotated(uint8_t layer_id,
+			     void *buffer, uint8_t bpp,
+			     uint32_t x, uint32_t y,
+			     int32_t w, int32_t h,
+			     uint32_t img_w, uint32_t img_h, int16_t rotation)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	struct _layer_data *data = layer->data;
+
+	uint8_t bottom_up = (h < 0);
+	uint8_t right_left = (w < 0);
+	uint32_t padding = 0;
+	int32_t src_w, src_h;
+	uint32_t bits_per_row, bytes_per_row;
+	uint32_t bytes_per_pixel = bpp >> 3;
+
+	void *old_buffer = data->buffer;
+
+	if (!layer->reg_cfg)
+		return old_buffer;
+
+	//printf("Show %x @ %d: (%d,%d)+(%d,%d) img %d x %d * %d\n\r", buffer, layer_id, x, y, w, h, img_w, img_h, bpp);
+
+	switch (bpp) {
+	/*  RGB 565 */
+	case 16:
+#ifdef LCDC_HEOCFG1_YUVEN
+		if ((layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
+			layer->reg_cfg[1] = layer->reg_cfg[1] & (~LCDC_HEOCFG1_YUVMODE_Msk) | LCDC_HEOCFG1_YUVMODE_16BPP_YCBCR_MODE0;
+		} else
+#endif
+		{
+			layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_16BPP_RGB_565;
+		}
+		break;
+	/*  RGB  888 packed */
+	case 24:
+		layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_24BPP_RGB_888_PACKED;
+		break;
+	/* ARGB 8888 */
+	case 32:
+		layer->reg_cfg[1] = LCDC_HEOCFG1_RGBMODE_32BPP_ARGB_8888;
+		break;
+	default:
+		return old_buffer;
+	}
+
+	/* Windows position & size check */
+	if (h < 0)
+		h = -h;
+	if (w < 0)
+		w = -w;
+	if (x + w > lcdc_config.width) {
+		//printf("! w %d -> %d\n\r", w, lcdc_config.width-x);
+		w = lcdc_config.width - x;
+	}
+	if (y + h > lcdc_config.height) {
+		//printf("! h %d -> %d\n\r", h, lcdc_config.height-y);
+		h = lcdc_config.height - y;
+	}
+	if (w == 0)
+		w++;
+	if (h == 0)
+		h++;
+	if (img_w == 0)
+		img_w++;
+	if (img_h == 0)
+		img_h++;
+
+	/* Only 0,(-)90,(-)180,(-)270 accepted */
+	switch (rotation) {
+	case 0:
+	case 90:
+	case 180:
+	case 270:
+		break;
+	case -90:
+	case -180:
+	case -270:
+		rotation += 360;
+		break;
+	default:
+		return NULL;
+	}
+
+	/* Setup display buffer & window */
+	if (buffer)
+		data->buffer = buffer;
+	else
+		buffer = data->buffer;
+
+	/* Set display buffer & mode */
+	bits_per_row = img_w * bpp;
+	bytes_per_row = bits_per_row >> 3;
+	if (bits_per_row & 0x7)
+		bytes_per_row++;
+	if (bytes_per_row & 0x3)
+		padding = 4 - (bytes_per_row & 0x3);
+
+	/* No X mirror supported layer, no Right->Left scan */
+	if (!layer->stride_supported)
+		right_left = 0;
+
+	/* --------- Mirror & then rotate --------- */
+	/* Normal direction: Left,Top -> Right,Down */
+	if ((!right_left && !bottom_up && rotation == 0)
+	    || (right_left && bottom_up && rotation == 180)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0);
+			/* Pointer to Left,Top (x0,y0) */
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* X0 ++ */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(padding);
+			/* Pointer to Left,Top (x0,y0) */
+		}
+	}
+	/* X mirror: Right,Top -> Left,Down */
+	else if ((right_left && !bottom_up && rotation == 0)
+		 || (!right_left && bottom_up && rotation == 180)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if ((layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) == LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel - 4);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 - 2 * bytes_per_pixel - 4);
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row - 4);
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* X1 -- */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * 2 + padding - 2 * bytes_per_pixel);
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_pixel * (img_w - 1));
+		}
+	}
+	/* Y mirror: Left,Down -> Right,Top */
+	else if ((!right_left && bottom_up && rotation == 0)
+		 || (right_left && !bottom_up && rotation == 180)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h - 1));
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* X0 ++ */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+			/* Y1 -- */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * 2 + padding));
+			/* Pointer to Left,Down (x0,y1) */
+			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1));
+		}
+	}
+	/* X,Y mirror: Right,Top -> Left,Down */
+	else if ((right_left && bottom_up && rotation == 0)
+		 || (!right_left && !bottom_up && rotation == 180)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] &= ~LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+				  layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - bytes_per_row * 2);
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h-1));
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* X1 -- */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - 2 * bytes_per_pixel);
+			/* Y1 -- */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_pixel * 2 + padding));
+			/* Pointer to Left,Down (x1,y1) */
+			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1));
+		}
+	}
+	/* Rotate  90: Down,Left -> Top,Right (with w,h swap) */
+	else if ((!right_left && !bottom_up && rotation == 90)
+		 || (right_left && bottom_up && rotation == 270)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h-1));
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row * (img_h - 1));
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* Y -- as pixels in row */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
+			/* X ++ as rows */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE((bytes_per_row + padding) * (img_h - 1));
+			/* Pointer to Bottom,Left */
+			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1));
+		}
+	}
+	/* Rotate 270: Top,Right -> Down,Left (with w,h swap) */
+	else if ((!right_left && !bottom_up && rotation == 270)
+		 || (right_left && bottom_up && rotation == 90)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE((bytes_per_row * (1 - img_h) - 4 - 4));
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row - 4);
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* Y ++ as pixels in row */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
+			/* X -- as rows */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel - (bytes_per_row + padding) * (img_h - 1));
+			/* Pointer to top right */
+			buffer = (void *)((uint32_t) buffer + bytes_per_pixel * (img_w - 1));
+		}
+	}
+	/* Mirror X then Rotate 90: Down,Right -> Top,Left */
+	else if ((right_left && !bottom_up && rotation == 90)
+		 || (!right_left && bottom_up && rotation == 270)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - bytes_per_row - 4);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(bytes_per_row * (img_h - 1) - 2 * bytes_per_pixel - 4);
+			/* Pointer to Right,Top (x1,y0) */
+			buffer = (void *)((uint32_t) buffer + bytes_per_row * img_h - 4);
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* Y -- as pixels in row */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(0 - (bytes_per_pixel + bytes_per_row + padding));
+			/* X -- as rows */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - 2 * bytes_per_pixel + (bytes_per_row + padding) * (img_h - 1));
+			/* Pointer to down right (x1,y1) */
+			buffer = (void *)((uint32_t) buffer + (bytes_per_row + padding) * (img_h - 1) + (bytes_per_pixel) * (img_w - 1));
+		}
+	}
+	/* Mirror Y then Rotate 90: Top,Left -> Down,Right */
+	else if ((!right_left && bottom_up && rotation == 90)
+		 || (right_left && !bottom_up && rotation == 270)) {
+#ifdef LCDC_HEOCFG1_YUVEN
+		if(layer->reg_cfg[1] & LCDC_HEOCFG1_YUVEN) {
+			/* No rotation optimization */
+			layer->reg_cfg[0] = LCDC_HEOCFG0_BLEN(0x2) | LCDC_HEOCFG0_ROTDIS;
+			layer->reg_cfg[1] |= LCDC_HEOCFG1_YUV422ROT;
+			/* X0 ++ */
+			if (layer->stride_supported)
+					layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row - 4);
+			/* Y0 ++ */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row * (img_h - 1)));
+			/* Pointer to Right,Top (x1,y0) */
+		} else
+#endif
+		{
+			/* No rotation optimization */
+			layer->reg_cfg[0] |= LCDC_HEOCFG0_ROTDIS;
+			/* Y ++ as pixels in row */
+			if (layer->stride_supported)
+				layer->reg_stride[1] = LCDC_HEOCFG6_PSTRIDE(bytes_per_row + padding - bytes_per_pixel);
+			/* X ++ as rows */
+			layer->reg_stride[0] = LCDC_HEOCFG5_XSTRIDE(0 - (bytes_per_row + padding) * (img_h - 1));
+			/* Pointer to top left (x0,y0) */
+		}
+	}
+
+	/** DMA is running, just add new descriptor to queue */
+	if (layer->reg_blender[0] & LCDC_HEOCFG12_DMA) {
+		data->dma_desc->addr = (uint32_t)buffer;
+		data->dma_desc->ctrl = LCDC_HEOCTRL_DFETCH;
+		data->dma_desc->next = (uint32_t)data->dma_desc;
+		cache_clean_region(data->dma_desc, sizeof(*(data->dma_desc)));
+		layer->reg_dma_head[0] = (uint32_t)data->dma_desc;
+		layer->reg_enable[0] = LCDC_HEOCHER_A2QEN;
+	} else {
+		/* 2. Write the channel descriptor (DSCR) structure in the system memory by
+		   writing DSCR.CHXADDR Frame base address, DSCR.CHXCTRL channel control
+		   and DSCR.CHXNEXT next descriptor location.
+		   3. If more than one descriptor is expected, the DFETCH field of
+		   DSCR.CHXCTRL is set to one to enable the descriptor fetch operation.
+		   4. Write the DSCR.CHXNEXT register with the address location of the
+		   descriptor structure and set DFETCH field of the DSCR.CHXCTRL register
+		   to one. */
+		_set_dma_desc(buffer, data->dma_desc, layer->reg_dma_head);
+	}
+
+	/* Set window & position */
+	if (layer->reg_win) {
+		layer->reg_win[0] = LCDC_HEOCFG2_XPOS(x) | LCDC_HEOCFG2_YPOS(y);
+		layer->reg_win[1] = LCDC_HEOCFG3_XSIZE(w - 1) | LCDC_HEOCFG3_YSIZE(h - 1);
+	}
+
+	/* Scaling setup */
+	if (layer->reg_win && layer->reg_scale) {
+		/* Image size only used in scaling */
+		/* Scaling target */
+		if (rotation == 90 || rotation == 270) {
+			src_w = img_h;
+			src_h = img_w;
+		} else {
+			src_w = img_w;
+			src_h = img_h;
+		}
+		layer->reg_win[2] = LCDC_HEOCFG4_XMEMSIZE(src_w - 1)
+			| LCDC_HEOCFG4_YMEMSIZE(src_h - 1);
+		/* Scaled */
+		if (w != src_w || h != src_h) {
+			uint16_t scale_w, scale_h;
+			_ref_compute_scaling_factors(layer, &scale_w, &scale_h);
+			layer->reg_scale[0] = LCDC_HEOCFG13_YFACTOR(scale_h)
+				| LCDC_HEOCFG13_XFACTOR(scale_w)
+				| LCDC_HEOCFG13_SCALEN;
+		}
+		/* Disable scaling */
+		else {
+			layer->reg_scale[0] = 0;
+		}
+	}
+	/* Enable DMA */
+	if (buffer) {
+		layer->reg_blender[0] |= LCDC_HEOCFG12_DMA | LCDC_HEOCFG12_OVR;
+	}
+	/* Enable & Update */
+	/* 5. Enable the relevant channel by writing one to the CHEN field of the
+	   CHXCHER register. */
+	layer->reg_enable[0] = LCDC_HEOCHER_UPDATEEN | LCDC_HEOCHER_CHEN;
+
+	/* 6. An interrupt may be raised if unmasked when the descriptor has been
+	   loaded.  */
+
+	return old_buffer;
+}
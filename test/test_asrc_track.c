@@ -0,0 +1,281 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host test: asrc_track() must lock the conversion ratio onto drifting
+ * clocks and keep the buffer level stable, and asrc_process() must keep a
+ * clean tone while doing so.
+ *
+ * A USB-like source delivers 48 stereo frames of a 1 kHz, -6 dBFS tone
+ * every millisecond of its clock. The converter output goes to a FIFO
+ * read by a sink running at 48 kHz on another clock, whose position is
+ * known to the frame as given by audio_ring_get_position(). asrc_track()
+ * is called once per packet with the FIFO level minus the target.
+ *
+ * For each sink drift, the test checks:
+ * - the FIFO never underruns nor overflows,
+ * - after SETTLE_TIME, the level error stays within LOCK_RANGE frames and
+ *   its peak does not grow from one half of the remaining time to the
+ *   next (the loop does not oscillate),
+ * - with a constant drift, the ratio correction matches it within
+ *   PPM_TOLERANCE and the THD+N of the tone over the last frames is below
+ *   MAX_THD_N.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+
+#include "libaudio/asrc.c"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define RATE 48000
+#define CHANNELS 2
+
+/** Source packet: 1 ms */
+#define PACKET_FRAMES (RATE / 1000)
+
+/** FIFO target level and size, in frames */
+#define TARGET_LEVEL (4 * PACKET_FRAMES)
+#define FIFO_FRAMES (8 * PACKET_FRAMES)
+
+/** Simulated time, in seconds */
+#define DURATION 40
+#define SETTLE_TIME 10
+
+#define LOCK_RANGE 4
+#define PPM_TOLERANCE 3
+#define MAX_THD_N -80.0
+
+#define TONE_FREQ 1000.0
+#define TONE_AMPLITUDE 0.5
+
+/** Frames used for the THD+N measurement */
+#define FIT_FRAMES 16384
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Every output frame, first channel only */
+static int16_t output[(DURATION + 1) * RATE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/** Residual power over signal power of a least-squares sine fit at f */
+static double _fit(const int16_t *x, uint32_t len, double f, double *signal)
+{
+	double cc = 0.0, ss = 0.0, cs = 0.0, vc = 0.0, vs = 0.0, vv = 0.0;
+	double det, a, b, residual;
+	uint32_t n;
+
+	for (n = 0; n < len; n++) {
+		double c = cos(2 * M_PI * f * n / RATE);
+		double s = sin(2 * M_PI * f * n / RATE);
+		cc += c * c;
+		ss += s * s;
+		cs += c * s;
+		vc += x[n] * c;
+		vs += x[n] * s;
+		vv += (double)x[n] * x[n];
+	}
+	det = cc * ss - cs * cs;
+	a = (vc * ss - vs * cs) / det;
+	b = (vs * cc - vc * cs) / det;
+	residual = vv - a * vc - b * vs;
+	*signal = vv - residual;
+	return residual;
+}
+
+/** THD+N in dB of a tone close to f */
+static double _thd_n(const int16_t *x, uint32_t len, double f)
+{
+	double step = 0.05, signal, best = _fit(x, len, f, &signal);
+	double best_signal = signal;
+
+	/* Refine the frequency, it depends on the ratio the loop settled on */
+	while (step > 1e-6) {
+		double lo = _fit(x, len, f - step, &signal);
+		double lo_signal = signal;
+		double hi = _fit(x, len, f + step, &signal);
+		if (lo < best && lo <= hi) {
+			best = lo;
+			best_signal = lo_signal;
+			f -= step;
+		} else if (hi < best) {
+			best = hi;
+			best_signal = signal;
+			f += step;
+		} else {
+			step /= 2;
+		}
+	}
+	return 10 * log10(best / best_signal);
+}
+
+/**
+ * Run the source and sink for DURATION seconds of sink time.
+ * \param ppm        Sink clock drift at start, relative to the source
+ * \param ppm_slope  Drift variation, ppm per second
+ */
+static bool _run(double ppm, double ppm_slope)
+{
+	struct _asrc asrc;
+	int16_t packet[PACKET_FRAMES * CHANNELS];
+	int16_t frames[2 * PACKET_FRAMES * CHANNELS];
+	uint64_t produced = TARGET_LEVEL, played = 0;
+	uint32_t tone = 0, packets = 0, i;
+	int32_t peak[2] = { 0, 0 }, worst;
+	double sink_time = 0.0, sink_pos = 0.0;
+	bool ok = true;
+
+	asrc_init(&asrc, CHANNELS, RATE, RATE);
+
+	/* The FIFO starts with TARGET_LEVEL frames of silence */
+	memset(output, 0, TARGET_LEVEL * sizeof(output[0]));
+
+	while (sink_time < DURATION) {
+		double drift = (ppm + ppm_slope * sink_time) * 1e-6;
+		uint32_t in_frames = PACKET_FRAMES, count;
+		int32_t error;
+
+		/* Sink progress during one source millisecond */
+		sink_pos += RATE / 1000.0 * (1.0 + drift);
+		sink_time += (1.0 + drift) / 1000.0;
+		played = (uint64_t)sink_pos;
+
+		if (produced < played || produced - played > FIFO_FRAMES) {
+			printf("  %+.0f ppm %+.0f ppm/s: FIFO %s at %.3f s\n",
+					ppm, ppm_slope, produced < played ?
+					"underrun" : "overflow", sink_time);
+			return false;
+		}
+
+		error = (int32_t)(produced - played) - TARGET_LEVEL;
+		if (packets > 0)
+			asrc_track(&asrc, error);
+		if (sink_time > SETTLE_TIME) {
+			uint32_t half = sink_time > (DURATION + SETTLE_TIME) / 2;
+			if (abs(error) > peak[half])
+				peak[half] = abs(error);
+		}
+
+		for (i = 0; i < PACKET_FRAMES; i++, tone++) {
+			double v = TONE_AMPLITUDE * sin(2 * M_PI * TONE_FREQ *
+					tone / RATE);
+			packet[CHANNELS * i] = (int16_t)lrint(v * INT16_MAX);
+			packet[CHANNELS * i + 1] = packet[CHANNELS * i];
+		}
+		count = asrc_process(&asrc, packet, &in_frames, frames,
+				2 * PACKET_FRAMES);
+		if (in_frames != PACKET_FRAMES) {
+			printf("  %+.0f ppm %+.0f ppm/s: %u frames not consumed\n",
+					ppm, ppm_slope,
+					PACKET_FRAMES - in_frames);
+			return false;
+		}
+		for (i = 0; i < count && produced + i < ARRAY_SIZE(output); i++)
+			output[produced + i] = frames[CHANNELS * i];
+		produced += count;
+		packets++;
+	}
+
+	worst = peak[0] > peak[1] ? peak[0] : peak[1];
+	if (worst > LOCK_RANGE) {
+		printf("  %+.0f ppm %+.0f ppm/s: level error up to %d frames\n",
+				ppm, ppm_slope, (int)worst);
+		ok = false;
+	}
+	if (peak[1] > peak[0] + 1) {
+		printf("  %+.0f ppm %+.0f ppm/s: level error grows, %d then %d\n",
+				ppm, ppm_slope, (int)peak[0], (int)peak[1]);
+		ok = false;
+	}
+
+	if (ppm_slope == 0.0) {
+		int32_t correction = asrc_get_correction_ppm(&asrc);
+		/* The sink consumes 1 + drift frames per source frame */
+		double expected = -ppm / (1.0 + ppm * 1e-6);
+		double thd_n;
+
+		if (fabs(correction - expected) > PPM_TOLERANCE) {
+			printf("  %+.0f ppm: correction %d ppm\n", ppm,
+					(int)correction);
+			ok = false;
+		}
+		thd_n = _thd_n(&output[produced - FIT_FRAMES - PACKET_FRAMES],
+				FIT_FRAMES, TONE_FREQ / (1.0 + ppm * 1e-6));
+		if (thd_n > MAX_THD_N) {
+			printf("  %+.0f ppm: THD+N %.1f dB\n", ppm, thd_n);
+			ok = false;
+		}
+		printf("  %+5.0f ppm: correction %+5d ppm, level error %2d "
+				"frames, THD+N %.1f dB\n", ppm, (int)correction,
+				(int)worst, thd_n);
+	} else {
+		printf("  %+5.0f ppm %+.0f ppm/s: level error %2d frames\n",
+				ppm, ppm_slope, (int)worst);
+	}
+	return ok;
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	/* Constant drifts, then drifts ramping through zero */
+	static const double drifts[][2] = {
+		{ 0, 0 }, { 100, 0 }, { -100, 0 }, { 500, 0 }, { -500, 0 },
+		{ 1500, 0 }, { -1500, 0 }, { -400, 20 }, { 400, -20 },
+	};
+	uint32_t i, errors = 0;
+
+	for (i = 0; i < ARRAY_SIZE(drifts); i++)
+		if (!_run(drifts[i][0], drifts[i][1]))
+			errors++;
+
+	printf("asrc_track: %u cases, %u failed\n",
+			(unsigned)ARRAY_SIZE(drifts), errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host test: the register state written by lcdc_put_image_rotated() and by
+ * lcdc_prepare_image_transform() + lcdc_apply_image_transform() must match
+ * the one written by the reference implementation in lcdc_ref.c, for every
+ * layer, bpp, rotation, mirroring (sign of w/h), YUV mode, DMA state and
+ * NULL buffer combination. The LCDC registers are a fake block in memory.
+ * For an unsupported bpp or rotation, no register is written any more and
+ * NULL is returned.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "chip.h"
+
+#undef LCDC
+static Lcdc fake_lcdc;
+#define LCDC (&fake_lcdc)
+
+#include "display/lcdc.c"
+#include "lcdc_ref.c"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define PREV_BUFFER ((void *)0x30000000)
+#define NEW_BUFFER  ((void *)0x20000000)
+
+/** Everything the image functions may write */
+struct _state {
+	uint32_t regs[sizeof(Lcdc) / 4];
+	struct _lcdc_dma_desc desc[3];
+	void *buffer[3];
+	void *ret;
+};
+
+/*----------------------------------------------------------------------------
+ *        Stubs
+ *----------------------------------------------------------------------------*/
+
+void cache_clean_region(const void *start, uint32_t length) {}
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _reset(bool yuv, bool running)
+{
+	memset((void *)&fake_lcdc, 0, sizeof(fake_lcdc));
+	memset(&base_dma_desc, 0, sizeof(base_dma_desc));
+	memset(&ovr1_dma_desc, 0, sizeof(ovr1_dma_desc));
+	memset(&heo_dma_desc, 0, sizeof(heo_dma_desc));
+	/* Non-zero bits the functions must keep */
+	fake_lcdc.LCDC_HEOCFG0 = LCDC_HEOCFG0_BLEN(0x1) | LCDC_HEOCFG0_DLBO;
+	fake_lcdc.LCDC_OVR1CFG0 = LCDC_OVR1CFG0_BLEN(0x1) | LCDC_OVR1CFG0_DLBO;
+	if (yuv)
+		fake_lcdc.LCDC_HEOCFG1 = LCDC_HEOCFG1_YUVEN
+			| LCDC_HEOCFG1_YUVMODE_12BPP_YCBCR_PLANAR;
+	if (running) {
+		fake_lcdc.LCDC_BASECFG4 = LCDC_BASECFG4_DMA;
+		fake_lcdc.LCDC_OVR1CFG9 = LCDC_OVR1CFG9_DMA;
+		fake_lcdc.LCDC_HEOCFG12 = LCDC_HEOCFG12_DMA;
+	}
+	lcdc_base.buffer = lcdc_ovr1.buffer = lcdc_heo.buffer = PREV_BUFFER;
+}
+
+static void _save(struct _state *state, void *ret)
+{
+	memset(state, 0, sizeof(*state));
+	memcpy(state->regs, (const void *)&fake_lcdc, sizeof(state->regs));
+	state->desc[0] = base_dma_desc;
+	state->desc[1] = ovr1_dma_desc;
+	state->desc[2] = heo_dma_desc;
+	state->buffer[0] = lcdc_base.buffer;
+	state->buffer[1] = lcdc_ovr1.buffer;
+	state->buffer[2] = lcdc_heo.buffer;
+	state->ret = ret;
+}
+
+static bool _compare(const char *name, const struct _state *ref,
+		const struct _state *state)
+{
+	const uint32_t *r = ref->regs;
+	const uint32_t *s = state->regs;
+	bool ok = true;
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(ref->regs); i++) {
+		if (r[i] != s[i]) {
+			printf("  %s: register 0x%03x is 0x%08x, expected 0x%08x\n",
+					name, (unsigned)(i * 4), (unsigned)s[i],
+					(unsigned)r[i]);
+			ok = false;
+		}
+	}
+	if (memcmp(ref->desc, state->desc, sizeof(ref->desc))) {
+		printf("  %s: DMA descriptors differ\n", name);
+		ok = false;
+	}
+	if (memcmp(ref->buffer, state->buffer, sizeof(ref->buffer))) {
+		printf("  %s: layer buffers differ\n", name);
+		ok = false;
+	}
+	if (state->ret != ref->ret) {
+		printf("  %s: returned %p, expected %p\n", name, state->ret,
+				ref->ret);
+		ok = false;
+	}
+	return ok;
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	static const uint8_t layers[] = { LCDC_BASE, LCDC_OVR1, LCDC_HEO };
+	static const uint8_t bpps[] = { 16, 24, 32, 8 };
+	static const int16_t rotations[] = { 0, 90, 180, 270, -90, -180, -270, 45 };
+	/* w, h, img_w, img_h; negative w/h mirror the image */
+	static const int32_t sizes[][4] = {
+		{ 100, 50, 100, 50 }, { -100, 50, 100, 50 },
+		{ 100, -50, 100, 50 }, { -100, -50, 100, 50 },
+		{ 50, 100, 100, 50 }, { -50, -100, 100, 50 },
+		{ 200, 120, 37, 21 }, { -33, -77, 101, 59 },
+		{ 641, 11, 3, 700 }, { 800, 480, 800, 480 },
+	};
+	uint32_t li, bi, ri, si, yuv, running, keep, count = 0, errors = 0;
+
+	lcdc_config.width = 800;
+	lcdc_config.height = 480;
+	lcdc_base.dma_desc = &base_dma_desc;
+	lcdc_ovr1.dma_desc = &ovr1_dma_desc;
+	lcdc_heo.dma_desc = &heo_dma_desc;
+
+	for (li = 0; li < ARRAY_SIZE(layers); li++)
+	for (bi = 0; bi < ARRAY_SIZE(bpps); bi++)
+	for (ri = 0; ri < ARRAY_SIZE(rotations); ri++)
+	for (si = 0; si < ARRAY_SIZE(sizes); si++)
+	for (yuv = 0; yuv < 2; yuv++)
+	for (running = 0; running < 2; running++)
+	for (keep = 0; keep < 2; keep++) {
+		const int32_t *sz = sizes[si];
+		void *buffer = keep ? NULL : NEW_BUFFER;
+		struct _lcdc_image_transform transform;
+		struct _state ref, state;
+		bool ok;
+		void *ret;
+
+		_reset(yuv, running);
+		ret = _ref_put_image_rotated(layers[li], buffer, bpps[bi], 10, 20,
+				sz[0], sz[1], sz[2], sz[3], rotations[ri]);
+		_save(&ref, ret);
+		if (bpps[bi] == 8 || rotations[ri] == 45) {
+			/* The reference wrote the mode register before
+			 * giving up, now nothing is written and NULL is
+			 * returned */
+			_reset(yuv, running);
+			_save(&ref, NULL);
+		}
+
+		_reset(yuv, running);
+		ret = lcdc_put_image_rotated(layers[li], buffer, bpps[bi], 10, 20,
+				sz[0], sz[1], sz[2], sz[3], rotations[ri]);
+		_save(&state, ret);
+		ok = _compare("put_image_rotated", &ref, &state);
+
+		_reset(yuv, running);
+		if (lcdc_prepare_image_transform(&transform, layers[li],
+				bpps[bi], 10, 20, sz[0], sz[1], sz[2], sz[3],
+				rotations[ri]))
+			ret = lcdc_apply_image_transform(&transform, buffer);
+		else
+			ret = NULL;
+		_save(&state, ret);
+		ok &= _compare("prepare+apply", &ref, &state);
+
+		if (!ok) {
+			printf("FAIL layer %u bpp %u rotation %d size %d,%d,%u,%u "
+					"yuv %u running %u keep %u\n",
+					layers[li], bpps[bi], rotations[ri],
+					(int)sz[0], (int)sz[1], (unsigned)sz[2],
+					(unsigned)sz[3], yuv, running, keep);
+			errors++;
+		}
+		count++;
+	}
+
+	printf("lcdc_transform: %u cases, %u failed\n", count, errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,553 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host test: the NAND FTL of media_nand.c on a simulated NAND flash with
+ * bit errors and power cuts.
+ *
+ * The simulated flash replaces the raw, ECC and skip-block drivers. Pages
+ * keep their programmed content; bit flips are recorded per page, the ECC
+ * corrects up to SIM_ECC_BITS of them and reports an uncorrectable page
+ * beyond. A power cut stops the flash at a chosen program or erase: the
+ * interrupted operation leaves the page or block unprogrammed, garbage or
+ * complete, then the test longjmp()s back, mounts the FTL again and
+ * checks the content.
+ *
+ * Every sector holds a pattern identifying its number and a version. The
+ * test tracks the version written last and the version made persistent by
+ * the last media_flush(): after a power cut each sector must read one of
+ * the versions in between, and after a clean remount the last one.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+
+#include "libstoragemedia/media.c"
+#include "libstoragemedia/media_nand.c"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SIM_BLOCKS 64
+#define SIM_PAGES_PER_BLOCK 32
+#define SIM_PAGE_SIZE 2048
+#define SIM_SPARE_SIZE 64
+
+/** Bit errors corrected by the simulated ECC */
+#define SIM_ECC_BITS 4
+
+/** Bit flips recorded per page */
+#define SIM_MAX_FLIPS 8
+
+/** Spare bytes written by the ECC, so that a page of 0xff is not erased */
+#define SIM_ECC_BYTES 16
+
+/** Spare blocks: the default leaves too few on a small partition and
+ * garbage collection would dominate the run time */
+#define SIM_RESERVED 8
+
+#define SECTOR_SIZE NAND_FTL_SECTOR_SIZE
+
+/** Largest write, in sectors */
+#define MAX_WRITE 16
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _sim_page {
+	bool programmed;
+	bool garbage;       /**< interrupted program: uncorrectable */
+	uint8_t flips;
+	uint16_t flip[SIM_MAX_FLIPS];   /**< flipped bits of the data area */
+	uint8_t data[SIM_PAGE_SIZE];
+};
+
+struct _sim_block {
+	bool bad;
+	struct _sim_page pages[SIM_PAGES_PER_BLOCK];
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _sim_block sim[SIM_BLOCKS];
+
+/** Program and erase operations done */
+static uint32_t sim_ops;
+
+/** Operation interrupted by a power cut, 0 for none */
+static uint32_t sim_cut_at;
+
+static jmp_buf sim_power_cut;
+
+/** Uncorrectable ECC reads */
+static uint32_t sim_ecc_failures;
+
+static struct _nand_flash nand;
+static CACHE_ALIGNED struct _nand_ftl ftl;
+static struct _media media;
+static uint32_t map[SIM_BLOCKS * SIM_PAGES_PER_BLOCK];
+
+static uint32_t num_sectors;
+
+/** Last version written to each sector, 0 for never written */
+static uint32_t *latest;
+
+/** Version made persistent by the last flush */
+static uint32_t *durable;
+
+static uint8_t io_buf[MAX_WRITE * SECTOR_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Simulated NAND flash
+ *----------------------------------------------------------------------------*/
+
+uint16_t nand_model_get_block_size_in_pages(
+		const struct _nand_flash_model *model)
+{
+	return SIM_PAGES_PER_BLOCK;
+}
+
+uint32_t nand_model_get_page_data_size(const struct _nand_flash_model *model)
+{
+	return SIM_PAGE_SIZE;
+}
+
+uint16_t nand_model_get_page_spare_size(const struct _nand_flash_model *model)
+{
+	return SIM_SPARE_SIZE;
+}
+
+static void _sim_erase_page(struct _sim_page *p)
+{
+	p->programmed = false;
+	p->garbage = false;
+	p->flips = 0;
+	memset(p->data, 0xff, sizeof(p->data));
+}
+
+/** Count an operation, cut the power if it is the chosen one */
+static bool _sim_power_cut(void)
+{
+	return ++sim_ops == sim_cut_at;
+}
+
+uint8_t nand_raw_erase_block(const struct _nand_flash *nand, uint16_t block)
+{
+	struct _sim_block *b = &sim[block];
+	uint32_t i;
+
+	if (_sim_power_cut()) {
+		/* not started, partly erased or complete */
+		int outcome = rand() % 3;
+		for (i = 0; i < SIM_PAGES_PER_BLOCK; i++) {
+			if (outcome == 2 || (outcome == 1 && rand() % 2)) {
+				_sim_erase_page(&b->pages[i]);
+			} else if (outcome == 1) {
+				b->pages[i].programmed = true;
+				b->pages[i].garbage = true;
+			}
+		}
+		longjmp(sim_power_cut, 1);
+	}
+
+	for (i = 0; i < SIM_PAGES_PER_BLOCK; i++)
+		_sim_erase_page(&b->pages[i]);
+	return 0;
+}
+
+static void _sim_program(struct _sim_page *p, const void *data)
+{
+	p->programmed = true;
+	p->garbage = false;
+	p->flips = 0;
+	memcpy(p->data, data, SIM_PAGE_SIZE);
+}
+
+uint8_t nand_ecc_write_page(const struct _nand_flash *nand, uint16_t block,
+		uint16_t page, void *data, void *spare)
+{
+	struct _sim_page *p = &sim[block].pages[page];
+
+	if (p->programmed) {
+		printf("  block %u page %u programmed twice\n", block, page);
+		exit(1);
+	}
+
+	if (_sim_power_cut()) {
+		/* not started, garbage or complete */
+		int outcome = rand() % 3;
+		if (outcome == 1) {
+			uint32_t i;
+			for (i = 0; i < SIM_PAGE_SIZE; i++)
+				p->data[i] = rand();
+			p->programmed = true;
+			p->garbage = true;
+		} else if (outcome == 2) {
+			_sim_program(p, data);
+		}
+		longjmp(sim_power_cut, 1);
+	}
+
+	_sim_program(p, data);
+	return 0;
+}
+
+/** Data as read from the array, with its bit flips */
+static void _sim_read_raw(const struct _sim_page *p, uint8_t *data)
+{
+	uint32_t i;
+
+	memcpy(data, p->data, SIM_PAGE_SIZE);
+	for (i = 0; i < p->flips; i++)
+		data[p->flip[i] / 8] ^= 1 << (p->flip[i] % 8);
+}
+
+uint8_t nand_raw_read_page(const struct _nand_flash *nand, uint16_t block,
+		uint16_t page, void *data, void *spare)
+{
+	const struct _sim_page *p = &sim[block].pages[page];
+
+	if (data)
+		_sim_read_raw(p, data);
+	if (spare) {
+		memset(spare, 0xff, SIM_SPARE_SIZE);
+		if (p->programmed)
+			memset(spare, 0, SIM_ECC_BYTES);
+	}
+	return 0;
+}
+
+uint8_t nand_ecc_read_page(const struct _nand_flash *nand, uint16_t block,
+		uint16_t page, void *data, void *spare)
+{
+	const struct _sim_page *p = &sim[block].pages[page];
+
+	if (!p->programmed) {
+		/* erased pages are not corrected */
+		_sim_read_raw(p, data);
+		return 0;
+	}
+	if (p->garbage || p->flips > SIM_ECC_BITS) {
+		sim_ecc_failures++;
+		return NAND_ERROR_CORRUPTEDDATA;
+	}
+	memcpy(data, p->data, SIM_PAGE_SIZE);
+	return 0;
+}
+
+uint8_t nand_skipblock_check_block(const struct _nand_flash *nand,
+		uint16_t block)
+{
+	return sim[block].bad ? BADBLOCK : GOODBLOCK;
+}
+
+uint8_t nand_skipblock_tag_block(struct _nand_flash *nand, uint16_t block,
+		bool bad)
+{
+	sim[block].bad = bad;
+	return 0;
+}
+
+/** Flip a bit of a page, keeping it correctable */
+static void _sim_flip(struct _sim_page *p, uint32_t max_flips)
+{
+	if (p->flips < max_flips)
+		p->flip[p->flips++] = rand() % (SIM_PAGE_SIZE * 8);
+}
+
+/** Flip a bit of a random page: correctable on programmed pages, a
+ * couple of zeros on erased ones */
+static void _sim_disturb(void)
+{
+	struct _sim_page *p = &sim[rand() % SIM_BLOCKS].pages[rand() %
+		SIM_PAGES_PER_BLOCK];
+
+	_sim_flip(p, p->programmed ? SIM_ECC_BITS : 2);
+}
+
+/*----------------------------------------------------------------------------
+ *        Content model
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _pattern(uint32_t sector, uint32_t version, uint32_t i)
+{
+	uint32_t x = sector * 0x9e3779b1u ^ version * 0x85ebca6bu ^ i;
+
+	x ^= x >> 15;
+	x *= 0x2c1b3c6du;
+	x ^= x >> 12;
+	return x;
+}
+
+static void _fill(uint8_t *buf, uint32_t sector, uint32_t version)
+{
+	uint32_t *w = (uint32_t *)buf;
+	uint32_t i;
+
+	w[0] = sector;
+	w[1] = version;
+	for (i = 2; i < SECTOR_SIZE / 4; i++)
+		w[i] = _pattern(sector, version, i);
+}
+
+/** Version held by a sector, or -1 if the content is not a valid pattern */
+static int64_t _version(const uint8_t *buf, uint32_t sector)
+{
+	const uint32_t *w = (const uint32_t *)buf;
+	uint32_t i;
+
+	for (i = 0; i < SECTOR_SIZE / 4 && !w[i]; i++);
+	if (i == SECTOR_SIZE / 4)
+		return 0;
+	if (w[0] != sector || w[1] == 0)
+		return -1;
+	for (i = 2; i < SECTOR_SIZE / 4; i++)
+		if (w[i] != _pattern(sector, w[1], i))
+			return -1;
+	return w[1];
+}
+
+static bool _mount(void)
+{
+	if (media_nand_initialize(&media, &ftl, &nand, 0, SIM_BLOCKS,
+			SIM_RESERVED, map) != MEDIA_STATUS_SUCCESS) {
+		printf("  mount failed\n");
+		return false;
+	}
+	num_sectors = media_get_size(&media);
+	return true;
+}
+
+/**
+ * Check every sector against the model. After a power cut a sector may
+ * hold any version from the durable one to the latest one; the model is
+ * then updated to what was found.
+ */
+static bool _verify(bool power_cut)
+{
+	uint32_t sector, errors = 0;
+
+	for (sector = 0; sector < num_sectors; sector++) {
+		int64_t version;
+
+		if (media_read(&media, sector, io_buf, 1, NULL, NULL)
+				!= MEDIA_STATUS_SUCCESS) {
+			if (!errors++)
+				printf("  sector %u: read error\n", sector);
+			continue;
+		}
+		version = _version(io_buf, sector);
+		if (version < 0 || version < durable[sector] ||
+		    version > latest[sector] ||
+		    (!power_cut && version != latest[sector])) {
+			if (!errors++)
+				printf("  sector %u: version %d, expected %u..%u\n",
+						sector, (int)version,
+						durable[sector], latest[sector]);
+			continue;
+		}
+		latest[sector] = durable[sector] = (uint32_t)version;
+	}
+	if (errors)
+		printf("  %u bad sectors\n", errors);
+	return !errors;
+}
+
+static bool _write(uint32_t sector, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+		_fill(io_buf + i * SECTOR_SIZE, sector + i, ++latest[sector + i]);
+	return media_write(&media, sector, io_buf, count, NULL, NULL)
+		== MEDIA_STATUS_SUCCESS;
+}
+
+static bool _flush(void)
+{
+	if (media_flush(&media) != MEDIA_STATUS_SUCCESS)
+		return false;
+	memcpy(durable, latest, num_sectors * sizeof(*durable));
+	return true;
+}
+
+/**
+ * Random writes, mostly sequential runs inside a hot area, with a flush
+ * every few writes and bit flips in between.
+ */
+static bool _workload(uint32_t writes, uint32_t flips_per_write)
+{
+	uint32_t n, i;
+
+	for (n = 0; n < writes; n++) {
+		uint32_t count = 1 + rand() % MAX_WRITE;
+		uint32_t area = rand() % 4 ? num_sectors / 4 : num_sectors;
+		uint32_t sector = rand() % (area - count);
+
+		if (!_write(sector, count)) {
+			printf("  write failed\n");
+			return false;
+		}
+		if (rand() % 16 == 0 && !_flush()) {
+			printf("  flush failed\n");
+			return false;
+		}
+		for (i = 0; i < flips_per_write; i++)
+			_sim_disturb();
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/** Fill the media twice with correctable bit flips, remount, check */
+static bool _test_bit_errors(void)
+{
+	uint32_t sector;
+
+	for (sector = 0; sector + MAX_WRITE <= num_sectors; sector += MAX_WRITE)
+		if (!_write(sector, MAX_WRITE))
+			return false;
+	if (!_workload(4000, 2) || !_flush())
+		return false;
+	if (!_verify(false))
+		return false;
+	if (ftl.stats.gc_runs == 0) {
+		printf("  no garbage collection\n");
+		return false;
+	}
+	printf("  bit errors: %u GC runs, %u pages relocated\n",
+			(unsigned)ftl.stats.gc_runs,
+			(unsigned)ftl.stats.relocated);
+	return _mount() && _verify(false);
+}
+
+/**
+ * Cut the power at a random program or erase, remount and check, many
+ * times. Mount replays the summaries, and GC runs between cuts since the
+ * media is full.
+ */
+static bool _test_power_cuts(uint32_t cuts)
+{
+	uint32_t n, gc_runs = 0;
+
+	for (n = 0; n < cuts; n++) {
+		sim_ops = 0;
+		sim_cut_at = 1 + rand() % 3000;
+		if (setjmp(sim_power_cut) == 0) {
+			if (!_workload(UINT32_MAX, 1))
+				return false;
+		}
+		sim_cut_at = 0;
+		gc_runs += ftl.stats.gc_runs;
+
+		if (!_mount() || !_verify(true)) {
+			printf("  after power cut %u\n", n);
+			return false;
+		}
+	}
+	printf("  power cuts: %u cuts, %u GC runs\n", cuts, gc_runs);
+	return true;
+}
+
+/**
+ * Make the summary of every closed block uncorrectable: GC must find the
+ * pages of its victims from the map, and nothing may be lost.
+ */
+static bool _test_lost_summaries(void)
+{
+	uint32_t block, corrupted = 0, failures = sim_ecc_failures;
+
+	for (block = 0; block < SIM_BLOCKS; block++) {
+		const struct _nand_ftl_block *b = &ftl.blocks[block];
+		struct _sim_page *p;
+		if (b->state != NAND_FTL_BLOCK_CLOSED)
+			continue;
+		p = &sim[block].pages[b->sum_page];
+		while (p->flips <= SIM_ECC_BITS)
+			_sim_flip(p, SIM_MAX_FLIPS);
+		corrupted++;
+	}
+
+	/* rewrite everything twice, each closed block is collected */
+	if (!_workload(2 * num_sectors / (MAX_WRITE / 2), 0) || !_flush())
+		return false;
+	if (!_verify(false) || !_mount() || !_verify(false))
+		return false;
+	printf("  lost summaries: %u corrupted, %u uncorrectable reads\n",
+			corrupted, sim_ecc_failures - failures);
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t block, errors = 0;
+
+	srand(1);
+	for (block = 0; block < SIM_BLOCKS; block++)
+		memset(sim[block].pages, 0, sizeof(sim[block].pages));
+	sim[5].bad = true;
+
+	if (media_nand_format(&media, &ftl, &nand, 0, SIM_BLOCKS,
+			SIM_RESERVED, map) != MEDIA_STATUS_SUCCESS) {
+		printf("media_nand: format failed\n");
+		return 1;
+	}
+	num_sectors = media_get_size(&media);
+	latest = calloc(num_sectors, sizeof(*latest));
+	durable = calloc(num_sectors, sizeof(*durable));
+
+	if (!_test_bit_errors())
+		errors++;
+	if (!_test_power_cuts(500))
+		errors++;
+	if (!_mount() || !_test_lost_summaries())
+		errors++;
+
+	printf("media_nand: 3 tests, %u failed\n", errors);
+	return errors ? 1 : 0;
+}
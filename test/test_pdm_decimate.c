@@ -0,0 +1,287 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host test: pdm_decimate() must be bit-exact with a direct-form reference
+ * of the same filter chain, for decimation ratios 16, 48, 64, 128 and 256.
+ *
+ * The reference convolves the +1/-1 bitstream with the sinc^4 impulse
+ * response, convolves the result with the CIC impulse response at each
+ * output instant, scales and clips it like pdm_decimate(), and applies the
+ * FIR filter by a plain dot product over the last PDM_FIR_TAPS samples.
+ * Bits before the start of the stream are silence (0x55 bytes), and the
+ * CIC sum is wrapped to 32 bits as the integrators do.
+ *
+ * The bitstreams are a sine modulated by a 2nd order sigma-delta, random
+ * bits and a constant full scale. They are fed in chunks of random length
+ * and written with a stride of 2.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+
+#include "libaudio/pdm.c"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Bitstream rate */
+#define BIT_RATE 3072000
+
+/** Test tone frequency */
+#define TONE_FREQ 1000
+
+/** Bitstream length: 250 ms */
+#define BITS_LEN (BIT_RATE / 8 / 4)
+
+/** Output samples, with room for the stride */
+#define PCM_LEN (BITS_LEN * 8 / PDM_MIN_DECIMATION + 1)
+
+enum {
+	SIGNAL_TONE,
+	SIGNAL_RANDOM,
+	SIGNAL_FULL_SCALE,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t bits[BITS_LEN];
+
+/** Output of the sinc^4 stage, one per byte */
+static int32_t sinc[BITS_LEN];
+
+/** Scaled CIC outputs */
+static int16_t cic[BITS_LEN];
+
+static int16_t ref[PCM_LEN];
+static int16_t pcm[2 * PCM_LEN];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/** Impulse response of 4 cascaded moving sums of length m */
+static uint32_t _moving_sum4(int32_t *h, uint32_t m)
+{
+	int32_t tmp[64];
+	uint32_t len = 4 * (m - 1) + 1;
+	uint32_t i, j, k;
+
+	memset(h, 0, len * sizeof(*h));
+	h[0] = 1;
+	for (k = 0; k < 4; k++) {
+		memcpy(tmp, h, len * sizeof(*h));
+		for (i = 0; i < len; i++) {
+			h[i] = 0;
+			for (j = 0; j < m && j <= i; j++)
+				h[i] += tmp[i - j];
+		}
+	}
+	return len;
+}
+
+/** Bit t of the stream as +1/-1, silence before the stream */
+static int _bit(int32_t t)
+{
+	uint8_t b = t < 0 ? 0x55 : bits[t / 8];
+	uint32_t pos = (uint32_t)(t + 64) % 8;
+
+	return (b >> (7 - pos)) & 1 ? 1 : -1;
+}
+
+static uint32_t _reference(uint32_t decimation)
+{
+	uint32_t m = decimation / 16;
+	int32_t h8[32], hm[64];
+	uint32_t len8, lenm, count = 0, nq = 0;
+	int64_t norm = (1LL << 46) / (4096LL * m * m * m * m);
+	int32_t n;
+	uint32_t k;
+
+	/* sinc^4 decimate-by-8: output n covers bits up to 8 * n + 7 */
+	len8 = _moving_sum4(h8, 8);
+	for (n = 0; n < BITS_LEN; n++) {
+		int32_t s = 0;
+		for (k = 0; k < len8; k++)
+			s += h8[k] * _bit(8 * n + 7 - (int32_t)k);
+		sinc[n] = s;
+	}
+
+	/* CIC decimate-by-m, then decimate-by-2 FIR */
+	lenm = _moving_sum4(hm, m);
+	for (n = m - 1; n < BITS_LEN; n += m) {
+		uint32_t y = 0;
+		int64_t q, acc = 0;
+		for (k = 0; k < lenm && (int32_t)k <= n; k++)
+			y += (uint32_t)(hm[k] * sinc[n - k]);
+		q = ((int32_t)y * norm) >> 32;
+		q = q > INT16_MAX ? INT16_MAX : q < INT16_MIN ? INT16_MIN : q;
+		cic[nq++] = (int16_t)q;
+		if (nq % 2)
+			continue;
+
+		for (k = 0; k < PDM_FIR_TAPS; k++) {
+			int32_t i = nq - PDM_FIR_TAPS + k;
+			acc += _pdm_fir[k] * (i >= 0 ? cic[i] : 0);
+		}
+		acc = (acc + (1 << 13)) >> 14;
+		acc = acc > INT16_MAX ? INT16_MAX : acc < INT16_MIN ? INT16_MIN : acc;
+		ref[count++] = (int16_t)acc;
+	}
+	return count;
+}
+
+static void _generate(int signal, double amplitude)
+{
+	double i1 = 0.0, i2 = 0.0;
+	uint32_t n, k;
+
+	for (n = 0; n < BITS_LEN; n++) {
+		uint8_t b = 0;
+		for (k = 0; k < 8; k++) {
+			int bit;
+			if (signal == SIGNAL_RANDOM) {
+				bit = rand() & 1;
+			} else if (signal == SIGNAL_FULL_SCALE) {
+				bit = 1;
+			} else {
+				double x = amplitude * sin(2 * M_PI * TONE_FREQ *
+						(8 * n + k) / BIT_RATE);
+				double fb = i2 >= 0.0 ? 1.0 : -1.0;
+				i1 += x - fb;
+				i2 += i1 - fb;
+				bit = i2 >= 0.0;
+			}
+			b = (b << 1) | bit;
+		}
+		bits[n] = b;
+	}
+}
+
+/** Amplitude of the tone over whole periods of the second half of the
+ * output, relative to full scale */
+static double _tone_amplitude(uint32_t count, uint32_t decimation)
+{
+	uint32_t period = BIT_RATE / decimation / TONE_FREQ;
+	uint32_t len = count / 2 / period * period;
+	double c = 0.0, s = 0.0;
+	uint32_t n;
+
+	for (n = count - len; n < count; n++) {
+		double phase = 2 * M_PI * (n % period) / period;
+		c += pcm[2 * n] * cos(phase);
+		s += pcm[2 * n] * sin(phase);
+	}
+	return 2.0 * hypot(c, s) / len / 32768;
+}
+
+static bool _check(uint32_t decimation, int signal, const char *name)
+{
+	struct _pdm_decimator pdm;
+	uint32_t count = 0, pos = 0, ref_count, n, mismatches = 0;
+
+	if (pdm_decimator_init(&pdm, decimation) != 0) {
+		printf("  %u: init failed\n", decimation);
+		return false;
+	}
+	while (pos < BITS_LEN) {
+		uint32_t len = 1 + rand() % 97;
+		if (len > BITS_LEN - pos)
+			len = BITS_LEN - pos;
+		count += pdm_decimate(&pdm, bits + pos, len, pcm + 2 * count, 2);
+		pos += len;
+	}
+
+	ref_count = _reference(decimation);
+	if (count != ref_count) {
+		printf("  %u %s: %u samples, expected %u\n", decimation, name,
+				count, ref_count);
+		return false;
+	}
+	for (n = 0; n < count; n++) {
+		if (pcm[2 * n] != ref[n]) {
+			if (!mismatches)
+				printf("  %u %s: sample %u is %d, expected %d\n",
+						decimation, name, n, pcm[2 * n],
+						ref[n]);
+			mismatches++;
+		}
+	}
+	if (mismatches) {
+		printf("  %u %s: %u mismatches\n", decimation, name, mismatches);
+		return false;
+	}
+
+	if (signal == SIGNAL_TONE) {
+		/* -6 dBFS at the modulator input, unity gain to the PCM */
+		double amplitude = _tone_amplitude(count, decimation);
+		if (fabs(20 * log10(amplitude / 0.5)) > 0.2) {
+			printf("  %u %s: amplitude %.4f, expected 0.5\n",
+					decimation, name, amplitude);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	static const uint16_t decimations[] = { 16, 48, 64, 128, 256 };
+	static const char *names[] = { "tone", "random", "full scale" };
+	uint32_t i, errors = 0, count = 0;
+	int signal;
+
+	srand(1);
+	for (signal = SIGNAL_TONE; signal <= SIGNAL_FULL_SCALE; signal++) {
+		_generate(signal, 0.5);
+		for (i = 0; i < ARRAY_SIZE(decimations); i++) {
+			if (!_check(decimations[i], signal, names[signal]))
+				errors++;
+			count++;
+		}
+	}
+
+	printf("pdm_decimate: %u cases, %u failed\n", count, errors);
+	return errors ? 1 : 0;
+}